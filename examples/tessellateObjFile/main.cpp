@@ -147,8 +147,11 @@ blenderStyleTessellate(char *inputFile, char *outputFile, std::string *errorMess
     }
 
     // Push the vertex data
-    adaptiveEvaluator.SetCoarsePositions(
-        &(pointPositions[0]), (int) pointPositions.size(), errorMessage);
+    if (not adaptiveEvaluator.SetCoarsePositions(
+            &(pointPositions[0]), (int) pointPositions.size(), errorMessage)) {
+        std::cout << "SetCoarsePositions failed with " << *errorMessage << "\n";
+        return false;
+    }
 
     // Refine with one thread
     if (not adaptiveEvaluator.Refine(1, errorMessage)) {
@@ -159,8 +162,14 @@ blenderStyleTessellate(char *inputFile, char *outputFile, std::string *errorMess
     OsdUtilSubdivTopology refinedTopology;
     std::vector<float> positions;
    
+    int numThreads = 1;
+#ifdef OPENSUBDIV_HAS_OPENMP
+    numThreads = omp_get_max_threads();
+#endif
+
     if (not adaptiveEvaluator.GetRefinedTopology(
-            &refinedTopology, &positions, errorMessage)) {
+            &refinedTopology, &positions, errorMessage,
+            /*tessRate*/ 4, /*edgeRates*/ NULL, numThreads)) {
         std::cout << "GetRefinedTopology failed with " << *errorMessage <<"\n";
         return false;
     }
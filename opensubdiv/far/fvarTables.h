@@ -0,0 +1,186 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef FAR_FVAR_TABLES_H
+#define FAR_FVAR_TABLES_H
+
+#include "../version.h"
+
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Face-varying refinement tables.
+///
+/// FarFVarTables serialize the face-varying subdivision rules applied by Hbr
+/// (including the face-varying boundary interpolation and corner propagation
+/// modes of the mesh) so that face-varying primvars can be re-refined every
+/// frame without re-building the FarMesh.
+///
+/// Face-varying values are stored in a single buffer of interleaved values
+/// of width GetFVarWidth() :
+///
+/// * the first GetNumCoarseValues() values are the coarse face-varying data,
+///   one value for each vertex of each coarse face (in the order of the faces
+///   of the HbrMesh, which is the order used to author the data)
+///
+/// * the refined values follow, sorted by level of subdivision
+///
+/// Each refined value is computed with a stencil per face-varying item, which
+/// only references values of the previous levels. RefineValues() applies the
+/// stencils and GatherFVarData() copies the refined values into the layout of
+/// FarPatchTables::FVarData.
+///
+/// \note The topology of the face-varying data (the seams) is baked in the
+/// tables : only the values may change.
+///
+class FarFVarTables {
+
+public:
+
+    /// \brief Returns the width of the interleaved face-varying data
+    int GetFVarWidth() const { return _fvarWidth; }
+
+    /// \brief Returns the number of coarse face-varying values (one per
+    /// coarse face-vertex)
+    int GetNumCoarseValues() const { return _numCoarseValues; }
+
+    /// \brief Returns the total number of face-varying values (coarse and
+    /// refined)
+    int GetNumValues() const { return _numValues; }
+
+    /// \brief Returns the number of stencils in the tables
+    int GetNumStencils() const { return (int)_sizes.size(); }
+
+    /// \brief Returns the offset of the first stencil of each level of
+    /// subdivision : the stencils that compute the values of level 'i+1' are
+    /// in the range [ offsets[i], offsets[i+1] [ and can be applied in parallel
+    std::vector<int> const & GetLevelOffsets() const { return _levelOffsets; }
+
+    /// \brief Returns the number of source values of each stencil
+    std::vector<int> const & GetSizes() const { return _sizes; }
+
+    /// \brief Returns the offset of the destination of each stencil (in floats)
+    std::vector<int> const & GetDestinations() const { return _dst; }
+
+    /// \brief Returns the number of floats written by each stencil
+    std::vector<int> const & GetWidths() const { return _widths; }
+
+    /// \brief Returns the offsets of the source values of the stencils (in floats)
+    std::vector<int> const & GetSourceIndices() const { return _indices; }
+
+    /// \brief Returns the weights of the source values of the stencils
+    std::vector<float> const & GetWeights() const { return _weights; }
+
+    /// \brief Returns the index of the value copied into each face-varying
+    /// vertex of FarPatchTables::FVarData (or into each unique value if the
+    /// face-varying data is indexed)
+    std::vector<int> const & GetFVarDataIndices() const { return _fvarDataIndices; }
+
+    /// \brief Computes the refined face-varying values
+    ///
+    /// This is the serial reference implementation : the Osd CPU compute
+    /// controllers apply the same stencils in parallel (see
+    /// OsdCpuComputeController::RefineFVar).
+    ///
+    /// @param values  buffer of GetNumValues() * GetFVarWidth() floats, the
+    ///                coarse values must be set by the client
+    ///
+    void RefineValues( float * values ) const;
+
+    /// \brief Copies refined values into the layout of FarPatchTables::FVarData
+    /// (the layout of FVarData::GetValues() if the data is indexed)
+    ///
+    /// @param values    face-varying values updated with RefineValues()
+    ///
+    /// @param fvarData  buffer of GetFVarDataIndices().size() * GetFVarWidth()
+    ///                  floats
+    ///
+    void GatherFVarData( float const * values, float * fvarData ) const;
+
+private:
+
+    template <class X, class Y> friend class FarFVarTablesFactory;
+
+    FarFVarTables() : _fvarWidth(0), _numCoarseValues(0), _numValues(0) { }
+
+    int _fvarWidth,
+        _numCoarseValues,
+        _numValues;
+
+    std::vector<int> _levelOffsets,     // first stencil of each level
+
+                     _sizes,            // number of sources of each stencil
+                     _dst,              // destination offset of each stencil
+                     _widths,           // width of the face-varying item
+
+                     _indices,          // source offsets
+
+                     _fvarDataIndices;  // FVarData layout
+
+    std::vector<float> _weights;
+};
+
+inline void
+FarFVarTables::RefineValues( float * values ) const {
+
+    assert(values);
+
+    int const * index = _indices.empty() ? 0 : &_indices[0];
+    float const * weight = _weights.empty() ? 0 : &_weights[0];
+
+    for (int i=0; i<GetNumStencils(); ++i) {
+
+        float * dst = values + _dst[i];
+        int width = _widths[i];
+
+        memset(dst, 0, width*sizeof(float));
+
+        for (int j=0; j<_sizes[i]; ++j, ++index, ++weight) {
+            float const * src = values + *index;
+            for (int k=0; k<width; ++k)
+                dst[k] += *weight * src[k];
+        }
+    }
+}
+
+inline void
+FarFVarTables::GatherFVarData( float const * values, float * fvarData ) const {
+
+    assert(values and fvarData);
+
+    for (int i=0; i<(int)_fvarDataIndices.size(); ++i, fvarData+=_fvarWidth) {
+        memcpy(fvarData, values + _fvarDataIndices[i]*_fvarWidth, _fvarWidth*sizeof(float));
+    }
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_FVAR_TABLES_H */
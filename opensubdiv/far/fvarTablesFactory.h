@@ -0,0 +1,490 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef FAR_FVAR_TABLES_FACTORY_H
+#define FAR_FVAR_TABLES_FACTORY_H
+
+#include "../version.h"
+
+#include "../hbr/mesh.h"
+#include "../hbr/face.h"
+#include "../hbr/vertex.h"
+#include "../hbr/halfedge.h"
+#include "../hbr/fvarData.h"
+
+#include "../far/fvarTables.h"
+
+#include <cassert>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+template <class T, class U> class FarMeshFactory;
+
+/// \brief A specialized factory for FarFVarTables
+///
+/// The factory replays the face-varying rules of HbrCatmarkSubdivision and
+/// HbrBilinearSubdivision (transferFVarToChild) on the refined HbrMesh and
+/// records the weights instead of the values.
+///
+/// This factory is private to Far and should not be used by client code.
+///
+template <class T, class U> class FarFVarTablesFactory {
+
+public:
+    typedef std::vector<std::pair<HbrVertex<T> *, HbrFace<T> const *> > FVarSourceVector;
+
+protected:
+    template <class X, class Y> friend class FarMeshFactory;
+
+    /// \brief Creates a FarFVarTables instance, or returns NULL if the
+    /// subdivision scheme is not supported (Loop).
+    ///
+    /// @param factory      the mesh factory (the HbrMesh must be refined)
+    ///
+    /// @param fvarSources  the Hbr vertex and face of each face-varying vertex of the
+    ///                     FarPatchTables::FVarData table (or of each unique
+    ///                     value if the data is indexed)
+    ///
+    static FarFVarTables * Create( FarMeshFactory<T,U> const * factory,
+                                   FVarSourceVector const & fvarSources );
+
+private:
+
+    typedef std::map<int, float> Stencil;
+
+    // The stencils of a refined face-varying value (one per fvar item)
+    struct Value {
+        Value(int fvarcount) : initialized(false), stencils(fvarcount) { }
+
+        bool initialized;
+        std::vector<Stencil> stencils;
+    };
+
+    FarFVarTablesFactory(HbrMesh<T> * mesh);
+
+    ~FarFVarTablesFactory();
+
+    // Returns the index of an existing face-varying value
+    int getIndex(HbrFVarData<T> const & data) const;
+
+    // Returns the refined value that holds 'data', allocates it if needed
+    Value & getValue(HbrFVarData<T> const & data);
+
+    // Replays HbrCatmarkSubdivision<T>::transferFVarToChild
+    void transferFVarToChild(HbrFace<T> * face, HbrFace<T> * child, int index);
+
+    void setWithWeight(Value & dst, int item, HbrFVarData<T> const & src, float weight) {
+        dst.stencils[item].clear();
+        addWithWeight(dst, item, src, weight);
+    }
+
+    void addWithWeight(Value & dst, int item, HbrFVarData<T> const & src, float weight) {
+        dst.stencils[item][getIndex(src)] += weight;
+    }
+
+    // Adds the weighted stencil of a refined value
+    void addWithWeight(Value & dst, int item, Value const & src, float weight) {
+        Stencil const & s = src.stencils[item];
+        for (typename Stencil::const_iterator it=s.begin(); it!=s.end(); ++it)
+            dst.stencils[item][it->first] += it->second * weight;
+    }
+
+    HbrMesh<T> * _mesh;
+
+    int _numCoarseValues;
+
+    std::map<HbrFVarData<T> const *, int> _indices;
+
+    std::vector<Value *> _values;  // refined values (index - _numCoarseValues)
+};
+
+template <class T, class U>
+FarFVarTablesFactory<T,U>::FarFVarTablesFactory(HbrMesh<T> * mesh) :
+    _mesh(mesh), _numCoarseValues(0) {
+
+    // The coarse values are indexed by face-vertex : vertices that share their
+    // face-varying data are bound to the first face-vertex that references it
+    for (int i=0; i<mesh->GetNumCoarseFaces(); ++i) {
+        HbrFace<T> * f = mesh->GetFace(i);
+        for (int j=0; j<f->GetNumVertices(); ++j, ++_numCoarseValues) {
+            _indices.insert(std::make_pair(&f->GetFVarData(j), _numCoarseValues));
+        }
+    }
+}
+
+template <class T, class U>
+FarFVarTablesFactory<T,U>::~FarFVarTablesFactory() {
+
+    for (int i=0; i<(int)_values.size(); ++i)
+        delete _values[i];
+}
+
+template <class T, class U> int
+FarFVarTablesFactory<T,U>::getIndex(HbrFVarData<T> const & data) const {
+
+    typename std::map<HbrFVarData<T> const *, int>::const_iterator it = _indices.find(&data);
+    assert(it!=_indices.end());
+    return it->second;
+}
+
+template <class T, class U> typename FarFVarTablesFactory<T,U>::Value &
+FarFVarTablesFactory<T,U>::getValue(HbrFVarData<T> const & data) {
+
+    std::pair<typename std::map<HbrFVarData<T> const *, int>::iterator, bool> it =
+        _indices.insert(std::make_pair(&data, _numCoarseValues+(int)_values.size()));
+
+    if (it.second)
+        _values.push_back(new Value(_mesh->GetFVarCount()));
+
+    assert(it.first->second >= _numCoarseValues);
+    return *_values[it.first->second-_numCoarseValues];
+}
+
+template <class T, class U> void
+FarFVarTablesFactory<T,U>::transferFVarToChild(HbrFace<T> * face, HbrFace<T> * child, int index) {
+
+    // Note : this mirrors HbrCatmarkSubdivision<T>::transferFVarToChild (see
+    // hbr/catmark.h for the details of each rule), the bilinear scheme uses
+    // the same face-varying rules.
+
+    typename HbrMesh<T>::InterpolateBoundaryMethod fvarinterp = _mesh->GetFVarInterpolateBoundaryMethod();
+    const int fvarcount = _mesh->GetFVarCount();
+    const int nv = face->GetNumVertices();
+    bool extraordinary = (nv != 4);
+    HbrVertex<T> *v = face->GetVertex(index);
+    HbrHalfedge<T>* edge;
+
+    // Face rule (smooth for all the items)
+    Value & fv2 = getValue(child->GetFVarData(extraordinary ? 2 : (index+2)%4));
+    if (not fv2.initialized) {
+        float weight = 1.0f / nv;
+        for (int item=0; item<fvarcount; ++item) {
+            fv2.stencils[item].clear();
+            for (int j=0; j<nv; ++j)
+                addWithWeight(fv2, item, face->GetFVarData(j), weight);
+        }
+        fv2.initialized = true;
+    }
+
+    v->GuaranteeNeighbors();
+
+    bool fv0IsSmooth = v->IsFVarAllSmooth();
+    Value & fv0 = getValue(child->GetFVarData(extraordinary ? 0 : (index+0)%4));
+
+    edge = face->GetEdge(index);
+    bool fv1IsSmooth = not edge->IsFVarInfiniteSharpAnywhere();
+    Value & fv1 = getValue(child->GetFVarData(extraordinary ? 1 : (index+1)%4));
+
+    edge = edge->GetPrev();
+    bool fv3IsSmooth = not edge->IsFVarInfiniteSharpAnywhere();
+    Value & fv3 = getValue(child->GetFVarData(extraordinary ? 3 : (index+3)%4));
+
+    for (int fvaritem=0; fvaritem<fvarcount; ++fvaritem) {
+
+        bool infcorner = false;
+        const unsigned char fvarmask = v->GetFVarMask(fvaritem);
+        if (fvarinterp == HbrMesh<T>::k_InterpolateBoundaryEdgeAndCorner) {
+            if (fvarmask >= HbrVertex<T>::k_Corner) {
+                infcorner = true;
+            } else if (_mesh->GetFVarPropagateCorners()) {
+                if (v->IsFVarCorner(fvaritem)) {
+                    infcorner = true;
+                }
+            } else {
+                if (face->GetEdge(index)->GetFVarSharpness(fvaritem, true) and
+                    face->GetEdge(index)->GetPrev()->GetFVarSharpness(fvaritem, true)) {
+                    infcorner = true;
+                }
+            }
+        }
+
+        // Infinitely sharp vertex rule
+        if (fvarinterp == HbrMesh<T>::k_InterpolateBoundaryNone or
+            (fvarinterp == HbrMesh<T>::k_InterpolateBoundaryAlwaysSharp and fvarmask >= 1) or
+            v->GetSharpness() > HbrVertex<T>::k_Smooth or
+            infcorner) {
+
+            setWithWeight(fv0, fvaritem, face->GetFVarData(index), 1.0f);
+        }
+        // Dart rule
+        else if (fvarmask == 1) {
+
+            setWithWeight(fv0, fvaritem, face->GetFVarData(index), 0.75f);
+
+            HbrHalfedge<T>* start = v->GetIncidentEdge(), *nextedge;
+            edge = start;
+            while (edge) {
+                if (edge->GetFVarSharpness(fvaritem)) {
+                    break;
+                }
+                nextedge = v->GetNextEdge(edge);
+                if (nextedge == start) {
+                    assert(0);
+                    break;
+                } else if (not nextedge) {
+                    assert(0);
+                    edge = edge->GetPrev();
+                    break;
+                } else {
+                    edge = nextedge;
+                }
+            }
+            HbrVertex<T>* w = edge->GetDestVertex();
+            HbrFace<T>* bestface = edge->GetLeftFace();
+            int j;
+            for (j = 0; j < bestface->GetNumVertices(); ++j) {
+                if (bestface->GetVertex(j) == w) break;
+            }
+            assert(j != bestface->GetNumVertices());
+            addWithWeight(fv0, fvaritem, bestface->GetFVarData(j), 0.125f);
+            bestface = edge->GetRightFace();
+            for (j = 0; j < bestface->GetNumVertices(); ++j) {
+                if (bestface->GetVertex(j) == w) break;
+            }
+            assert(j != bestface->GetNumVertices());
+            addWithWeight(fv0, fvaritem, bestface->GetFVarData(j), 0.125f);
+        }
+        // Boundary vertex rule
+        else if (fvarmask != 0) {
+
+            setWithWeight(fv0, fvaritem, face->GetFVarData(index), 0.75f);
+
+            // first face-varying boundary edge, counterclockwise around v
+            HbrFace<T>* bestface = face;
+            HbrHalfedge<T>* bestedge = face->GetEdge(index)->GetPrev();
+            HbrHalfedge<T>* starte = bestedge->GetOpposite();
+            HbrVertex<T>* w = 0;
+            if (not starte) {
+                w = face->GetEdge(index)->GetPrev()->GetOrgVertex();
+            } else {
+                HbrHalfedge<T>* e = starte, *next;
+                assert(starte->GetOrgVertex() == v);
+                do {
+                    if (e->GetFVarSharpness(fvaritem) or not e->GetLeftFace()) {
+                        bestface = e->GetRightFace();
+                        bestedge = e;
+                        break;
+                    }
+                    next = v->GetNextEdge(e);
+                    if (not next) {
+                        bestface = e->GetLeftFace();
+                        w = e->GetPrev()->GetOrgVertex();
+                        break;
+                    }
+                    e = next;
+                } while (e and e != starte);
+            }
+            if (not w) w = bestedge->GetDestVertex();
+            int j;
+            for (j = 0; j < bestface->GetNumVertices(); ++j) {
+                if (bestface->GetVertex(j) == w) break;
+            }
+            assert(j != bestface->GetNumVertices());
+            addWithWeight(fv0, fvaritem, bestface->GetFVarData(j), 0.125f);
+
+            // the other one, clockwise around v
+            bestface = face;
+            bestedge = face->GetEdge(index);
+            starte = bestedge;
+            w = 0;
+            if (HbrHalfedge<T>* e = starte) {
+                assert(starte->GetOrgVertex() == v);
+                do {
+                    if (e->GetFVarSharpness(fvaritem) or not e->GetRightFace()) {
+                        bestface = e->GetLeftFace();
+                        bestedge = e;
+                        break;
+                    }
+                    assert(e->GetOpposite());
+                    e = v->GetPreviousEdge(e);
+                } while (e and e != starte);
+            }
+            if (not w) w = bestedge->GetDestVertex();
+            for (j = 0; j < bestface->GetNumVertices(); ++j) {
+                if (bestface->GetVertex(j) == w) break;
+            }
+            assert(j != bestface->GetNumVertices());
+            addWithWeight(fv0, fvaritem, bestface->GetFVarData(j), 0.125f);
+        }
+        // Smooth rule
+        else if (not fv0IsSmooth or not fv0.initialized) {
+
+            int valence = v->GetValence();
+            float invvalencesquared = 1.0f / (valence * valence);
+
+            setWithWeight(fv0, fvaritem, face->GetFVarData(index), invvalencesquared * valence * (valence - 2));
+
+            HbrHalfedge<T>* start = v->GetIncidentEdge();
+            edge = start;
+            while (edge) {
+                HbrFace<T>* g = edge->GetLeftFace();
+                float weight = invvalencesquared / g->GetNumVertices();
+                for (int j = 0; j < g->GetNumVertices(); ++j) {
+                    addWithWeight(fv0, fvaritem, g->GetFVarData(j), weight);
+                    if (g->GetEdge(j)->GetOrgVertex() == v) {
+                        addWithWeight(fv0, fvaritem, g->GetFVarData((j + 1) % g->GetNumVertices()), invvalencesquared);
+                    }
+                }
+                edge = v->GetNextEdge(edge);
+                if (edge == start) break;
+            }
+        }
+
+        // Edge rules
+        for (int k=0; k<2; ++k) {
+
+            Value & fv = k==0 ? fv1 : fv3;
+            bool fvIsSmooth = k==0 ? fv1IsSmooth : fv3IsSmooth;
+
+            edge = k==0 ? face->GetEdge(index) : face->GetEdge(index)->GetPrev();
+
+            HbrFVarData<T> & org = face->GetFVarData(k==0 ? index : (index + nv - 1) % nv),
+                           & dst = face->GetFVarData(k==0 ? (index + 1) % nv : index);
+
+            if (fvarinterp == HbrMesh<T>::k_InterpolateBoundaryNone or
+                edge->GetFVarSharpness(fvaritem) or edge->IsBoundary()) {
+
+                // Sharp edge rule
+                setWithWeight(fv, fvaritem, org, 0.5f);
+                addWithWeight(fv, fvaritem, dst, 0.5f);
+            } else if (not fvIsSmooth or not fv.initialized) {
+
+                // Smooth edge rule
+                setWithWeight(fv, fvaritem, org, 0.25f);
+                addWithWeight(fv, fvaritem, dst, 0.25f);
+                addWithWeight(fv, fvaritem, fv2, 0.25f);
+                HbrFace<T>* oppFace = edge->GetRightFace();
+                float weight = 0.25f / oppFace->GetNumVertices();
+                for (int j = 0; j < oppFace->GetNumVertices(); ++j) {
+                    addWithWeight(fv, fvaritem, oppFace->GetFVarData(j), weight);
+                }
+            }
+        }
+    }
+    fv0.initialized = true;
+    fv1.initialized = true;
+    fv3.initialized = true;
+}
+
+template <class T, class U> FarFVarTables *
+FarFVarTablesFactory<T,U>::Create( FarMeshFactory<T,U> const * factory,
+                                   FVarSourceVector const & fvarSources ) {
+
+    assert( factory );
+
+    HbrMesh<T> * mesh = factory->_hbrMesh;
+
+    if (FarMeshFactory<T,U>::isLoop(mesh) or mesh->GetTotalFVarWidth()==0)
+        return 0;
+
+    // The values are identified by the address of their Hbr data : complete
+    // the neighborhoods up front, as Hbr re-allocates the face-varying data
+    // of the vertices it refines
+    int nfaces = mesh->GetNumFaces();
+    for (int i=0; i<nfaces; ++i) {
+        HbrFace<T> * f = mesh->GetFace(i);
+        if (f and f->GetDepth()<factory->GetMaxLevel()) {
+            for (int j=0; j<f->GetNumVertices(); ++j) {
+                if (f->GetChild(j))
+                    f->GetVertex(j)->GuaranteeNeighbors();
+            }
+        }
+    }
+
+    // Replay the face-varying rules level by level, so that the stencils only
+    // reference values of the previous levels
+    std::vector<std::vector<HbrFace<T> *> > faces(factory->GetMaxLevel()+1);
+    for (int i=0; i<nfaces; ++i) {
+        HbrFace<T> * f = mesh->GetFace(i);
+        if (f and f->GetDepth()<(int)faces.size())
+            faces[f->GetDepth()].push_back(f);
+    }
+
+    FarFVarTablesFactory<T,U> builder(mesh);
+
+    std::vector<int> levelValues(1, builder._numCoarseValues);
+
+    for (int level=0; level<factory->GetMaxLevel(); ++level) {
+        for (int i=0; i<(int)faces[level].size(); ++i) {
+            HbrFace<T> * f = faces[level][i];
+            for (int j=0; j<f->GetNumVertices(); ++j) {
+                if (HbrFace<T> * child = f->GetChild(j))
+                    builder.transferFVarToChild(f, child, j);
+            }
+        }
+        levelValues.push_back(builder._numCoarseValues + (int)builder._values.size());
+    }
+
+    // Serialize the stencils
+    FarFVarTables * result = new FarFVarTables;
+
+    int fvarcount = mesh->GetFVarCount();
+    int const * fvarwidths = mesh->GetFVarWidths();
+
+    result->_fvarWidth = mesh->GetTotalFVarWidth();
+    result->_numCoarseValues = builder._numCoarseValues;
+    result->_numValues = levelValues.back();
+
+    result->_levelOffsets.push_back(0);
+    for (int level=1; level<(int)levelValues.size(); ++level) {
+        for (int i=levelValues[level-1]; i<levelValues[level]; ++i) {
+
+            Value const * value = builder._values[i-builder._numCoarseValues];
+
+            for (int item=0, fvarindex=0; item<fvarcount; fvarindex+=fvarwidths[item++]) {
+
+                Stencil const & s = value->stencils[item];
+
+                result->_sizes.push_back((int)s.size());
+                result->_dst.push_back(i*result->_fvarWidth + fvarindex);
+                result->_widths.push_back(fvarwidths[item]);
+
+                for (typename Stencil::const_iterator it=s.begin(); it!=s.end(); ++it) {
+                    result->_indices.push_back(it->first*result->_fvarWidth + fvarindex);
+                    result->_weights.push_back(it->second);
+                }
+            }
+        }
+        result->_levelOffsets.push_back(result->GetNumStencils());
+    }
+
+    result->_fvarDataIndices.resize(fvarSources.size());
+    for (int i=0; i<(int)fvarSources.size(); ++i) {
+        assert(fvarSources[i].first and fvarSources[i].second);
+        result->_fvarDataIndices[i] = builder.getIndex(fvarSources[i].first->GetFVarData(fvarSources[i].second));
+    }
+
+    return result;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_FVAR_TABLES_FACTORY_H */
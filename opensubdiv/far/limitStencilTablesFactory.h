@@ -0,0 +1,1184 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+
+#ifndef FAR_LIMIT_STENCILTABLES_FACTORY_H
+#define FAR_LIMIT_STENCILTABLES_FACTORY_H
+
+#include "../version.h"
+
+// The patch tables are only created for feature adaptive meshes : as with
+// FarMeshFactory, the Hbr adaptive tags must be active
+#ifndef HBR_ADAPTIVE
+#define HBR_ADAPTIVE
+#endif
+
+#include "../far/mesh.h"
+#include "../far/patchMap.h"
+#include "../far/patchTables.h"
+#include "../far/stencilTables.h"
+#include "../far/subdivisionStencilTablesFactory.h"
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief A factory for limit stencils of feature adaptive meshes
+///
+/// The FarLimitStencilTablesFactory generates limit stencils (position, du and
+/// dv weights) at arbitrary (face, u, v) locations of the limit surface of a
+/// feature adaptive Catmark mesh, using only Far data :
+///
+///   - a FarPatchMap finds the patch that contains each sample
+///   - the basis of the patch gives the weights of its control vertices
+///   - the control vertices are expressed as weighted sums of the coarse
+///     vertices by the stencils of the refined vertices (see
+///     FarSubdivisionStencilTablesFactory::CreateAll)
+///
+/// Unlike the FarStencilTablesFactory, no HbrMesh is required (or modified),
+/// and the samples are processed in parallel. The stencils give the same limit
+/// positions and derivatives as the OsdCpuEvalLimitController, Gregory patches
+/// included.
+///
+/// The (u,v) locations are ptex coordinates, like OsdEvalCoords. The stencils
+/// are ordered like the samples : samples that do not land on a patch (holes,
+/// invalid faces) get empty stencils.
+///
+/// \note Loop patches are not supported yet : the factory fails on Loop meshes.
+///
+class FarLimitStencilTablesFactory {
+
+public:
+
+    /// \brief Creates limit stencils for a set of samples
+    ///
+    /// @param patchTables     The feature adaptive patch tables of the mesh
+    ///
+    /// @param vertexStencils  The stencils of all the vertices of the mesh,
+    ///                        indexed like its vertex buffer (see
+    ///                        FarSubdivisionStencilTablesFactory::CreateAll)
+    ///
+    /// @param nsamples        The number of samples
+    ///
+    /// @param faces           The ptex face of each sample
+    ///
+    /// @param u               The ptex u of each sample
+    ///
+    /// @param v               The ptex v of each sample
+    ///
+    /// @param numThreads      If numThreads > 1 and OpenMP is available, the
+    ///                        stencils are generated with numThreads threads
+    ///
+    /// @return                The stencil tables, or NULL if the patch tables
+    ///                        are not feature adaptive Catmark patches or if
+    ///                        the vertex stencils do not cover their control
+    ///                        vertices
+    ///
+    static FarStencilTables * Create( FarPatchTables const * patchTables,
+                                      FarStencilTables const * vertexStencils,
+                                      int nsamples,
+                                      int const * faces,
+                                      float const * u,
+                                      float const * v,
+                                      int numThreads=1 );
+
+    /// \brief Creates limit stencils for a set of samples
+    ///
+    /// @param mesh        A feature adaptive Far mesh
+    ///
+    /// @param nsamples    The number of samples
+    ///
+    /// @param faces       The ptex face of each sample
+    ///
+    /// @param u           The ptex u of each sample
+    ///
+    /// @param v           The ptex v of each sample
+    ///
+    /// @param numThreads  If numThreads > 1 and OpenMP is available, the
+    ///                    stencils are generated with numThreads threads
+    ///
+    /// @return            The stencil tables, or NULL on failure (see above,
+    ///                    the mesh must not have vertex edits either)
+    ///
+    template <class U>
+    static FarStencilTables * Create( FarMesh<U> const * mesh,
+                                      int nsamples,
+                                      int const * faces,
+                                      float const * u,
+                                      float const * v,
+                                      int numThreads=1 );
+
+private:
+
+    // Stencils generated by a thread, in the order of their samples
+    struct Chunk {
+        std::vector<int>   indices;
+        std::vector<float> point,
+                           du,
+                           dv;
+    };
+
+    // Accumulates the weights of the coarse vertices of a stencil in dense
+    // scratch arrays
+    class Accumulator {
+    public:
+        explicit Accumulator( int ncoarse ) :
+            _weights(3*ncoarse, 0.0f), _used(ncoarse, 0) { }
+
+        // Adds the stencil of a refined vertex with the given weights
+        void Add( FarStencil const & src, float point, float du, float dv );
+
+        // Same, without derivatives
+        void Add( FarStencil const & src, float point );
+
+        // Appends the accumulated weights to the chunk (sorted by coarse
+        // vertex), resets the accumulator and returns the stencil size
+        int Flush( Chunk & chunk, bool derivs );
+
+    private:
+        std::vector<float> _weights;  // point, du, dv of each coarse vertex
+        std::vector<char>  _used;
+        std::vector<int>   _touched;
+    };
+
+    // The vertices of the 1-rings of the corners of a Gregory patch, with
+    // dense identity weights : the Gregory points computed from these
+    // vertices are their weights
+    class LocalVertices {
+    public:
+        LocalVertices( unsigned int const * cvs, int const * valenceTable, int maxValence );
+
+        int GetNumVertices() const {
+            return (int)_indices.size();
+        }
+
+        int GetVertexIndex( int i ) const {
+            return _indices[i];
+        }
+
+        // Returns the weights of the vertex of the given mesh index
+        float const * operator[]( int index ) const {
+            int i = (int)(std::lower_bound(_indices.begin(), _indices.end(), index) - _indices.begin());
+            assert(i<(int)_indices.size() and _indices[i]==index);
+            return &_identity[i*_indices.size()];
+        }
+
+    private:
+        std::vector<int>   _indices;
+        std::vector<float> _identity;
+    };
+
+    // Gregory points of a patch (same as the Osd CPU limit evaluation kernels)
+    static void computeGregoryPoints( unsigned int const * vertexIndices,
+                                      int const * vertexValenceBuffer,
+                                      unsigned int const * quadOffsets,
+                                      int maxValence,
+                                      LocalVertices const & verts,
+                                      float * points );
+
+    static void computeGregoryBoundaryPoints( unsigned int const * vertexIndices,
+                                              int const * vertexValenceBuffer,
+                                              unsigned int const * quadOffsets,
+                                              int maxValence,
+                                              LocalVertices const & verts,
+                                              float * points );
+
+    static float csf( unsigned int n, unsigned int j );
+
+    static float ef( int n );
+
+    // Cubic B-spline and Bezier basis functions & derivatives
+    static void evalCubicBSpline( float u, float B[4], float D[4] );
+
+    static void evalCubicBezier( float u, float B[4], float D[4] );
+
+    // Adds the weights of the control vertices of a B-spline patch at (s,t)
+    static void addBSplineWeights( FarPatchTables::Type type,
+                                   unsigned int const * cvs,
+                                   float s, float t,
+                                   FarStencilTables const & vertexStencils,
+                                   Accumulator & accumulator );
+
+    // Adds the weights of the 20 points of a Gregory patch at (s,t)
+    static void addGregoryWeights( int firstPoint,
+                                   float s, float t,
+                                   FarStencilTables const & gregoryStencils,
+                                   Accumulator & accumulator );
+
+    // Splits [0,n) in contiguous ranges, one per thread : returns the range
+    // and the index of the calling thread
+    static int getThreadRange( int n, int & begin, int & end );
+
+    static void serialize( std::vector<int> const & sizes,
+                           std::vector<Chunk> const & chunks,
+                           bool derivs,
+                           FarStencilTables * result );
+};
+
+inline void
+FarLimitStencilTablesFactory::Accumulator::Add( FarStencil const & src,
+                                                float point,
+                                                float du,
+                                                float dv ) {
+
+    int const * indices = src.GetVertexIndices();
+    float const * weights = src.GetValueWeights();
+
+    for (int i=0; i<src.GetSize(); ++i) {
+        int c = indices[i];
+        if (not _used[c]) {
+            _used[c] = 1;
+            _touched.push_back(c);
+        }
+        float * dst = &_weights[3*c];
+        dst[0] += point * weights[i];
+        dst[1] += du * weights[i];
+        dst[2] += dv * weights[i];
+    }
+}
+
+inline void
+FarLimitStencilTablesFactory::Accumulator::Add( FarStencil const & src,
+                                                float point ) {
+
+    int const * indices = src.GetVertexIndices();
+    float const * weights = src.GetValueWeights();
+
+    for (int i=0; i<src.GetSize(); ++i) {
+        int c = indices[i];
+        if (not _used[c]) {
+            _used[c] = 1;
+            _touched.push_back(c);
+        }
+        _weights[3*c] += point * weights[i];
+    }
+}
+
+inline int
+FarLimitStencilTablesFactory::Accumulator::Flush( Chunk & chunk, bool derivs ) {
+
+    std::sort(_touched.begin(), _touched.end());
+
+    for (int i=0; i<(int)_touched.size(); ++i) {
+        int c = _touched[i];
+        float * src = &_weights[3*c];
+        chunk.indices.push_back(c);
+        chunk.point.push_back(src[0]);
+        if (derivs) {
+            chunk.du.push_back(src[1]);
+            chunk.dv.push_back(src[2]);
+        }
+        src[0] = src[1] = src[2] = 0.0f;
+        _used[c] = 0;
+    }
+
+    int size = (int)_touched.size();
+    _touched.clear();
+    return size;
+}
+
+inline
+FarLimitStencilTablesFactory::LocalVertices::LocalVertices( unsigned int const * cvs,
+                                                            int const * valenceTable,
+                                                            int maxValence ) {
+
+    for (int i=0; i<4; ++i) {
+
+        _indices.push_back(cvs[i]);
+
+        int const * ring = valenceTable + cvs[i] * (2*maxValence+1);
+        int valence = abs(*ring);
+        for (int j=0; j<2*valence; ++j) {
+            _indices.push_back(ring[1+j]);
+        }
+    }
+
+    std::sort(_indices.begin(), _indices.end());
+    _indices.erase(std::unique(_indices.begin(), _indices.end()), _indices.end());
+
+    int n = (int)_indices.size();
+    _identity.resize(n*n, 0.0f);
+    for (int i=0; i<n; ++i) {
+        _identity[i*n+i] = 1.0f;
+    }
+}
+
+inline float
+FarLimitStencilTablesFactory::csf( unsigned int n, unsigned int j ) {
+
+    if (j%2 == 0) {
+        return cosf((2.0f * float(M_PI) * float(float(j-0)/2.0f))/(float(n)+3.0f));
+    } else {
+        return sinf((2.0f * float(M_PI) * float(float(j-1)/2.0f))/(float(n)+3.0f));
+    }
+}
+
+inline float
+FarLimitStencilTablesFactory::ef( int n ) {
+
+    static float const efTable[27] = {
+        0.812816f, 0.500000f, 0.363644f, 0.287514f,
+        0.238688f, 0.204544f, 0.179229f, 0.159657f,
+        0.144042f, 0.131276f, 0.120632f, 0.111614f,
+        0.103872f, 0.09715f, 0.0912559f, 0.0860444f,
+        0.0814022f, 0.0772401f, 0.0734867f, 0.0700842f,
+        0.0669851f, 0.0641504f, 0.0615475f, 0.0591488f,
+        0.0569311f, 0.0548745f, 0.0529621f
+    };
+    assert(n>=0 and n<27);
+    return efTable[n];
+}
+
+inline void
+FarLimitStencilTablesFactory::computeGregoryPoints( unsigned int const * vertexIndices,
+                                                    int const * vertexValenceBuffer,
+                                                    unsigned int const * quadOffsets,
+                                                    int maxValence,
+                                                    LocalVertices const & verts,
+                                                    float * points ) {
+
+    int valences[4], length = verts.GetNumVertices();
+
+    std::vector<float> r((maxValence+2)*4*length, 0.0f),
+                       f(maxValence*length, 0.0f),
+                       opos(4*length, 0.0f);
+
+    float * rp,
+          * e0 = &r[maxValence*4*length],
+          * e1 = e0 + 4*length;
+
+    for (int vid=0; vid<4; ++vid) {
+
+        int vertexID = vertexIndices[vid];
+
+        int const * valenceTable = vertexValenceBuffer + vertexID * (2*maxValence+1);
+        int valence = abs(*valenceTable);
+        assert(valence<=maxValence);
+        valences[vid] = valence;
+
+        float const * pos = verts[vertexID];
+
+        rp = &r[vid*maxValence*length];
+
+        int vofs = vid*length;
+
+        for (int i=0; i<valence; ++i) {
+            unsigned int im = (i+valence-1)%valence,
+                         ip = (i+1)%valence;
+
+            float const * neighbor   = verts[valenceTable[2*i  + 0 + 1]],
+                        * diagonal   = verts[valenceTable[2*i  + 1 + 1]],
+                        * neighbor_p = verts[valenceTable[2*ip + 0 + 1]],
+                        * neighbor_m = verts[valenceTable[2*im + 0 + 1]],
+                        * diagonal_m = verts[valenceTable[2*im + 1 + 1]];
+
+            float * fp = &f[i*length];
+
+            for (int k=0; k<length; ++k) {
+                fp[k] = (pos[k]*float(valence) + (neighbor_p[k]+neighbor[k])*2.0f + diagonal[k])/(float(valence)+5.0f);
+
+                opos[vofs+k] += fp[k];
+                rp[i*length+k] = (neighbor_p[k]-neighbor_m[k])/3.0f + (diagonal[k]-diagonal_m[k])/6.0f;
+            }
+        }
+
+        for (int k=0; k<length; ++k) {
+            opos[vofs+k] /= valence;
+        }
+
+        for (int i=0; i<valence; ++i) {
+            int im = (i+valence-1)%valence;
+            for (int k=0; k<length; ++k) {
+                float e = 0.5f*(f[i*length+k]+f[im*length+k]);
+                e0[vofs+k] += csf(valence-3, 2*i) * e;
+                e1[vofs+k] += csf(valence-3, 2*i+1) * e;
+            }
+        }
+
+        for (int k=0; k<length; ++k) {
+            e0[vofs+k] *= ef(valence-3);
+            e1[vofs+k] *= ef(valence-3);
+        }
+    }
+
+    std::vector<float> Ep(4*length), Em(4*length), Fp(4*length), Fm(4*length),
+                       Em_ip(length), Ep_im(length);
+
+    for (int vid=0; vid<4; ++vid) {
+
+        int ip = (vid+1)%4;
+        int im = (vid+3)%4;
+        int n = valences[vid];
+
+        int start = quadOffsets[vid] & 0x00ff;
+        int prev = (quadOffsets[vid] & 0xff00) / 256;
+
+        for (int k=0, ofs=vid*length; k<length; ++k, ++ofs) {
+            Ep[ofs] = opos[ofs] + e0[ofs] * csf(n-3, 2*start) + e1[ofs]*csf(n-3, 2*start +1);
+            Em[ofs] = opos[ofs] + e0[ofs] * csf(n-3, 2*prev ) + e1[ofs]*csf(n-3, 2*prev + 1);
+        }
+
+        unsigned int np = valences[ip],
+                     nm = valences[im];
+
+        unsigned int prev_p = (quadOffsets[ip] & 0xff00) / 256,
+                    start_m = quadOffsets[im] & 0x00ff;
+
+        for (int k=0, ipofs=ip*length, imofs=im*length; k<length; ++k, ++ipofs, ++imofs) {
+            Em_ip[k] = opos[ipofs] + e0[ipofs]*csf(np-3, 2*prev_p)  + e1[ipofs]*csf(np-3, 2*prev_p+1);
+            Ep_im[k] = opos[imofs] + e0[imofs]*csf(nm-3, 2*start_m) + e1[imofs]*csf(nm-3, 2*start_m+1);
+        }
+
+        float s1 = 3.0f - 2.0f*csf(n-3,2)-csf(np-3,2),
+              s2 = 2.0f*csf(n-3,2),
+              s3 = 3.0f -2.0f*cosf(2.0f*float(M_PI)/float(n)) - cosf(2.0f*float(M_PI)/float(nm));
+
+        rp = &r[vid*maxValence*length];
+        for (int k=0, ofs=vid*length; k<length; ++k, ++ofs) {
+            Fp[ofs] = (csf(np-3,2)*opos[ofs] + s1*Ep[ofs] + s2*Em_ip[k] + rp[start*length+k])/3.0f;
+            Fm[ofs] = (csf(nm-3,2)*opos[ofs] + s3*Em[ofs] + s2*Ep_im[k] - rp[prev*length+k])/3.0f;
+        }
+    }
+
+    // pack the 20 control points : P, Ep, Em, Fp, Fm for each corner
+    for (int vid=0, ofs=0; vid<4; ++vid, ofs+=length) {
+        std::copy(&opos[ofs], &opos[ofs]+length, points + (vid*5+0)*length);
+        std::copy(  &Ep[ofs],   &Ep[ofs]+length, points + (vid*5+1)*length);
+        std::copy(  &Em[ofs],   &Em[ofs]+length, points + (vid*5+2)*length);
+        std::copy(  &Fp[ofs],   &Fp[ofs]+length, points + (vid*5+3)*length);
+        std::copy(  &Fm[ofs],   &Fm[ofs]+length, points + (vid*5+4)*length);
+    }
+}
+
+inline void
+FarLimitStencilTablesFactory::computeGregoryBoundaryPoints( unsigned int const * vertexIndices,
+                                                            int const * vertexValenceBuffer,
+                                                            unsigned int const * quadOffsets,
+                                                            int maxValence,
+                                                            LocalVertices const & verts,
+                                                            float * points ) {
+
+    int valences[4], zerothNeighbors[4], length = verts.GetNumVertices();
+
+    std::vector<float> r((maxValence+2)*4*length, 0.0f),
+                       f(maxValence*length, 0.0f),
+                       org(4*length, 0.0f),
+                       opos(4*length, 0.0f);
+
+    float * rp,
+          * e0 = &r[maxValence*4*length],
+          * e1 = e0 + 4*length;
+
+    for (int vid=0; vid<4; ++vid) {
+
+        int vertexID = vertexIndices[vid];
+
+        int const * valenceTable = vertexValenceBuffer + vertexID * (2*maxValence+1);
+        int valence = *valenceTable,
+            ivalence = abs(valence);
+
+        assert(ivalence<=maxValence);
+        valences[vid] = valence;
+
+        int vofs = vid * length;
+
+        float * pos = &org[vofs];
+        std::copy(verts[vertexID], verts[vertexID]+length, pos);
+
+        int boundaryEdgeNeighbors[2];
+        unsigned int currNeighbor = 0,
+                     ibefore = 0,
+                     zerothNeighbor = 0;
+
+        rp = &r[vid*maxValence*length];
+
+        for (int i=0; i<ivalence; ++i) {
+            unsigned int im = (i+ivalence-1)%ivalence,
+                         ip = (i+1)%ivalence;
+
+            int idx_neighbor = valenceTable[2*i + 0 + 1];
+
+            int valenceNeighbor = vertexValenceBuffer[idx_neighbor * (2*maxValence+1)];
+            if (valenceNeighbor < 0) {
+
+                if (currNeighbor<2) {
+                    boundaryEdgeNeighbors[currNeighbor] = idx_neighbor;
+                }
+                currNeighbor++;
+
+                if (currNeighbor == 1) {
+                    ibefore = i;
+                    zerothNeighbor = i;
+                } else {
+                    if (i-ibefore == 1) {
+                        std::swap(boundaryEdgeNeighbors[0], boundaryEdgeNeighbors[1]);
+                        zerothNeighbor = i;
+                    }
+                }
+            }
+
+            float const * neighbor   = verts[idx_neighbor],
+                        * diagonal   = verts[valenceTable[2*i  + 1 + 1]],
+                        * neighbor_p = verts[valenceTable[2*ip + 0 + 1]],
+                        * neighbor_m = verts[valenceTable[2*im + 0 + 1]],
+                        * diagonal_m = verts[valenceTable[2*im + 1 + 1]];
+
+            float * fp = &f[i*length];
+
+            for (int k=0; k<length; ++k) {
+                fp[k] = (pos[k]*float(ivalence) + (neighbor_p[k]+neighbor[k])*2.0f + diagonal[k])/(float(ivalence)+5.0f);
+
+                opos[vofs+k] += fp[k];
+                rp[i*length+k] = (neighbor_p[k]-neighbor_m[k])/3.0f + (diagonal[k]-diagonal_m[k])/6.0f;
+            }
+        }
+
+        for (int k=0; k<length; ++k) {
+            opos[vofs+k] /= ivalence;
+        }
+
+        zerothNeighbors[vid] = zerothNeighbor;
+
+        if (currNeighbor == 1) {
+            boundaryEdgeNeighbors[1] = boundaryEdgeNeighbors[0];
+        }
+
+        for (int i=0; i<ivalence; ++i) {
+            unsigned int im = (i+ivalence-1)%ivalence;
+            for (int k=0; k<length; ++k) {
+                float e = 0.5f*(f[i*length+k]+f[im*length+k]);
+                e0[vofs+k] += csf(ivalence-3, 2*i  ) * e;
+                e1[vofs+k] += csf(ivalence-3, 2*i+1) * e;
+            }
+        }
+
+        // (the tangents of the boundary vertices are replaced below)
+        if (ivalence>2) {
+            for (int k=0; k<length; ++k) {
+                e0[vofs+k] *= ef(ivalence-3);
+                e1[vofs+k] *= ef(ivalence-3);
+            }
+        }
+
+        if (valence<0) {
+
+            float const * b0 = verts[boundaryEdgeNeighbors[0]],
+                        * b1 = verts[boundaryEdgeNeighbors[1]];
+
+            if (ivalence>2) {
+                for (int k=0; k<length; ++k) {
+                    opos[vofs+k] = (b0[k] + b1[k] + 4.0f*pos[k])/6.0f;
+                }
+            } else {
+                std::copy(pos, pos+length, &opos[0]);
+            }
+
+            float k = float(float(ivalence) - 1.0f);    //k is the number of faces
+            float c = cosf(float(M_PI)/k);
+            float s = sinf(float(M_PI)/k);
+            float gamma = -(4.0f*s)/(3.0f*k+c);
+            float alpha_0k = -((1.0f+2.0f*c)*sqrtf(1.0f+c))/((3.0f*k+c)*sqrtf(1.0f-c));
+            float beta_0 = s/(3.0f*k + c);
+
+            float const * diagonal = verts[valenceTable[2*zerothNeighbor + 1 + 1]];
+
+            for (int j=0; j<length; ++j) {
+                e0[vofs+j] = (b0[j] - b1[j])/6.0f;
+                e1[vofs+j] = gamma * pos[j] + beta_0 * diagonal[j] + (b0[j] + b1[j]) * alpha_0k;
+            }
+
+            for (int x=1; x<ivalence-1; ++x) {
+                unsigned int curri = ((x + zerothNeighbor)%ivalence);
+                float alpha = (4.0f*sinf((float(M_PI) * float(x))/k))/(3.0f*k+c);
+                float beta = (sinf((float(M_PI) * float(x))/k) + sinf((float(M_PI) * float(x+1))/k))/(3.0f*k+c);
+
+                float const * neighbor = verts[valenceTable[2*curri + 0 + 1]];
+                diagonal = verts[valenceTable[2*curri + 1 + 1]];
+
+                for (int j=0; j<length; ++j) {
+                    e1[vofs+j] += alpha*neighbor[j] + beta*diagonal[j];
+                }
+            }
+
+            for (int j=0; j<length; ++j) {
+                e1[vofs+j] /= 3.0f;
+            }
+        }
+    }
+
+    std::vector<float> Ep(4*length, 0.0f), Em(4*length, 0.0f),
+                       Fp(4*length, 0.0f), Fm(4*length, 0.0f),
+                       Em_ip(length), Ep_im(length);
+
+    for (int vid=0; vid<4; ++vid) {
+
+        unsigned int ip = (vid+1)%4,
+                     im = (vid+3)%4,
+                     n = abs(valences[vid]),
+                     ivalence = n;
+
+        int vofs = vid * length;
+
+        unsigned int   start =  quadOffsets[vid] & 0x00ff,
+                        prev = (quadOffsets[vid] & 0xff00) / 256,
+                          np = abs(valences[ip]),
+                          nm = abs(valences[im]),
+                     start_m =  quadOffsets[im] & 0x00ff,
+                      prev_p = (quadOffsets[ip] & 0xff00) / 256;
+
+        if (valences[ip]<-2) {
+            unsigned int j = (np + prev_p - zerothNeighbors[ip]) % np;
+            for (int k=0, ipofs=ip*length; k<length; ++k, ++ipofs) {
+                Em_ip[k] = opos[ipofs] + cosf((float(M_PI)*j)/float(np-1))*e0[ipofs] + sinf((float(M_PI)*j)/float(np-1))*e1[ipofs];
+            }
+        } else {
+            for (int k=0, ipofs=ip*length; k<length; ++k, ++ipofs) {
+                Em_ip[k] = opos[ipofs] + e0[ipofs]*csf(np-3,2*prev_p) + e1[ipofs]*csf(np-3,2*prev_p+1);
+            }
+        }
+
+        if (valences[im]<-2) {
+            unsigned int j = (nm + start_m - zerothNeighbors[im]) % nm;
+            for (int k=0, imofs=im*length; k<length; ++k, ++imofs) {
+                Ep_im[k] = opos[imofs] + cosf((float(M_PI)*j)/float(nm-1))*e0[imofs] + sinf((float(M_PI)*j)/float(nm-1))*e1[imofs];
+            }
+        } else {
+            for (int k=0, imofs=im*length; k<length; ++k, ++imofs) {
+                Ep_im[k] = opos[imofs] + e0[imofs]*csf(nm-3,2*start_m) + e1[imofs]*csf(nm-3,2*start_m+1);
+            }
+        }
+
+        if (valences[vid] < 0) {
+            n = (n-1)*2;
+        }
+        if (valences[im] < 0) {
+            nm = (nm-1)*2;
+        }
+        if (valences[ip] < 0) {
+            np = (np-1)*2;
+        }
+
+        rp = &r[vid*maxValence*length];
+
+        if (valences[vid] > 2) {
+            float s1 = 3.0f - 2.0f*csf(n-3,2)-csf(np-3,2),
+                  s2 = 2.0f*csf(n-3,2),
+                  s3 = 3.0f -2.0f*cosf(2.0f*float(M_PI)/float(n)) - cosf(2.0f*float(M_PI)/float(nm));
+
+            for (int k=0, ofs=vofs; k<length; ++k, ++ofs) {
+                Ep[ofs] = opos[ofs] + e0[ofs] * csf(n-3, 2*start) + e1[ofs]*csf(n-3, 2*start +1);
+                Em[ofs] = opos[ofs] + e0[ofs] * csf(n-3, 2*prev ) + e1[ofs]*csf(n-3, 2*prev + 1);
+                Fp[ofs] = (csf(np-3,2)*opos[ofs] + s1*Ep[ofs] + s2*Em_ip[k] + rp[start*length+k])/3.0f;
+                Fm[ofs] = (csf(nm-3,2)*opos[ofs] + s3*Em[ofs] + s2*Ep_im[k] - rp[prev*length+k])/3.0f;
+            }
+        } else if (valences[vid] < -2) {
+            unsigned int jp = (ivalence + start - zerothNeighbors[vid]) % ivalence,
+                         jm = (ivalence + prev  - zerothNeighbors[vid]) % ivalence;
+
+            float s1 = 3-2*csf(n-3,2)-csf(np-3,2),
+                  s2 = 2*csf(n-3,2),
+                  s3 = 3.0f-2.0f*cosf(2.0f*float(M_PI)/n)-cosf(2.0f*float(M_PI)/nm);
+
+            for (int k=0, ofs=vofs; k<length; ++k, ++ofs) {
+                Ep[ofs] = opos[ofs] + cosf((float(M_PI)*jp)/float(ivalence-1))*e0[ofs] + sinf((float(M_PI)*jp)/float(ivalence-1))*e1[ofs];
+                Em[ofs] = opos[ofs] + cosf((float(M_PI)*jm)/float(ivalence-1))*e0[ofs] + sinf((float(M_PI)*jm)/float(ivalence-1))*e1[ofs];
+                Fp[ofs] = (csf(np-3,2)*opos[ofs] + s1*Ep[ofs] + s2*Em_ip[k] + rp[start*length+k])/3.0f;
+                Fm[ofs] = (csf(nm-3,2)*opos[ofs] + s3*Em[ofs] + s2*Ep_im[k] - rp[prev*length+k])/3.0f;
+            }
+
+            if (valences[im]<0) {
+                s1=3-2*csf(n-3,2)-csf(np-3,2);
+                for (int k=0, ofs=vofs; k<length; ++k, ++ofs) {
+                    Fp[ofs] = Fm[ofs] = (csf(np-3,2)*opos[ofs] + s1*Ep[ofs] + s2*Em_ip[k] + rp[start*length+k])/3.0f;
+                }
+            } else if (valences[ip]<0) {
+                s1 = 3.0f-2.0f*cosf(2.0f*float(M_PI)/n)-cosf(2.0f*float(M_PI)/nm);
+                for (int k=0, ofs=vofs; k<length; ++k, ++ofs) {
+                    Fm[ofs] = Fp[ofs] = (csf(nm-3,2)*opos[ofs] + s1*Em[ofs] + s2*Ep_im[k] - rp[prev*length+k])/3.0f;
+                }
+            }
+        } else if (valences[vid]==-2) {
+            for (int k=0, ofs=vofs, ipofs=ip*length, imofs=im*length; k<length; ++k, ++ofs, ++ipofs, ++imofs) {
+                Ep[ofs] = (2.0f * org[ofs] + org[ipofs])/3.0f;
+                Em[ofs] = (2.0f * org[ofs] + org[imofs])/3.0f;
+                Fp[ofs] = Fm[ofs] = (4.0f * org[ofs] + org[((vid+2)%n)*length+k] + 2.0f * org[ipofs] + 2.0f * org[imofs])/9.0f;
+            }
+        }
+    }
+
+    // pack the 20 control points : P, Ep, Em, Fp, Fm for each corner
+    for (int vid=0, ofs=0; vid<4; ++vid, ofs+=length) {
+        std::copy(&opos[ofs], &opos[ofs]+length, points + (vid*5+0)*length);
+        std::copy(  &Ep[ofs],   &Ep[ofs]+length, points + (vid*5+1)*length);
+        std::copy(  &Em[ofs],   &Em[ofs]+length, points + (vid*5+2)*length);
+        std::copy(  &Fp[ofs],   &Fp[ofs]+length, points + (vid*5+3)*length);
+        std::copy(  &Fm[ofs],   &Fm[ofs]+length, points + (vid*5+4)*length);
+    }
+}
+
+inline void
+FarLimitStencilTablesFactory::evalCubicBSpline( float u, float B[4], float D[4] ) {
+
+    float t = u;
+    float s = 1.0f - u;
+
+    float A0 =                      s * (0.5f * s);
+    float A1 = t * (s + 0.5f * t) + s * (0.5f * s + t);
+    float A2 = t * (    0.5f * t);
+
+    B[0] =                                     1.f/3.f * s                * A0;
+    B[1] = (2.f/3.f * s +           t) * A0 + (2.f/3.f * s + 1.f/3.f * t) * A1;
+    B[2] = (1.f/3.f * s + 2.f/3.f * t) * A1 + (          s + 2.f/3.f * t) * A2;
+    B[3] =                1.f/3.f * t  * A2;
+
+    D[0] =    - A0;
+    D[1] = A0 - A1;
+    D[2] = A1 - A2;
+    D[3] = A2;
+}
+
+inline void
+FarLimitStencilTablesFactory::evalCubicBezier( float u, float B[4], float D[4] ) {
+
+    float t = u;
+    float s = 1.0f - u;
+
+    float A0 = s * s;
+    float A1 = 2 * s * t;
+    float A2 = t * t;
+
+    B[0] = s * A0;
+    B[1] = t * A0 + s * A1;
+    B[2] = t * A1 + s * A2;
+    B[3] = t * A2;
+
+    D[0] =    - A0;
+    D[1] = A0 - A1;
+    D[2] = A1 - A2;
+    D[3] = A2;
+}
+
+inline void
+FarLimitStencilTablesFactory::addBSplineWeights( FarPatchTables::Type type,
+                                                 unsigned int const * cvs,
+                                                 float s, float t,
+                                                 FarStencilTables const & vertexStencils,
+                                                 Accumulator & accumulator ) {
+
+    float Bs[4], Ds[4], Bt[4], Dt[4];
+    evalCubicBSpline(s, Bs, Ds);
+    evalCubicBSpline(t, Bt, Dt);
+
+    // weights (point, du, dv) of the control vertices : the missing vertices
+    // of the boundary and corner patches are mirrored (see evalBoundary and
+    // evalCorner in the Osd CPU limit evaluation kernels)
+    float w[16][3];
+    memset(w, 0, sizeof(w));
+
+    int ncvs = FarPatchTables::Descriptor::GetNumControlVertices(type);
+
+    for (int i=0; i<4; ++i) {
+        for (int j=0; j<4; ++j) {
+
+            float W[3] = { Bs[j]*Bt[i], Ds[j]*Bt[i], Bs[j]*Dt[i] };
+
+            // control vertices of the B-spline point (i,j) and their weights
+            int index[4] = { -1, -1, -1, -1 };
+            float scale[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+
+            if (type==FarPatchTables::REGULAR) {
+                index[0] = i+j*4;
+            } else if (type==FarPatchTables::BOUNDARY) {
+                if (j==0) {
+                    index[0] = i;    scale[0] =  2.0f;
+                    index[1] = i+4;  scale[1] = -1.0f;
+                } else {
+                    index[0] = i+(j-1)*4;
+                }
+            } else {
+                if (j==0) {
+                    if (i<3) {
+                        index[0] = i;    scale[0] =  2.0f;
+                        index[1] = i+3;  scale[1] = -1.0f;
+                    } else {
+                        // M3 = 2*M2 - M1
+                        index[0] = 2;  scale[0] =  4.0f;
+                        index[1] = 5;  scale[1] = -2.0f;
+                        index[2] = 1;  scale[2] = -2.0f;
+                        index[3] = 4;  scale[3] =  1.0f;
+                    }
+                } else if (i==3) {
+                    // M4 = 2*v2 - v1, M5 = 2*v5 - v4, M6 = 2*v8 - v7
+                    index[0] = 3*j-1;  scale[0] =  2.0f;
+                    index[1] = 3*j-2;  scale[1] = -1.0f;
+                } else {
+                    index[0] = i+(j-1)*3;
+                }
+            }
+
+            for (int k=0; k<4 and index[k]>=0; ++k) {
+                assert(index[k]<ncvs);
+                w[index[k]][0] += scale[k] * W[0];
+                w[index[k]][1] += scale[k] * W[1];
+                w[index[k]][2] += scale[k] * W[2];
+            }
+        }
+    }
+
+    for (int i=0; i<ncvs; ++i) {
+        accumulator.Add(vertexStencils.GetStencil(cvs[i]), w[i][0], w[i][1], w[i][2]);
+    }
+}
+
+inline void
+FarLimitStencilTablesFactory::addGregoryWeights( int firstPoint,
+                                                 float s, float t,
+                                                 FarStencilTables const & gregoryStencils,
+                                                 Accumulator & accumulator ) {
+
+    float Bs[4], Ds[4], Bt[4], Dt[4];
+    evalCubicBezier(s, Bs, Ds);
+    evalCubicBezier(t, Bt, Dt);
+
+    float S = 1.0f-s, T = 1.0f-t;
+
+    float d11 = s+t; if (s+t==0.0f) d11 = 1.0f;
+    float d12 = S+t; if (S+t==0.0f) d12 = 1.0f;
+    float d21 = s+T; if (s+T==0.0f) d21 = 1.0f;
+    float d22 = S+T; if (S+T==0.0f) d22 = 1.0f;
+
+    // Gregory points of the 16 Bezier points : the 4 interior points blend
+    // 2 face points (see evalGregoryPoints in the Osd CPU limit evaluation
+    // kernels)
+    static int const bezierPoints[16][2] = {
+        { 0, -1}, { 1, -1}, { 7, -1}, { 5, -1},
+        { 2, -1}, { 3,  4}, { 9,  8}, { 6, -1},
+        {16, -1}, {19, 18}, {13, 14}, {12, -1},
+        {15, -1}, {17, -1}, {11, -1}, {10, -1} };
+
+    float blend[16][2];
+    for (int i=0; i<16; ++i) {
+        blend[i][0] = 1.0f;
+        blend[i][1] = 0.0f;
+    }
+    blend[ 5][0] = s/d11;  blend[ 5][1] = t/d11;
+    blend[ 6][0] = S/d12;  blend[ 6][1] = t/d12;
+    blend[ 9][0] = s/d21;  blend[ 9][1] = T/d21;
+    blend[10][0] = S/d22;  blend[10][1] = T/d22;
+
+    float w[20][3];
+    memset(w, 0, sizeof(w));
+
+    for (int i=0; i<4; ++i) {
+        for (int j=0; j<4; ++j) {
+
+            int q = i+j*4;
+
+            float W[3] = { Bs[j]*Bt[i], Ds[j]*Bt[i], Bs[j]*Dt[i] };
+
+            for (int k=0; k<2 and bezierPoints[q][k]>=0; ++k) {
+                float * dst = w[bezierPoints[q][k]];
+                dst[0] += blend[q][k] * W[0];
+                dst[1] += blend[q][k] * W[1];
+                dst[2] += blend[q][k] * W[2];
+            }
+        }
+    }
+
+    for (int i=0; i<20; ++i) {
+        accumulator.Add(gregoryStencils.GetStencil(firstPoint+i), w[i][0], w[i][1], w[i][2]);
+    }
+}
+
+inline int
+FarLimitStencilTablesFactory::getThreadRange( int n, int & begin, int & end ) {
+
+    int thread = 0,
+        numThreads = 1;
+#ifdef OPENSUBDIV_HAS_OPENMP
+    thread = omp_get_thread_num();
+    numThreads = omp_get_num_threads();
+#endif
+    begin = (int)((long long)n * thread / numThreads);
+    end = (int)((long long)n * (thread+1) / numThreads);
+    return thread;
+}
+
+inline void
+FarLimitStencilTablesFactory::serialize( std::vector<int> const & sizes,
+                                         std::vector<Chunk> const & chunks,
+                                         bool derivs,
+                                         FarStencilTables * result ) {
+
+    int nstencils = (int)sizes.size();
+
+    result->_sizes = sizes;
+    result->_offsets.resize(nstencils);
+
+    int size=0;
+    for (int i=0; i<nstencils; ++i) {
+        result->_offsets[i] = size;
+        size += sizes[i];
+    }
+
+    result->_indices.reserve(size);
+    result->_point.reserve(size);
+    if (derivs) {
+        result->_uderiv.reserve(size);
+        result->_vderiv.reserve(size);
+    }
+
+    // the chunks hold contiguous ranges of stencils, in order
+    for (int i=0; i<(int)chunks.size(); ++i) {
+        Chunk const & chunk = chunks[i];
+        result->_indices.insert(result->_indices.end(), chunk.indices.begin(), chunk.indices.end());
+        result->_point.insert(result->_point.end(), chunk.point.begin(), chunk.point.end());
+        if (derivs) {
+            result->_uderiv.insert(result->_uderiv.end(), chunk.du.begin(), chunk.du.end());
+            result->_vderiv.insert(result->_vderiv.end(), chunk.dv.begin(), chunk.dv.end());
+        }
+    }
+    assert((int)result->_indices.size()==size);
+}
+
+inline FarStencilTables *
+FarLimitStencilTablesFactory::Create( FarPatchTables const * patchTables,
+                                      FarStencilTables const * vertexStencils,
+                                      int nsamples,
+                                      int const * faces,
+                                      float const * u,
+                                      float const * v,
+                                      int numThreads ) {
+
+    if ((not patchTables) or (not vertexStencils) or nsamples<0 or
+        (not patchTables->IsFeatureAdaptive()))
+        return 0;
+
+    numThreads = std::max(1, numThreads);
+
+    FarPatchTables::PatchArrayVector const & parrays = patchTables->GetPatchArrayVector();
+
+    FarPatchTables::PTable const & cvs = patchTables->GetPatchTable();
+
+    // the control vertices must have stencils
+    int nvertices = vertexStencils->GetNumStencils();
+    for (int i=0; i<(int)cvs.size(); ++i) {
+        if ((int)cvs[i]>=nvertices)
+            return 0;
+    }
+
+    std::vector<int> const & coarseIndices = vertexStencils->GetControlIndices();
+    int ncoarse = coarseIndices.empty() ? 0 :
+        *std::max_element(coarseIndices.begin(), coarseIndices.end()) + 1;
+
+    // index of the first Gregory patch of each patch array
+    std::vector<int> gregoryOffsets(parrays.size(), -1);
+    std::vector<int> gregoryArrays;
+
+    for (int i=0; i<(int)parrays.size(); ++i) {
+
+        FarPatchTables::Type type = parrays[i].GetDescriptor().GetType();
+
+        if (type==FarPatchTables::LOOP or type==FarPatchTables::LOOP_IRREGULAR)
+            return 0;
+
+        if (type==FarPatchTables::GREGORY or type==FarPatchTables::GREGORY_BOUNDARY) {
+            gregoryOffsets[i] = (int)gregoryArrays.size();
+            gregoryArrays.resize(gregoryArrays.size() + parrays[i].GetNumPatches(), i);
+        }
+    }
+
+    // stencils of the 20 control points of the Gregory patches
+    FarStencilTables gregoryStencils;
+
+    int ngregory = (int)gregoryArrays.size();
+    if (ngregory>0) {
+
+        std::vector<int> sizes(ngregory*20);
+        std::vector<Chunk> chunks(numThreads);
+
+        FarPatchTables::VertexValenceTable const & valenceTable =
+            patchTables->GetVertexValenceTable();
+        FarPatchTables::QuadOffsetTable const & quadOffsetTable =
+            patchTables->GetQuadOffsetTable();
+
+        int maxValence = patchTables->GetMaxValence();
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+        #pragma omp parallel num_threads(numThreads) if (numThreads > 1)
+#endif
+        {
+            int begin, end;
+            Chunk & chunk = chunks[getThreadRange(ngregory, begin, end)];
+
+            Accumulator accumulator(ncoarse);
+
+            std::vector<float> points;
+
+            for (int i=begin; i<end; ++i) {
+
+                FarPatchTables::PatchArray const & parray = parrays[gregoryArrays[i]];
+
+                int patch = i - gregoryOffsets[gregoryArrays[i]];
+
+                unsigned int const * pcvs = &cvs[parray.GetVertIndex() + patch*4];
+
+                unsigned int const * quadOffsets =
+                    &quadOffsetTable[parray.GetQuadOffsetIndex() + patch*4];
+
+                LocalVertices verts(pcvs, &valenceTable[0], maxValence);
+
+                int n = verts.GetNumVertices();
+
+                points.resize(20*n);
+
+                if (parray.GetDescriptor().GetType()==FarPatchTables::GREGORY) {
+                    computeGregoryPoints(pcvs, &valenceTable[0], quadOffsets,
+                                         maxValence, verts, &points[0]);
+                } else {
+                    computeGregoryBoundaryPoints(pcvs, &valenceTable[0], quadOffsets,
+                                                 maxValence, verts, &points[0]);
+                }
+
+                for (int j=0; j<20; ++j) {
+                    for (int k=0; k<n; ++k) {
+                        float weight = points[j*n+k];
+                        if (weight!=0.0f) {
+                            accumulator.Add(vertexStencils->GetStencil(verts.GetVertexIndex(k)),
+                                            weight);
+                        }
+                    }
+                    sizes[i*20+j] = accumulator.Flush(chunk, false);
+                }
+            }
+        }
+
+        serialize(sizes, chunks, false, &gregoryStencils);
+    }
+
+    // limit stencils of the samples
+    FarPatchMap patchMap(*patchTables);
+
+    FarPatchTables::PatchParamTable const & params = patchTables->GetPatchParamTable();
+
+    int nfaces = patchTables->GetNumPtexFaces();
+
+    std::vector<int> sizes(nsamples, 0);
+    std::vector<Chunk> chunks(numThreads);
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #pragma omp parallel num_threads(numThreads) if (numThreads > 1)
+#endif
+    {
+        int begin, end;
+        Chunk & chunk = chunks[getThreadRange(nsamples, begin, end)];
+
+        Accumulator accumulator(ncoarse);
+
+        for (int i=begin; i<end; ++i) {
+
+            if (faces[i]<0 or faces[i]>=nfaces)
+                continue;
+
+            float s = u[i],
+                  t = v[i];
+
+            FarPatchMap::Handle const * handle = patchMap.FindPatch(faces[i], s, t);
+            if (not handle)
+                continue;
+
+            // normalize & rotate (u,v) to the sub-patch
+            params[handle->patchIdx].bitField.Normalize(s, t);
+            params[handle->patchIdx].bitField.Rotate(s, t);
+
+            FarPatchTables::PatchArray const & parray = parrays[handle->patchArrayIdx];
+
+            FarPatchTables::Type type = parray.GetDescriptor().GetType();
+
+            // the patches are evaluated at (v,u), like OsdCpuEvalLimitController
+            if (type==FarPatchTables::GREGORY or type==FarPatchTables::GREGORY_BOUNDARY) {
+
+                int patch = gregoryOffsets[handle->patchArrayIdx] + handle->vertexOffset/4;
+
+                addGregoryWeights(patch*20, t, s, gregoryStencils, accumulator);
+            } else {
+
+                unsigned int const * pcvs = &cvs[parray.GetVertIndex() + handle->vertexOffset];
+
+                addBSplineWeights(type, pcvs, t, s, *vertexStencils, accumulator);
+            }
+
+            sizes[i] = accumulator.Flush(chunk, true);
+        }
+    }
+
+    (void)numThreads;
+
+    FarStencilTables * result = new FarStencilTables;
+
+    serialize(sizes, chunks, true, result);
+
+    return result;
+}
+
+template <class U> FarStencilTables *
+FarLimitStencilTablesFactory::Create( FarMesh<U> const * mesh,
+                                      int nsamples,
+                                      int const * faces,
+                                      float const * u,
+                                      float const * v,
+                                      int numThreads ) {
+
+    assert(mesh);
+
+    FarStencilTables * vertexStencils =
+        FarSubdivisionStencilTablesFactory::CreateAll(mesh->GetSubdivisionTables(),
+                                                      mesh->GetKernelBatches());
+    if (not vertexStencils)
+        return 0;
+
+    FarStencilTables * result = Create(mesh->GetPatchTables(), vertexStencils,
+                                       nsamples, faces, u, v, numThreads);
+
+    delete vertexStencils;
+
+    return result;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_LIMIT_STENCILTABLES_FACTORY_H */
@@ -30,6 +30,7 @@
 #include "../far/subdivisionTables.h"
 #include "../far/patchTables.h"
 #include "../far/vertexEditTables.h"
+#include "../far/fvarTables.h"
 #include "../far/kernelBatch.h"
 
 #include <cassert>
@@ -54,7 +55,7 @@ public:
     FarMesh(FarSubdivisionTables *subdivisionTables, FarPatchTables *patchTables,
             FarVertexEditTables *vertexEditTables, FarKernelBatchVector const &batches) :
         _subdivisionTables(subdivisionTables), _patchTables(patchTables),
-        _vertexEditTables(vertexEditTables), _batches(batches) { }
+        _vertexEditTables(vertexEditTables), _fvarTables(0), _batches(batches) { }
 
     ~FarMesh();
 
@@ -79,6 +80,10 @@ public:
     /// \brief Returns vertex edit tables
     FarVertexEditTables const * GetVertexEditTables() const { return _vertexEditTables; }
 
+    /// \brief Returns face-varying refinement tables (NULL unless requested
+    /// from the FarMeshFactory)
+    FarFVarTables const * GetFVarTables() const { return _fvarTables; }
+
     /// \brief True if the mesh tables support the feature-adaptive mode.
     bool IsFeatureAdaptive() const { return _patchTables->IsFeatureAdaptive(); }
 
@@ -92,7 +97,7 @@ private:
     // declaration of the templated vertex class U.
     template <class X, class Y> friend class FarMeshFactory;
 
-    FarMesh() : _subdivisionTables(0), _patchTables(0), _vertexEditTables(0) { }
+    FarMesh() : _subdivisionTables(0), _patchTables(0), _vertexEditTables(0), _fvarTables(0) { }
 
     // non-copyable, so these are not implemented:
     FarMesh(FarMesh<U> const &);
@@ -107,6 +112,9 @@ private:
     // hierarchical vertex edit tables
     FarVertexEditTables * _vertexEditTables;
 
+    // face-varying refinement tables
+    FarFVarTables * _fvarTables;
+
     // kernel execution batches
     FarKernelBatchVector _batches;
 
@@ -120,6 +128,7 @@ FarMesh<U>::~FarMesh()
     delete _subdivisionTables;
     delete _patchTables;
     delete _vertexEditTables;
+    delete _fvarTables;
 }
 
 } // end namespace OPENSUBDIV_VERSION
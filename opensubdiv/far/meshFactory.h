@@ -48,8 +48,10 @@
 #include "../far/patchTables.h"
 #include "../far/patchTablesFactory.h"
 #include "../far/vertexEditTablesFactory.h"
+#include "../far/fvarTablesFactory.h"
 
 #include <typeinfo>
+#include <map>
 #include <set>
 
 namespace OpenSubdiv {
@@ -97,17 +99,41 @@ public:
     ///                    controller.
     ///                    Note : NULL indicates that all kernel types are supported
     ///
+    /// @param faceIsolation  Optional maximum level of isolation for each coarse
+    ///                    face of the HbrMesh (clamped to maxlevel). The features
+    ///                    of the less important regions of the mesh can be
+    ///                    isolated less deeply, which reduces the number of
+    ///                    patches. A vertex is isolated to the highest level of
+    ///                    its incident faces. Extraordinary and sharp vertices
+    ///                    next to more refined regions are isolated further, so
+    ///                    that the limit surface stays watertight.
+    ///                    Note : faceIsolation is only applicable if adaptive is true
+    ///
     FarMeshFactory(HbrMesh<T> * mesh, int maxlevel, bool adaptive=false, int firstLevel=-1,
                    FarPatchTables::Type patchType=FarPatchTables::QUADS,
-                   const int * kernelTypes = NULL);
+                   const int * kernelTypes = NULL,
+                   std::vector<int> const * faceIsolation = NULL);
 
     /// \brief Create a table-based mesh representation
     ///
     /// @param requireFVarData create a face-varying table
     ///
+    /// @param requireFVarTables create face-varying refinement tables, so
+    ///                          that the face-varying data can be updated
+    ///                          without re-creating the mesh (implies
+    ///                          requireFVarData, not supported with Loop
+    ///                          subdivision)
+    ///
+    /// @param indexFVarData     store the face-varying data as unique values
+    ///                          and per-face-vertex indices instead of
+    ///                          duplicating it for each vertex of each face
+    ///                          (implies requireFVarData). The data is left
+    ///                          per-face-per-vertex when indexing would not
+    ///                          reduce its size (see FVarData::IsIndexed)
+    ///
     /// @return a pointer to the FarMesh created
     ///
-    FarMesh<U> * Create( bool requireFVarData=false );
+    FarMesh<U> * Create( bool requireFVarData=false, bool requireFVarTables=false, bool indexFVarData=false );
 
     /// \brief Computes the minimum number of adaptive feature isolation levels required
     /// in order for the limit surface to be an accurate representation of the
@@ -207,6 +233,7 @@ private:
     friend class FarLoopSubdivisionTablesFactory<T,U>;
     friend class FarSubdivisionTablesFactory<T,U>;
     friend class FarVertexEditTablesFactory<T,U>;
+    friend class FarFVarTablesFactory<T,U>;
     friend class FarPatchTablesFactory<T>;
 
     template <class X> struct VertCompare {
@@ -249,11 +276,25 @@ private:
     // Calls Hbr to refines the neighbors of v
     static void refineVertexNeighbors(HbrVertex<T> * v);
 
+    // True if the boundary vertices of the coarse quad face f match one of
+    // the boundary configurations of the patches
+    static bool coarseFaceIsPatch(HbrFace<T> * f);
+
+    // Returns the vertex of the quad face f that must be isolated further
+    // if f is next to a more refined face, NULL otherwise : an extraordinary
+    // vertex or a single boundary vertex (Gregory patches have no transition
+    // patterns), or a vertex with sharp edges that were not isolated (the
+    // patches ignore the sharpness, so they depend on their level)
+    static HbrVertex<T> * getIsolationVertex(HbrFace<T> * f);
+
+    // True if a face that shares an edge with f is tagged for refinement
+    static bool faceHasTaggedNeighbors(HbrFace<T> * f);
+
     // Uniformly refine the Hbr mesh
     static void refine( HbrMesh<T> * mesh, int maxlevel );
 
     // Adaptively refine the Hbr mesh
-    int refineAdaptive( HbrMesh<T> * mesh, int maxIsolate );
+    int refineAdaptive( HbrMesh<T> * mesh, int maxIsolate, std::vector<int> const * faceIsolation=0 );
 
     typedef std::vector<std::vector< HbrFace<T> *> > FacesList;
 
@@ -370,8 +411,11 @@ FarMeshFactory<T,U>::ComputeMinIsolation( HbrMesh<T> const * mesh, int nfaces, i
         int nv = f->GetNumVertices();
         for (int j=0; j<nv; ++j) {
 
+            // Regular infinitely sharp creases are evaluated as boundary
+            // patches and do not need isolation
             HbrHalfedge<T> * e = f->GetEdge(j);
-            if (not e->IsBoundary())
+            if (not e->IsBoundary() and
+                (not FarPatchTablesFactory<T>::edgeIsRegularCrease(e)))
                 sharpmax = std::max( sharpmax, f->GetEdge(j)->GetSharpness() );
         }
     }
@@ -395,6 +439,11 @@ FarMeshFactory<T,U>::vertexIsBSpline( HbrVertex<T> * v, bool next ) {
 
     int valence = v->GetValence();
 
+    // Loop meshes have no boundary patches : boundary vertices are isolated
+    // like extraordinary vertices
+    if (isLoop(v->GetMesh()))
+        return not (v->OnBoundary() or v->IsExtraordinary() or v->IsSharp(next));
+
     // Boundary & corner vertices
     if (v->OnBoundary()) {
         if (valence==2) {
@@ -460,6 +509,15 @@ FarMeshFactory<T,U>::refineVertexNeighbors(HbrVertex<T> * v) {
             if (lft)
                 lft->_adaptiveFlags.isTagged=true;
 
+            // Loop : refining the vertices of a triangle does not create its
+            // middle child
+            if (isLoop(v->GetMesh())) {
+                if (rgt and (not rgt->IsHole()))
+                    rgt->Refine();
+                if (lft and (not lft->IsHole()))
+                    lft->Refine();
+            }
+
             HbrHalfedge<T> * istart = next,
                            * inext = istart;
             do {
@@ -473,13 +531,83 @@ FarMeshFactory<T,U>::refineVertexNeighbors(HbrVertex<T> * v) {
 }
 
 
+template <class T, class U> bool
+FarMeshFactory<T,U>::coarseFaceIsPatch(HbrFace<T> * f) {
+
+    // Loop triangles are always either regular or irregular patches
+    if (f and f->GetNumVertices()==3)
+        return true;
+
+    assert(f and f->GetNumVertices()==4);
+
+    int bverts=0, bedges=0;
+    for (int i=0; i<4; ++i) {
+        if (f->GetVertex(i)->OnBoundary())
+            ++bverts;
+        if (f->GetEdge(i)->IsBoundary())
+            ++bedges;
+    }
+
+    switch (bverts) {
+        case 0 :
+        case 1 : return true;   // regular or Gregory patch
+        case 2 : return bedges==1;
+        case 3 : return bedges==2;
+        default : return false;
+    }
+}
+
+template <class T, class U> HbrVertex<T> *
+FarMeshFactory<T,U>::getIsolationVertex(HbrFace<T> * f) {
+
+    assert(f and f->GetNumVertices()==4);
+
+    HbrVertex<T> * bvert=0;
+    int bverts=0;
+    for (int i=0; i<4; ++i) {
+        HbrVertex<T> * v = f->GetVertex(i);
+        if (v->OnBoundary()) {
+            if (v->IsSingular() or v->GetValence()>3)
+                return v;
+            bvert = v;
+            ++bverts;
+        } else if (v->IsExtraordinary() or v->GetSharpness()>HbrVertex<T>::k_Smooth)
+            return v;
+
+        HbrHalfedge<T> * start = v->GetIncidentEdge(), * e = start;
+        while (e) {
+            if (e->GetSharpness()>HbrHalfedge<T>::k_Smooth and (not e->IsBoundary()) and
+                (not FarPatchTablesFactory<T>::edgeIsRegularCrease(e)))
+                return v;
+            if ((e = v->GetNextEdge(e))==start)
+                break;
+        }
+    }
+    return bverts==1 ? bvert : 0;
+}
+
+template <class T, class U> bool
+FarMeshFactory<T,U>::faceHasTaggedNeighbors(HbrFace<T> * f) {
+
+    assert(f);
+
+    for (int i=0; i<f->GetNumVertices(); ++i) {
+        HbrHalfedge<T> * e = f->GetEdge(i)->GetOpposite();
+        if (e and e->GetFace() and e->GetFace()->_adaptiveFlags.isTagged)
+            return true;
+    }
+    return false;
+}
+
 // Refines an Hbr Catmark mesh adaptively around extraordinary features
 template <class T, class U> int
-FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
+FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate, std::vector<int> const * faceIsolation ) {
 
     int ncoarsefaces = mesh->GetNumCoarseFaces(),
         ncoarseverts = mesh->GetNumVertices();
 
+    bool loop = isLoop(mesh);
+
     // First pass : tag coarse vertices & faces that need refinement
 
     typedef std::set<HbrVertex<T> *,VertCompare<T> > VertSet;
@@ -514,8 +642,10 @@ FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
             HbrHalfedge<T> * e = f->GetEdge(j);
             assert(e);
 
-            // Tag sharp edges for refinement
-            if (e->IsSharp(true) and (not e->IsBoundary())) {
+            // Tag sharp edges for refinement (faces along regular infinitely
+            // sharp creases are boundary patches and don't need isolation)
+            if (e->IsSharp(true) and (not e->IsBoundary()) and
+                (not FarPatchTablesFactory<T>::edgeIsRegularCrease(e))) {
                 nextverts.insert(e->GetOrgVertex());
                 nextverts.insert(e->GetDestVertex());
 
@@ -558,11 +688,93 @@ FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
                     }
                 }
             }
+
+            // Same for quad-faces along a regular crease that have a second
+            // crease edge or a boundary vertex
+            if ( (not f->_adaptiveFlags.isTagged) and nv==4 and
+                 FarPatchTablesFactory<T>::edgeIsRegularCrease(e) ) {
+
+                bool isolate = FarPatchTablesFactory<T>::edgeIsRegularCrease(f->GetEdge((j+2)%4));
+                for (int k=0; k<4; ++k)
+                    isolate |= f->GetVertex(k)->OnBoundary();
+
+                if (isolate) {
+                    f->_adaptiveFlags.isTagged=true;
+                    for (int k=0; k<4; ++k) {
+                        HbrVertex<T> * v = f->GetVertex(k);
+                        v->_adaptiveFlags.isTagged=true;
+                        nextverts.insert(v);
+                    }
+                }
+            }
         }
         _maxValence = std::max(_maxValence, nv);
     }
 
 
+    // Isolation budgets : each vertex is isolated up to the highest level
+    // requested by its incident coarse faces. The budgets are propagated to
+    // the child vertices tagged for refinement.
+    typedef std::map<HbrVertex<T> *, int> BudgetMap;
+    BudgetMap budgets;
+
+    struct Budget {
+        static void tag(VertSet & verts, BudgetMap * budgets, HbrVertex<T> * v, int budget) {
+            verts.insert(v);
+            if (budgets) {
+                int & b = (*budgets)[v];
+                b = std::max(b, budget);
+            }
+        }
+    };
+
+    BudgetMap * vbudgets = faceIsolation ? &budgets : 0;
+
+    std::vector<int> fbudgets(faceIsolation ? ncoarsefaces : 0, maxIsolate);
+
+    if (faceIsolation) {
+
+        assert((int)faceIsolation->size()>=ncoarsefaces);
+
+        for (int i=0; i<ncoarsefaces; ++i) {
+            HbrFace<T> * f = mesh->GetFace(i);
+
+            if (f->IsHole())
+                continue;
+
+            int budget = std::max(0, std::min((*faceIsolation)[i], maxIsolate));
+
+            // Non-quad faces, faces tagged as 2-boundary or crease patches and
+            // faces with boundary vertices that do not match a boundary or a
+            // corner patch cannot be represented by a patch at the coarse level
+            if (f->_adaptiveFlags.isTagged or
+                mesh->GetSubdivision()->FaceIsExtraordinary(mesh,f) or
+                (not coarseFaceIsPatch(f)))
+                budget = std::max(budget, std::min(1, maxIsolate));
+
+            // Hierarchical edits are always applied at full resolution
+            if (f->HasVertexEdits())
+                budget = maxIsolate;
+
+            fbudgets[i] = budget;
+
+            for (int j=0; j<f->GetNumVertices(); ++j) {
+                int & b = budgets[f->GetVertex(j)];
+                b = std::max(b, budget);
+            }
+        }
+
+        // Un-tag the coarse vertices that do not need to be isolated
+        for (typename VertSet::iterator i=nextverts.begin(); i!=nextverts.end(); ) {
+            if (budgets[*i]==0) {
+                (*i)->_adaptiveFlags.isTagged=false;
+                nextverts.erase(i++);
+            } else
+                ++i;
+        }
+    }
+
+
     // Second pass : refine adaptively around singularities
 
     for (int level=0; level<maxIsolate; ++level) {
@@ -576,6 +788,11 @@ FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
             HbrVertex<T> * v = *i;
             assert(v);
 
+            // Skip vertices that have exhausted their isolation budget
+            int budget = vbudgets ? budgets[v] : maxIsolate;
+            if (level>=budget)
+                continue;
+
             if (level>0)
                 v->_adaptiveFlags.isTagged=true;
             else
@@ -585,7 +802,7 @@ FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
 
             // Tag non-BSpline vertices for refinement
             if (not vertexIsBSpline(v, true))
-                nextverts.insert(v->Subdivide());
+                Budget::tag(nextverts, vbudgets, v->Subdivide(), budget);
 
             // Refine edges with creases or edits
             int valence = v->GetValence();
@@ -595,14 +812,29 @@ FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
             for (int j=0; j<valence; ++j) {
 
                 // Skip edges that have already been processed (HasChild())
-                if ((not e->HasChild()) and e->IsSharp(false) and (not e->IsBoundary())) {
+                if ((not e->HasChild()) and e->IsSharp(false) and (not e->IsBoundary()) and
+                    (not FarPatchTablesFactory<T>::edgeIsRegularCrease(e))) {
 
                     if (not e->IsInsideHole()) {
-                        nextverts.insert( e->Subdivide() );
-                        nextverts.insert( e->GetOrgVertex()->Subdivide() );
-                        nextverts.insert( e->GetDestVertex()->Subdivide() );
+                        Budget::tag(nextverts, vbudgets, e->Subdivide(), budget);
+
+                        // The faces around the other end of the edge are not
+                        // refined if its budget is exhausted : don't isolate
+                        // its child either.
+                        HbrVertex<T> * org = e->GetOrgVertex(),
+                                     * dst = e->GetDestVertex();
+                        if (org==v or (not vbudgets) or budgets[org]>level)
+                            Budget::tag(nextverts, vbudgets, org->Subdivide(), budget);
+                        if (dst==v or (not vbudgets) or budgets[dst]>level)
+                            Budget::tag(nextverts, vbudgets, dst->Subdivide(), budget);
                     }
                 }
+
+                // Loop : there are no boundary patches, so the boundaries
+                // are isolated all the way
+                if (loop and e->IsBoundary() and (not e->IsInsideHole()))
+                    Budget::tag(nextverts, vbudgets, e->Subdivide(), budget);
+
                 HbrHalfedge<T> * next = v->GetNextEdge(e);
                 e = next ? next : e->GetPrev();
             }
@@ -616,7 +848,7 @@ FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
                 if (f->HasVertexEdits()) {
                     int nv = f->GetNumVertices();
                     for (int k=0; k<nv; ++k)
-                        nextverts.insert( f->GetVertex(k) );
+                        Budget::tag(nextverts, vbudgets, f->GetVertex(k), budget);
                 }
                 if ((childedge = childvert->GetNextEdge(childedge)) == NULL)
                     break;
@@ -630,7 +862,69 @@ FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
                 assert (f->IsCoarse());
 
                 if (mesh->GetSubdivision()->FaceIsExtraordinary(mesh,f))
-                    nextverts.insert( f->Subdivide() );
+                    Budget::tag(nextverts, vbudgets, f->Subdivide(),
+                        vbudgets ? fbudgets[i] : maxIsolate);
+            }
+        }
+
+        // When a vertex has exhausted its isolation budget, the faces around
+        // it that are Gregory patches or that approximate sharp features
+        // cannot be left next to a refined neighbor. Isolate the vertex one
+        // more level, so that the neighbors of its refined faces become
+        // transition patches.
+        if (vbudgets and (not loop)) {
+
+            std::vector<HbrFace<T> *> faces;
+            for (int i=0, nfaces=mesh->GetNumFaces(); i<nfaces; ++i) {
+                HbrFace<T> * f = mesh->GetFace(i);
+                if (f->GetDepth()==level and f->GetNumVertices()==4 and
+                    (not f->IsHole()) and getIsolationVertex(f))
+                    faces.push_back(f);
+            }
+
+            // refining the faces around a vertex can create new mismatches
+            for (bool refined=true; refined; ) {
+                refined=false;
+                for (int i=0; i<(int)faces.size(); ++i) {
+
+                    HbrFace<T> * f = faces[i];
+                    if (f->_adaptiveFlags.isTagged or (not faceHasTaggedNeighbors(f)))
+                        continue;
+
+                    HbrVertex<T> * v = getIsolationVertex(f);
+
+                    if (level>0)
+                        v->_adaptiveFlags.isTagged=true;
+                    else
+                        v->_adaptiveFlags.wasTagged=true;
+
+                    refineVertexNeighbors(v);
+
+                    budgets[v] = std::max(budgets[v], level+1);
+                    Budget::tag(nextverts, vbudgets, v->Subdivide(), level+1);
+
+                    refined=true;
+                }
+            }
+        }
+    }
+
+    // Loop patches have no transitions : make sure that the 1-ring of every
+    // patch is refined to the level of the patch.
+    if (loop) {
+
+        std::vector<HbrFace<T> *> patches;
+        for (int i=0, nfaces=mesh->GetNumFaces(); i<nfaces; ++i) {
+            HbrFace<T> * f = mesh->GetFace(i);
+            if (FarPatchTablesFactory<T>::loopFaceIsPatch(f))
+                patches.push_back(f);
+        }
+
+        for (int i=0; i<(int)patches.size(); ++i) {
+            for (int j=0; j<patches[i]->GetNumVertices(); ++j) {
+                HbrVertex<T> * v = patches[i]->GetVertex(j);
+                v->GuaranteeNeighbors();
+                _maxValence = std::max(_maxValence, v->GetValence());
             }
         }
     }
@@ -642,7 +936,8 @@ FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
 // gather the counters needed to generate the indexing tables.
 template <class T, class U>
 FarMeshFactory<T,U>::FarMeshFactory( HbrMesh<T> * mesh, int maxlevel, bool adaptive,
-    int firstlevel, FarPatchTables::Type patchType, const int * kernelTypes ) :
+    int firstlevel, FarPatchTables::Type patchType, const int * kernelTypes,
+    std::vector<int> const * faceIsolation ) :
     _hbrMesh(mesh),
     _adaptive(adaptive),
     _maxlevel(maxlevel),
@@ -674,7 +969,7 @@ FarMeshFactory<T,U>::FarMeshFactory( HbrMesh<T> * mesh, int maxlevel, bool adapt
     // Note : using a placeholder vertex class 'T' can greatly speed up the
     // topological analysis if the interpolation results are not used.
     if (adaptive)
-        _maxlevel=refineAdaptive( mesh, maxlevel );
+        _maxlevel=refineAdaptive( mesh, maxlevel, faceIsolation );
     else
         refine( mesh, maxlevel);
 
@@ -763,7 +1058,7 @@ getNumPtexFaces(HbrMesh<T> const * hmesh) {
 }
 
 template <class T, class U> FarMesh<U> *
-FarMeshFactory<T,U>::Create( bool requireFVarData ) {
+FarMeshFactory<T,U>::Create( bool requireFVarData, bool requireFVarTables, bool indexFVarData ) {
 
     assert( GetHbrMesh() );
 
@@ -791,7 +1086,15 @@ FarMeshFactory<T,U>::Create( bool requireFVarData ) {
             copyVertex(result->_vertices[i], GetHbrMesh()->GetVertex(i)->GetData());
     }
 
-    int fvarwidth = requireFVarData ? _hbrMesh->GetTotalFVarWidth() : 0;
+    int fvarwidth = (requireFVarData or requireFVarTables or indexFVarData) ? _hbrMesh->GetTotalFVarWidth() : 0;
+
+    // XXXX face-varying data is not supported yet with adaptive Loop patches
+    if (isAdaptive() and isLoop(GetHbrMesh()))
+        fvarwidth = 0;
+
+    bool requireFVarSources = requireFVarTables or indexFVarData;
+
+    typename FarPatchTablesFactory<T>::FVarSourceVector fvarSources;
 
     // Create the element indices tables (patches for adaptive, quads for non-adaptive)
     if (isAdaptive()) {
@@ -799,13 +1102,24 @@ FarMeshFactory<T,U>::Create( bool requireFVarData ) {
         FarPatchTablesFactory<T> factory(GetHbrMesh(), _numFaces, _remapTable);
 
         // XXXX: currently PatchGregory shader supports up to 29 valence
-        result->_patchTables = factory.Create(_maxValence, _numPtexFaces, fvarwidth);
+        result->_patchTables = factory.Create(_maxValence, _numPtexFaces, fvarwidth,
+                                              requireFVarSources ? &fvarSources : 0);
 
     } else {
-        result->_patchTables = FarPatchTablesFactory<T>::Create(GetHbrMesh(), _facesList, _remapTable, _firstlevel, _patchType, _numPtexFaces, fvarwidth );
+        result->_patchTables = FarPatchTablesFactory<T>::Create(GetHbrMesh(), _facesList, _remapTable, _firstlevel, _patchType, _numPtexFaces, fvarwidth,
+                                                                requireFVarSources ? &fvarSources : 0);
     }
     assert( result->_patchTables );
 
+    if (indexFVarData) {
+        FarPatchTablesFactory<T>::indexFVarData( result->_patchTables, fvarSources, /*mergeValues*/ not requireFVarTables );
+    }
+
+    // Create FVarTables if requested
+    if (requireFVarTables and fvarwidth>0) {
+        result->_fvarTables = FarFVarTablesFactory<T,U>::Create( this, fvarSources );
+    }
+
     // Create VertexEditTables if necessary
     if (GetHbrMesh()->HasVertexEdits()) {
         result->_vertexEditTables = FarVertexEditTablesFactory<T,U>::Create( this, result, &result->_batches, GetMaxLevel() );
@@ -44,6 +44,10 @@ namespace OPENSUBDIV_VERSION {
 /// parametric location, can efficiently return a handle to the sub-patch that
 /// contains this location.
 ///
+/// The patches of adaptive Loop meshes are triangles : each node of the tree
+/// then has the 4 children of a Loop triangle (3 corner triangles and the
+/// flipped middle triangle).
+///
 class FarPatchMap {
 public:
 
@@ -64,6 +68,10 @@ public:
     /// Note : the faceid corresponds to quadrangulated face indices (ie. quads
     /// count as 1 index, non-quads add as many indices as they have vertices)
     ///
+    /// Note : the (u,v) locations of Loop meshes are the barycentric
+    /// coordinates of the 2nd and 3rd vertices of the coarse triangle
+    /// (u+v <= 1)
+    ///
     /// @param faceid  The index of the face
     ///
     /// @param u       Local u parameter
@@ -117,13 +125,33 @@ private:
     //
     template <class T> static int resolveQuadrant(T & median, T & u, T & v);
 
+    // transforms the (u,v) to the local coordinates of the child triangle
+    // they point to, and returns the index of the child.
+    //
+    // Children indexing (the middle triangle 3 is flipped):
+    //
+    //   (0,1) o
+    //         | .
+    //         |  2 .
+    //         |      .
+    //         o-------o
+    //         | .  3  | .
+    //         |  0 .  |  1 .
+    //         |      .|      .
+    //   (0,0) o-------o-------o (1,0)
+    //
+    static int resolveTriangle(float & u, float & v);
+
     std::vector<Handle>   _handles;  // all the patches in the FarPatchTable
     std::vector<QuadNode> _quadtree; // quadtree nodes
+
+    bool _triangles;                 // true if the patches are Loop triangles
 };
 
 // Constructor
 inline
-FarPatchMap::FarPatchMap( FarPatchTables const & patchTables ) {
+FarPatchMap::FarPatchMap( FarPatchTables const & patchTables ) :
+    _triangles(false) {
     initialize( patchTables );
 }
 
@@ -180,6 +208,31 @@ FarPatchMap::resolveQuadrant(T & median, T & u, T & v) {
     return quadrant;
 }
 
+// transforms the (u,v) to the child triangle they point to, and return the
+// index of the child.
+inline int
+FarPatchMap::resolveTriangle(float & u, float & v) {
+
+    if (u>=0.5f) {
+        u = 2.0f*u - 1.0f;
+        v = 2.0f*v;
+        return 1;
+    }
+    if (v>=0.5f) {
+        u = 2.0f*u;
+        v = 2.0f*v - 1.0f;
+        return 2;
+    }
+    if (u+v<0.5f) {
+        u = 2.0f*u;
+        v = 2.0f*v;
+        return 0;
+    }
+    u = 1.0f - 2.0f*u;
+    v = 1.0f - 2.0f*v;
+    return 3;
+}
+
 /// Returns a handle to the sub-patch of the face at the given (u,v).
 inline FarPatchMap::Handle const * 
 FarPatchMap::FindPatch( int faceid, float u, float v ) const {
@@ -198,7 +251,8 @@ FarPatchMap::FindPatch( int faceid, float u, float v ) const {
 
         float delta = half * 0.5f;
         
-        int quadrant = resolveQuadrant( half, u, v );
+        int quadrant = _triangles ? resolveTriangle( u, v ) :
+                                    resolveQuadrant( half, u, v );
         assert(quadrant>=0);
         
         // is the quadrant a hole ?
@@ -240,6 +294,10 @@ FarPatchMap::initialize( FarPatchTables const & patchTables ) {
         FarPatchTables::PatchArray const & parray = patchArrays[arrayIdx];
 
         int ringsize = parray.GetDescriptor().GetNumControlVertices();
+
+        FarPatchTables::Type type = parray.GetDescriptor().GetType();
+        if (type==FarPatchTables::LOOP or type==FarPatchTables::LOOP_IRREGULAR)
+            _triangles = true;
         
         for (unsigned int j=0; j < parray.GetNumPatches(); ++j) {
             
@@ -287,6 +345,45 @@ FarPatchMap::initialize( FarPatchTables const & patchTables ) {
                 node->SetChild( handleIdx );
                 continue;
             } 
+
+            if (_triangles) {
+                // Loop triangles : recover the path of child triangles from
+                // the parametric location of the sub-patch (see
+                // FarPatchTablesFactory::computeLoopPatchParam)
+                assert(depth<16);
+                unsigned char path[16];
+
+                int a = bits.GetU(),
+                    b = bits.GetV(),
+                    sign = 1;
+
+                if (bits.GetRotation()==2) {
+                    // flipped triangle
+                    ++a; ++b;
+                    sign = -1;
+                }
+
+                for (int k=depth-1; k>=0; --k) {
+                    path[k] = (unsigned char)((a&1) | ((b&1)<<1));
+                    if (path[k]==3)
+                        sign = -sign;
+                    a = (a - ((a&1) ? sign : 0)) / 2;
+                    b = (b - ((b&1) ? sign : 0)) / 2;
+                }
+                assert(a==0 and b==0 and sign==1);
+
+                for (unsigned char k=0; k<depth; ++k) {
+                    if (k==depth-1) {
+                        assert( not node->children[path[k]].isSet );
+                        node->SetChild(path[k], handleIdx, true);
+                    } else if (not node->children[path[k]].isSet) {
+                        node = addChild(quadtree, node, path[k]);
+                    } else {
+                        node = &(quadtree[ node->children[path[k]].idx ]);
+                    }
+                }
+                continue;
+            }
                   
             int u = bits.GetU(),
                 v = bits.GetV(),
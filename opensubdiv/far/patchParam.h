@@ -54,6 +54,10 @@ namespace OPENSUBDIV_VERSION {
 /// Note : the bitfield is not expanded in the struct due to differences in how
 ///        GPU & CPU compilers pack bit-fields and endian-ness.
 ///
+/// Note : the sub-patches of Loop meshes are triangles that cover half of the
+///        (u,v) square set by the bitfield : the middle child triangles of
+///        the Loop refinement are flipped, which is encoded as 2 rotations.
+///
 struct FarPatchParam {
     unsigned int faceIndex:32; // Ptex face index
     
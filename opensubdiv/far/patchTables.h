@@ -60,13 +60,15 @@ public:
         QUADS,             ///< bilinear quads-only patches
         TRIANGLES,         ///< bilinear triangles-only mesh
 
-        LOOP,              ///< Loop patch  (unsupported)
+        LOOP,              ///< feature-adaptive quartic box-spline triangles
 
         REGULAR,           ///< feature-adaptive bicubic patches
         BOUNDARY,
         CORNER,
         GREGORY,
-        GREGORY_BOUNDARY
+        GREGORY_BOUNDARY,
+
+        LOOP_IRREGULAR     ///< feature-adaptive Loop extraordinary triangles
     };
 
     enum TransitionPattern {
@@ -93,6 +95,10 @@ public:
     ///   also further distinguished by a transition pattern as well as a rotational
     ///   orientation.
     ///
+    /// * Adaptively subdivided Loop meshes contain triangular patches of types
+    ///   LOOP (regular quartic box-splines) and LOOP_IRREGULAR (approximation
+    ///   of the triangles with an extraordinary or a boundary vertex)
+    ///
     /// An iterator class is provided as a convenience to enumerate over the set
     /// of valid feature adaptive patch descriptors.
     ///
@@ -153,7 +159,6 @@ public:
         ///        LINES
         ///        QUADS
         ///        TRIANGLES
-        ///        LOOP
         ///
         /// FEATURE_ADAPTIVE_CATMARK order:
         ///
@@ -172,19 +177,27 @@ public:
         ///                   CORNER   ROT0 ROT1 ROT2 ROT3 )
         ///        ...
         ///
+        /// FEATURE_ADAPTIVE_LOOP order:
+        ///
+        ///       NON_TRANSITION ( LOOP
+        ///                         LOOP_IRREGULAR )
+        ///
         ///        NON_TRANSITION NON_PATCH ROT0 (end)
         ///
         class iterator;
 
         enum PrimType {
             ANY,
-            FEATURE_ADAPTIVE_CATMARK
+            FEATURE_ADAPTIVE_CATMARK,
+            FEATURE_ADAPTIVE_LOOP
         };
 
         /// \brief Returns a patch type iterator
         /// @param type       if type=ANY then the iterater points to type POINTS
         ///                   if type=FEATURE_ADAPTIVE_CATMARK then the iterator
         ///                   points to type NON_TRANSITION REGULAR
+        ///                   if type=FEATURE_ADAPTIVE_LOOP then the iterator
+        ///                   points to type NON_TRANSITION LOOP
         static iterator begin(PrimType type);
 
         /// \brief Returns an iterator to the end of the list of patch types (NON_PATCH)
@@ -310,6 +323,9 @@ public:
     ///
     /// @param maxValence       Highest vertex valence allowed in the mesh
     ///
+    /// @param fvarIndices      Optional face varying indices : if not NULL,
+    ///                         fvarData holds the unique face-varying values
+    ///
     FarPatchTables(PatchArrayVector const & patchArrays,
                    PTable const & patches,
                    VertexValenceTable const * vertexValences,
@@ -317,7 +333,8 @@ public:
                    PatchParamTable const * patchParams,
                    std::vector<float> const * fvarData,
                    int fvarWidth,
-                   int maxValence);
+                   int maxValence,
+                   std::vector<unsigned int> const * fvarIndices=0);
 
     /// \brief Get the table of patch control vertices
     PTable const & GetPatchTable() const { return _patches; }
@@ -366,7 +383,7 @@ public:
     ///
     int GetNumFaces(int level=0) const;
 
-    /// \brief Returns a vertex valence table used by Gregory patches
+    /// \brief Returns a vertex valence table used by Gregory and irregular Loop patches
     VertexValenceTable const & GetVertexValenceTable() const { return _vertexValenceTable; }
 
     /// \brief Returns a quad offsets table used by Gregory patches
@@ -387,6 +404,12 @@ public:
     /// \brief Ringsize of Gregory (and Gregory Boundary) Patches in table.
     static short GetGregoryPatchRingsize() { return 4; }
 
+    /// \brief Ringsize of Loop (box-spline) Patches in table.
+    static short GetLoopPatchRingsize() { return 12; }
+
+    /// \brief Ringsize of irregular Loop Patches in table.
+    static short GetLoopIrregularPatchRingsize() { return 3; }
+
     /// \brief Returns the total number of patches stored in the tables
     int GetNumPatches() const;
 
@@ -427,13 +450,62 @@ public:
         /// @param level  the level of subdivision of the faces (returns the highest
         ///               level by default) **Uniform subdivision only**
         ///
+        /// Note : returns NULL if the data is indexed (see IsIndexed())
+        ///
         float const * GetData(int level=0) const;
 
         /// \brief Returns a vector of floats containing the face-varying data attached
+        /// (empty if the data is indexed, see IsIndexed())
         std::vector<float> const & GetAllData() const {
             return _data;
         }
 
+        /// \brief Returns true if the face-varying data is indexed : instead of
+        /// being duplicated for each vertex of each face, the unique values are
+        /// stored once in GetValues() and referenced by GetIndices(). Indexing
+        /// is skipped when it would not reduce the size of the data.
+        bool IsIndexed() const {
+            return not _indices.empty();
+        }
+
+        /// \brief Returns the unique face-varying values (indexed data only)
+        std::vector<float> const & GetValues() const {
+            return _values;
+        }
+
+        /// \brief Returns the index of the value of each vertex of each face
+        /// (indexed data only), with the same layout as GetAllData() : e.g.
+        /// unsigned int[p][4] for quads.
+        std::vector<unsigned int> const & GetIndices() const {
+            return _indices;
+        }
+
+        /// \brief Returns the number of vertices of the faces (4 or 3 per face)
+        int GetNumVertices() const {
+            return IsIndexed() ? (int)_indices.size() :
+                (_fvarWidth>0 ? (int)_data.size()/_fvarWidth : 0);
+        }
+
+        /// \brief Returns the data of the vertex at index 'vert' in either storage
+        float const * GetVertexData(int vert) const {
+            return IsIndexed() ? &_values[_indices[vert]*_fvarWidth] :
+                                 &_data[vert*_fvarWidth];
+        }
+
+        /// \brief Returns the number of levels of subdivision stored in the data
+        int GetNumLevels() const {
+            return _offsets.empty() ? 1 : (int)_offsets.size();
+        }
+
+        /// \brief Expands the face-varying data into the layout of GetAllData()
+        void ExpandData(std::vector<float> & data) const;
+
+        /// \brief Returns the memory footprint of the face-varying data (in bytes)
+        int GetMemoryUsage() const {
+            return (int)(_data.size()*sizeof(float) + _values.size()*sizeof(float) +
+                         _indices.size()*sizeof(unsigned int));
+        }
+
         /// \brief Returns the width of the interleaved face-varying data
         int GetFVarWidth() const {
             return _fvarWidth;
@@ -446,11 +518,16 @@ public:
 
         FVarData() : _fvarWidth(0) { }
         
-        inline FVarData( std::vector<float> const * data, int fvarWidth );
+        inline FVarData( std::vector<float> const * data, int fvarWidth,
+                         std::vector<unsigned int> const * indices=0 );
 
         std::vector<float> _data;      // face-varying data stored per-face-per-vertex
         std::vector<int>   _offsets;   // a vector of offsets if multiple leves of
                                        // subdivision are stored in _data
+
+        std::vector<float>        _values;  // indexed data : unique values and
+        std::vector<unsigned int> _indices; // index of each vertex of each face
+
         int                _fvarWidth; // width of the face-varying data
     };
     
@@ -574,10 +651,10 @@ FarPatchTables::Descriptor::GetAllValidDescriptors() {
     static std::vector<Descriptor> _descriptors;
 
     if (_descriptors.empty()) {
-        _descriptors.reserve(55);
+        _descriptors.reserve(56);
 
         // non-patch primitives
-        for (int i=POINTS; i<=LOOP; ++i) {
+        for (int i=POINTS; i<=TRIANGLES; ++i) {
             _descriptors.push_back( Descriptor(i, NON_TRANSITION, 0) );
         }
 
@@ -600,6 +677,10 @@ FarPatchTables::Descriptor::GetAllValidDescriptors() {
                 _descriptors.push_back( Descriptor(CORNER, i, j) );
             }
         }
+
+        // Loop patches
+        _descriptors.push_back( Descriptor(LOOP, NON_TRANSITION, 0) );
+        _descriptors.push_back( Descriptor(LOOP_IRREGULAR, NON_TRANSITION, 0) );
     }
 
     return _descriptors;
@@ -613,6 +694,8 @@ FarPatchTables::Descriptor::begin(PrimType type) {
             return iterator( Descriptor(POINTS, NON_TRANSITION, 0) );
         case FEATURE_ADAPTIVE_CATMARK:
             return iterator( Descriptor(REGULAR, NON_TRANSITION, 0) );
+        case FEATURE_ADAPTIVE_LOOP:
+            return iterator( Descriptor(LOOP, NON_TRANSITION, 0) );
         default:
             return iterator( Descriptor() );
     }
@@ -633,10 +716,11 @@ FarPatchTables::FarPatchTables(PatchArrayVector const & patchArrays,
                                PatchParamTable const * patchParams,
                                std::vector<float> const * fvarData,
                                int fvarWidth,
-                               int maxValence) :
+                               int maxValence,
+                               std::vector<unsigned int> const * fvarIndices) :
     _patchArrays(patchArrays),
     _patches(patches),
-    _fvarData(fvarData, fvarWidth),
+    _fvarData(fvarData, fvarWidth, fvarIndices),
     _maxValence(maxValence),
     _numPtexFaces(0) {
 
@@ -652,8 +736,9 @@ FarPatchTables::FarPatchTables(PatchArrayVector const & patchArrays,
 inline bool
 FarPatchTables::IsFeatureAdaptive() const {
 
-    // the vertex valence table is only used by Gregory patches, so the PatchTables
-    // contain feature adaptive patches if this is not empty.
+    // the vertex valence table is only used by Gregory and irregular Loop
+    // patches, so the PatchTables contain feature adaptive patches if this is
+    // not empty.
     if (not _vertexValenceTable.empty())
         return true;
 
@@ -662,8 +747,10 @@ FarPatchTables::IsFeatureAdaptive() const {
     // otherwise, we have to check each patch array
     for (int i=0; i<(int)parrays.size(); ++i) {
 
-        if (parrays[i].GetDescriptor().GetType() >= REGULAR and
-            parrays[i].GetDescriptor().GetType() <= GREGORY_BOUNDARY)
+        Type type = parrays[i].GetDescriptor().GetType();
+
+        if ((type >= REGULAR and type <= GREGORY_BOUNDARY) or
+            type == LOOP or type == LOOP_IRREGULAR)
             return true;
 
     }
@@ -680,6 +767,8 @@ FarPatchTables::Descriptor::GetNumControlVertices( FarPatchTables::Type type ) {
         case GREGORY_BOUNDARY  : return FarPatchTables::GetGregoryPatchRingsize();
         case BOUNDARY          : return FarPatchTables::GetBoundaryPatchRingsize();
         case CORNER            : return FarPatchTables::GetCornerPatchRingsize();
+        case LOOP              : return FarPatchTables::GetLoopPatchRingsize();
+        case LOOP_IRREGULAR    : return FarPatchTables::GetLoopIrregularPatchRingsize();
         case TRIANGLES         : return 3;
         case LINES             : return 2;
         case POINTS            : return 1;
@@ -778,10 +867,16 @@ FarPatchTables::GetNumControlVertices() const {
 
 // Constructor
 inline
-FarPatchTables::FVarData::FVarData( std::vector<float> const * data, int fvarWidth ) : 
+FarPatchTables::FVarData::FVarData( std::vector<float> const * data, int fvarWidth,
+                                    std::vector<unsigned int> const * indices ) :
     _fvarWidth(fvarWidth) {
 
-    if (data) {
+    if (indices and (not indices->empty())) {
+        _indices = *indices;
+        if (data) {
+            _values = *data;
+        }
+    } else if (data) {
         _data = *data;
     }    
 }
@@ -790,6 +885,9 @@ FarPatchTables::FVarData::FVarData( std::vector<float> const * data, int fvarWid
 inline float const *
 FarPatchTables::FVarData::GetData(int level) const {
 
+    if (_data.empty())
+        return NULL;
+
     if ( (level-1)<(int)_offsets.size()) {
 
         int offset = 0;
@@ -805,6 +903,23 @@ FarPatchTables::FVarData::GetData(int level) const {
     return NULL;
 }
 
+// Expands the face-varying data into the per-face-per-vertex layout
+inline void
+FarPatchTables::FVarData::ExpandData(std::vector<float> & data) const {
+
+    if (not IsIndexed()) {
+        data = _data;
+        return;
+    }
+
+    data.resize(_indices.size()*_fvarWidth);
+    for (int i=0; i<(int)_indices.size(); ++i) {
+        std::copy(&_values[_indices[i]*_fvarWidth],
+                  &_values[_indices[i]*_fvarWidth] + _fvarWidth,
+                  &data[i*_fvarWidth]);
+    }
+}
+
 
 } // end namespace OPENSUBDIV_VERSION
 using namespace OPENSUBDIV_VERSION;
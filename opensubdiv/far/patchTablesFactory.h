@@ -45,6 +45,16 @@ public:
     typedef std::vector<FarMesh<T> const *> FarMeshVector;
     typedef std::vector<FarPatchTables::PatchArrayVector> MultiPatchArrayVector;
 
+    /// \brief The Hbr vertex and face of the face-varying data copied into
+    /// a face-varying vertex of the FVarData table (see FarFVarTablesFactory)
+    ///
+    /// \note The address of the HbrFVarData itself is not recorded : Hbr
+    /// re-allocates the face-varying data of a vertex as it refines adaptively
+    ///
+    typedef std::pair<HbrVertex<T> *, HbrFace<T> const *> FVarSource;
+
+    typedef std::vector<FVarSource> FVarSourceVector;
+
     /// \brief Splices patch tables from multiple meshes.
     /// if non-null multPatchArrays is given, it returns subsets of patcharrays such that
     /// corresponding input meshes are separately expressed.
@@ -73,9 +83,13 @@ protected:
     ///
     /// @param fvarWidth        The width of the interleaved face-varying data
     ///
+    /// @param fvarSources      Optional : returns the Hbr data of each
+    ///                         face-varying vertex of the FVarData table
+    ///
     /// @return                 A new instance of FarPatchTables
     ///
-    FarPatchTables * Create(int maxvalence, int numPtexFaces=0, int fvarWidth=0 );
+    FarPatchTables * Create(int maxvalence, int numPtexFaces=0, int fvarWidth=0,
+                            FVarSourceVector * fvarSources=0 );
 
 
     typedef std::vector<std::vector< HbrFace<T> *> > FacesList;
@@ -100,6 +114,9 @@ protected:
     ///
     /// @param fvarWidth        The width of the interleaved face-varying data
     ///
+    /// @param fvarSources      Optional : returns the Hbr data of each
+    ///                         face-varying vertex of the FVarData table
+    ///
     /// @return                 A new instance of FarPatchTables
     ///
     static FarPatchTables * Create( HbrMesh<T> const * mesh,
@@ -108,7 +125,8 @@ protected:
                                     int firstLevel=-1,
                                     FarPatchTables::Type patchType=FarPatchTables::QUADS,
                                     int numPtexFaces=0,
-                                    int fvarWidth=0 );
+                                    int fvarWidth=0,
+                                    FVarSourceVector * fvarSources=0 );
 
     typedef std::vector<unsigned int> VertexList;
     typedef std::map<unsigned int, unsigned int> VertexPermutation;
@@ -144,6 +162,17 @@ protected:
     static void SplitVertices( FarPatchTables * patchTables,
                                SplitTable const &splitTable );
 
+    /// \brief Returns true if the vertex is a regular vertex of an infinitely
+    /// sharp crease (valence 4, with 2 opposite infinitely sharp edges and
+    /// 2 smooth edges)
+    static bool vertexIsRegularCrease( HbrVertex<T> * v );
+
+    /// \brief Returns true if the edge is an infinitely sharp crease between
+    /// two regular crease vertices. The faces on each side of a regular crease
+    /// are evaluated exactly as boundary patches, so the crease does not need
+    /// to be isolated.
+    static bool edgeIsRegularCrease( HbrHalfedge<T> * e );
+
 private:
 
     typedef FarPatchTables::Descriptor Descriptor;
@@ -157,17 +186,47 @@ private:
     // Returns the rotation for a corner patch
     static unsigned char computeCornerPatchRotation( HbrFace<T> * f );
 
+    // True if f is a patch of an adaptively refined Loop mesh : the face is
+    // not refined any further, but its parent was (or it is a coarse face)
+    static bool loopFaceIsPatch( HbrFace<T> const * f );
+
+    // True if f can be represented with a regular Loop (box-spline) patch
+    static bool loopFaceIsRegular( HbrFace<T> const * f );
+
     // Populates the face-varying data buffer 'coord' for the given face and
-    // returns a pointer to the next entry in the table
-    static float * computeFVarData(HbrFace<T> const *f, const int width, float *coord, bool isAdaptive);
+    // returns a pointer to the next entry in the table. If 'sources' is not
+    // null, the source of the Hbr data copied is also recorded at the same
+    // location ('base' is the beginning of the face-varying data buffer)
+    static float * computeFVarData(HbrFace<T> const *f, const int width, float *coord, bool isAdaptive,
+                                   FVarSourceVector * sources=0, float const * base=0);
+
+    // Replaces the per-face-per-vertex face-varying data with unique values and
+    // indices : the vertices that share their Hbr face-varying data share the
+    // same value. If 'mergeValues' is true, the equal values of a same vertex
+    // are merged as well. On return, 'sources' holds the source of each value.
+    // Note : the Hbr mesh must be fully refined.
+    static void indexFVarData(FarPatchTables * tables, FVarSourceVector & sources, bool mergeValues);
 
     // Populates the patch parametrization descriptor 'coord' for the given face
     // returns a pointer to the next descriptor
     static FarPatchParam * computePatchParam(HbrFace<T> const *f, FarPatchParam *coord);
 
+    // Same as computePatchParam for the triangles of an adaptive Loop mesh
+    static FarPatchParam * computeLoopPatchParam(HbrFace<T> const *f, FarPatchParam *coord);
+
     // Populates an array of indices with the "one-ring" vertices for the given face
     unsigned int * getOneRing(HbrFace<T> const * f, int ringsize, unsigned int const * remap, unsigned int * result) const;
 
+    // Populates an array of indices with the 12 control vertices of a regular
+    // Loop patch
+    unsigned int * getLoopOneRing(HbrFace<T> const * f, unsigned int * result) const;
+
+    // Returns a feature-adaptive FarPatchTables instance for a Loop mesh
+    FarPatchTables * createLoop(int maxvalence, int numPtexFaces);
+
+    // Populates the vertex valence table used by Gregory and irregular Loop patches
+    void computeVertexValenceTable(FarPatchTables * result, int maxvalence) const;
+
     // Populates the Gregory patch quad offsets table
     static void getQuadOffsets(HbrFace<T> const * f, unsigned int * result);
 
@@ -199,7 +258,9 @@ private:
              B[NUM_TRANSITIONS][NUM_ROTATIONS],    // boundary patch (4 rotations)
              C[NUM_TRANSITIONS][NUM_ROTATIONS],    // corner patch (4 rotations)
              G,                                    // gregory patch
-             GB;                                   // gregory boundary patch
+             GB,                                   // gregory boundary patch
+             L,                                    // loop patch
+             LI;                                   // irregular loop patch
 
         PatchTypes() { memset(this, 0, sizeof(PatchTypes<TYPE>)); }
 
@@ -242,6 +303,8 @@ FarPatchTablesFactory<T>::PatchTypes<TYPE>::getValue( FarPatchTables::Descriptor
         case FarPatchTables::CORNER           : return C[desc.GetPattern()][desc.GetRotation()];
         case FarPatchTables::GREGORY          : return G;
         case FarPatchTables::GREGORY_BOUNDARY : return GB;
+        case FarPatchTables::LOOP             : return L;
+        case FarPatchTables::LOOP_IRREGULAR   : return LI;
         default : assert(0);
     }
     // can't be reached (suppress compiler warning)
@@ -267,6 +330,8 @@ FarPatchTablesFactory<T>::PatchTypes<TYPE>::getNumPatchArrays() const {
 
     if (G) ++result;
     if (GB) ++result;
+    if (L) ++result;
+    if (LI) ++result;
 
     return result;
 }
@@ -296,7 +361,45 @@ FarPatchTablesFactory<T>::vertexHasTaggedNeighbors(HbrVertex<T> * v) {
     return false;
 }
 
-// Returns a rotation index for boundary patches (range [0-3])
+// True if v is a valence 4 vertex between 2 opposite infinitely sharp edges
+template <class T> bool
+FarPatchTablesFactory<T>::vertexIsRegularCrease( HbrVertex<T> * v ) {
+
+    assert(v);
+
+    if (v->OnBoundary() or v->IsExtraordinary() or v->GetValence()!=4 or
+        v->GetSharpness()>HbrVertex<T>::k_Smooth)
+        return false;
+
+    int sharpEdges=0;
+
+    HbrHalfedge<T> * e = v->GetIncidentEdge();
+    for (int i=0; i<4; ++i, e=v->GetNextEdge(e)) {
+
+        float sharpness = e->GetSharpness();
+
+        if (sharpness>=HbrHalfedge<T>::k_InfinitelySharp)
+            sharpEdges |= (1<<i);
+        else if (sharpness>HbrHalfedge<T>::k_Smooth)
+            return false;   // semi-sharp edges still need to be isolated
+    }
+    return sharpEdges==0x5 or sharpEdges==0xA;
+}
+
+// True if e is an infinitely sharp edge between 2 regular crease vertices
+template <class T> bool
+FarPatchTablesFactory<T>::edgeIsRegularCrease( HbrHalfedge<T> * e ) {
+
+    assert(e);
+
+    return (not e->IsBoundary()) and
+           e->GetSharpness()>=HbrHalfedge<T>::k_InfinitelySharp and
+           vertexIsRegularCrease(e->GetOrgVertex()) and
+           vertexIsRegularCrease(e->GetDestVertex());
+}
+
+// Returns a rotation index for boundary patches (range [0-3]) : regular
+// creases are treated as boundaries
 template <class T> unsigned char
 FarPatchTablesFactory<T>::computeBoundaryPatchRotation( HbrFace<T> * f ) {
     unsigned char rot=0;
@@ -304,6 +407,8 @@ FarPatchTablesFactory<T>::computeBoundaryPatchRotation( HbrFace<T> * f ) {
         if (f->GetVertex(i)->OnBoundary() and
             f->GetVertex((i+1)%4)->OnBoundary())
             break;
+        if (edgeIsRegularCrease(f->GetEdge(i)))
+            break;
         ++rot;
     }
     return rot;
@@ -321,6 +426,41 @@ FarPatchTablesFactory<T>::computeCornerPatchRotation( HbrFace<T> * f ) {
     return rot;
 }
 
+// True if f is a leaf face of an adaptively refined Loop mesh
+template <class T> bool
+FarPatchTablesFactory<T>::loopFaceIsPatch( HbrFace<T> const * f ) {
+
+    assert(f);
+
+    if (f->IsHole() or f->_adaptiveFlags.isTagged)
+        return false;
+
+    return f->IsCoarse() or f->GetParent()->_adaptiveFlags.isTagged;
+}
+
+// True if the 3 vertices of f are smooth interior vertices of valence 6
+template <class T> bool
+FarPatchTablesFactory<T>::loopFaceIsRegular( HbrFace<T> const * f ) {
+
+    assert(f and f->GetNumVertices()==3);
+
+    for (int i=0; i<3; ++i) {
+
+        HbrVertex<T> * v = f->GetVertex(i);
+
+        if (v->OnBoundary() or v->IsSingular() or v->GetValence()!=6 or
+            v->GetSharpness()>HbrVertex<T>::k_Smooth)
+            return false;
+
+        HbrHalfedge<T> * e = v->GetIncidentEdge();
+        for (int j=0; j<6; ++j, e=v->GetNextEdge(e)) {
+            if (e->GetSharpness()>HbrHalfedge<T>::k_Smooth)
+                return false;
+        }
+    }
+    return true;
+}
+
 // Reserves tables based on the contents of the PatchArrayVector
 template <class T> void
 FarPatchTablesFactory<T>::allocateTables( FarPatchTables * tables, int nlevels, int fvarwidth ) {
@@ -353,7 +493,7 @@ FarPatchTablesFactory<T>::allocateTables( FarPatchTables * tables, int nlevels,
 
 // Uniform mesh factory (static function because it requires no cached state)
 template <class T> FarPatchTables *
-FarPatchTablesFactory<T>::Create( HbrMesh<T> const * mesh, FacesList const & flist, std::vector<int> const & remapTable, int firstLevel, FarPatchTables::Type patchType, int numPtexFaces, int fvarwidth ) {
+FarPatchTablesFactory<T>::Create( HbrMesh<T> const * mesh, FacesList const & flist, std::vector<int> const & remapTable, int firstLevel, FarPatchTables::Type patchType, int numPtexFaces, int fvarwidth, FVarSourceVector * fvarSources ) {
 
     assert(patchType == FarPatchTables::QUADS || patchType == FarPatchTables::TRIANGLES);
 
@@ -404,6 +544,10 @@ FarPatchTablesFactory<T>::Create( HbrMesh<T> const * mesh, FacesList const & fli
     unsigned int  * iptr = &result->_patches[0];
     FarPatchParam * pptr = &result->_paramTable[0];
     float         * fptr = fvarwidth>0 ? &result->_fvarData._data[0] : 0;
+    float const   * fbase = fptr;
+
+    if (fvarSources)
+        fvarSources->assign( fvarwidth>0 ? result->_fvarData._data.size()/fvarwidth : 0, FVarSource() );
 
     for (int level=firstArray, fvarOffset=0; level<(int)flist.size(); ++level) {
 
@@ -418,7 +562,7 @@ FarPatchTablesFactory<T>::Create( HbrMesh<T> const * mesh, FacesList const & fli
             pptr = computePatchParam(f, pptr);
 
             if (fvarwidth>0)
-                fptr = computeFVarData(f, fvarwidth, fptr, /*isAdaptive=*/false);
+                fptr = computeFVarData(f, fvarwidth, fptr, /*isAdaptive=*/false, fvarSources, fbase);
 
             if (triangulateQuads) {
                 // Triangulate the quadrilateral: {v0,v1,v2,v3} -> {v0,v1,v2},{v3,v0,v2}.
@@ -436,6 +580,11 @@ FarPatchTablesFactory<T>::Create( HbrMesh<T> const * mesh, FacesList const & fli
                 for (int j = 0; j < fvarwidth; ++j, ++fptr) {
                     *fptr = *(fptr - 3 * fvarwidth); // copy v2 fvar data
                 }
+                if (fvarSources and fvarwidth>0) {
+                    FVarSource * src = &(*fvarSources)[(fptr-fbase)/fvarwidth];
+                    src[-2] = src[-6];
+                    src[-1] = src[-5];
+                }
             }
         }
 
@@ -456,6 +605,24 @@ FarPatchTablesFactory<T>::FarPatchTablesFactory( HbrMesh<T> const * mesh, int nf
 {
     assert(mesh and nfaces>0);
 
+    // Loop meshes : there are no transition patches, so we only need to sort
+    // the leaf triangles into regular and irregular patches
+    if (FarMeshFactory<T,T>::isLoop(mesh)) {
+        for (int i=0; i<nfaces; ++i) {
+
+            HbrFace<T> * f = mesh->GetFace(i);
+
+            if (not loopFaceIsPatch(f))
+                continue;
+
+            if (loopFaceIsRegular(f))
+                _patchCtr.L++;
+            else
+                _patchCtr.LI++;
+        }
+        return;
+    }
+
     // First pass : identify transition / watertight-critical
     for (int i=0; i<nfaces; ++i) {
 
@@ -564,6 +731,18 @@ FarPatchTablesFactory<T>::FarPatchTablesFactory( HbrMesh<T> const * mesh, int nf
             }
         }
 
+        // Faces along a regular crease are boundary patches (refineAdaptive
+        // isolates the faces with more than 1 crease edge, or with a crease
+        // edge and a boundary vertex)
+        if (boundaryVerts==0 and not isExtraordinary) {
+            for (int j=0; j<nv; ++j) {
+                if (edgeIsRegularCrease(f->GetEdge(j))) {
+                    boundaryVerts=2;
+                    break;
+                }
+            }
+        }
+
         f->_adaptiveFlags.bverts=boundaryVerts;
         f->_adaptiveFlags.isCritical=isWatertightCritical;
 
@@ -744,7 +923,7 @@ FarPatchTablesFactory<T>::pushPatchArray( FarPatchTables::Descriptor desc,
 
 // Feature adaptive mesh factory
 template <class T> FarPatchTables *
-FarPatchTablesFactory<T>::Create(int maxvalence, int numPtexFaces, int fvarwidth ) {
+FarPatchTablesFactory<T>::Create(int maxvalence, int numPtexFaces, int fvarwidth, FVarSourceVector * fvarSources ) {
 
     static const unsigned int remapRegular        [16] = {5,6,10,9,4,0,1,2,3,7,11,15,14,13,12,8};
     static const unsigned int remapRegularBoundary[12] = {1,2,6,5,0,3,7,11,10,9,8,4};
@@ -752,6 +931,12 @@ FarPatchTablesFactory<T>::Create(int maxvalence, int numPtexFaces, int fvarwidth
 
     assert(getMesh() and getNumFaces()>0);
 
+    if (FarMeshFactory<T,T>::isLoop(getMesh())) {
+        // there is no adaptive face-varying data for Loop triangles
+        assert(fvarwidth==0);
+        return createLoop(maxvalence, numPtexFaces);
+    }
+
     FarPatchTables * result = new FarPatchTables(maxvalence);
 
     // Populate the patch array descriptors
@@ -798,6 +983,11 @@ FarPatchTablesFactory<T>::Create(int maxvalence, int numPtexFaces, int fvarwidth
             fptrs.getValue( *it ) = &result->_fvarData._data[pa->GetPatchIndex() * 4 * fvarwidth];
     }
 
+    float const * fbase = fvarwidth>0 ? &result->_fvarData._data[0] : 0;
+
+    if (fvarSources)
+        fvarSources->assign( fvarwidth>0 ? result->_fvarData._data.size()/fvarwidth : 0, FVarSource() );
+
     FarPatchTables::QuadOffsetTable::value_type *quad_G_C0_P = _patchCtr.G>0 ? &result->_quadOffsetTable[0] : 0;
     FarPatchTables::QuadOffsetTable::value_type *quad_G_C1_P = _patchCtr.GB>0 ? &result->_quadOffsetTable[_patchCtr.G*4] : 0;
 
@@ -820,21 +1010,21 @@ FarPatchTablesFactory<T>::Create(int maxvalence, int numPtexFaces, int fvarwidth
                         case 0 : {   // Regular Patch (16 CVs)
                                      iptrs.R[pattern] = getOneRing(f, 16, remapRegular, iptrs.R[0]);
                                      pptrs.R[pattern] = computePatchParam(f, pptrs.R[0]);
-                                     fptrs.R[pattern] = computeFVarData(f, fvarwidth, fptrs.R[0], /*isAdaptive=*/true);
+                                     fptrs.R[pattern] = computeFVarData(f, fvarwidth, fptrs.R[0], /*isAdaptive=*/true, fvarSources, fbase);
                                  } break;
 
                         case 2 : {   // Boundary Patch (12 CVs)
                                      f->_adaptiveFlags.brots = (f->_adaptiveFlags.rots+1)%4;
                                      iptrs.B[pattern][rot] = getOneRing(f, 12, remapRegularBoundary, iptrs.B[0][0]);
                                      pptrs.B[pattern][rot] = computePatchParam(f, pptrs.B[0][0]);
-                                     fptrs.B[pattern][rot] = computeFVarData(f, fvarwidth, fptrs.B[0][0], /*isAdaptive=*/true);
+                                     fptrs.B[pattern][rot] = computeFVarData(f, fvarwidth, fptrs.B[0][0], /*isAdaptive=*/true, fvarSources, fbase);
                                  } break;
 
                         case 3 : {   // Corner Patch (9 CVs)
                                      f->_adaptiveFlags.brots = (f->_adaptiveFlags.rots+1)%4;
                                      iptrs.C[pattern][rot] = getOneRing(f, 9, remapRegularCorner, iptrs.C[0][0]);
                                      pptrs.C[pattern][rot] = computePatchParam(f, pptrs.C[0][0]);
-                                     fptrs.C[pattern][rot] = computeFVarData(f, fvarwidth, fptrs.C[0][0], /*isAdaptive=*/true);
+                                     fptrs.C[pattern][rot] = computeFVarData(f, fvarwidth, fptrs.C[0][0], /*isAdaptive=*/true, fvarSources, fbase);
                                  } break;
 
                         default : assert(0);
@@ -851,7 +1041,7 @@ FarPatchTablesFactory<T>::Create(int maxvalence, int numPtexFaces, int fvarwidth
                     getQuadOffsets(f, quad_G_C0_P);
                     quad_G_C0_P += 4;
                     pptrs.G = computePatchParam(f, pptrs.G);
-                    fptrs.G = computeFVarData(f, fvarwidth, fptrs.G, /*isAdaptive=*/true);
+                    fptrs.G = computeFVarData(f, fvarwidth, fptrs.G, /*isAdaptive=*/true, fvarSources, fbase);
                 } else {
 
                     // Gregory Boundary Patch (4 CVs + quad-offsets / valence tables)
@@ -861,7 +1051,7 @@ FarPatchTablesFactory<T>::Create(int maxvalence, int numPtexFaces, int fvarwidth
                     getQuadOffsets(f, quad_G_C1_P);
                     quad_G_C1_P += 4;
                     pptrs.GB = computePatchParam(f, pptrs.GB);
-                    fptrs.GB = computeFVarData(f, fvarwidth, fptrs.GB, /*isAdaptive=*/true);
+                    fptrs.GB = computeFVarData(f, fvarwidth, fptrs.GB, /*isAdaptive=*/true, fvarSources, fbase);
                 }
             } else {
                 // XXXX manuelk - end patches here
@@ -880,21 +1070,21 @@ FarPatchTablesFactory<T>::Create(int maxvalence, int numPtexFaces, int fvarwidth
                     case 0 : {   // Regular Transition Patch (16 CVs)
                                  iptrs.R[pattern] = getOneRing(f, 16, remapRegular, iptrs.R[pattern]);
                                  pptrs.R[pattern] = computePatchParam(f, pptrs.R[pattern]);
-                                 fptrs.R[pattern] = computeFVarData(f, fvarwidth, fptrs.R[pattern], /*isAdaptive=*/true);
+                                 fptrs.R[pattern] = computeFVarData(f, fvarwidth, fptrs.R[pattern], /*isAdaptive=*/true, fvarSources, fbase);
                              } break;
 
                     case 2 : {   // Boundary Transition Patch (12 CVs)
                                  unsigned rot = f->_adaptiveFlags.brots;
                                  iptrs.B[pattern][rot] = getOneRing(f, 12, remapRegularBoundary, iptrs.B[pattern][rot]);
                                  pptrs.B[pattern][rot] = computePatchParam(f, pptrs.B[pattern][rot]);
-                                 fptrs.B[pattern][rot] = computeFVarData(f, fvarwidth, fptrs.B[pattern][rot], /*isAdaptive=*/true);
+                                 fptrs.B[pattern][rot] = computeFVarData(f, fvarwidth, fptrs.B[pattern][rot], /*isAdaptive=*/true, fvarSources, fbase);
                              } break;
 
                     case 3 : {   // Corner Transition Patch (9 CVs)
                                  unsigned rot = f->_adaptiveFlags.brots;
                                  iptrs.C[pattern][rot] = getOneRing(f, 9, remapRegularCorner, iptrs.C[pattern][rot]);
                                  pptrs.C[pattern][rot] = computePatchParam(f, pptrs.C[pattern][rot]);
-                                 fptrs.C[pattern][rot] = computeFVarData(f, fvarwidth, fptrs.C[pattern][rot], /*isAdaptive=*/true);
+                                 fptrs.C[pattern][rot] = computeFVarData(f, fvarwidth, fptrs.C[pattern][rot], /*isAdaptive=*/true, fvarSources, fbase);
                              } break;
                 }
             } else
@@ -905,96 +1095,170 @@ FarPatchTablesFactory<T>::Create(int maxvalence, int numPtexFaces, int fvarwidth
 
     // Build Gregory patches vertex valence indices table
     if ((_patchCtr.G > 0) or (_patchCtr.GB > 0)) {
+        computeVertexValenceTable(result, maxvalence);
+    } else {
+        result->_vertexValenceTable.clear();
+    }
 
-        // MAX_VALENCE is a property of hardware shaders and needs to be matched in OSD
-        const int perVertexValenceSize = 2*maxvalence + 1;
-
-        const int nverts = getMesh()->GetNumVertices();
-
-        FarPatchTables::VertexValenceTable & table = result->_vertexValenceTable;
-        table.resize(nverts * perVertexValenceSize);
-
-        class GatherNeighborsOperator : public HbrVertexOperator<T> {
-        public:
-            HbrVertex<T> * center;
-            FarPatchTables::VertexValenceTable & table;
-            int offset, valence;
-            std::vector<int> const & remap;
-
-            GatherNeighborsOperator(FarPatchTables::VertexValenceTable & itable, int ioffset, HbrVertex<T> * v, std::vector<int> const & iremap) :
-                center(v), table(itable), offset(ioffset), valence(0), remap(iremap) { }
-
-            ~GatherNeighborsOperator() { }
-
-            // Operator iterates over neighbor vertices of v and accumulates
-            // pairs of indices the neighbor and diagonal vertices
-            //
-            //          Regular case
-            //                                           Boundary case
-            //      o ------- o      D3 o
-            //   D0        N0 |         |
-            //                |         |             o ------- o      D2 o
-            //                |         |          D0        N0 |         |
-            //                |         |                       |         |
-            //      o ------- o ------- o                       |         |
-            //   N1 |       V |      N3                         |         |
-            //      |         |                       o ------- o ------- o
-            //      |         |                    N1          V       N2
-            //      |         |
-            //      o         o ------- o
-            //   D1         N2        D2
-            //
-            virtual void operator() (HbrVertex<T> &v) {
-
-                table[offset++] = remap[v.GetID()];
-
-                HbrVertex<T> * diagonal=&v;
-
-                HbrHalfedge<T> * e = center->GetEdge(&v);
-                if ( e ) {
-                    // If v is on a boundary, there may not be a diagonal vertex
-                    diagonal = e->GetNext()->GetDestVertex();
-                }
-                //else {
-                //    diagonal = v.GetQEONext( center );
-                //}
+    return result;
+}
 
-                table[offset++] = remap[diagonal->GetID()];
+// Builds the vertex valence indices table of Gregory and irregular Loop patches
+template <class T> void
+FarPatchTablesFactory<T>::computeVertexValenceTable(FarPatchTables * result, int maxvalence) const {
 
-                ++valence;
-            }
-        };
+    // MAX_VALENCE is a property of hardware shaders and needs to be matched in OSD
+    const int perVertexValenceSize = 2*maxvalence + 1;
 
-        for (int i=0; i<nverts; ++i) {
-            HbrVertex<T> * v = getMesh()->GetVertex(i);
+    const int nverts = getMesh()->GetNumVertices();
 
-            int outputVertexID = _remapTable[v->GetID()];
-            int offset = outputVertexID * perVertexValenceSize;
+    FarPatchTables::VertexValenceTable & table = result->_vertexValenceTable;
+    table.resize(nverts * perVertexValenceSize);
 
-            // feature adaptive refinement can generate un-connected face-vertices
-            // that have a valence of 0
-            if (not v->IsConnected()) {
-                //assert( v->GetParentFace() );
-                table[offset] = 0;
-                continue;
+    class GatherNeighborsOperator : public HbrVertexOperator<T> {
+    public:
+        HbrVertex<T> * center;
+        FarPatchTables::VertexValenceTable & table;
+        int offset, valence;
+        std::vector<int> const & remap;
+
+        GatherNeighborsOperator(FarPatchTables::VertexValenceTable & itable, int ioffset, HbrVertex<T> * v, std::vector<int> const & iremap) :
+            center(v), table(itable), offset(ioffset), valence(0), remap(iremap) { }
+
+        ~GatherNeighborsOperator() { }
+
+        // Operator iterates over neighbor vertices of v and accumulates
+        // pairs of indices the neighbor and diagonal vertices
+        //
+        //          Regular case
+        //                                           Boundary case
+        //      o ------- o      D3 o
+        //   D0        N0 |         |
+        //                |         |             o ------- o      D2 o
+        //                |         |          D0        N0 |         |
+        //                |         |                       |         |
+        //      o ------- o ------- o                       |         |
+        //   N1 |       V |      N3                         |         |
+        //      |         |                       o ------- o ------- o
+        //      |         |                    N1          V       N2
+        //      |         |
+        //      o         o ------- o
+        //   D1         N2        D2
+        //
+        virtual void operator() (HbrVertex<T> &v) {
+
+            table[offset++] = remap[v.GetID()];
+
+            HbrVertex<T> * diagonal=&v;
+
+            HbrHalfedge<T> * e = center->GetEdge(&v);
+            if ( e ) {
+                // If v is on a boundary, there may not be a diagonal vertex
+                diagonal = e->GetNext()->GetDestVertex();
             }
+            //else {
+            //    diagonal = v.GetQEONext( center );
+            //}
+
+            table[offset++] = remap[diagonal->GetID()];
+
+            ++valence;
+        }
+    };
 
-            // "offset+1" : the first table entry is the vertex valence, which
-            // is gathered by the operator (see note below)
-            GatherNeighborsOperator op( table, offset+1, v, _remapTable );
-            v->ApplyOperatorSurroundingVertices( op );
+    for (int i=0; i<nverts; ++i) {
+        HbrVertex<T> * v = getMesh()->GetVertex(i);
 
-            // Valence sign bit used to mark boundary vertices
-            table[offset] = v->OnBoundary() ? -op.valence : op.valence;
+        int outputVertexID = _remapTable[v->GetID()];
+        int offset = outputVertexID * perVertexValenceSize;
 
-            // Note : some topologies can cause v to be singular at certain
-            // levels of adaptive refinement, which prevents us from using
-            // the GetValence() function. Fortunately, the GatherNeighbors
-            // operator above just performed a similar traversal, so it is
-            // very convenient to use it to accumulate the actionable valence.
+        // feature adaptive refinement can generate un-connected face-vertices
+        // that have a valence of 0
+        if (not v->IsConnected()) {
+            //assert( v->GetParentFace() );
+            table[offset] = 0;
+            continue;
         }
-    } else {
-        result->_vertexValenceTable.clear();
+
+        // "offset+1" : the first table entry is the vertex valence, which
+        // is gathered by the operator (see note below)
+        GatherNeighborsOperator op( table, offset+1, v, _remapTable );
+        v->ApplyOperatorSurroundingVertices( op );
+
+        // Valence sign bit used to mark boundary vertices
+        table[offset] = v->OnBoundary() ? -op.valence : op.valence;
+
+        // Note : some topologies can cause v to be singular at certain
+        // levels of adaptive refinement, which prevents us from using
+        // the GetValence() function. Fortunately, the GatherNeighbors
+        // operator above just performed a similar traversal, so it is
+        // very convenient to use it to accumulate the actionable valence.
+    }
+}
+
+// Feature adaptive Loop mesh factory
+template <class T> FarPatchTables *
+FarPatchTablesFactory<T>::createLoop(int maxvalence, int numPtexFaces) {
+
+    FarPatchTables * result = new FarPatchTables(maxvalence);
+
+    // Populate the patch array descriptors
+    FarPatchTables::PatchArrayVector & parray = result->_patchArrays;
+    parray.reserve( getNumPatchArrays() );
+
+    int voffset=0, poffset=0, qoffset=0;
+
+    for (Descriptor::iterator it=Descriptor::begin(Descriptor::FEATURE_ADAPTIVE_LOOP);
+        it!=Descriptor::end(); ++it) {
+
+        pushPatchArray( *it, parray, _patchCtr.getValue(*it), &voffset, &poffset, &qoffset );
+    }
+
+    result->_numPtexFaces = numPtexFaces;
+
+    allocateTables( result, 0, 0 );
+
+    CVPointers    iptrs;
+    ParamPointers pptrs;
+
+    for (Descriptor::iterator it=Descriptor::begin(Descriptor::FEATURE_ADAPTIVE_LOOP);
+        it!=Descriptor::end(); ++it) {
+
+        FarPatchTables::PatchArray * pa = result->findPatchArray(*it);
+
+        if (not pa)
+            continue;
+
+        iptrs.getValue( *it ) = &result->_patches[pa->GetVertIndex()];
+        pptrs.getValue( *it ) = &result->_paramTable[pa->GetPatchIndex()];
+    }
+
+    // Populate patch index tables with vertex indices
+    for (int i=0; i<getNumFaces(); ++i) {
+
+        HbrFace<T> * f = getMesh()->GetFace(i);
+
+        if (not loopFaceIsPatch(f))
+            continue;
+
+        if (loopFaceIsRegular(f)) {
+
+            // Regular Loop patch (12 CVs)
+            iptrs.L = getLoopOneRing(f, iptrs.L);
+            pptrs.L = computeLoopPatchParam(f, pptrs.L);
+        } else {
+
+            // Irregular Loop patch (3 CVs + valence table)
+            for (int j=0; j<3; ++j)
+                iptrs.LI[j] = _remapTable[f->GetVertex(j)->GetID()];
+            iptrs.LI+=3;
+            pptrs.LI = computeLoopPatchParam(f, pptrs.LI);
+        }
+    }
+
+    // Build irregular Loop patches vertex valence indices table
+    if (_patchCtr.LI > 0) {
+        computeVertexValenceTable(result, maxvalence);
     }
 
     return result;
@@ -1067,12 +1331,16 @@ FarPatchTablesFactory<T>::getOneRing(HbrFace<T> const * f,
         for (int i=0; i<4; ++i)
             v[i] = f->GetVertex( (i+f->_adaptiveFlags.rots)%4 );
 
-        HbrHalfedge<T> * e;
+        // Note : the boundary edge v0-v1 may also be a regular crease, so
+        // the outer vertices are found with the edges of the face (and not
+        // the incident edges of the boundary vertices)
+        HbrHalfedge<T> * e = f->GetEdge( f->_adaptiveFlags.rots );
+        assert( e->GetOrgVertex()==v[0] );
 
-        e = v[0]->GetIncidentEdge()->GetPrev()->GetOpposite()->GetPrev();
+        e = e->GetPrev()->GetOpposite()->GetPrev();
         result[remap[idx++ % ringsize]] = _remapTable[e->GetOrgVertex()->GetID()];
 
-        e = v[1]->GetIncidentEdge();
+        e = f->GetEdge( (f->_adaptiveFlags.rots+1)%4 )->GetOpposite()->GetNext();
         result[remap[idx++ % ringsize]] = _remapTable[e->GetDestVertex()->GetID()];
 
         e = v[2]->GetNextEdge( v[2]->GetEdge(v[1]) );
@@ -1129,6 +1397,50 @@ FarPatchTablesFactory<T>::getOneRing(HbrFace<T> const * f,
     return result;
 }
 
+// Gathers the 12 control vertices of a regular Loop patch
+template <class T> unsigned int *
+FarPatchTablesFactory<T>::getLoopOneRing(HbrFace<T> const * f, unsigned int * result) const {
+
+    assert( f and f->GetNumVertices()==3 );
+
+    // Regular case (the face is the triangle 3-6-7)
+    //
+    //             8       11
+    //             o ----- o
+    //        4  /   \ 7 /   \ 10
+    //         o ----- o ----- o
+    //    1  /   \ 3 /   \ 6 /   \ 9
+    //     o ----- o ----- o ----- o
+    //       \   /   \   /   \   /
+    //         o ----- o ----- o
+    //         0       2       5
+    //
+    // The vertices of the one-ring of each corner of the face are visited in
+    // counter-clockwise order, starting from the next corner of the face.
+    static const int remap[3][6] = { { 6,  7,  4,  1,  0,  2 },
+                                     { 7,  3,  2,  5,  9, 10 },
+                                     { 3,  6, 10, 11,  8, -1 } };
+
+    static const int corners[3] = { 3, 6, 7 };
+
+    for (int i=0; i<3; ++i) {
+
+        HbrVertex<T> * v = f->GetVertex(i);
+
+        result[corners[i]] = _remapTable[v->GetID()];
+
+        HbrHalfedge<T> * e = f->GetEdge(i);
+        assert( e->GetOrgVertex()==v );
+
+        for (int j=0; j<6 and remap[i][j]>=0; ++j, e=v->GetNextEdge(e)) {
+            assert(e);
+            result[remap[i][j]] = _remapTable[e->GetDestVertex()->GetID()];
+        }
+    }
+
+    return result+12;
+}
+
 // Populate the quad-offsets table used by Gregory patches
 template <class T> void
 FarPatchTablesFactory<T>::getQuadOffsets(HbrFace<T> const * f, unsigned int * result) {
@@ -1248,13 +1560,64 @@ FarPatchTablesFactory<T>::computePatchParam(HbrFace<T> const * f, FarPatchParam
     return ++coord;
 }
 
+// Computes the local ptex texture coordinates of an adaptive Loop patch.
+//
+// The sub-triangles are located in the (u,v) lattice of their level : the
+// corner children (0,1,2) keep the orientation of their parent, while the
+// middle child (3) is flipped. Flipped triangles are stored with 2 rotations
+// and the coordinates of the lattice cell that they cover.
+template <class T> FarPatchParam *
+FarPatchTablesFactory<T>::computeLoopPatchParam(HbrFace<T> const * f, FarPatchParam *coord) {
+
+    if (coord == NULL) return NULL;
+
+    // track upwards towards coarse parent face, recording the child indices
+    unsigned char path[16];
+    int depth=0;
+
+    HbrFace<T> const * p = f->GetParent();
+    for ( ; p!=NULL; ++depth) {
+
+        assert(depth<16 and p->GetNumVertices()==3);
+
+        for (unsigned char i=0; i<4; ++i) {
+            if ( p->GetChild( i )==f ) {
+                path[depth] = i;
+                break;
+            }
+        }
+        f = p;
+        p = f->GetParent();
+    }
+
+    // walk back down accumulating the u,v indices
+    int u=0, v=0, sign=1;
+    for (int k=depth-1; k>=0; --k) {
+        u = 2*u + ((path[k]==1 or path[k]==3) ? sign : 0);
+        v = 2*v + ((path[k]==2 or path[k]==3) ? sign : 0);
+        if (path[k]==3)
+            sign = -sign;
+    }
+
+    if (sign<0) {
+        coord->Set( f->GetPtexIndex(), (short)(u-1), (short)(v-1), 2, (unsigned char)depth, false );
+    } else {
+        coord->Set( f->GetPtexIndex(), (short)u, (short)v, 0, (unsigned char)depth, false );
+    }
+
+    return ++coord;
+}
+
 // Populates the face-varying data buffer 'coord' for the given face
 template <class T> float *
 FarPatchTablesFactory<T>::computeFVarData(
-    HbrFace<T> const *f, const int width, float *coord, bool isAdaptive) {
+    HbrFace<T> const *f, const int width, float *coord, bool isAdaptive,
+    FVarSourceVector * sources, float const * base) {
 
     if (coord == NULL) return NULL;
 
+    FVarSource * src = sources ? &(*sources)[(coord-base)/width] : 0;
+
     if (isAdaptive) {
 
         int rots = f->_adaptiveFlags.rots;
@@ -1266,6 +1629,9 @@ FarPatchTablesFactory<T>::computeFVarData(
             HbrVertex<T> *v      = f->GetVertex((j+rots)%4);
             float        *fvdata = v->GetFVarData(f).GetData(0);
 
+            if (src)
+                *src++ = FVarSource(v, f);
+
             for ( int k=0; k<width; ++k ) {
                 (*coord++) = fvdata[k];
             }
@@ -1280,6 +1646,9 @@ FarPatchTablesFactory<T>::computeFVarData(
             HbrVertex<T> *v      = f->GetVertex(j);
             float        *fvdata = v->GetFVarData(f).GetData(0);
 
+            if (src)
+                *src++ = FVarSource(v, f);
+
             for ( int k=0; k<width; ++k ) {
                 (*coord++) = fvdata[k];
             }
@@ -1290,6 +1659,65 @@ FarPatchTablesFactory<T>::computeFVarData(
     return coord;
 }
 
+// Replaces the face-varying data with unique values and indices, unless the
+// indexed representation is not smaller
+template <class T> void
+FarPatchTablesFactory<T>::indexFVarData( FarPatchTables * tables, FVarSourceVector & sources, bool mergeValues ) {
+
+    FarPatchTables::FVarData & fvarData = tables->_fvarData;
+
+    int width = fvarData._fvarWidth;
+
+    if (width==0 or fvarData._data.empty())
+        return;
+
+    assert( sources.size()*width == fvarData._data.size() );
+
+    // Values are identified by their Hbr data : the vertices of a face-varying
+    // seam own distinct data for each side, even when their values are equal.
+    // Unless the refinement tables must bind each value to a single Hbr datum,
+    // the equal values of a same vertex are merged.
+    typedef std::pair<void const *, std::vector<float> > ValueKey;
+    typedef std::map<ValueKey, unsigned int> ValueMap;
+    ValueMap values;
+
+    FVarSourceVector uniqueSources;
+
+    fvarData._indices.resize(sources.size());
+
+    for (int i=0; i<(int)sources.size(); ++i) {
+
+        float const * value = &fvarData._data[i*width];
+
+        ValueKey key = mergeValues ?
+            ValueKey(sources[i].first, std::vector<float>(value, value+width)) :
+            ValueKey(&sources[i].first->GetFVarData(sources[i].second), std::vector<float>());
+
+        std::pair<typename ValueMap::iterator, bool> it =
+            values.insert(std::make_pair(key, (unsigned int)uniqueSources.size()));
+
+        if (it.second) {
+            uniqueSources.push_back(sources[i]);
+            fvarData._values.insert(fvarData._values.end(), value, value+width);
+        }
+        fvarData._indices[i] = it.first->second;
+    }
+
+    // Adaptive meshes share few values between patches : keep the
+    // per-face-per-vertex data when the indices would not save memory
+    if (fvarData._values.size()*sizeof(float)+fvarData._indices.size()*sizeof(unsigned int) >=
+        fvarData._data.size()*sizeof(float)) {
+        std::vector<float>().swap(fvarData._values);
+        std::vector<unsigned int>().swap(fvarData._indices);
+        return;
+    }
+
+    // release the per-face-per-vertex data
+    std::vector<float>().swap(fvarData._data);
+
+    sources.swap(uniqueSources);
+}
+
 // splicing functions
 template <typename V, typename IT> static IT
 copyWithOffset(IT dst_iterator, V const &src, int start, int count, int offset) {
@@ -1415,7 +1843,7 @@ FarPatchTablesFactory<T>::Splice(FarMeshVector const &meshes,
         numGregoryPatches.push_back(nGregory);
         gregoryQuadOffsets.push_back(totalQuadOffset0);
 
-        totalFVarData += (int)ptables->GetFVarData()._data.size();
+        totalFVarData += ptables->GetFVarData().GetNumVertices() * ptables->GetFVarData().GetFVarWidth();
         numTotalIndices += ptables->GetNumControlVertices();
 
         // note: some prims may not have vertex valence table, but still need a space
@@ -1528,6 +1956,14 @@ FarPatchTablesFactory<T>::Splice(FarMeshVector const &meshes,
 
         std::vector<float>::iterator FV_IT = result->_fvarData._data.begin();
 
+        // the spliced data is not indexed : expand the indexed tables
+        std::vector<std::vector<float> > expanded(meshes.size());
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            FarPatchTables::FVarData const & fvarData = meshes[i]->GetPatchTables()->GetFVarData();
+            if (fvarData.IsIndexed())
+                fvarData.ExpandData(expanded[i]);
+        }
+
         for (FarPatchTables::Descriptor::iterator it =
             FarPatchTables::Descriptor::begin(FarPatchTables::Descriptor::ANY);
                 it != FarPatchTables::Descriptor::end(); ++it) {
@@ -1543,8 +1979,11 @@ FarPatchTablesFactory<T>::Splice(FarMeshVector const &meshes,
                     int nv = (scheme == FarSubdivisionTables::LOOP) ? 3 : 4;
                     int width = ptables->GetFVarData().GetFVarWidth() * nv; // for each quads or tris
 
+                    std::vector<float> const & fvarData =
+                        ptables->GetFVarData().IsIndexed() ? expanded[i] : ptables->_fvarData._data;
+
                     std::vector<float>::const_iterator begin =
-                        ptables->_fvarData._data.begin() + parray->GetPatchIndex() * width;
+                        fvarData.begin() + parray->GetPatchIndex() * width;
 
                     std::vector<float>::const_iterator end =
                         begin + parray->GetNumPatches() * width;
@@ -92,6 +92,7 @@ private:
 
     friend class FarStencilTables;
     template <class T> friend class FarStencilTablesFactory;
+    friend class FarSubdivisionStencilTablesFactory;
 
     int * _size,
         * _indices;
@@ -190,6 +191,9 @@ public:
 private:
 
     template <class T> friend class FarStencilTablesFactory;
+    friend class FarSubdivisionStencilTablesFactory;
+    friend class FarLimitStencilTablesFactory;
+    friend class FarStencilTablesOptimizer;
 
     // Update values by appling cached stencil weights to new control values
     template <class T> void _Update( T const *controlValues,
@@ -232,11 +236,13 @@ FarStencilTables::GetStencil(int i) const {
 
     int ofs = _offsets[i];
 
+    // note : some tables only carry value weights (no derivatives), and the
+    // trailing stencils may be empty (offset past the end of the weights)
     return FarStencil( const_cast<int *>(&_sizes[i]),
-                       const_cast<int *>(&_indices[ofs]),
-                       const_cast<float *>(&_point[ofs]),
-                       const_cast<float *>(&_uderiv[ofs]),
-                       const_cast<float *>(&_vderiv[ofs]) );
+                       _indices.empty() ? 0 : const_cast<int *>(&_indices[0] + ofs),
+                       _point.empty() ? 0 : const_cast<float *>(&_point[0] + ofs),
+                       _uderiv.empty() ? 0 : const_cast<float *>(&_uderiv[0] + ofs),
+                       _vderiv.empty() ? 0 : const_cast<float *>(&_vderiv[0] + ofs) );
 }
 
 
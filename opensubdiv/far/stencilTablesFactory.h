@@ -35,6 +35,8 @@
 
 #include <string.h>
 #include <list>
+#include <map>
+#include <vector>
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -120,6 +122,45 @@ public:
                         float const * v,
                         int reflevel );
 
+    /// \brief Append stencils for regular grids of samples over every face
+    ///
+    /// Each coarse quad (and each sub-face of the other faces) is sampled at
+    /// gridsize x gridsize locations u,v = (i/(gridsize-1), j/(gridsize-1)).
+    /// The B-spline basis is separable : the weights of the rows and columns
+    /// of the grid are computed once per B-spline patch and each row of
+    /// samples is composed from 4 row stencils, which is much cheaper than
+    /// calling AppendStencils with the same samples.
+    ///
+    /// The samples on the boundaries of the faces are appended only once :
+    /// vertices, and samples along the edges and the sub-face boundaries that
+    /// are at the same location in the faces around them. Along an edge
+    /// between a quad and a non-quad only every other sample of the non-quad
+    /// matches a sample of the quad. The tangents of a shared sample are
+    /// those of the first face that appended it (their cross product has the
+    /// same orientation in the other faces).
+    ///
+    /// Faces that are holes (or with vertex edits) are skipped.
+    ///
+    /// @param stencilTables  The table of stencils to add the results to
+    ///
+    /// @param gridsize       The number of samples along the sides of the
+    ///                       faces (at least 2)
+    ///
+    /// @param reflevel       Max level of feature isolation
+    ///
+    /// @param quads          Optional grid topology : the indices of the 4
+    ///                       stencils (in stencilTables) of each quad of the
+    ///                       grids, in the (u,v) orientation of the faces
+    ///
+    /// @return               The number of stencils added to the array
+    ///
+    /// \note This changes the current face of the factory
+    ///
+    int AppendGridStencils( FarStencilTables * stencilTables,
+                            int gridsize,
+                            int reflevel,
+                            std::vector<int> * quads=0 );
+
     /// \brief Returns the maximum valence of a vertex allowed in the coarse
     /// mesh topology. Higher valences will generate incorrect limit tangents.
     int GetMaxValenceSupported();
@@ -132,6 +173,35 @@ private:
     // Reserve space for stencils of a set size at the end of a stencil table
     void _AddNewStencils( FarStencilTables * tables, int nstencils, int stencilsize);
 
+    // Location of a grid sample on the boundary of a face : the samples at
+    // the same location in different faces have the same key
+    struct GridKey {
+        GridKey( int type_, int a_, int b_, int pos_ ) :
+            type(type_), a(a_), b(b_), pos(pos_) { }
+
+        bool operator < ( GridKey const & other ) const {
+            if (type!=other.type) return type < other.type;
+            if (a!=other.a) return a < other.a;
+            if (b!=other.b) return b < other.b;
+            return pos < other.pos;
+        }
+
+        int type, // 0 : vertex, 1 : edge, 2 : sub-face boundary, 3 : center
+            a, b, // vertex IDs of the edge, or face ID and sub-face
+            pos;  // position of the sample along the edge or boundary
+    };
+
+    // Sample at 'pos' along the k-th edge of f, from its origin vertex
+    // (2*n edge segments : the sub-faces of non-quads have n along each half)
+    static GridKey _GetEdgeKey( HbrFace<T> const * f, int k, int pos, int n );
+
+    // Sample at 'pos' along the boundary between the middle of the k-th edge
+    // of a non-quad and its center (n segments)
+    static GridKey _GetSubFaceKey( HbrFace<T> const * f, int k, int pos, int n );
+
+    // Key of the sample (i,j) on the boundary of a grid of n segments
+    GridKey _GetGridKey( HbrFace<T> * f, int quadrant, int i, int j, int n ) const;
+
     HbrMesh<T> * _mesh;
 
     int _numCoarseVertices;
@@ -228,6 +298,175 @@ FarStencilTablesFactory<T>::AppendStencils( FarStencilTables * stencilTables,
     return result;
 }
 
+// Append stencils for regular grids of samples over every face
+template <class T> int
+FarStencilTablesFactory<T>::AppendGridStencils( FarStencilTables * stencilTables,
+                                                int gridsize,
+                                                int reflevel,
+                                                std::vector<int> * quads ) {
+
+    assert(stencilTables);
+
+    if (gridsize<2)
+        return 0;
+
+    int first = stencilTables->GetNumStencils(),
+        nsamples = gridsize*gridsize,
+        n = gridsize-1;
+
+    // Parametric coordinates of the rows (and columns) of the grids
+    typename Patch::GridCoordVector coords;
+    for (int i=0; i<gridsize; ++i) {
+        coords.push_back( typename Patch::GridCoord( (float)i/(float)n, i ) );
+    }
+
+    std::map<GridKey, int> shared;
+
+    std::vector<int> gridIndices(nsamples), offsets(nsamples);
+
+    for (int i=0; i<GetMesh()->GetNumCoarseFaces(); ++i) {
+
+        HbrFace<T> * f = _mesh->GetFace(i);
+
+        if (f->IsHole())
+            continue;
+
+        int nquadrants =
+            GetMesh()->GetSubdivision()->FaceIsExtraordinary(GetMesh(), f) ?
+                f->GetNumVertices() : 1;
+
+        for (int quadrant=0; quadrant<nquadrants; ++quadrant) {
+
+            if (not SetCurrentFace(i, quadrant))
+                continue;
+
+            int stencilsize = _patch.GetStencilSize(),
+                firstStencil = stencilTables->GetNumStencils(),
+                nstencils = 0;
+
+            // Number the samples of the grid : the boundary samples that were
+            // already appended by a neighboring face are reused, the others
+            // are evaluated directly into the new stencils
+            for (int j=0, k=0; j<gridsize; ++j) {
+                for (int l=0; l<gridsize; ++l, ++k) {
+
+                    if (j==0 or l==0 or j==n or l==n) {
+
+                        GridKey key = _GetGridKey(f, quadrant, l, j, n);
+
+                        typename std::map<GridKey, int>::const_iterator it =
+                            shared.find(key);
+
+                        if (it!=shared.end()) {
+                            gridIndices[k] = it->second;
+                            offsets[k] = -1;
+                            continue;
+                        }
+                        shared.insert(std::make_pair(key, firstStencil+nstencils));
+                    }
+                    gridIndices[k] = firstStencil + nstencils;
+                    offsets[k] = nstencils * stencilsize;
+                    ++nstencils;
+                }
+            }
+
+            if (nstencils>0) {
+
+                _AddNewStencils( stencilTables, nstencils, stencilsize );
+
+                FarStencil stencil = stencilTables->GetStencil( firstStencil );
+
+                std::vector<int> const & indices = _patch.GetControlVertexIndices();
+
+                for (int j=0; j<nstencils; ++j) {
+                    for (int l=0; l<stencilsize; ++l) {
+                        stencil._indices[l] = indices[l];
+                    }
+                    stencil.Increment();
+                }
+
+                stencil = stencilTables->GetStencil( firstStencil );
+
+                _patch.GetGridStencils( f->GetEdge(quadrant), coords, coords,
+                                        gridsize, &offsets[0], reflevel,
+                                        stencil._point,
+                                        stencil._uderiv,
+                                        stencil._vderiv );
+            }
+
+            if (quads) {
+                for (int j=0; j<n; ++j) {
+                    for (int l=0; l<n; ++l) {
+                        int k = j*gridsize + l;
+                        quads->push_back(gridIndices[k]);
+                        quads->push_back(gridIndices[k+1]);
+                        quads->push_back(gridIndices[k+gridsize+1]);
+                        quads->push_back(gridIndices[k+gridsize]);
+                    }
+                }
+            }
+        }
+    }
+
+    return stencilTables->GetNumStencils() - first;
+}
+
+template <class T> typename FarStencilTablesFactory<T>::GridKey
+FarStencilTablesFactory<T>::_GetEdgeKey( HbrFace<T> const * f, int k, int pos, int n ) {
+
+    HbrVertex<T> const * org = f->GetVertex(k),
+                       * dst = f->GetVertex((k+1)%f->GetNumVertices());
+
+    if (pos==0)
+        return GridKey(0, org->GetID(), 0, 0);
+
+    if (pos==2*n)
+        return GridKey(0, dst->GetID(), 0, 0);
+
+    // edges are oriented from their lowest vertex ID
+    if (org->GetID() < dst->GetID()) {
+        return GridKey(1, org->GetID(), dst->GetID(), pos);
+    } else {
+        return GridKey(1, dst->GetID(), org->GetID(), 2*n-pos);
+    }
+}
+
+template <class T> typename FarStencilTablesFactory<T>::GridKey
+FarStencilTablesFactory<T>::_GetSubFaceKey( HbrFace<T> const * f, int k, int pos, int n ) {
+
+    if (pos==0)
+        return _GetEdgeKey(f, k, n, n);
+
+    if (pos==n)
+        return GridKey(3, f->GetID(), 0, 0);
+
+    return GridKey(2, f->GetID(), k, pos);
+}
+
+template <class T> typename FarStencilTablesFactory<T>::GridKey
+FarStencilTablesFactory<T>::_GetGridKey( HbrFace<T> * f, int quadrant,
+                                         int i, int j, int n ) const {
+
+    if (not _mesh->GetSubdivision()->FaceIsExtraordinary(_mesh, f)) {
+
+        // quads : (0,0) is the first vertex, u runs along the first edge
+        if (j==0) return _GetEdgeKey(f, 0, 2*i, n);
+        if (i==n) return _GetEdgeKey(f, 1, 2*j, n);
+        if (j==n) return _GetEdgeKey(f, 2, 2*(n-i), n);
+        return _GetEdgeKey(f, 3, 2*(n-j), n);
+    }
+
+    // sub-faces of non-quads : (0,0) is the vertex of the quadrant, (1,0)
+    // the middle of the next edge, (1,1) the center and (0,1) the middle
+    // of the previous edge
+    int prev = (quadrant+f->GetNumVertices()-1) % f->GetNumVertices();
+
+    if (j==0) return _GetEdgeKey(f, quadrant, i, n);
+    if (i==n) return _GetSubFaceKey(f, quadrant, j, n);
+    if (j==n) return _GetSubFaceKey(f, prev, i, n);
+    return _GetEdgeKey(f, prev, 2*n-j, n);
+}
+
 template <class T> void
 FarStencilTablesFactory<T>::_AddNewStencils( FarStencilTables * tables,
                                              int nstencils, int stencilsize) {
@@ -626,6 +865,31 @@ public:
                           float *deriv1,
                           float *deriv2 );
 
+    // Parametric coordinate of a row (or column) of a grid of samples and
+    // its index in the grid
+    struct GridCoord {
+        GridCoord( float t_, int index_ ) : t(t_), index(index_) { }
+
+        float t;
+        int index;
+    };
+
+    typedef std::vector<GridCoord> GridCoordVector;
+
+    // Appends stencil weight coefficients for the samples at the intersections
+    // of the given columns (u) and rows (v) : the coefficients of the sample
+    // of row j and column i are written at offsets[j*gridsize+i] (skipped if
+    // the offset is negative)
+    bool GetGridStencils( HbrHalfedge<T> * e,
+                          GridCoordVector const & ucoords,
+                          GridCoordVector const & vcoords,
+                          int gridsize,
+                          int const * offsets,
+                          int reflevel,
+                          float *point,
+                          float *deriv1,
+                          float *deriv2 );
+
 private:
 
     // True if the vertex has a BSpline limit
@@ -668,6 +932,15 @@ private:
                                   float *deriv1,
                                   float *deriv2 );
 
+    // Computes BSpline stencil weights for a grid of samples
+    void _GetBSplineGridStencils( GridCoordVector const & ucoords,
+                                  GridCoordVector const & vcoords,
+                                  int gridsize,
+                                  int const * offsets,
+                                  float *point,
+                                  float *deriv1,
+                                  float *deriv2 );
+
     HbrFace<T> * _face; // current face
 
     int _quadrant,      // current quadrant (if _face is not a quad)
@@ -690,15 +963,11 @@ FarStencilTablesFactory<T>::Patch::SetupControlStencils( HbrFace<T> * f,
 
     assert(f and f->IsCoarse());
 
-    // same face and same quadrant: control stencil and cached bspline patch
-    // stay the same
-    if (quadrant==GetCurrentQuadrant() and f==GetCurrentFace())
-        return;
+    // the mesh was unrefined : the cached bspline patch must be invalidated
+    _bsplineFace = NULL;
 
-    // new face or new quadrant: control stencil may still be the same, but
-    // cached bspline patch must be invalidated
+    // same face: control stencil stays the same
     _quadrant = quadrant;
-    _bsplineFace = NULL;
     if (f==GetCurrentFace())
         return;
 
@@ -961,6 +1230,107 @@ FarStencilTablesFactory<T>::Patch::GetStencilsAtUV( HbrHalfedge<T> * e,
     return true;
 }
 
+// Evaluate the surface for a grid of samples of the quad face left of edge.
+// The samples are split between the sub-faces exactly as GetStencilsAtUV
+// does, but each B-spline sub-face evaluates all its samples at once.
+template <class T> bool
+FarStencilTablesFactory<T>::Patch::GetGridStencils( HbrHalfedge<T> * e,
+                                                    GridCoordVector const & ucoords,
+                                                    GridCoordVector const & vcoords,
+                                                    int gridsize,
+                                                    int const * offsets,
+                                                    int reflevel,
+                                                    float *point,
+                                                    float *uderiv,
+                                                    float *vderiv ) {
+
+    assert( _allocator );
+
+    HbrFace<T> * f = e->GetLeftFace();
+
+    if (f->IsHole())
+        return false;
+
+    // non-quad ? get corresponding quadrant sub-face
+    if (f->GetMesh()->GetSubdivision()->FaceIsExtraordinary(f->GetMesh(), f)) {
+
+        f->Refine();
+        f = f->GetChild(GetCurrentQuadrant());
+    }
+
+    if (f==_bsplineFace or _IsaBSpline(f)) {
+
+        if (f!=_bsplineFace)
+            _UpdateBSplineStencils( f );
+
+        _GetBSplineGridStencils( ucoords, vcoords, gridsize, offsets, point, uderiv, vderiv );
+        return true;
+    }
+
+    // We reached the maximum recursion : interpolate each sample
+    if (reflevel==0) {
+
+        for (int j=0; j<(int)vcoords.size(); ++j) {
+            for (int i=0; i<(int)ucoords.size(); ++i) {
+
+                int ofs = offsets[vcoords[j].index*gridsize + ucoords[i].index];
+                if (ofs<0)
+                    continue;
+
+                GetStencilsAtUV( e, ucoords[i].t, vcoords[j].t, 0, point + ofs,
+                                 uderiv ? uderiv + ofs : 0,
+                                 vderiv ? vderiv + ofs : 0 );
+            }
+        }
+        return true;
+    }
+
+    f->Refine();
+
+    // Split the rows and columns between the 4 sub-faces
+    GridCoordVector usplit[2], vsplit[2];
+
+    for (int i=0; i<(int)ucoords.size(); ++i) {
+        float u = ucoords[i].t;
+        if (u<=0.5f) {
+            usplit[0].push_back( GridCoord(2.0f*u, ucoords[i].index) );
+        } else {
+            u-=0.5f;
+            usplit[1].push_back( GridCoord(2.0f*u, ucoords[i].index) );
+        }
+    }
+
+    for (int i=0; i<(int)vcoords.size(); ++i) {
+        float v = vcoords[i].t;
+        if (v<=0.5f) {
+            vsplit[0].push_back( GridCoord(2.0f*v, vcoords[i].index) );
+        } else {
+            v-=0.5f;
+            vsplit[1].push_back( GridCoord(2.0f*v, vcoords[i].index) );
+        }
+    }
+
+    // u and v halves of each quadrant
+    static int const halves[4][2] = { {0, 0}, {1, 0}, {1, 1}, {0, 1} };
+
+    for (int quadrant=0; quadrant<4; ++quadrant) {
+
+        GridCoordVector const & usub = usplit[halves[quadrant][0]],
+                              & vsub = vsplit[halves[quadrant][1]];
+
+        if (usub.empty() or vsub.empty())
+            continue;
+
+        HbrVertex<T> * a = f->GetVertex(quadrant)->Subdivide(),
+                     * b = f->GetEdge(quadrant)->Subdivide();
+
+        HbrHalfedge<T> * subedge = a->GetEdge(b);
+
+        GetGridStencils( subedge, usub, vsub, gridsize, offsets, reflevel-1, point, uderiv, vderiv );
+    }
+    return true;
+}
+
 // True if the vertex has a BSpline limit
 template <class T> bool
 FarStencilTablesFactory<T>::Patch::_IsaBSpline( HbrVertex<T> * v ) {
@@ -1365,6 +1735,109 @@ FarStencilTablesFactory<T>::Patch::_GetBSplineStencilsAtUV( float u,
     }
 }
 
+// Computes BSpline stencil weights for a grid of samples : the tensor product
+// weights are factored so that the 16 control stencils are combined once per
+// row into 4 row stencils, and each sample only combines the row stencils.
+template <class T> void
+FarStencilTablesFactory<T>::Patch::_GetBSplineGridStencils( GridCoordVector const & ucoords,
+                                                            GridCoordVector const & vcoords,
+                                                            int gridsize,
+                                                            int const * offsets,
+                                                            float *point,
+                                                            float *deriv1,
+                                                            float *deriv2 ) {
+
+    int stencilsize = GetStencilSize(),
+        nu = (int)ucoords.size(),
+        nv = (int)vcoords.size();
+
+    bool derivs = deriv1 and deriv2;
+
+    // Cubic weights and tangent weights (differences of the quadratic
+    // weights) of each column and row
+    std::vector<float> uWeights(4*nu), duWeights(4*nu),
+                       vWeights(4*nv), dvWeights(4*nv);
+
+    for (int k=0; k<2; ++k) {
+
+        GridCoordVector const & coords = k ? vcoords : ucoords;
+
+        float * weights = k ? &vWeights[0] : &uWeights[0],
+              * dweights = k ? &dvWeights[0] : &duWeights[0];
+
+        for (int i=0; i<(int)coords.size(); ++i, weights+=4, dweights+=4) {
+
+            float quadraticWeights[3];
+            _GetBSplineWeights(coords[i].t, weights, quadraticWeights);
+
+            dweights[0] = -quadraticWeights[0];
+            dweights[1] = quadraticWeights[0] - quadraticWeights[1];
+            dweights[2] = quadraticWeights[1] - quadraticWeights[2];
+            dweights[3] = quadraticWeights[2];
+        }
+    }
+
+    FarVertexStencil * rows[4], * drows[4];
+    for (int j=0; j<4; ++j) {
+        rows[j] = _allocator->Allocate();
+        drows[j] = _allocator->Allocate();
+    }
+
+    for (int r=0; r<nv; ++r) {
+
+        float const * vw = &vWeights[4*r],
+                    * dvw = &dvWeights[4*r];
+
+        // Combine the control stencils of each column of the patch with the
+        // weights of the row
+        for (int j=0; j<4; ++j) {
+            rows[j]->Reset(0.0f);
+            for (int i=0; i<4; ++i) {
+                rows[j]->AddScaled(*_bsplineStencils[4*i+j], vw[i]);
+            }
+
+            if (derivs) {
+                drows[j]->Reset(0.0f);
+                for (int i=0; i<4; ++i) {
+                    drows[j]->AddScaled(*_bsplineStencils[4*i+j], dvw[i]);
+                }
+            }
+        }
+
+        for (int c=0; c<nu; ++c) {
+
+            float const * uw = &uWeights[4*c],
+                        * duw = &duWeights[4*c];
+
+            int ofs = offsets[vcoords[r].index*gridsize + ucoords[c].index];
+            if (ofs<0)
+                continue;
+
+            FarVertexStencil::Reset(point + ofs, 0.0f, stencilsize);
+            for (int j=0; j<4; ++j) {
+                FarVertexStencil::AddScaled(point + ofs, rows[j], uw[j]);
+            }
+
+            if (derivs) {
+
+                FarVertexStencil::Reset(deriv1 + ofs, 0.0f, stencilsize);
+                FarVertexStencil::Reset(deriv2 + ofs, 0.0f, stencilsize);
+
+                for (int j=0; j<4; ++j) {
+                    FarVertexStencil::AddScaled(deriv1 + ofs, rows[j], duw[j]);
+                    FarVertexStencil::AddScaled(deriv2 + ofs, drows[j], uw[j]);
+                }
+                _ScaleTangentStencil(_bsplineFace, stencilsize, deriv1 + ofs, deriv2 + ofs);
+            }
+        }
+    }
+
+    for (int j=0; j<4; ++j) {
+        _allocator->Deallocate(rows[j]);
+        _allocator->Deallocate(drows[j]);
+    }
+}
+
 // Computes the limit stencils
 template <class T> void
 FarStencilTablesFactory<T>::Patch::_GetLimitStencils( HbrVertex<T> * v,
@@ -0,0 +1,442 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef FAR_STENCILTABLES_OPTIMIZER_H
+#define FAR_STENCILTABLES_OPTIMIZER_H
+
+#include "../version.h"
+
+#include "../far/stencilTables.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Reorders stencil tables for the locality of the control vertex reads
+///
+/// Stencils are created in the order of their samples, and consecutive
+/// stencils can read control vertices anywhere in the control vertex buffer :
+/// on large meshes, applying the stencils is then dominated by the cache
+/// misses on the control vertices. The FarStencilTablesOptimizer creates a
+/// copy of the stencil tables where the stencils that read the same control
+/// vertices are next to each other :
+///
+///   - the control vertices are ordered by a breadth-first traversal (Cuthill
+///     McKee) of the graph that links the vertices read by a same stencil,
+///     which keeps the vertices of a neighborhood of the surface close in the
+///     ordering
+///
+///   - the stencils are sorted by the lowest rank of their control vertices
+///     in this ordering (stable sort : the samples of a same patch stay
+///     together)
+///
+///   - the sorted stencils are tiled in blocks that read at most a given
+///     number of distinct control vertices : the working set of a block fits
+///     in the cache, and parallel evaluations can schedule the blocks as
+///     tasks
+///
+/// The stencils are not modified, only their order : the permutation is
+/// returned so that the clients can find the results of their samples.
+/// Optionally the control vertices can be renumbered too, in the order in
+/// which the sorted stencils first read them, which makes the control reads
+/// almost sequential. The client must then reorder its control vertex data.
+///
+/// Ex :
+/// \code
+/// std::vector<int> permutation, blocks;
+/// FarStencilTables * optimized =
+///     FarStencilTablesOptimizer::Create(stencils, &permutation, &blocks);
+///
+/// // results of the optimized stencils
+/// controller.UpdateValues(context, ...);
+///
+/// // result of stencil i of the optimized tables = sample permutation[i]
+/// \endcode
+///
+class FarStencilTablesOptimizer {
+
+public:
+
+    /// \brief Creates a copy of the stencil tables reordered for locality
+    ///
+    /// @param stencils            The stencils to reorder
+    ///
+    /// @param permutation         Receives the index in 'stencils' of each
+    ///                            stencil of the result
+    ///
+    /// @param blocks              Optional : receives the index of the first
+    ///                            stencil of each block, followed by the number
+    ///                            of stencils (blocks->size()-1 blocks)
+    ///
+    /// @param maxBlockVertices    The maximum number of distinct control
+    ///                            vertices read by the stencils of a block (a
+    ///                            single stencil can exceed it). For a 256KB
+    ///                            L2 cache, with half of it left for the
+    ///                            stencil weights and results, and vertices of
+    ///                            3 floats : 128KB / 12B ~ 10000 vertices
+    ///
+    /// @param controlPermutation  Optional : if not NULL, the control vertices
+    ///                            are renumbered and controlPermutation
+    ///                            receives the new index of each control
+    ///                            vertex (the vertices read by no stencil are
+    ///                            moved after the others). The control data
+    ///                            must be reordered the same way :
+    ///                            new[controlPermutation[i]] = old[i]
+    ///
+    /// @return                    The reordered stencil tables
+    ///
+    static FarStencilTables * Create( FarStencilTables const * stencils,
+                                      std::vector<int> * permutation,
+                                      std::vector<int> * blocks=0,
+                                      int maxBlockVertices=10000,
+                                      std::vector<int> * controlPermutation=0 );
+
+private:
+
+    // Returns the number of control vertices (highest index + 1)
+    static int getNumControlVertices( FarStencilTables const * stencils );
+
+    // Returns one stencil of each distinct set of control vertices (the
+    // samples of a same patch share their control vertices)
+    static void getDistinctSupports( FarStencilTables const * stencils,
+                                     std::vector<int> & result );
+
+    // Ranks the control vertices with a breadth-first traversal of the graph
+    // linking the dominant vertex of each distinct stencil to its other
+    // vertices
+    static void rankControlVertices( FarStencilTables const * stencils,
+                                     std::vector<int> const & dominant,
+                                     int numControlVertices,
+                                     std::vector<int> & ranks );
+};
+
+inline int
+FarStencilTablesOptimizer::getNumControlVertices( FarStencilTables const * stencils ) {
+
+    std::vector<int> const & indices = stencils->GetControlIndices();
+
+    int result = 0;
+    for (int i=0; i<(int)indices.size(); ++i) {
+        result = std::max(result, indices[i]+1);
+    }
+    return result;
+}
+
+inline void
+FarStencilTablesOptimizer::getDistinctSupports( FarStencilTables const * stencils,
+                                                std::vector<int> & result ) {
+
+    int nstencils = stencils->GetNumStencils();
+
+    std::vector<int> const & sizes = stencils->GetSizes(),
+                     & offsets = stencils->GetOffsets(),
+                     & indices = stencils->GetControlIndices();
+
+    // Sort the stencils by a hash of their control vertices (FNV-1a)
+    std::vector<std::pair<unsigned int, int> > hashes(nstencils);
+
+    for (int i=0; i<nstencils; ++i) {
+        unsigned int hash = 2166136261u;
+        for (int j=offsets[i]; j<offsets[i]+sizes[i]; ++j) {
+            hash = (hash ^ (unsigned int)indices[j]) * 16777619u;
+        }
+        hashes[i] = std::make_pair(hash, i);
+    }
+    std::sort(hashes.begin(), hashes.end());
+
+    result.clear();
+    for (int i=0; i<nstencils; ++i) {
+
+        int s = hashes[i].second;
+
+        // same hash : compare with the previous distinct support
+        if (i>0 and hashes[i].first==hashes[i-1].first and not result.empty()) {
+            int prev = result.back();
+            if (sizes[s]==sizes[prev] and
+                std::equal(&indices[0]+offsets[s], &indices[0]+offsets[s]+sizes[s],
+                           &indices[0]+offsets[prev])) {
+                continue;
+            }
+        }
+        result.push_back(s);
+    }
+}
+
+inline void
+FarStencilTablesOptimizer::rankControlVertices( FarStencilTables const * stencils,
+                                                std::vector<int> const & dominant,
+                                                int numControlVertices,
+                                                std::vector<int> & ranks ) {
+
+    std::vector<int> const & sizes = stencils->GetSizes(),
+                     & offsets = stencils->GetOffsets(),
+                     & indices = stencils->GetControlIndices();
+
+    std::vector<int> distinct;
+    getDistinctSupports(stencils, distinct);
+
+    // Adjacency of the control vertices (compressed rows) : every vertex of a
+    // stencil is linked to its dominant vertex, both ways
+    std::vector<int> adjOffsets(numControlVertices+1, 0);
+
+    for (int k=0; k<(int)distinct.size(); ++k) {
+        int i = distinct[k];
+        if (dominant[i]<0)
+            continue;
+        int const * index = &indices[offsets[i]];
+        for (int j=0; j<sizes[i]; ++j) {
+            if (index[j]!=dominant[i]) {
+                ++adjOffsets[index[j]+1];
+                ++adjOffsets[dominant[i]+1];
+            }
+        }
+    }
+
+    for (int i=0; i<numControlVertices; ++i) {
+        adjOffsets[i+1] += adjOffsets[i];
+    }
+
+    std::vector<int> adjacency(adjOffsets.back()),
+                     fill(adjOffsets.begin(), adjOffsets.end()-1);
+
+    for (int k=0; k<(int)distinct.size(); ++k) {
+        int i = distinct[k];
+        if (dominant[i]<0)
+            continue;
+        int const * index = &indices[offsets[i]];
+        for (int j=0; j<sizes[i]; ++j) {
+            if (index[j]!=dominant[i]) {
+                adjacency[fill[index[j]]++] = dominant[i];
+                adjacency[fill[dominant[i]]++] = index[j];
+            }
+        }
+    }
+
+    // Breadth-first traversal of each connected component
+    ranks.assign(numControlVertices, -1);
+
+    std::vector<int> queue;
+    queue.reserve(numControlVertices);
+
+    for (int seed=0; seed<numControlVertices; ++seed) {
+
+        if (ranks[seed]>=0)
+            continue;
+
+        int head = (int)queue.size();
+
+        ranks[seed] = (int)queue.size();
+        queue.push_back(seed);
+
+        for (; head<(int)queue.size(); ++head) {
+
+            int v = queue[head];
+
+            for (int j=adjOffsets[v]; j<adjOffsets[v+1]; ++j) {
+                int n = adjacency[j];
+                if (ranks[n]<0) {
+                    ranks[n] = (int)queue.size();
+                    queue.push_back(n);
+                }
+            }
+        }
+    }
+}
+
+inline FarStencilTables *
+FarStencilTablesOptimizer::Create( FarStencilTables const * stencils,
+                                   std::vector<int> * permutation,
+                                   std::vector<int> * blocks,
+                                   int maxBlockVertices,
+                                   std::vector<int> * controlPermutation ) {
+
+    assert(stencils and permutation);
+
+    int nstencils = stencils->GetNumStencils(),
+        ncontrols = getNumControlVertices(stencils);
+
+    std::vector<int> const & sizes = stencils->GetSizes(),
+                     & offsets = stencils->GetOffsets(),
+                     & indices = stencils->GetControlIndices();
+
+    std::vector<float> const & point = stencils->GetWeights();
+
+    // Dominant control vertex of each stencil (-1 if empty)
+    std::vector<int> dominant(nstencils, -1);
+
+    for (int i=0; i<nstencils; ++i) {
+        float wmax = -1.0f;
+        for (int j=offsets[i]; j<offsets[i]+sizes[i]; ++j) {
+            float w = point.empty() ? 1.0f : std::fabs(point[j]);
+            if (w>wmax) {
+                wmax = w;
+                dominant[i] = indices[j];
+            }
+        }
+    }
+
+    std::vector<int> ranks;
+    rankControlVertices(stencils, dominant, ncontrols, ranks);
+
+    // Sort the stencils by the lowest rank of their control vertices (the
+    // empty stencils last), keeping the original order of the ties : the
+    // stencils with the same control vertices (samples of a same patch) stay
+    // together. The keys are ranks : counting sort.
+    std::vector<int> keys(nstencils),
+                     counts(ncontrols+2, 0);
+
+    for (int i=0; i<nstencils; ++i) {
+        int key = ncontrols;
+        for (int j=offsets[i]; j<offsets[i]+sizes[i]; ++j) {
+            key = std::min(key, ranks[indices[j]]);
+        }
+        keys[i] = key;
+        ++counts[key+1];
+    }
+    for (int i=0; i<=ncontrols; ++i) {
+        counts[i+1] += counts[i];
+    }
+
+    permutation->resize(nstencils);
+    for (int i=0; i<nstencils; ++i) {
+        (*permutation)[counts[keys[i]]++] = i;
+    }
+
+    // Renumber the control vertices in the order of their first read
+    std::vector<int> remap;
+    if (controlPermutation) {
+
+        remap.assign(ncontrols, -1);
+
+        int next = 0;
+        for (int i=0; i<nstencils; ++i) {
+            int s = (*permutation)[i];
+            for (int j=offsets[s]; j<offsets[s]+sizes[s]; ++j) {
+                if (remap[indices[j]]<0) {
+                    remap[indices[j]] = next++;
+                }
+            }
+        }
+        for (int i=0; i<ncontrols; ++i) {
+            if (remap[i]<0) {
+                remap[i] = next++;
+            }
+        }
+        *controlPermutation = remap;
+    }
+
+    // Copy the stencils in their new order
+    FarStencilTables * result = new FarStencilTables;
+
+    result->_sizes.resize(nstencils);
+    result->_offsets.resize(nstencils);
+    result->_indices.resize(indices.size());
+
+    bool hasPoint = not point.empty(),
+         hasDerivs = not stencils->GetDuWeights().empty();
+
+    if (hasPoint) {
+        result->_point.resize(indices.size());
+    }
+    if (hasDerivs) {
+        result->_uderiv.resize(indices.size());
+        result->_vderiv.resize(indices.size());
+    }
+
+    for (int i=0, ofs=0; i<nstencils; ++i) {
+
+        int s = (*permutation)[i],
+            size = sizes[s],
+            src = offsets[s];
+
+        result->_sizes[i] = size;
+        result->_offsets[i] = ofs;
+
+        for (int j=0; j<size; ++j) {
+            int index = indices[src+j];
+            result->_indices[ofs+j] = remap.empty() ? index : remap[index];
+        }
+
+        if (hasPoint) {
+            std::copy(&point[src], &point[src]+size, &result->_point[ofs]);
+        }
+        if (hasDerivs) {
+            std::copy(&stencils->_uderiv[src], &stencils->_uderiv[src]+size, &result->_uderiv[ofs]);
+            std::copy(&stencils->_vderiv[src], &stencils->_vderiv[src]+size, &result->_vderiv[ofs]);
+        }
+        ofs += size;
+    }
+
+    // Tile the sorted stencils in blocks : a new block starts when the next
+    // stencil would read too many distinct control vertices
+    if (blocks) {
+
+        blocks->clear();
+
+        std::vector<int> marks(ncontrols, -1);
+
+        int nblocks = 0,
+            nverts = 0;
+
+        for (int i=0; i<nstencils; ++i) {
+
+            int const * index = &result->_indices[result->_offsets[i]];
+
+            int nnew = 0;
+            for (int j=0; j<result->_sizes[i]; ++j) {
+                if (marks[index[j]]!=nblocks-1) {
+                    ++nnew;
+                }
+            }
+
+            if (nblocks==0 or (nverts+nnew>maxBlockVertices and nverts>0)) {
+                blocks->push_back(i);
+                ++nblocks;
+                nverts = 0;
+            }
+
+            for (int j=0; j<result->_sizes[i]; ++j) {
+                if (marks[index[j]]!=nblocks-1) {
+                    marks[index[j]] = nblocks-1;
+                    ++nverts;
+                }
+            }
+        }
+        blocks->push_back(nstencils);
+    }
+
+    return result;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // FAR_STENCILTABLES_OPTIMIZER_H
@@ -0,0 +1,825 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+
+#ifndef FAR_SUBDIVISION_STENCILTABLES_FACTORY_H
+#define FAR_SUBDIVISION_STENCILTABLES_FACTORY_H
+
+#include "../version.h"
+
+#include "../hbr/mesh.h"
+#include "../hbr/catmark.h"
+
+#include "../far/dispatcher.h"
+#include "../far/mesh.h"
+#include "../far/stencilTables.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief A factory for stencils of refined vertices
+///
+/// The FarSubdivisionStencilTablesFactory flattens the FarSubdivisionTables
+/// of a mesh into FarStencilTables that express each vertex of a given level
+/// of subdivision as a direct weighted sum of the coarse control vertices.
+///
+/// Applying these stencils to the coarse vertices produces the same vertices
+/// as running all the kernel batches of the mesh up to that level, without
+/// computing (or storing) any of the intermediate levels. This is mostly useful
+/// for deforming meshes where only the finest level of refinement is used.
+///
+/// Unlike the FarStencilTablesFactory, the stencils are generated from the
+/// Far tables only, without requiring an HbrMesh.
+///
+/// \note The stencils only contain value weights : derivative weights are
+/// left empty.
+///
+/// \note Hierarchical edits cannot be represented by stencils : the factory
+/// fails on meshes with vertex edits.
+///
+/// The factory can also project the vertices of a level to the limit surface
+/// (see CreateLimit) : the limit stencils carry position, du and dv weights.
+///
+class FarSubdivisionStencilTablesFactory {
+
+public:
+
+    enum InterpolationMode {
+        INTERPOLATE_VERTEX,  ///< vertex interpolation rules
+        INTERPOLATE_VARYING  ///< varying interpolation rules
+    };
+
+    /// \brief Creates stencils for the vertices of a level of subdivision
+    ///
+    /// @param tables   The subdivision tables of the mesh
+    ///
+    /// @param batches  The kernel batches of the mesh
+    ///
+    /// @param level    The level of subdivision of the vertices. Stencils are
+    ///                 ordered like the vertices of that level in the vertex
+    ///                 buffer of the mesh.
+    ///
+    /// @param mode     The interpolation rules to use
+    ///
+    /// @return         The stencil tables, or NULL if the batches cannot be
+    ///                 represented by stencils (vertex edits or user-defined
+    ///                 kernels)
+    ///
+    static FarStencilTables * Create( FarSubdivisionTables const * tables,
+                                      FarKernelBatchVector const & batches,
+                                      int level,
+                                      InterpolationMode mode=INTERPOLATE_VERTEX );
+
+    /// \brief Creates stencils for the vertices of a level of subdivision
+    ///
+    /// @param mesh     The Far mesh
+    ///
+    /// @param level    The level of subdivision of the vertices
+    ///
+    /// @param mode     The interpolation rules to use
+    ///
+    /// @return         The stencil tables, or NULL on failure
+    ///
+    template <class U>
+    static FarStencilTables * Create( FarMesh<U> const * mesh,
+                                      int level,
+                                      InterpolationMode mode=INTERPOLATE_VERTEX ) {
+        assert(mesh);
+        return Create(mesh->GetSubdivisionTables(), mesh->GetKernelBatches(),
+                      level, mode);
+    }
+
+    /// \brief Creates stencils for all the vertices of a mesh
+    ///
+    /// The stencils are ordered like the vertex buffer of the mesh : the
+    /// coarse vertices, followed by the vertices of every level of
+    /// subdivision. This is what the control vertices of the patches of
+    /// feature adaptive meshes index (see FarLimitStencilTablesFactory).
+    ///
+    /// @param tables   The subdivision tables of the mesh
+    ///
+    /// @param batches  The kernel batches of the mesh
+    ///
+    /// @param mode     The interpolation rules to use
+    ///
+    /// @return         The stencil tables, or NULL if the batches cannot be
+    ///                 represented by stencils (vertex edits or user-defined
+    ///                 kernels)
+    ///
+    static FarStencilTables * CreateAll( FarSubdivisionTables const * tables,
+                                         FarKernelBatchVector const & batches,
+                                         InterpolationMode mode=INTERPOLATE_VERTEX );
+
+    /// \brief Creates limit stencils for the vertices of a level of
+    /// subdivision
+    ///
+    /// The limit position and tangents of each vertex are obtained by applying
+    /// the Catmull-Clark (or Loop, for triangle meshes) limit masks to its
+    /// 1-ring in that level (smooth, crease and corner rules). Semi-sharp
+    /// features that are still volatile at that level are projected with the
+    /// rule of their current sharpness.
+    ///
+    /// Tangents are scaled to the parametric space of the coarse faces.
+    ///
+    /// @param hmesh    The Hbr mesh the FarMesh was created from, refined up
+    ///                 to 'level'
+    ///
+    /// @param remap    The Hbr vertex ID to FarMesh vertex index remapping
+    ///                 table (see FarMeshFactory::GetRemappingTable)
+    ///
+    /// @param tables   The subdivision tables of the FarMesh
+    ///
+    /// @param level    The level of subdivision of the vertices (> 0)
+    ///
+    /// @param refined  Optional stencils of the vertices of 'level' (see
+    ///                 Create). If provided, the limit stencils are composed
+    ///                 with them and index the coarse vertices directly.
+    ///                 Otherwise they index the vertex buffer of the FarMesh.
+    ///
+    /// @return         The stencil tables, or NULL if the faces of the level
+    ///                 are neither all quads nor all triangles
+    ///
+    template <class T>
+    static FarStencilTables * CreateLimit( HbrMesh<T> * hmesh,
+                                           std::vector<int> const & remap,
+                                           FarSubdivisionTables const * tables,
+                                           int level,
+                                           FarStencilTables const * refined=0 );
+
+private:
+
+    // Sparse vertex class accumulating the weights of the coarse vertices.
+    // It implements the vertex API of the FarSubdivisionTables kernels.
+    template <bool VARYING> class StencilVertex {
+    public:
+        typedef std::pair<int, float> Weight;
+
+        void Clear( void * =0 ) {
+            _weights.clear();
+        }
+
+        void AddWithWeight( StencilVertex const & src, float weight ) {
+            if (not VARYING)
+                addScaled(src, weight);
+        }
+
+        void AddVaryingWithWeight( StencilVertex const & src, float weight ) {
+            if (VARYING)
+                addScaled(src, weight);
+        }
+
+        // vertex edits are rejected before any kernel is applied
+        void ApplyVertexEdit( FarVertexEdit const & ) {
+            assert(0);
+        }
+
+        void SetCoarseVertex( int index ) {
+            _weights.assign(1, Weight(index, 1.0f));
+        }
+
+        // Sorts the weights and merges the contributions of each coarse vertex
+        void Compact();
+
+        // Releases the memory of a vertex that is no longer referenced
+        void Release() {
+            std::vector<Weight>().swap(_weights);
+        }
+
+        std::vector<Weight> const & GetWeights() const {
+            return _weights;
+        }
+
+    private:
+        void addScaled( StencilVertex const & src, float weight ) {
+            if (weight==0.0f)
+                return;
+            for (int i=0; i<(int)src._weights.size(); ++i) {
+                _weights.push_back(Weight(src._weights[i].first,
+                                          src._weights[i].second * weight));
+            }
+        }
+
+        std::vector<Weight> _weights;
+    };
+
+    // Refinement context passed to the FarComputeController
+    template <class VERTEX> class Context {
+    public:
+        typedef VERTEX VertexType;
+
+        Context( FarSubdivisionTables const * tables, int numVertices ) :
+            _tables(tables), _vertices(numVertices) { }
+
+        std::vector<VERTEX> & GetVertices() { return _vertices; }
+
+        FarSubdivisionTables const * GetSubdivisionTables() const { return _tables; }
+
+        FarVertexEditTables const * GetVertexEditTables() const { return 0; }
+
+    private:
+        FarSubdivisionTables const * _tables;
+        std::vector<VERTEX> _vertices;
+    };
+
+    // Varying data is only interpolated by the first pass of the multi-pass
+    // vertex kernels (the Far kernels would add the parent vertex twice)
+    class VaryingComputeController : public FarComputeController {
+    public:
+        template <class CONTEXT>
+        void ApplyCatmarkVertexVerticesKernelA2(FarKernelBatch const &, CONTEXT *) const { }
+
+        template <class CONTEXT>
+        void ApplyLoopVertexVerticesKernelA2(FarKernelBatch const &, CONTEXT *) const { }
+    };
+
+    // Limit weights of a single vertex
+    class LimitStencil {
+    public:
+        void Add( int index, float point, float du, float dv );
+
+        std::vector<int>   indices;
+        std::vector<float> point,
+                           du,
+                           dv;
+    };
+
+    template <class T>
+    static bool getLimitStencil( HbrVertex<T> * v,
+                                 std::vector<int> const & remap,
+                                 float scale,
+                                 LimitStencil & stencil );
+
+    // Loop limit masks ('a' and 'b' are the crease edges of k_Crease vertices)
+    template <class T>
+    static void getLoopLimitStencil( HbrVertex<T> * v,
+                                     std::vector<HbrVertex<T> *> const & ring,
+                                     unsigned char mask, int a, int b,
+                                     std::vector<int> const & remap,
+                                     float scale,
+                                     LimitStencil & stencil );
+
+    // Stencils of the vertices of 'level', or of all the vertices up to
+    // 'level' if 'allLevels' is true
+    template <bool VARYING, class CONTROLLER>
+    static FarStencilTables * create( FarSubdivisionTables const * tables,
+                                      FarKernelBatchVector const & batches,
+                                      int level,
+                                      bool allLevels );
+};
+
+template <bool VARYING> void
+FarSubdivisionStencilTablesFactory::StencilVertex<VARYING>::Compact() {
+
+    if (_weights.size()<2)
+        return;
+
+    std::sort(_weights.begin(), _weights.end());
+
+    int n=0;
+    for (int i=1; i<(int)_weights.size(); ++i) {
+        if (_weights[i].first==_weights[n].first) {
+            _weights[n].second += _weights[i].second;
+        } else {
+            _weights[++n] = _weights[i];
+        }
+    }
+    _weights.resize(n+1);
+}
+
+inline FarStencilTables *
+FarSubdivisionStencilTablesFactory::Create( FarSubdivisionTables const * tables,
+                                            FarKernelBatchVector const & batches,
+                                            int level,
+                                            InterpolationMode mode ) {
+
+    if ((not tables) or level<0 or level>=tables->GetMaxLevel())
+        return 0;
+
+    if (mode==INTERPOLATE_VARYING) {
+        return create<true, VaryingComputeController>(tables, batches, level, false);
+    } else {
+        return create<false, FarComputeController>(tables, batches, level, false);
+    }
+}
+
+inline FarStencilTables *
+FarSubdivisionStencilTablesFactory::CreateAll( FarSubdivisionTables const * tables,
+                                               FarKernelBatchVector const & batches,
+                                               InterpolationMode mode ) {
+
+    if ((not tables) or tables->GetMaxLevel()<1)
+        return 0;
+
+    int level = tables->GetMaxLevel()-1;
+
+    if (mode==INTERPOLATE_VARYING) {
+        return create<true, VaryingComputeController>(tables, batches, level, true);
+    } else {
+        return create<false, FarComputeController>(tables, batches, level, true);
+    }
+}
+
+template <bool VARYING, class CONTROLLER> FarStencilTables *
+FarSubdivisionStencilTablesFactory::create( FarSubdivisionTables const * tables,
+                                            FarKernelBatchVector const & batches,
+                                            int level,
+                                            bool allLevels ) {
+
+    typedef StencilVertex<VARYING> Vertex;
+
+    Context<Vertex> context(tables, tables->GetNumVerticesTotal(level));
+
+    std::vector<Vertex> & vertices = context.GetVertices();
+
+    // coarse vertices are their own stencils
+    int nCoarseVertices = tables->GetNumVertices(0);
+    for (int i=0; i<nCoarseVertices; ++i) {
+        vertices[i].SetCoarseVertex(i);
+    }
+
+    CONTROLLER controller;
+
+    int currentLevel = 0;
+    for (int i=0; i<(int)batches.size(); ++i) {
+
+        FarKernelBatch const & batch = batches[i];
+
+        if (batch.GetLevel()>level)
+            continue;
+
+        if (batch.GetKernelType()==FarKernelBatch::HIERARCHICAL_EDIT)
+            return 0;
+
+        // vertices of level n are only referenced by the vertices of level
+        // n+1 : release the levels we are done with
+        if (batch.GetLevel()>currentLevel and (not allLevels)) {
+            currentLevel = batch.GetLevel();
+            for (int l=1; l<currentLevel-1; ++l) {
+                int first = tables->GetFirstVertexOffset(l),
+                    last = first + tables->GetNumVertices(l);
+                for (int j=first; j<last; ++j) {
+                    vertices[j].Release();
+                }
+            }
+        }
+
+        if (not FarDispatcher::ApplyKernel(&controller, &context, batch))
+            return 0;
+
+        int first = batch.GetVertexOffset() + batch.GetStart(),
+            last = batch.GetVertexOffset() + batch.GetEnd();
+        for (int j=first; j<last; ++j) {
+            vertices[j].Compact();
+        }
+    }
+
+    // serialize the stencils of the requested level(s)
+    int firstVertex = allLevels ? 0 : tables->GetFirstVertexOffset(level),
+        nstencils = allLevels ? tables->GetNumVerticesTotal(level) :
+                                tables->GetNumVertices(level);
+
+    FarStencilTables * result = new FarStencilTables;
+
+    result->_sizes.resize(nstencils);
+    result->_offsets.resize(nstencils);
+
+    int size=0;
+    for (int i=0; i<nstencils; ++i) {
+        result->_offsets[i] = size;
+        result->_sizes[i] = (int)vertices[firstVertex+i].GetWeights().size();
+        size += result->_sizes[i];
+    }
+
+    result->_indices.resize(size);
+    result->_point.resize(size);
+
+    int * indices = size ? &result->_indices[0] : 0;
+    float * point = size ? &result->_point[0] : 0;
+
+    for (int i=0; i<nstencils; ++i) {
+        typename std::vector<typename Vertex::Weight> const & weights =
+            vertices[firstVertex+i].GetWeights();
+        for (int j=0; j<(int)weights.size(); ++j) {
+            *indices++ = weights[j].first;
+            *point++ = weights[j].second;
+        }
+    }
+
+    return result;
+}
+
+inline void
+FarSubdivisionStencilTablesFactory::LimitStencil::Add( int index,
+                                                       float p,
+                                                       float u,
+                                                       float v ) {
+
+    for (int i=0; i<(int)indices.size(); ++i) {
+        if (indices[i]==index) {
+            point[i] += p;
+            du[i] += u;
+            dv[i] += v;
+            return;
+        }
+    }
+    indices.push_back(index);
+    point.push_back(p);
+    du.push_back(u);
+    dv.push_back(v);
+}
+
+template <class T> bool
+FarSubdivisionStencilTablesFactory::getLimitStencil( HbrVertex<T> * v,
+                                                     std::vector<int> const & remap,
+                                                     float scale,
+                                                     LimitStencil & stencil ) {
+
+    // Gather the 1-ring of the vertex : 'ring' holds the edge neighbors and
+    // 'diag' the opposite vertex of each quad, face i sitting between ring[i]
+    // and ring[i+1]. Boundary vertices start on their first boundary edge.
+    std::vector<HbrVertex<T> *> ring, diag;
+    std::vector<bool> sharp;
+
+    bool boundary = false;
+
+    HbrHalfedge<T> * start = v->GetIncidentEdge(), * e = start;
+
+    // Loop triangles or Catmark quads
+    int nsides = start->GetFace()->GetNumVertices();
+    if (nsides!=3 and nsides!=4)
+        return false;
+
+    while (e) {
+        if (e->GetFace()->GetNumVertices()!=nsides)
+            return false;
+
+        ring.push_back(e->GetDestVertex());
+        diag.push_back(e->GetNext()->GetDestVertex());
+        sharp.push_back(e->IsBoundary() or e->IsSharp(false));
+
+        HbrHalfedge<T> * next = v->GetNextEdge(e);
+        if (next==start) {
+            break;
+        } else if (not next) {
+            ring.push_back(e->GetPrev()->GetOrgVertex());
+            sharp.push_back(true);
+            boundary = true;
+            break;
+        }
+        e = next;
+    }
+
+    int n = (int)ring.size();
+    if (n<2)
+        return false;
+
+    int vidx = remap[v->GetID()];
+
+    unsigned char mask = v->GetMask(false);
+
+    // boundaries are creases, whatever the boundary interpolation rule
+    if (boundary and mask<HbrVertex<T>::k_Crease)
+        mask = HbrVertex<T>::k_Crease;
+
+    int a=-1, b=-1;
+    if (mask==HbrVertex<T>::k_Crease) {
+        for (int i=0; i<n; ++i) {
+            if (sharp[i]) {
+                if (a<0) {
+                    a = i;
+                } else {
+                    b = i;
+                    break;
+                }
+            }
+        }
+        if (b<0)
+            mask = HbrVertex<T>::k_Corner;
+    }
+
+    if (nsides==3) {
+        getLoopLimitStencil(v, ring, mask, a, b, remap, scale, stencil);
+        return true;
+    }
+
+    switch (mask) {
+
+        case HbrVertex<T>::k_Smooth:
+        case HbrVertex<T>::k_Dart: {
+
+            // point = (n^2 * v + 4 * sum(ring) + sum(diag)) / (n * (n+5))
+            float s = 1.0f / float(n*(n+5));
+
+            stencil.Add(vidx, s*n*n, 0.0f, 0.0f);
+
+            // tangents : Halstead et al. limit masks
+            float alpha = 2.0f * float(M_PI) / float(n),
+                  A = 1.0f + cosf(alpha) +
+                      cosf(0.5f*alpha) * sqrtf(2.0f*(9.0f + cosf(alpha)));
+
+            float d = 0.0f;
+            for (int i=0; i<n; ++i) {
+                float K1 = A * cosf(i*alpha),
+                      K2 = cosf(i*alpha) + cosf((i+1)*alpha);
+                d += fabsf(K1) + fabsf(K2);
+            }
+            float t = scale / d;
+
+            for (int i=0; i<n; ++i) {
+                int j = (i+1)%n;
+
+                float K1 = A * cosf(i*alpha) * t,
+                      K2 = (cosf(i*alpha) + cosf((i+1)*alpha)) * t;
+
+                stencil.Add(remap[ring[i]->GetID()], 4.0f*s, K1, 0.0f);
+                stencil.Add(remap[diag[i]->GetID()],      s, K2, 0.0f);
+                stencil.Add(remap[ring[j]->GetID()],   0.0f, 0.0f, K1);
+                stencil.Add(remap[diag[j]->GetID()],   0.0f, 0.0f, K2);
+            }
+        } break;
+
+        case HbrVertex<T>::k_Crease: {
+
+            int ia = remap[ring[a]->GetID()],
+                ib = remap[ring[b]->GetID()];
+
+            // point = (ring[a] + 4 * v + ring[b]) / 6
+            stencil.Add(vidx, 2.0f/3.0f, 0.0f, 0.0f);
+
+            // u tangent : along the crease
+            stencil.Add(ia, 1.0f/6.0f,  0.5f*scale, 0.0f);
+            stencil.Add(ib, 1.0f/6.0f, -0.5f*scale, 0.0f);
+
+            // v tangent : across the crease, on the side of faces a to b-1
+            int k = b-a;
+            if (k==1) {
+                float t = 0.5f * scale;
+                stencil.Add(remap[diag[a]->GetID()], 0.0f, 0.0f, t);
+                stencil.Add(ib,   0.0f, 0.0f,  t);
+                stencil.Add(ia,   0.0f, 0.0f, -t);
+                stencil.Add(vidx, 0.0f, 0.0f, -t);
+            } else {
+                // sine weighted interior edges and faces, exact for regular
+                // (k==2) creases
+                float theta = float(M_PI) / float(k), d = 0.0f;
+
+                std::vector<float> ew(k+1, 0.0f), fw(k, 0.0f);
+                for (int i=1; i<k; ++i) {
+                    ew[i] = sinf(i*theta);
+                    d += 2.0f * ew[i];
+                }
+                for (int i=0; i<k; ++i) {
+                    fw[i] = 0.25f * (sinf(i*theta) + sinf((i+1)*theta));
+                    d += 2.0f * fw[i];
+                }
+
+                float t = 2.0f * scale / d;
+                for (int i=1; i<k; ++i) {
+                    stencil.Add(remap[ring[a+i]->GetID()], 0.0f, 0.0f, ew[i]*t);
+                    stencil.Add(vidx, 0.0f, 0.0f, -ew[i]*t);
+                }
+                for (int i=0; i<k; ++i) {
+                    stencil.Add(remap[diag[a+i]->GetID()], 0.0f, 0.0f, fw[i]*t);
+                    stencil.Add(ia, 0.0f, 0.0f, -0.5f*fw[i]*t);
+                    stencil.Add(ib, 0.0f, 0.0f, -0.5f*fw[i]*t);
+                }
+            }
+        } break;
+
+        case HbrVertex<T>::k_Corner:
+        default: {
+
+            stencil.Add(vidx, 1.0f, -scale, -scale);
+            stencil.Add(remap[ring[0]->GetID()], 0.0f, scale, 0.0f);
+            stencil.Add(remap[ring[1]->GetID()], 0.0f, 0.0f, scale);
+        } break;
+    }
+    return true;
+}
+
+template <class T> void
+FarSubdivisionStencilTablesFactory::getLoopLimitStencil( HbrVertex<T> * v,
+                                                         std::vector<HbrVertex<T> *> const & ring,
+                                                         unsigned char mask, int a, int b,
+                                                         std::vector<int> const & remap,
+                                                         float scale,
+                                                         LimitStencil & stencil ) {
+
+    int n = (int)ring.size(),
+        vidx = remap[v->GetID()];
+
+    switch (mask) {
+
+        case HbrVertex<T>::k_Smooth:
+        case HbrVertex<T>::k_Dart: {
+
+            // point = (1 - n * gamma) * v + gamma * sum(ring)
+            float c = 0.375f + 0.25f * cosf(2.0f * float(M_PI) / float(n)),
+                  beta = (0.625f - c*c) / float(n),
+                  gamma = 1.0f / (0.375f/beta + float(n));
+
+            stencil.Add(vidx, 1.0f - float(n)*gamma, 0.0f, 0.0f);
+
+            // tangents along the edges to ring[0] and ring[1] (exact for
+            // regular vertices)
+            float alpha = 2.0f * float(M_PI) / float(n),
+                  t = 2.0f * scale / float(n);
+
+            for (int i=0; i<n; ++i) {
+                stencil.Add(remap[ring[i]->GetID()], gamma,
+                            cosf(i*alpha) * t,
+                            cosf((i-1)*alpha) * t);
+            }
+        } break;
+
+        case HbrVertex<T>::k_Crease: {
+
+            int ia = remap[ring[a]->GetID()],
+                ib = remap[ring[b]->GetID()];
+
+            // point = (ring[a] + 4 * v + ring[b]) / 6
+            stencil.Add(vidx, 2.0f/3.0f, 0.0f, 0.0f);
+
+            // u tangent : along the crease
+            stencil.Add(ia, 1.0f/6.0f,  0.5f*scale, 0.0f);
+            stencil.Add(ib, 1.0f/6.0f, -0.5f*scale, 0.0f);
+
+            // v tangent : across the crease, on the side of faces a to b-1
+            int k = b-a;
+            if (k==1) {
+                stencil.Add(ib,   0.0f, 0.0f,  scale);
+                stencil.Add(vidx, 0.0f, 0.0f, -scale);
+            } else {
+                // sine weighted interior edges, exact for regular (k==3)
+                // creases
+                float theta = float(M_PI) / float(k), d = 0.0f;
+                for (int i=1; i<k; ++i)
+                    d += sinf(i*theta) * sinf(i*theta);
+
+                float t = scale / d;
+                for (int i=1; i<k; ++i) {
+                    float w = sinf(i*theta) * t;
+                    stencil.Add(remap[ring[a+i]->GetID()], 0.0f, 0.0f, w);
+                    stencil.Add(vidx, 0.0f, 0.0f, -w);
+                }
+            }
+        } break;
+
+        case HbrVertex<T>::k_Corner:
+        default: {
+
+            stencil.Add(vidx, 1.0f, -scale, -scale);
+            stencil.Add(remap[ring[0]->GetID()], 0.0f, scale, 0.0f);
+            stencil.Add(remap[ring[1]->GetID()], 0.0f, 0.0f, scale);
+        } break;
+    }
+}
+
+template <class T> FarStencilTables *
+FarSubdivisionStencilTablesFactory::CreateLimit( HbrMesh<T> * hmesh,
+                                                 std::vector<int> const & remap,
+                                                 FarSubdivisionTables const * tables,
+                                                 int level,
+                                                 FarStencilTables const * refined ) {
+
+    if ((not hmesh) or (not tables) or level<1 or level>=tables->GetMaxLevel())
+        return 0;
+
+    int firstVertex = tables->GetFirstVertexOffset(level),
+        nstencils = tables->GetNumVertices(level);
+
+    if (refined and refined->GetNumStencils()!=nstencils)
+        return 0;
+
+    // tangents in the parametric space of the coarse faces
+    float scale = float(1 << level);
+
+    std::vector<LimitStencil> stencils(nstencils);
+
+    int nverts = std::min(hmesh->GetNumVertices(), (int)remap.size());
+    for (int i=0; i<nverts; ++i) {
+
+        int index = remap[i] - firstVertex;
+        if (index<0 or index>=nstencils)
+            continue;
+
+        HbrVertex<T> * v = hmesh->GetVertex(i);
+        if ((not v) or (not v->IsConnected()))
+            continue;
+
+        if (not getLimitStencil(v, remap, scale, stencils[index]))
+            return 0;
+    }
+
+    // compose with the refined stencils : accumulate the weights of the
+    // coarse vertices in dense scratch arrays
+    if (refined) {
+
+        int ncoarse = tables->GetNumVertices(0);
+
+        std::vector<float> point(ncoarse, 0.0f), du(ncoarse, 0.0f), dv(ncoarse, 0.0f);
+        std::vector<int> touched;
+        std::vector<bool> used(ncoarse, false);
+
+        for (int i=0; i<nstencils; ++i) {
+
+            LimitStencil & limit = stencils[i];
+
+            for (int j=0; j<(int)limit.indices.size(); ++j) {
+
+                FarStencil src = refined->GetStencil(limit.indices[j] - firstVertex);
+
+                int const * indices = src.GetVertexIndices();
+                float const * weights = src.GetValueWeights();
+
+                for (int k=0; k<src.GetSize(); ++k) {
+                    int c = indices[k];
+                    if (not used[c]) {
+                        used[c] = true;
+                        touched.push_back(c);
+                    }
+                    point[c] += limit.point[j] * weights[k];
+                    du[c] += limit.du[j] * weights[k];
+                    dv[c] += limit.dv[j] * weights[k];
+                }
+            }
+
+            std::sort(touched.begin(), touched.end());
+
+            LimitStencil composed;
+            for (int j=0; j<(int)touched.size(); ++j) {
+                int c = touched[j];
+                composed.indices.push_back(c);
+                composed.point.push_back(point[c]);
+                composed.du.push_back(du[c]);
+                composed.dv.push_back(dv[c]);
+                point[c] = du[c] = dv[c] = 0.0f;
+                used[c] = false;
+            }
+            touched.clear();
+
+            std::swap(limit, composed);
+        }
+    }
+
+    FarStencilTables * result = new FarStencilTables;
+
+    result->_sizes.resize(nstencils);
+    result->_offsets.resize(nstencils);
+
+    int size=0;
+    for (int i=0; i<nstencils; ++i) {
+        result->_offsets[i] = size;
+        result->_sizes[i] = (int)stencils[i].indices.size();
+        size += result->_sizes[i];
+    }
+
+    result->_indices.reserve(size);
+    result->_point.reserve(size);
+    result->_uderiv.reserve(size);
+    result->_vderiv.reserve(size);
+
+    for (int i=0; i<nstencils; ++i) {
+        LimitStencil const & limit = stencils[i];
+        result->_indices.insert(result->_indices.end(), limit.indices.begin(), limit.indices.end());
+        result->_point.insert(result->_point.end(), limit.point.begin(), limit.point.end());
+        result->_uderiv.insert(result->_uderiv.end(), limit.du.begin(), limit.du.end());
+        result->_vderiv.insert(result->_vderiv.end(), limit.dv.begin(), limit.dv.end());
+    }
+
+    return result;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_SUBDIVISION_STENCILTABLES_FACTORY_H */
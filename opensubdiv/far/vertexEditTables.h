@@ -90,6 +90,12 @@ public:
     void computeVertexEdits(int tableIndex, int offset, int tableOffset, int start, int end, CONTEXT *context) const;
 
     /// \brief This class holds an array of edits. each batch has unique index/width/operation
+    ///
+    /// Within a kernel batch the edits are sorted by vertex index. The edits
+    /// of a vertex are folded into a single Set or Add edit per level and
+    /// primvar, so that each vertex is edited at most once by the kernel
+    /// batches of a level : the edits can be applied in parallel, and the
+    /// Set and Add batches in any order.
     class VertexEditBatch {
     public:
         /// \brief Constructor
@@ -32,6 +32,7 @@
 #include "../far/vertexEditTables.h"
 #include "../far/kernelBatch.h"
 
+#include <algorithm>
 #include <cassert>
 #include <vector>
 
@@ -54,21 +55,30 @@ public:
 protected:
     template <class X, class Y> friend class FarMeshFactory;
 
-    /// \brief Compares the number of subfaces in an edit (for sorting purposes)
-    static bool compareEdits(HbrVertexEdit<T> const *a, HbrVertexEdit<T> const *b);
-    
     static void insertHEditBatch(FarKernelBatchVector *batches, int batchIndex, int batchLevel, int batchCount, int tableOffset);
 
+    /// \brief An edit resolved to the absolute index of the vertex it targets
+    struct ResolvedEdit {
+        int level,
+            primvarIndex,
+            primvarWidth,
+            order;          // rank of the edit in the Hbr edits
+        unsigned int vertexID;
+        FarVertexEdit::Operation op;
+        int valueOffset;    // offset of the edit values
+    };
+
+    /// \brief Sorts resolved edits by level, primvar, vertex and rank
+    static bool compareResolvedEdits(ResolvedEdit const &a, ResolvedEdit const &b);
+
+    /// \brief Folds the edits of a same level, primvar and vertex into a
+    /// single edit. Returns the edits sorted by level, primvar and vertex.
+    static void mergeEdits(std::vector<ResolvedEdit> & edits, std::vector<float> & values);
+
     /// \brief Creates a FarVertexEditTables instance.
     static FarVertexEditTables * Create( FarMeshFactory<T,U> const * factory, FarMesh<U> * mesh, FarKernelBatchVector *batches, int maxlevel );
 };
 
-template <class T, class U> bool
-FarVertexEditTablesFactory<T,U>::compareEdits(HbrVertexEdit<T> const *a, HbrVertexEdit<T> const *b) {
-
-    return a->GetNSubfaces() < b->GetNSubfaces();
-}
-
 template <class T, class U> void
 FarVertexEditTablesFactory<T,U>::insertHEditBatch(FarKernelBatchVector *batches, int batchIndex, int batchLevel, int batchCount, int tableOffset) {
 
@@ -83,6 +93,66 @@ FarVertexEditTablesFactory<T,U>::insertHEditBatch(FarKernelBatchVector *batches,
     batches->insert(it, FarKernelBatch( FarKernelBatch::HIERARCHICAL_EDIT, batchLevel+1, batchIndex, 0, batchCount, tableOffset, 0) );
 }
 
+template <class T, class U> bool
+FarVertexEditTablesFactory<T,U>::compareResolvedEdits(ResolvedEdit const &a, ResolvedEdit const &b) {
+
+    if (a.level != b.level) return a.level < b.level;
+    if (a.primvarIndex != b.primvarIndex) return a.primvarIndex < b.primvarIndex;
+    if (a.primvarWidth != b.primvarWidth) return a.primvarWidth < b.primvarWidth;
+    if (a.vertexID != b.vertexID) return a.vertexID < b.vertexID;
+    return a.order < b.order;
+}
+
+// The Osd kernels apply the edits of a kernel batch in parallel, and the Set
+// and Add edits of a level in separate batches : fold the edits of each vertex
+// into one edit, so that each vertex is written only once per level and
+// primvar, whatever the order of the batches. Applying the edits in sequence,
+// an Add is summed with the previous edits and a Set discards them : the
+// edits of a vertex fold into a Set of the last Set value plus the Adds that
+// follow it, or into the sum of the Adds if there is no Set.
+template <class T, class U> void
+FarVertexEditTablesFactory<T,U>::mergeEdits(std::vector<ResolvedEdit> & edits, std::vector<float> & values) {
+
+    std::sort(edits.begin(), edits.end(), compareResolvedEdits);
+
+    std::vector<ResolvedEdit> merged;
+    std::vector<float> mergedValues;
+    merged.reserve(edits.size());
+    mergedValues.reserve(values.size());
+
+    for (int i=0; i<(int)edits.size(); ++i) {
+
+        ResolvedEdit const & edit = edits[i];
+        float const * src = &values[edit.valueOffset];
+        int width = edit.primvarWidth;
+
+        bool sameVertex = i>0 and
+                          edit.level == edits[i-1].level and
+                          edit.primvarIndex == edits[i-1].primvarIndex and
+                          edit.primvarWidth == edits[i-1].primvarWidth and
+                          edit.vertexID == edits[i-1].vertexID;
+
+        if (sameVertex) {
+            ResolvedEdit & dst = merged.back();
+            float * dstValues = &mergedValues[dst.valueOffset];
+            if (edit.op == FarVertexEdit::Set) {
+                dst.op = FarVertexEdit::Set;
+                std::copy(src, src+width, dstValues);
+            } else {
+                for (int j=0; j<width; ++j)
+                    dstValues[j] += src[j];
+            }
+        } else {
+            merged.push_back(edit);
+            merged.back().valueOffset = (int)mergedValues.size();
+            mergedValues.insert(mergedValues.end(), src, src+width);
+        }
+    }
+
+    edits.swap(merged);
+    values.swap(mergedValues);
+}
+
 template <class T, class U> FarVertexEditTables * 
 FarVertexEditTablesFactory<T,U>::Create( FarMeshFactory<T,U> const * factory, FarMesh<U> * mesh, FarKernelBatchVector *batches, int maxlevel ) {
 
@@ -92,41 +162,62 @@ FarVertexEditTablesFactory<T,U>::Create( FarMeshFactory<T,U> const * factory, Fa
 
     std::vector<HbrHierarchicalEdit<T>*> const & hEdits = factory->_hbrMesh->GetHierarchicalEdits();
 
-    std::vector<HbrVertexEdit<T> const *> vertexEdits;
-    vertexEdits.reserve(hEdits.size());
+    // Resolve vertexedits path to absolute offset : Subtract edits are
+    // optimized into Add edits (fewer batches)
+    std::vector<ResolvedEdit> edits;
+    std::vector<float> values;
+    edits.reserve(hEdits.size());
 
     for (int i=0; i<(int)hEdits.size(); ++i) {
         HbrVertexEdit<T> *vedit = dynamic_cast<HbrVertexEdit<T> *>(hEdits[i]);
-        if (vedit) {
-            int editlevel = vedit->GetNSubfaces();
-            if (editlevel > maxlevel)
-                continue;   // far table doesn't contain such level
+        if (not vedit)
+            continue;
 
-            vertexEdits.push_back(vedit);
-        }
+        int level = vedit->GetNSubfaces();
+        if (level > maxlevel)
+            continue;   // far table doesn't contain such level
+
+        HbrFace<T> * f = factory->_hbrMesh->GetFace(vedit->GetFaceID());
+        for (int j=0; j<level; ++j)
+            f = f->GetChild(vedit->GetSubface(j));
+
+        int vertexID = f->GetVertex(vedit->GetVertexID())->GetID();
+
+        ResolvedEdit edit;
+        edit.level = level;
+        edit.primvarIndex = vedit->GetIndex();
+        edit.primvarWidth = vedit->GetWidth();
+        edit.order = i;
+        edit.vertexID = factory->_remapTable[vertexID];
+        edit.op = (vedit->GetOperation() == HbrHierarchicalEdit<T>::Set) ?
+            FarVertexEdit::Set : FarVertexEdit::Add;
+        edit.valueOffset = (int)values.size();
+
+        bool negate = (vedit->GetOperation() == HbrHierarchicalEdit<T>::Subtract);
+
+        const float *src = vedit->GetEdit();
+        for (int j=0; j<edit.primvarWidth; ++j)
+            values.push_back(negate ? -src[j] : src[j]);
+
+        edits.push_back(edit);
     }
 
-    // sort vertex edits by level
-    std::sort(vertexEdits.begin(), vertexEdits.end(), compareEdits);
+    mergeEdits(edits, values);
 
     // First pass : count batches based on operation and primvar being edited
     std::vector<int> batchIndices;
     std::vector<int> batchSizes;
-    for(int i=0; i<(int)vertexEdits.size(); ++i) {
-        HbrVertexEdit<T> const *vedit = vertexEdits[i];
-
-        // translate operation enum
-        FarVertexEdit::Operation op = (vedit->GetOperation() == HbrHierarchicalEdit<T>::Set) ?
-            FarVertexEdit::Set : FarVertexEdit::Add;
+    for(int i=0; i<(int)edits.size(); ++i) {
+        ResolvedEdit const & edit = edits[i];
 
         // determine which batch this edit belongs to (create it if necessary)
         // XXXX manuelk - if the number of edits becomes large, we may need to switch this
         // to a map.
         int batchIndex = -1;
         for(int j = 0; j<(int)result->_batches.size(); ++j) {
-            if(result->_batches[j]._primvarIndex == vedit->GetIndex() &&
-               result->_batches[j]._primvarWidth == vedit->GetWidth() &&
-               result->_batches[j]._op == op) {
+            if(result->_batches[j]._primvarIndex == edit.primvarIndex &&
+               result->_batches[j]._primvarWidth == edit.primvarWidth &&
+               result->_batches[j]._op == edit.op) {
                 batchIndex = j;
                 break;
             }
@@ -134,7 +225,7 @@ FarVertexEditTablesFactory<T,U>::Create( FarMeshFactory<T,U> const * factory, Fa
         if (batchIndex == -1) {
             // create new batch
             batchIndex = (int)result->_batches.size();
-            result->_batches.push_back(typename FarVertexEditTables::VertexEditBatch(vedit->GetIndex(), vedit->GetWidth(), op));
+            result->_batches.push_back(typename FarVertexEditTables::VertexEditBatch(edit.primvarIndex, edit.primvarWidth, edit.op));
             batchSizes.push_back(0);
         }
         batchSizes[batchIndex]++;
@@ -148,23 +239,15 @@ FarVertexEditTablesFactory<T,U>::Create( FarMeshFactory<T,U> const * factory, Fa
         result->_batches[i]._edits.resize(batchSizes[i] * result->_batches[i].GetPrimvarWidth());
     }
 
-    // Resolve vertexedits path to absolute offset and put them into corresponding batch
+    // The edits are sorted by level then vertex : each batch gets one kernel
+    // batch per level, sorted by vertex index
     std::vector<int> currentLevels(numBatches);
     std::vector<int> currentCounts(numBatches);
     std::vector<int> currentOffsets(numBatches);
-    for(int i=0; i<(int)vertexEdits.size(); ++i){
-        HbrVertexEdit<T> const *vedit = vertexEdits[i];
-
-        HbrFace<T> * f = factory->_hbrMesh->GetFace(vedit->GetFaceID());
+    for(int i=0; i<(int)edits.size(); ++i){
+        ResolvedEdit const & edit = edits[i];
 
-        int level = vedit->GetNSubfaces();
-        for (int j=0; j<level; ++j)
-            f = f->GetChild(vedit->GetSubface(j));
-
-        int vertexID = f->GetVertex(vedit->GetVertexID())->GetID();
-
-        // Remap vertex ID
-        vertexID = factory->_remapTable[vertexID];
+        int level = edit.level;
 
         int batchIndex = batchIndices[i];
         int & batchLevel = currentLevels[batchIndex];
@@ -183,15 +266,11 @@ FarVertexEditTablesFactory<T,U>::Create( FarMeshFactory<T,U> const * factory, Fa
         }
 
         // Set absolute vertex index
-        batch._vertIndices[batchCount] = vertexID;
+        batch._vertIndices[batchCount] = edit.vertexID;
 
-        // Copy edit values : Subtract edits are optimized into Add edits (fewer batches)
-        const float *edit = vedit->GetEdit();
-
-        bool negate = (vedit->GetOperation() == HbrHierarchicalEdit<T>::Subtract);
-        
-        for(int j=0; j<batch.GetPrimvarWidth(); ++j)
-            batch._edits[batchCount * batch.GetPrimvarWidth() + j] = negate ? -edit[j] : edit[j];
+        // Copy edit values
+        std::copy(&values[edit.valueOffset], &values[edit.valueOffset]+edit.primvarWidth,
+                  &batch._edits[batchCount * batch.GetPrimvarWidth()]);
 
         batchCount++;
     }
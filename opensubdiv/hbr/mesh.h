@@ -733,7 +733,10 @@ HbrMesh<T>::Finish() {
     if (!hierarchicalEdits.empty()) {
         HbrHierarchicalEditComparator<T> cmp;
         int nHierarchicalEdits = (int)hierarchicalEdits.size();
-        std::sort(hierarchicalEdits.begin(), hierarchicalEdits.end(), cmp);
+        // The sort must be stable : the edits of a same path are applied in
+        // the order they were added, which decides the result of several
+        // edits of a same vertex (the last Set wins)
+        std::stable_sort(hierarchicalEdits.begin(), hierarchicalEdits.end(), cmp);
         // Push a sentinel null value - we rely upon this sentinel to
         // ensure face->GetHierarchicalEdits knows when to terminate
         hierarchicalEdits.push_back(0);
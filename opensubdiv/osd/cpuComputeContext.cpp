@@ -38,17 +38,19 @@ namespace OPENSUBDIV_VERSION {
 void
 OsdCpuTable::createCpuBuffer(size_t size, const void *ptr) {
 
-    _devicePtr = new unsigned char[size];
-    memcpy(_devicePtr, ptr, size);
+    unsigned char * buffer = new unsigned char[size];
+    memcpy(buffer, ptr, size);
+    _devicePtr = buffer;
+    _owner = true;
 }
 
 OsdCpuTable::~OsdCpuTable() {
 
-    if (_devicePtr) 
-        delete [] (unsigned char *)_devicePtr;
+    if (_owner and _devicePtr)
+        delete [] (const unsigned char *)_devicePtr;
 }
 
-void *
+const void *
 OsdCpuTable::GetBuffer() const {
 
     return _devicePtr;
@@ -56,10 +58,16 @@ OsdCpuTable::GetBuffer() const {
 
 // ----------------------------------------------------------------------------
 
+template <typename T> static OsdCpuTable *
+createTable(std::vector<T> const & table, OsdCpuTable::Storage storage) {
+
+    return new OsdCpuTable(table, storage);
+}
+
 OsdCpuHEditTable::OsdCpuHEditTable(
-    const FarVertexEditTables::VertexEditBatch &batch)
-    : _primvarIndicesTable(new OsdCpuTable(batch.GetVertexIndices())),
-      _editValuesTable(new OsdCpuTable(batch.GetValues())) {
+    const FarVertexEditTables::VertexEditBatch &batch, OsdCpuTable::Storage storage)
+    : _primvarIndicesTable(createTable(batch.GetVertexIndices(), storage)),
+      _editValuesTable(createTable(batch.GetValues(), storage)) {
 
     _operation = batch.GetOperation();
     _primvarOffset = batch.GetPrimvarIndex();
@@ -102,21 +110,116 @@ OsdCpuHEditTable::GetPrimvarWidth() const {
     return _primvarWidth;
 }
 
+OsdCpuFVarTable::OsdCpuFVarTable(
+    const FarFVarTables &tables, OsdCpuTable::Storage storage)
+    : _sizesTable(createTable(tables.GetSizes(), storage)),
+      _destinationsTable(createTable(tables.GetDestinations(), storage)),
+      _widthsTable(createTable(tables.GetWidths(), storage)),
+      _sourceIndicesTable(createTable(tables.GetSourceIndices(), storage)),
+      _weightsTable(createTable(tables.GetWeights(), storage)),
+      _levelOffsets(tables.GetLevelOffsets()),
+      _fvarWidth(tables.GetFVarWidth()),
+      _numValues(tables.GetNumValues()) {
+
+    // the Far tables walk the sources of the stencils in sequence : the
+    // offset of the first source of each stencil lets the kernels start
+    // anywhere
+    std::vector<int> const & sizes = tables.GetSizes();
+    std::vector<int> offsets(sizes.size());
+    for (int i=0, ofs=0; i<(int)sizes.size(); ++i) {
+        offsets[i] = ofs;
+        ofs += sizes[i];
+    }
+    _offsetsTable = createTable(offsets, OsdCpuTable::COPY);
+}
+
+OsdCpuFVarTable::~OsdCpuFVarTable() {
+
+    delete _sizesTable;
+    delete _offsetsTable;
+    delete _destinationsTable;
+    delete _widthsTable;
+    delete _sourceIndicesTable;
+    delete _weightsTable;
+}
+
+const OsdCpuTable *
+OsdCpuFVarTable::GetSizes() const {
+
+    return _sizesTable;
+}
+
+const OsdCpuTable *
+OsdCpuFVarTable::GetOffsets() const {
+
+    return _offsetsTable;
+}
+
+const OsdCpuTable *
+OsdCpuFVarTable::GetDestinations() const {
+
+    return _destinationsTable;
+}
+
+const OsdCpuTable *
+OsdCpuFVarTable::GetWidths() const {
+
+    return _widthsTable;
+}
+
+const OsdCpuTable *
+OsdCpuFVarTable::GetSourceIndices() const {
+
+    return _sourceIndicesTable;
+}
+
+const OsdCpuTable *
+OsdCpuFVarTable::GetWeights() const {
+
+    return _weightsTable;
+}
+
+const std::vector<int> &
+OsdCpuFVarTable::GetLevelOffsets() const {
+
+    return _levelOffsets;
+}
+
+int
+OsdCpuFVarTable::GetFVarWidth() const {
+
+    return _fvarWidth;
+}
+
+int
+OsdCpuFVarTable::GetNumValues() const {
+
+    return _numValues;
+}
+
 OsdCpuComputeContext::OsdCpuComputeContext(FarSubdivisionTables const *subdivisionTables,
-                                           FarVertexEditTables const *vertexEditTables) {
+                                           FarVertexEditTables const *vertexEditTables,
+                                           FarFVarTables const *fvarTables,
+                                           TableStorage storage) :
+    _fvarTable(NULL) {
+
+    int numTables = subdivisionTables->GetNumTables();
+
+    OsdCpuTable::Storage tableStorage = storage==SHARE_TABLES ? OsdCpuTable::SHARE :
+                                                                OsdCpuTable::COPY;
 
     // allocate 5 or 7 tables
-    _tables.resize(subdivisionTables->GetNumTables(), 0);
+    _tables.resize(numTables, 0);
 
-    _tables[FarSubdivisionTables::E_IT]  = new OsdCpuTable(subdivisionTables->Get_E_IT());
-    _tables[FarSubdivisionTables::V_IT]  = new OsdCpuTable(subdivisionTables->Get_V_IT());
-    _tables[FarSubdivisionTables::V_ITa] = new OsdCpuTable(subdivisionTables->Get_V_ITa());
-    _tables[FarSubdivisionTables::E_W]   = new OsdCpuTable(subdivisionTables->Get_E_W());
-    _tables[FarSubdivisionTables::V_W]   = new OsdCpuTable(subdivisionTables->Get_V_W());
+    _tables[FarSubdivisionTables::E_IT]  = createTable(subdivisionTables->Get_E_IT(), tableStorage);
+    _tables[FarSubdivisionTables::V_IT]  = createTable(subdivisionTables->Get_V_IT(), tableStorage);
+    _tables[FarSubdivisionTables::V_ITa] = createTable(subdivisionTables->Get_V_ITa(), tableStorage);
+    _tables[FarSubdivisionTables::E_W]   = createTable(subdivisionTables->Get_E_W(), tableStorage);
+    _tables[FarSubdivisionTables::V_W]   = createTable(subdivisionTables->Get_V_W(), tableStorage);
 
-    if (subdivisionTables->GetNumTables() > 5) {
-        _tables[FarSubdivisionTables::F_IT]  = new OsdCpuTable(subdivisionTables->Get_F_IT());
-        _tables[FarSubdivisionTables::F_ITa] = new OsdCpuTable(subdivisionTables->Get_F_ITa());
+    if (numTables > 5) {
+        _tables[FarSubdivisionTables::F_IT]  = createTable(subdivisionTables->Get_F_IT(), tableStorage);
+        _tables[FarSubdivisionTables::F_ITa] = createTable(subdivisionTables->Get_F_ITa(), tableStorage);
     }
 
     // create hedit tables
@@ -127,9 +230,14 @@ OsdCpuComputeContext::OsdCpuComputeContext(FarSubdivisionTables const *subdivisi
             const FarVertexEditTables::VertexEditBatch & edit =
                 vertexEditTables->GetBatch(i);
 
-            _editTables.push_back(new OsdCpuHEditTable(edit));
+            _editTables.push_back(new OsdCpuHEditTable(edit, tableStorage));
         }
     }
+
+    // create face-varying table
+    if (fvarTables) {
+        _fvarTable = new OsdCpuFVarTable(*fvarTables, tableStorage);
+    }
 }
 
 OsdCpuComputeContext::~OsdCpuComputeContext() {
@@ -140,6 +248,7 @@ OsdCpuComputeContext::~OsdCpuComputeContext() {
     for (size_t i = 0; i < _editTables.size(); ++i) {
         delete _editTables[i];
     }
+    delete _fvarTable;
 }
 
 const OsdCpuTable *
@@ -160,11 +269,27 @@ OsdCpuComputeContext::GetEditTable(int tableIndex) const {
     return _editTables[tableIndex];
 }
 
+const OsdCpuFVarTable *
+OsdCpuComputeContext::GetFVarTable() const {
+
+    return _fvarTable;
+}
+
+OsdCpuComputeContext *
+OsdCpuComputeContext::Create(FarSubdivisionTables const *subdivisionTables,
+                             FarVertexEditTables const *vertexEditTables,
+                             TableStorage storage) {
+
+    return new OsdCpuComputeContext(subdivisionTables, vertexEditTables, NULL, storage);
+}
+
 OsdCpuComputeContext *
 OsdCpuComputeContext::Create(FarSubdivisionTables const *subdivisionTables,
-                             FarVertexEditTables const *vertexEditTables) {
+                             FarVertexEditTables const *vertexEditTables,
+                             FarFVarTables const *fvarTables,
+                             TableStorage storage) {
 
-    return new OsdCpuComputeContext(subdivisionTables, vertexEditTables);
+    return new OsdCpuComputeContext(subdivisionTables, vertexEditTables, fvarTables, storage);
 }
 
 }  // end namespace OPENSUBDIV_VERSION
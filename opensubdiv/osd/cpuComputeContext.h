@@ -29,11 +29,13 @@
 
 #include "../far/subdivisionTables.h"
 #include "../far/vertexEditTables.h"
+#include "../far/fvarTables.h"
 #include "../osd/vertex.h"
 #include "../osd/vertexDescriptor.h"
 #include "../osd/nonCopyable.h"
 
 #include <stdlib.h>
+#include <vector>
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -42,24 +44,42 @@ struct OsdVertexDescriptor;
 
 class OsdCpuTable : private OsdNonCopyable<OsdCpuTable> {
 public:
+    /// Storage of the table data
+    enum Storage {
+        COPY,    ///< the table owns a copy of the data
+        SHARE    ///< the table references the data, which must outlive it
+    };
+
     template<typename T>
-    explicit OsdCpuTable(const std::vector<T> &table) {
-        createCpuBuffer(table.size() * sizeof(T), table.empty() ? NULL : &table[0]);
+    explicit OsdCpuTable(const std::vector<T> &table, Storage storage=COPY) :
+        _devicePtr(NULL), _owner(false) {
+
+        if (table.empty())
+            return;
+
+        if (storage==COPY) {
+            createCpuBuffer(table.size() * sizeof(T), &table[0]);
+        } else {
+            _devicePtr = &table[0];
+        }
     }
 
     virtual ~OsdCpuTable();
 
-    void * GetBuffer() const;
+    const void * GetBuffer() const;
 
 private:
     void createCpuBuffer(size_t size, const void *ptr);
 
-    void *_devicePtr;
+    const void *_devicePtr;
+
+    bool _owner;        // _devicePtr was allocated by the table
 };
 
 class OsdCpuHEditTable : private OsdNonCopyable<OsdCpuHEditTable> {
 public:
-    OsdCpuHEditTable(const FarVertexEditTables::VertexEditBatch &batch);
+    OsdCpuHEditTable(const FarVertexEditTables::VertexEditBatch &batch,
+                     OsdCpuTable::Storage storage=OsdCpuTable::COPY);
 
     virtual ~OsdCpuHEditTable();
 
@@ -82,6 +102,45 @@ private:
     int _primvarWidth;
 };
 
+class OsdCpuFVarTable : private OsdNonCopyable<OsdCpuFVarTable> {
+public:
+    OsdCpuFVarTable(const FarFVarTables &tables,
+                    OsdCpuTable::Storage storage=OsdCpuTable::COPY);
+
+    virtual ~OsdCpuFVarTable();
+
+    const OsdCpuTable * GetSizes() const;
+
+    const OsdCpuTable * GetOffsets() const;
+
+    const OsdCpuTable * GetDestinations() const;
+
+    const OsdCpuTable * GetWidths() const;
+
+    const OsdCpuTable * GetSourceIndices() const;
+
+    const OsdCpuTable * GetWeights() const;
+
+    const std::vector<int> & GetLevelOffsets() const;
+
+    int GetFVarWidth() const;
+
+    int GetNumValues() const;
+
+private:
+    OsdCpuTable *_sizesTable;
+    OsdCpuTable *_offsetsTable;     // first source of each stencil
+    OsdCpuTable *_destinationsTable;
+    OsdCpuTable *_widthsTable;
+    OsdCpuTable *_sourceIndicesTable;
+    OsdCpuTable *_weightsTable;
+
+    std::vector<int> _levelOffsets;
+
+    int _fvarWidth;
+    int _numValues;
+};
+
 ///
 /// \brief CPU Refine Context
 ///
@@ -91,17 +150,49 @@ private:
 /// geometric primitives with the capabilities of the selected discrete 
 /// compute device.
 ///
+/// By default the context holds a copy of the Far tables. With SHARE_TABLES
+/// it references the storage of the Far tables instead, which saves the copy
+/// of the topology : the FarMesh must then outlive the context.
+///
+/// The context can also hold the FarFVarTables of the mesh, which the
+/// controllers use to refine face-varying values (see RefineFVar).
+///
 class OsdCpuComputeContext : private OsdNonCopyable<OsdCpuComputeContext> {
 
 public:
+    /// Storage of the refinement tables of the context
+    enum TableStorage {
+        COPY_TABLES,    ///< copy the Far tables (default)
+        SHARE_TABLES    ///< reference the Far tables
+    };
+
+    /// Creates an OsdCpuComputeContext instance
+    ///
+    /// @param subdivisionTables the FarSubdivisionTables used for this Context.
+    ///
+    /// @param vertexEditTables the FarVertexEditTables used for this Context.
+    ///
+    /// @param storage          copy or reference the Far tables
+    ///
+    static OsdCpuComputeContext * Create(FarSubdivisionTables const *subdivisionTables,
+                                         FarVertexEditTables const *vertexEditTables,
+                                         TableStorage storage=COPY_TABLES);
+
     /// Creates an OsdCpuComputeContext instance
     ///
     /// @param subdivisionTables the FarSubdivisionTables used for this Context.
     ///
     /// @param vertexEditTables the FarVertexEditTables used for this Context.
     ///
+    /// @param fvarTables       the FarFVarTables used for this Context (see
+    ///                         FarMeshFactory::Create)
+    ///
+    /// @param storage          copy or reference the Far tables
+    ///
     static OsdCpuComputeContext * Create(FarSubdivisionTables const *subdivisionTables,
-                                         FarVertexEditTables const *vertexEditTables);
+                                         FarVertexEditTables const *vertexEditTables,
+                                         FarFVarTables const *fvarTables,
+                                         TableStorage storage=COPY_TABLES);
 
     /// Destructor
     virtual ~OsdCpuComputeContext();
@@ -121,13 +212,19 @@ public:
     ///
     const OsdCpuHEditTable * GetEditTable(int tableIndex) const;
 
+    /// Returns the face-varying refinement table (or NULL)
+    const OsdCpuFVarTable * GetFVarTable() const;
+
 protected:
     explicit OsdCpuComputeContext(FarSubdivisionTables const *subdivisionTables,
-                                  FarVertexEditTables const *vertexEditTables);
+                                  FarVertexEditTables const *vertexEditTables,
+                                  FarFVarTables const *fvarTables=NULL,
+                                  TableStorage storage=COPY_TABLES);
 
 private:
     std::vector<OsdCpuTable*> _tables;
     std::vector<OsdCpuHEditTable*> _editTables;
+    OsdCpuFVarTable * _fvarTable;
 };
 
 }  // end namespace OPENSUBDIV_VERSION
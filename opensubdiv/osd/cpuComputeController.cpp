@@ -30,7 +30,41 @@ namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
 
-OsdCpuComputeController::OsdCpuComputeController() {
+// Applies the kernel of a batch to a range of its vertices
+class OsdCpuKernelBatchTask : public OsdScheduler::Task {
+
+public:
+
+    OsdCpuKernelBatchTask(OsdCpuComputeController const * controller,
+                          OsdCpuComputeContext const * context,
+                          FarKernelBatch const & batch) :
+        _controller(controller), _context(context), _batch(batch) { }
+
+    virtual void Run(int begin, int end) const {
+
+        FarKernelBatch batch(_batch.GetKernelType(),
+                             _batch.GetLevel(),
+                             _batch.GetTableIndex(),
+                             begin,
+                             end,
+                             _batch.GetTableOffset(),
+                             _batch.GetVertexOffset(),
+                             _batch.GetMeshIndex());
+
+        FarDispatcher::ApplyKernel(_controller, _context, batch);
+    }
+
+private:
+
+    OsdCpuComputeController const * _controller;
+    OsdCpuComputeContext const * _context;
+    FarKernelBatch const & _batch;
+};
+
+static const int CPU_KERNEL_GRAIN_SIZE = 128;
+
+OsdCpuComputeController::OsdCpuComputeController(OsdScheduler * scheduler) :
+    _scheduler(scheduler) {
 }
 
 OsdCpuComputeController::~OsdCpuComputeController() {
@@ -278,28 +312,101 @@ OsdCpuComputeController::ApplyVertexEdits(
     const OsdCpuTable * primvarIndices = edit->GetPrimvarIndices();
     const OsdCpuTable * editValues = edit->GetEditValues();
 
-    if (edit->GetOperation() == FarVertexEdit::Add) {
-        OsdCpuEditVertexAdd(_currentBindState.vertexBuffer,
-                            _currentBindState.vertexDesc,
-                            edit->GetPrimvarOffset(),
-                            edit->GetPrimvarWidth(),
-                            batch.GetVertexOffset(),
-                            batch.GetTableOffset(),
-                            batch.GetStart(),
-                            batch.GetEnd(),
-                            static_cast<unsigned int*>(primvarIndices->GetBuffer()),
-                            static_cast<float*>(editValues->GetBuffer()));
-    } else if (edit->GetOperation() == FarVertexEdit::Set) {
-        OsdCpuEditVertexSet(_currentBindState.vertexBuffer,
-                            _currentBindState.vertexDesc,
-                            edit->GetPrimvarOffset(),
-                            edit->GetPrimvarWidth(),
-                            batch.GetVertexOffset(),
-                            batch.GetTableOffset(),
-                            batch.GetStart(),
-                            batch.GetEnd(),
-                            static_cast<unsigned int*>(primvarIndices->GetBuffer()),
-                            static_cast<float*>(editValues->GetBuffer()));
+    // the edits apply to each of the interleaved samples
+    int numSamples = _currentBindState.numSamples,
+        sampleLength = _currentBindState.vertexDesc.length / numSamples;
+
+    for (int sample = 0; sample < numSamples; ++sample) {
+
+        float * vertex = _currentBindState.vertexBuffer ?
+            _currentBindState.vertexBuffer + sample * sampleLength : NULL;
+
+        if (edit->GetOperation() == FarVertexEdit::Add) {
+            OsdCpuEditVertexAdd(vertex,
+                                _currentBindState.vertexDesc,
+                                edit->GetPrimvarOffset(),
+                                edit->GetPrimvarWidth(),
+                                batch.GetVertexOffset(),
+                                batch.GetTableOffset(),
+                                batch.GetStart(),
+                                batch.GetEnd(),
+                                static_cast<const unsigned int*>(primvarIndices->GetBuffer()),
+                                static_cast<const float*>(editValues->GetBuffer()));
+        } else if (edit->GetOperation() == FarVertexEdit::Set) {
+            OsdCpuEditVertexSet(vertex,
+                                _currentBindState.vertexDesc,
+                                edit->GetPrimvarOffset(),
+                                edit->GetPrimvarWidth(),
+                                batch.GetVertexOffset(),
+                                batch.GetTableOffset(),
+                                batch.GetStart(),
+                                batch.GetEnd(),
+                                static_cast<const unsigned int*>(primvarIndices->GetBuffer()),
+                                static_cast<const float*>(editValues->GetBuffer()));
+        }
+    }
+}
+
+void
+OsdCpuComputeController::refine(OsdCpuComputeContext const *context,
+                                FarKernelBatchVector const & batches) const {
+
+    for (int i = 0; i < (int)batches.size(); ++i) {
+
+        FarKernelBatch const & batch = batches[i];
+
+        // the vertices of a batch are independent, but the edits of a
+        // vertex are applied in order
+        if (_scheduler and batch.GetKernelType()!=FarKernelBatch::HIERARCHICAL_EDIT) {
+            _scheduler->ParallelFor(batch.GetStart(), batch.GetEnd(),
+                CPU_KERNEL_GRAIN_SIZE, OsdCpuKernelBatchTask(this, context, batch));
+        } else {
+            FarDispatcher::ApplyKernel(this, context, batch);
+        }
+    }
+}
+
+// Applies the face-varying stencils of a range of a level
+class OsdCpuFVarStencilsTask : public OsdScheduler::Task {
+
+public:
+
+    OsdCpuFVarStencilsTask(OsdCpuFVarTable const * table, float * values) :
+        _table(table), _values(values) { }
+
+    virtual void Run(int begin, int end) const {
+
+        OsdCpuComputeFVarStencils(_values,
+            static_cast<const int*>(_table->GetSizes()->GetBuffer()),
+            static_cast<const int*>(_table->GetOffsets()->GetBuffer()),
+            static_cast<const int*>(_table->GetDestinations()->GetBuffer()),
+            static_cast<const int*>(_table->GetWidths()->GetBuffer()),
+            static_cast<const int*>(_table->GetSourceIndices()->GetBuffer()),
+            static_cast<const float*>(_table->GetWeights()->GetBuffer()),
+            begin, end);
+    }
+
+private:
+
+    OsdCpuFVarTable const * _table;
+    float * _values;
+};
+
+void
+OsdCpuComputeController::refineFVar(OsdCpuFVarTable const *table, float *values) const {
+
+    assert(table and values);
+
+    OsdCpuFVarStencilsTask task(table, values);
+
+    // the stencils of a level read the values of the previous levels
+    std::vector<int> const & levels = table->GetLevelOffsets();
+    for (int i = 0; i+1 < (int)levels.size(); ++i) {
+        if (_scheduler) {
+            _scheduler->ParallelFor(levels[i], levels[i+1], CPU_KERNEL_GRAIN_SIZE, task);
+        } else {
+            task.Run(levels[i], levels[i+1]);
+        }
     }
 }
 
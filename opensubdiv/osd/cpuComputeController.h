@@ -29,6 +29,7 @@
 
 #include "../far/dispatcher.h"
 #include "../osd/cpuComputeContext.h"
+#include "../osd/scheduler.h"
 #include "../osd/vertexDescriptor.h"
 
 namespace OpenSubdiv {
@@ -40,6 +41,9 @@ namespace OPENSUBDIV_VERSION {
 /// single threaded CPU subdivision kernels. It requires
 /// OsdCpuVertexBufferInterface as arguments of Refine function.
 ///
+/// The vertices of each kernel batch can be split across the threads of an
+/// OsdScheduler, given to the constructor.
+///
 /// Controller entities execute requests from Context instances that they share
 /// common interfaces with. Controllers are attached to discrete compute devices
 /// and share the devices resources with Context entities.
@@ -48,8 +52,13 @@ class OsdCpuComputeController {
 public:
     typedef OsdCpuComputeContext ComputeContext;
 
-    /// Constructor.
-    OsdCpuComputeController();
+    /// \brief Constructor.
+    ///
+    /// @param scheduler  the scheduler running the kernels in parallel (not
+    ///                   owned). If it's null, the kernels run in the calling
+    ///                   thread.
+    ///
+    OsdCpuComputeController(OsdScheduler * scheduler=NULL);
 
     /// Destructor.
     ~OsdCpuComputeController();
@@ -85,7 +94,7 @@ public:
 
         bind(vertexBuffer, varyingBuffer, vertexDesc, varyingDesc);
 
-        FarDispatcher::Refine(this, context, batches, /*maxlevel*/-1);
+        refine(context, batches);
 
         unbind();
     }
@@ -106,6 +115,67 @@ public:
         Refine(context, batches, vertexBuffer, (VERTEX_BUFFER*)0);
     }
 
+    /// Launch subdivision kernels on several samples of the vertex data
+    /// (for instance the motion blur time samples of a mesh) in a single
+    /// traversal of the subdivision tables.
+    ///
+    /// The samples are interleaved in the vertex buffer : every vertex holds
+    /// the elements of each sample one after the other (see
+    /// OsdCpuVertexBuffer::UpdateSampleData), so that every index and weight
+    /// loaded from the tables is applied to all the samples.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  numSamples    the number of interleaved samples
+    ///
+    /// @param  vertexDesc    the descriptor of the elements of all the samples
+    ///                       (vertexDesc->length / numSamples elements per
+    ///                       sample). if it's null, all primvars in the vertex
+    ///                       buffer will be refined.
+    ///
+    template<class VERTEX_BUFFER>
+    void RefineSamples(OsdCpuComputeContext const *context,
+                       FarKernelBatchVector const & batches,
+                       VERTEX_BUFFER *vertexBuffer,
+                       int numSamples,
+                       OsdVertexBufferDescriptor const *vertexDesc=NULL) {
+
+        if (batches.empty() or numSamples < 1) return;
+
+        bind(vertexBuffer, (VERTEX_BUFFER*)0, vertexDesc, NULL);
+
+        _currentBindState.numSamples = numSamples;
+
+        refine(context, batches);
+
+        unbind();
+    }
+
+    /// Refines face-varying values with the face-varying table of the context
+    ///
+    /// The buffer holds the coarse face-varying values, one per vertex of each
+    /// coarse face, followed by the refined values (see FarFVarTables) : it
+    /// must have GetFVarWidth() elements and GetNumValues() vertices, and its
+    /// coarse values must be set.
+    ///
+    /// @param  context       the OsdCpuContext holding the FarFVarTables
+    ///
+    /// @param  fvarBuffer    face-varying data buffer
+    ///
+    template<class FVAR_BUFFER>
+    void RefineFVar(OsdCpuComputeContext const *context,
+                    FVAR_BUFFER *fvarBuffer) {
+
+        if (not context or not context->GetFVarTable() or not fvarBuffer) return;
+
+        refineFVar(context->GetFVarTable(), fvarBuffer->BindCpuBuffer());
+    }
+
     /// Waits until all running subdivision kernels finish.
     void Synchronize();
 
@@ -152,6 +222,13 @@ protected:
 
     void ApplyVertexEdits(FarKernelBatch const &batch, ComputeContext const *context) const;
 
+    // Applies the batches, split across the scheduler if any
+    void refine(ComputeContext const *context, FarKernelBatchVector const & batches) const;
+
+    // Applies the face-varying stencils level by level, split across the
+    // scheduler if any
+    void refineFVar(OsdCpuFVarTable const *table, float *values) const;
+
     template<class VERTEX_BUFFER, class VARYING_BUFFER>
     void bind(VERTEX_BUFFER *vertex, VARYING_BUFFER *varying,
               OsdVertexBufferDescriptor const *vertexDesc,
@@ -208,19 +285,23 @@ private:
     // Bind state is a transitional state during refinement.
     // It doesn't take an ownership of vertex buffers.
     struct BindState {
-        BindState() : vertexBuffer(NULL), varyingBuffer(NULL) {}
+        BindState() : vertexBuffer(NULL), varyingBuffer(NULL), numSamples(1) {}
         void Reset() {
             vertexBuffer = varyingBuffer = NULL;
             vertexDesc.Reset();
             varyingDesc.Reset();
+            numSamples = 1;
         }
         float *vertexBuffer;
         float *varyingBuffer;
         OsdVertexBufferDescriptor vertexDesc;
         OsdVertexBufferDescriptor varyingDesc;
+        int numSamples;     // interleaved samples of the vertex data
     };
 
     BindState _currentBindState;
+
+    OsdScheduler * _scheduler;
 };
 
 }  // end namespace OPENSUBDIV_VERSION
@@ -0,0 +1,1198 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../osd/cpuEvalLimitBVH.h"
+#include "../osd/cpuEvalLimitKernel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+// maximum number of patches of a leaf
+static const int kLeafSize = 4;
+
+// Bezier subdivisions of the patches : the sub-patches are not subdivided
+// beyond kMaxDepth. Ray intersections start Newton iterations from the center
+// of the sub-patches from kMinNewtonDepth.
+static const int kMinNewtonDepth = 2,
+                 kMaxDepth = 10,
+                 kNewtonIterations = 10;
+
+// Newton iterations stop when the step is smaller than kMinNewtonStep
+static const float kMinNewtonStep = 1e-5f;
+
+// Closest points : maximum Newton iterations, relative decrease of the squared
+// distance where the iterations stop, finite differences step of the second
+// derivatives, and squared relative tolerance of the distance
+static const int kProjectionIterations = 20;
+
+static const float kMinProjectionDecrease = 1e-6f,
+                   kProjectionStep = 1e-3f,
+                   kProjectionTolerance2 = (1.0f-1e-3f)*(1.0f-1e-3f);
+
+// Rays are intersected in a frame where the ray is the z axis and z is the
+// ray parameter t.
+struct OsdCpuEvalLimitBVH::Ray {
+
+    float org[3],
+          invDir[3],
+          frame[3][3];
+
+    void Transform(float const * p, float * q) const {
+        float d[3] = { p[0]-org[0], p[1]-org[1], p[2]-org[2] };
+        for (int k=0; k<3; ++k) {
+            q[k] = frame[k][0]*d[0] + frame[k][1]*d[1] + frame[k][2]*d[2];
+        }
+    }
+
+    // returns the ray parameter where the ray enters the box (or -1)
+    float Enter(float const bounds[6], float tmax) const {
+        float tnear = 0.0f, tfar = tmax;
+        for (int k=0; k<3; ++k) {
+            float t0 = (bounds[k  ]-org[k]) * invDir[k],
+                  t1 = (bounds[k+3]-org[k]) * invDir[k];
+            if (t0>t1) std::swap(t0, t1);
+            tnear = std::max(tnear, t0);
+            tfar = std::min(tfar, t1);
+            if (tnear>tfar)
+                return -1.0f;
+        }
+        return tnear;
+    }
+};
+
+// Cubic Bernstein polynomials and their derivatives
+static inline void
+evalBernstein(float t, float B[4], float D[4]) {
+
+    float s = 1.0f - t;
+
+    B[0] = s*s*s;
+    B[1] = 3.0f*s*s*t;
+    B[2] = 3.0f*s*t*t;
+    B[3] = t*t*t;
+
+    if (D) {
+        D[0] = -3.0f*s*s;
+        D[1] = 3.0f*s*s - 6.0f*s*t;
+        D[2] = 6.0f*s*t - 3.0f*t*t;
+        D[3] = 3.0f*t*t;
+    }
+}
+
+// Evaluates a bicubic Bezier patch : points[j*4+i] is the control point j along
+// the first parameter (s) and i along the second (t)
+static void
+evalBezier(float const points[16][3], float s, float t,
+           float * Q, float * Qs, float * Qt) {
+
+    float Bs[4], Ds[4], Bt[4], Dt[4];
+    evalBernstein(s, Bs, Ds);
+    evalBernstein(t, Bt, Dt);
+
+    for (int k=0; k<3; ++k) {
+        Q[k] = Qs[k] = Qt[k] = 0.0f;
+    }
+
+    for (int j=0; j<4; ++j) {
+        for (int i=0; i<4; ++i) {
+            float const * p = points[j*4+i];
+            for (int k=0; k<3; ++k) {
+                Q[k]  += p[k] * Bs[j] * Bt[i];
+                Qs[k] += p[k] * Ds[j] * Bt[i];
+                Qt[k] += p[k] * Bs[j] * Dt[i];
+            }
+        }
+    }
+}
+
+// Evaluates a Gregory patch from its 20 control points. Unlike the
+// derivatives of evalGregoryPoints, the derivatives include the variation of
+// the rational face points, which Newton iterations need near the corners.
+static void
+evalGregoryPatch(float const points[20][3], float s, float t,
+            float * Q, float * Qs, float * Qt) {
+
+    static int const bezier[16] = { 0, 1, 7, 5, 2, -1, -1, 6, 16, -1, -1, 12, 15, 17, 11, 10 };
+
+    float q[16][3], dqs[16][3], dqt[16][3];
+    for (int i=0; i<16; ++i) {
+        for (int k=0; k<3; ++k) {
+            q[i][k] = bezier[i]>=0 ? points[bezier[i]][k] : 0.0f;
+            dqs[i][k] = dqt[i][k] = 0.0f;
+        }
+    }
+
+    float S = 1.0f-s, T = 1.0f-t;
+
+    // face points (a*pa + b*pb)/(a+b) : the weight a is s or 1-s (sign sa of
+    // its derivative) and the weight b is t or 1-t (sign sb)
+    struct Face { int q, pa, pb; };
+    static Face const faces[4] = { { 5, 3, 4 }, { 6, 9, 8 }, { 9, 19, 18 }, { 10, 13, 14 } };
+    float const a[4] = { s, S, s, S },
+                 b[4] = { t, t, T, T },
+                 sa[4] = { 1.0f, -1.0f, 1.0f, -1.0f },
+                 sb[4] = { 1.0f, 1.0f, -1.0f, -1.0f };
+
+    for (int i=0; i<4; ++i) {
+        float d = a[i]+b[i];
+        if (d==0.0f)
+            d = 1.0f;
+        float const * pa = points[faces[i].pa],
+                    * pb = points[faces[i].pb];
+        float * out = q[faces[i].q],
+              * ds = dqs[faces[i].q],
+              * dt = dqt[faces[i].q];
+        for (int k=0; k<3; ++k) {
+            out[k] = (a[i]*pa[k] + b[i]*pb[k]) / d;
+            ds[k] = sa[i] * b[i] * (pa[k]-pb[k]) / (d*d);
+            dt[k] = sb[i] * a[i] * (pb[k]-pa[k]) / (d*d);
+        }
+    }
+
+    evalBezier(q, s, t, Q, Qs, Qt);
+
+    float Bs[4], Bt[4];
+    evalBernstein(s, Bs, 0);
+    evalBernstein(t, Bt, 0);
+
+    for (int i=0; i<4; ++i) {
+        int f = faces[i].q;
+        float w = Bs[f/4] * Bt[f%4];
+        for (int k=0; k<3; ++k) {
+            Qs[k] += w * dqs[f][k];
+            Qt[k] += w * dqt[f][k];
+        }
+    }
+}
+
+// Splits a cubic Bezier curve in half (de Casteljau)
+static inline void
+splitCurve(float const * p0, float const * p1, float const * p2, float const * p3,
+           float * l0, float * l1, float * l2, float * l3,
+           float * r0, float * r1, float * r2, float * r3) {
+
+    for (int k=0; k<3; ++k) {
+        float a = (p0[k]+p1[k])*0.5f,
+              b = (p1[k]+p2[k])*0.5f,
+              c = (p2[k]+p3[k])*0.5f,
+              d = (a+b)*0.5f,
+              e = (b+c)*0.5f,
+              m = (d+e)*0.5f;
+        l0[k]=p0[k]; l1[k]=a; l2[k]=d; l3[k]=m;
+        r0[k]=m;     r1[k]=e; r2[k]=c; r3[k]=p3[k];
+    }
+}
+
+// Splits a bicubic Bezier patch in 4 : child (j*2+i) covers the half j along s
+// and the half i along t
+static void
+splitPatch(float const points[16][3], float children[4][16][3]) {
+
+    float halves[2][16][3];
+
+    for (int i=0; i<4; ++i) {
+        splitCurve(points[i], points[4+i], points[8+i], points[12+i],
+                   halves[0][i], halves[0][4+i], halves[0][8+i], halves[0][12+i],
+                   halves[1][i], halves[1][4+i], halves[1][8+i], halves[1][12+i]);
+    }
+
+    for (int h=0; h<2; ++h) {
+        for (int j=0; j<4; ++j) {
+            float const (*p)[3] = &halves[h][j*4];
+            splitCurve(p[0], p[1], p[2], p[3],
+                       children[h*2][j*4], children[h*2][j*4+1],
+                       children[h*2][j*4+2], children[h*2][j*4+3],
+                       children[h*2+1][j*4], children[h*2+1][j*4+1],
+                       children[h*2+1][j*4+2], children[h*2+1][j*4+3]);
+        }
+    }
+}
+
+typedef void (*EvalFunction)(float, float, unsigned int const *,
+                             OsdVertexBufferDescriptor const &, float const *,
+                             OsdVertexBufferDescriptor const &, float *, float *, float *);
+
+// Computes the matrix that converts the n control vertices of a B-spline patch
+// into the control points of its Bezier form : the kernel is evaluated for each
+// control vertex (identity vertex data) at 4x4 locations of the patch, and the
+// Bezier points interpolating these values are solved for.
+static void
+computeBezierBasis(EvalFunction eval, int n, std::vector<float> & basis) {
+
+    // inverse of the Bernstein matrix A[a][j] = B_j(a/3)
+    double A[4][8];
+    for (int a=0; a<4; ++a) {
+        float B[4];
+        evalBernstein((float)a/3.0f, B, 0);
+        for (int j=0; j<4; ++j) {
+            A[a][j] = B[j];
+            A[a][4+j] = a==j ? 1.0 : 0.0;
+        }
+    }
+    for (int c=0; c<4; ++c) {
+        int pivot = c;
+        for (int r=c+1; r<4; ++r) {
+            if (std::fabs(A[r][c]) > std::fabs(A[pivot][c]))
+                pivot = r;
+        }
+        for (int k=0; k<8; ++k) {
+            std::swap(A[c][k], A[pivot][k]);
+        }
+        double d = A[c][c];
+        for (int k=0; k<8; ++k) {
+            A[c][k] /= d;
+        }
+        for (int r=0; r<4; ++r) {
+            if (r!=c) {
+                double f = A[r][c];
+                for (int k=0; k<8; ++k) {
+                    A[r][k] -= f * A[c][k];
+                }
+            }
+        }
+    }
+
+    std::vector<float> identity(n*n, 0.0f), weights(16*n);
+    std::vector<unsigned int> indices(n);
+    for (int c=0; c<n; ++c) {
+        identity[c*n+c] = 1.0f;
+        indices[c] = c;
+    }
+
+    OsdVertexBufferDescriptor desc(0, n, n);
+    for (int a=0; a<4; ++a) {
+        for (int b=0; b<4; ++b) {
+            eval((float)a/3.0f, (float)b/3.0f, &indices[0], desc, &identity[0],
+                 desc, &weights[(a*4+b)*n], 0, 0);
+        }
+    }
+
+    basis.resize(16*n);
+    for (int j=0; j<4; ++j) {
+        for (int i=0; i<4; ++i) {
+            for (int c=0; c<n; ++c) {
+                double w = 0.0;
+                for (int a=0; a<4; ++a) {
+                    for (int b=0; b<4; ++b) {
+                        w += A[j][4+a] * weights[(a*4+b)*n+c] * A[i][4+b];
+                    }
+                }
+                basis[(j*4+i)*n+c] = (float)w;
+            }
+        }
+    }
+}
+
+// Converts patch coordinates to ptex coordinates (inverse of the Normalize &
+// Rotate functions of the patch bit fields)
+static void
+computePtexCoords(FarPatchParam::BitField bits, float u, float v, float & pu, float & pv) {
+
+    float ru, rv;
+    switch (bits.GetRotation()) {
+        case 0 : ru = u;      rv = v;      break;
+        case 1 : ru = 1.0f-v; rv = u;      break;
+        case 2 : ru = 1.0f-u; rv = 1.0f-v; break;
+        case 3 : ru = v;      rv = 1.0f-u; break;
+        default: assert(0); ru = u; rv = v;
+    }
+
+    float frac = bits.GetParamFraction();
+
+    pu = (float)bits.GetU()*frac + ru*frac;
+    pv = (float)bits.GetV()*frac + rv*frac;
+}
+
+static inline void
+expandBounds(float bounds[6], float const * p) {
+    for (int k=0; k<3; ++k) {
+        bounds[k] = std::min(bounds[k], p[k]);
+        bounds[k+3] = std::max(bounds[k+3], p[k]);
+    }
+}
+
+static inline void
+clearBounds(float bounds[6]) {
+    for (int k=0; k<3; ++k) {
+        bounds[k] = FLT_MAX;
+        bounds[k+3] = -FLT_MAX;
+    }
+}
+
+// Computes the Bezier hull of a patch from its control points (see
+// getControlPoints). The Gregory patches are bounded by their Bezier form with
+// the average of their face points : the face points of the patch are blends
+// of the pairs of points, so the distance to this Bezier patch is at most half
+// of the distance between the points of a pair (margin).
+static void
+computeHull(int basis, float const points[20][3], float hull[16][3], float margin[3]) {
+
+    margin[0] = margin[1] = margin[2] = 0.0f;
+
+    if (basis<0) {
+        static int const bezier[16] = { 0, 1, 7, 5, 2, -1, -1, 6, 16, -1, -1, 12, 15, 17, 11, 10 },
+                         faces[4][3] = { { 5, 3, 4 }, { 6, 9, 8 }, { 9, 19, 18 }, { 10, 13, 14 } };
+        for (int i=0; i<16; ++i) {
+            if (bezier[i]>=0) {
+                for (int k=0; k<3; ++k) {
+                    hull[i][k] = points[bezier[i]][k];
+                }
+            }
+        }
+        for (int i=0; i<4; ++i) {
+            float const * a = points[faces[i][1]],
+                        * b = points[faces[i][2]];
+            for (int k=0; k<3; ++k) {
+                hull[faces[i][0]][k] = (a[k]+b[k])*0.5f;
+                margin[k] = std::max(margin[k], std::fabs(a[k]-b[k])*0.5f);
+            }
+        }
+    } else {
+        memcpy(hull, points, 16*3*sizeof(float));
+    }
+}
+
+// Evaluates a patch from its control points or its Bezier hull
+static inline void
+evalPatch(int basis, float const points[20][3], float const hull[16][3],
+          float s, float t, float * Q, float * Qs, float * Qt) {
+
+    if (basis<0) {
+        evalGregoryPatch(points, s, t, Q, Qs, Qt);
+    } else {
+        evalBezier(hull, s, t, Q, Qs, Qt);
+    }
+}
+
+// A sub-domain of a patch and its Bezier hull
+struct SubPatch {
+    float points[16][3];
+    float s, t, size;
+    int depth;
+
+    void GetBounds(float bounds[6]) const {
+        clearBounds(bounds);
+        for (int i=0; i<16; ++i) {
+            expandBounds(bounds, points[i]);
+        }
+    }
+
+    bool Contains(float u, float v) const {
+        float slack = size*0.01f;
+        return u>=s-slack and u<=s+size+slack and
+               v>=t-slack and v<=t+size+slack;
+    }
+
+    // pushes the 4 children of the sub-patch on a stack
+    void Split(SubPatch * stack, int & nstack) const {
+
+        float children[4][16][3];
+        splitPatch(points, children);
+
+        float half = size*0.5f;
+        for (int i=0; i<4; ++i) {
+            SubPatch & child = stack[nstack++];
+            memcpy(child.points, children[i], sizeof(child.points));
+            child.s = s + (i/2)*half;
+            child.t = t + (i%2)*half;
+            child.size = half;
+            child.depth = depth+1;
+        }
+    }
+};
+
+// squared distance from a point to a box
+static inline float
+boxDistance2(float const bounds[6], float const * p) {
+
+    float d2 = 0.0f;
+    for (int k=0; k<3; ++k) {
+        float d = std::max(bounds[k]-p[k], p[k]-bounds[k+3]);
+        if (d>0.0f)
+            d2 += d*d;
+    }
+    return d2;
+}
+
+//------------------------------------------------------------------------------
+OsdCpuEvalLimitBVH *
+OsdCpuEvalLimitBVH::Create(FarPatchTables const *patchTables) {
+
+    assert(patchTables);
+
+    if (not patchTables->IsFeatureAdaptive())
+        return NULL;
+
+    return new OsdCpuEvalLimitBVH(patchTables);
+}
+
+OsdCpuEvalLimitBVH::OsdCpuEvalLimitBVH(FarPatchTables const *patchTables) :
+    _maxValence(patchTables->GetMaxValence()), _numGregoryPatches(0), _data(0) {
+
+    _cvs = patchTables->GetPatchTable();
+    _vertexValenceTable = patchTables->GetVertexValenceTable();
+    _quadOffsetTable = patchTables->GetQuadOffsetTable();
+
+    computeBezierBasis(evalBSpline, 16, _bases[0]);
+    computeBezierBasis(evalBoundary, 12, _bases[1]);
+    computeBezierBasis(evalCorner, 9, _bases[2]);
+
+    FarPatchTables::PatchArrayVector const & parrays =
+        patchTables->GetPatchArrayVector();
+
+    FarPatchTables::PatchParamTable const & params =
+        patchTables->GetPatchParamTable();
+
+    for (int i=0; i<(int)parrays.size(); ++i) {
+
+        FarPatchTables::PatchArray const & parray = parrays[i];
+
+        FarPatchTables::Type type = parray.GetDescriptor().GetType();
+
+        int basis = 0;
+        switch (type) {
+            case FarPatchTables::REGULAR          : basis = 0; break;
+            case FarPatchTables::BOUNDARY         : basis = 1; break;
+            case FarPatchTables::CORNER           : basis = 2; break;
+            case FarPatchTables::GREGORY          : basis = -1; break;
+            case FarPatchTables::GREGORY_BOUNDARY : basis = -2; break;
+            default : continue;
+        }
+
+        int ncvs = parray.GetDescriptor().GetNumControlVertices();
+
+        for (unsigned int j=0; j<parray.GetNumPatches(); ++j) {
+
+            Patch patch;
+            patch.basis = basis;
+            patch.cvOffset = parray.GetVertIndex() + j*ncvs;
+            patch.quadOffset = parray.GetQuadOffsetIndex() + j*4;
+            patch.gregory = basis<0 ? _numGregoryPatches++ : -1;
+            patch.param = params[parray.GetPatchIndex() + j];
+
+            _patches.push_back(patch);
+        }
+    }
+}
+
+OsdCpuEvalLimitBVH::~OsdCpuEvalLimitBVH() {
+}
+
+//------------------------------------------------------------------------------
+// Returns the control points of the hull of a patch in the current pose : the
+// 16 Bezier points of the B-spline patches, or the 20 Gregory points
+int
+OsdCpuEvalLimitBVH::getControlPoints(Patch const & patch, float points[20][3]) const {
+
+    if (patch.basis<0) {
+        float const * src = &_gregoryPoints[patch.gregory*60];
+        for (int i=0; i<20; ++i) {
+            for (int k=0; k<3; ++k) {
+                points[i][k] = src[i*3+k];
+            }
+        }
+        return 20;
+    }
+
+    std::vector<float> const & basis = _bases[patch.basis];
+
+    int n = (int)basis.size()/16;
+
+    float const * cvs[16];
+    for (int c=0; c<n; ++c) {
+        cvs[c] = _data + _desc.offset + _cvs[patch.cvOffset+c]*_desc.stride;
+    }
+
+    for (int i=0; i<16; ++i) {
+        float const * w = &basis[i*n];
+        points[i][0] = points[i][1] = points[i][2] = 0.0f;
+        for (int c=0; c<n; ++c) {
+            for (int k=0; k<3; ++k) {
+                points[i][k] += w[c] * cvs[c][k];
+            }
+        }
+    }
+    return 16;
+}
+
+void
+OsdCpuEvalLimitBVH::computePatchBounds() {
+
+    OsdVertexBufferDescriptor desc(_desc.offset, 3, _desc.stride);
+
+    _gregoryPoints.resize(_numGregoryPatches*60);
+
+    int npatches = (int)_patches.size();
+
+    _patchBounds.resize(npatches*6);
+
+    for (int i=0; i<npatches; ++i) {
+
+        Patch const & patch = _patches[i];
+
+        if (patch.basis<0) {
+            float * points = &_gregoryPoints[patch.gregory*60];
+            if (patch.basis==-1) {
+                computeGregoryPoints(&_cvs[patch.cvOffset], &_vertexValenceTable[0],
+                                     &_quadOffsetTable[patch.quadOffset],
+                                     _maxValence, desc, _data, points);
+            } else {
+                computeGregoryBoundaryPoints(&_cvs[patch.cvOffset], &_vertexValenceTable[0],
+                                             &_quadOffsetTable[patch.quadOffset],
+                                             _maxValence, desc, _data, points);
+            }
+        }
+
+        float points[20][3];
+        int npoints = getControlPoints(patch, points);
+
+        float * bounds = &_patchBounds[i*6];
+        clearBounds(bounds);
+        for (int j=0; j<npoints; ++j) {
+            expandBounds(bounds, points[j]);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Orders the patches along an axis of their centers
+class PatchCenterCompare {
+public:
+    PatchCenterCompare(std::vector<float> const & centers, int axis) :
+        _centers(centers), _axis(axis) { }
+
+    bool operator()(int a, int b) const {
+        return _centers[a*3+_axis] < _centers[b*3+_axis];
+    }
+private:
+    std::vector<float> const & _centers;
+    int _axis;
+};
+
+// Creates the sub-tree of the patches [begin, end) of the patch order : the
+// patches are split at the median of their centers along the longest axis of
+// the centers
+int
+OsdCpuEvalLimitBVH::buildNode(int begin, int end, std::vector<float> const & centers) {
+
+    int index = (int)_nodes.size();
+    _nodes.push_back(Node());
+
+    if (end-begin <= kLeafSize) {
+        _nodes[index].offset = begin;
+        _nodes[index].count = end-begin;
+        return index;
+    }
+
+    float bounds[6];
+    clearBounds(bounds);
+    for (int i=begin; i<end; ++i) {
+        expandBounds(bounds, &centers[_patchOrder[i]*3]);
+    }
+
+    int axis = 0;
+    for (int k=1; k<3; ++k) {
+        if (bounds[k+3]-bounds[k] > bounds[axis+3]-bounds[axis])
+            axis = k;
+    }
+
+    int mid = (begin+end)/2;
+    std::nth_element(_patchOrder.begin()+begin, _patchOrder.begin()+mid,
+        _patchOrder.begin()+end, PatchCenterCompare(centers, axis));
+
+    _nodes[index].count = 0;
+
+    buildNode(begin, mid, centers);
+
+    // the vector may have been reallocated
+    int second = buildNode(mid, end, centers);
+    _nodes[index].offset = second;
+
+    return index;
+}
+
+void
+OsdCpuEvalLimitBVH::Build(OsdVertexBufferDescriptor const & desc, float const * data) {
+
+    _desc = desc;
+    _data = data;
+
+    computePatchBounds();
+
+    int npatches = (int)_patches.size();
+
+    std::vector<float> centers(npatches*3);
+    for (int i=0; i<npatches; ++i) {
+        for (int k=0; k<3; ++k) {
+            centers[i*3+k] = (_patchBounds[i*6+k] + _patchBounds[i*6+k+3]) * 0.5f;
+        }
+    }
+
+    _patchOrder.resize(npatches);
+    for (int i=0; i<npatches; ++i) {
+        _patchOrder[i] = i;
+    }
+
+    _nodes.clear();
+    if (npatches>0) {
+        _nodes.reserve(2*npatches/kLeafSize+1);
+        buildNode(0, npatches, centers);
+    }
+
+    Refit(desc, data);
+}
+
+void
+OsdCpuEvalLimitBVH::Refit(OsdVertexBufferDescriptor const & desc, float const * data) {
+
+    if (_nodes.empty() and not _patches.empty()) {
+        Build(desc, data);
+        return;
+    }
+
+    _desc = desc;
+    _data = data;
+
+    computePatchBounds();
+
+    // the children of a node follow it
+    for (int i=(int)_nodes.size()-1; i>=0; --i) {
+
+        Node & node = _nodes[i];
+
+        clearBounds(node.bounds);
+
+        if (node.count>0) {
+            for (int j=0; j<node.count; ++j) {
+                float const * bounds = &_patchBounds[_patchOrder[node.offset+j]*6];
+                expandBounds(node.bounds, bounds);
+                expandBounds(node.bounds, bounds+3);
+            }
+        } else {
+            Node const & first = _nodes[i+1],
+                       & second = _nodes[node.offset];
+            expandBounds(node.bounds, first.bounds);
+            expandBounds(node.bounds, first.bounds+3);
+            expandBounds(node.bounds, second.bounds);
+            expandBounds(node.bounds, second.bounds+3);
+        }
+    }
+}
+
+void
+OsdCpuEvalLimitBVH::GetBounds(float bounds[6]) const {
+
+    if (_nodes.empty()) {
+        clearBounds(bounds);
+    } else {
+        for (int k=0; k<6; ++k) {
+            bounds[k] = _nodes[0].bounds[k];
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Intersects a ray with a patch : the Bezier hull of the patch is subdivided
+// until Newton iterations started from the center of a sub-patch converge
+// inside the sub-patch. Updates the hit if the intersection is closer.
+bool
+OsdCpuEvalLimitBVH::intersectPatch(int patchIndex, Ray const & ray, Hit * hit) const {
+
+    Patch const & patch = _patches[patchIndex];
+
+    // control points in the frame of the ray
+    float points[20][3];
+    int npoints = getControlPoints(patch, points);
+    for (int i=0; i<npoints; ++i) {
+        float p[3] = { points[i][0], points[i][1], points[i][2] };
+        ray.Transform(p, points[i]);
+    }
+
+    SubPatch stack[3*kMaxDepth+1];
+    int nstack = 1;
+
+    SubPatch & root = stack[0];
+    root.s = root.t = 0.0f;
+    root.size = 1.0f;
+    root.depth = 0;
+
+    float margin[3];
+    computeHull(patch.basis, points, root.points, margin);
+
+    float hull[16][3];
+    memcpy(hull, root.points, sizeof(hull));
+
+    // convergence tolerance relative to the size of the patch
+    float bounds[6];
+    root.GetBounds(bounds);
+
+    float extent = std::max(bounds[3]-bounds[0], bounds[4]-bounds[1]);
+    if (extent<=0.0f)
+        return false;
+
+    float tolerance = extent * 1e-5f;
+
+    bool found = false;
+
+    while (nstack>0) {
+
+        SubPatch sub = stack[--nstack];
+
+        sub.GetBounds(bounds);
+
+        // the ray is the z axis of the frame
+        if (bounds[0]-margin[0] > 0.0f or bounds[3]+margin[0] < 0.0f or
+            bounds[1]-margin[1] > 0.0f or bounds[4]+margin[1] < 0.0f or
+            bounds[5]+margin[2] < 0.0f or bounds[2]-margin[2] > hit->t)
+            continue;
+
+        if (sub.depth>=kMinNewtonDepth) {
+
+            float s = sub.s + sub.size*0.5f,
+                  t = sub.t + sub.size*0.5f,
+                  Q[3], Qs[3], Qt[3];
+
+            bool converged = false;
+
+            for (int i=0; i<kNewtonIterations; ++i) {
+
+                evalPatch(patch.basis, points, hull, s, t, Q, Qs, Qt);
+
+                float residual = std::max(std::fabs(Q[0]), std::fabs(Q[1]));
+
+                if (residual<tolerance) {
+                    converged = true;
+                    break;
+                }
+
+                float det = Qs[0]*Qt[1] - Qs[1]*Qt[0];
+                if (det==0.0f)
+                    break;
+
+                float ds = (Q[0]*Qt[1] - Q[1]*Qt[0]) / det,
+                      dt = (Qs[0]*Q[1] - Qs[1]*Q[0]) / det;
+
+                s -= ds;
+                t -= dt;
+
+                if (s<-0.5f or s>1.5f or t<-0.5f or t>1.5f)
+                    break;
+
+                // the residual of the small patches near the extraordinary
+                // vertices may not reach the tolerance in single precision :
+                // accept a stationary solution
+                if (std::fabs(ds)<kMinNewtonStep and std::fabs(dt)<kMinNewtonStep and
+                    residual<tolerance*100.0f) {
+                    converged = true;
+                    break;
+                }
+            }
+
+            static float const eps = 1e-4f;
+
+            if (converged and s>-eps and s<1.0f+eps and t>-eps and t<1.0f+eps) {
+
+                s = std::min(std::max(s, 0.0f), 1.0f);
+                t = std::min(std::max(t, 0.0f), 1.0f);
+
+                if (Q[2]>=0.0f and Q[2]<hit->t) {
+
+                    hit->t = Q[2];
+
+                    // the kernels evaluate the patches at (v,u)
+                    hit->coords.face = patch.param.faceIndex;
+                    computePtexCoords(patch.param.bitField, t, s,
+                        hit->coords.u, hit->coords.v);
+
+                    found = true;
+                }
+
+                // the intersection of this sub-patch was found
+                if (sub.Contains(s, t))
+                    continue;
+            }
+        }
+
+        if (sub.depth<kMaxDepth)
+            sub.Split(stack, nstack);
+    }
+    return found;
+}
+
+//------------------------------------------------------------------------------
+// Finds the closest point of a patch : the distance is minimized with Newton
+// iterations started from the center of the patch. If they do not converge,
+// the Bezier hull of the patch is subdivided where it may be closer than the
+// closest point found so far, and the iterations are started from the center
+// of the sub-patches. Updates the closest point if a closer one is found.
+bool
+OsdCpuEvalLimitBVH::closestPointPatch(int patchIndex, float const point[3],
+                                      float * distance2, OsdEvalCoords * coords) const {
+
+    Patch const & patch = _patches[patchIndex];
+
+    // control points relative to the query point
+    float points[20][3];
+    int npoints = getControlPoints(patch, points);
+    for (int i=0; i<npoints; ++i) {
+        for (int k=0; k<3; ++k) {
+            points[i][k] -= point[k];
+        }
+    }
+
+    SubPatch stack[3*kMaxDepth+1];
+    int nstack = 1;
+
+    SubPatch & root = stack[0];
+    root.s = root.t = 0.0f;
+    root.size = 1.0f;
+    root.depth = 0;
+
+    float margin[3];
+    computeHull(patch.basis, points, root.points, margin);
+
+    float hull[16][3];
+    memcpy(hull, root.points, sizeof(hull));
+
+    bool found = false;
+
+    while (nstack>0) {
+
+        SubPatch sub = stack[--nstack];
+
+        float bounds[6];
+        sub.GetBounds(bounds);
+        for (int k=0; k<3; ++k) {
+            bounds[k] -= margin[k];
+            bounds[k+3] += margin[k];
+        }
+
+        // the sub-patch cannot be closer than the closest point found so
+        // far, within the relative tolerance of the projection
+        float const origin[3] = { 0.0f, 0.0f, 0.0f };
+        if (boxDistance2(bounds, origin) >= *distance2 * kProjectionTolerance2)
+            continue;
+
+        float s = sub.s + sub.size*0.5f,
+              t = sub.t + sub.size*0.5f,
+              Q[3], Qs[3], Qt[3];
+
+        bool converged = false;
+
+        // minimizes |Q|^2 in the domain of the patch, backtracking the
+        // steps that overshoot
+        float prevS = s, prevT = t, prevD2 = FLT_MAX;
+
+        for (int i=0; i<kProjectionIterations; ++i) {
+
+            evalPatch(patch.basis, points, hull, s, t, Q, Qs, Qt);
+
+            float d2 = Q[0]*Q[0] + Q[1]*Q[1] + Q[2]*Q[2];
+
+            if (d2>prevD2) {
+                s = (s+prevS)*0.5f;
+                t = (t+prevT)*0.5f;
+                continue;
+            }
+
+            // the distance is flat far from the surface : stop when it
+            // no longer decreases
+            if (prevD2-d2 <= prevD2*kMinProjectionDecrease) {
+                prevS = s;
+                prevT = t;
+                prevD2 = d2;
+                converged = true;
+                break;
+            }
+
+            prevS = s;
+            prevT = t;
+            prevD2 = d2;
+
+            float gs = Qs[0]*Q[0] + Qs[1]*Q[1] + Qs[2]*Q[2],
+                  gt = Qt[0]*Q[0] + Qt[1]*Q[1] + Qt[2]*Q[2],
+                  hss = Qs[0]*Qs[0] + Qs[1]*Qs[1] + Qs[2]*Qs[2],
+                  hst = Qs[0]*Qt[0] + Qs[1]*Qt[1] + Qs[2]*Qt[2],
+                  htt = Qt[0]*Qt[0] + Qt[1]*Qt[1] + Qt[2]*Qt[2],
+                  det = hss*htt - hst*hst;
+
+            if (det<=0.0f)
+                break;
+
+            // Gauss-Newton overshoots where the distance is large
+            // relative to the curvature of the surface : add the second
+            // derivatives of the patch (finite differences of the
+            // tangents) unless the Hessian is not positive definite
+            {
+                float hs = s<0.5f ? kProjectionStep : -kProjectionStep,
+                      ht = t<0.5f ? kProjectionStep : -kProjectionStep,
+                      P[3], Ps[3], Pt[3], R[3], Rs[3], Rt[3];
+
+                evalPatch(patch.basis, points, hull, s+hs, t, P, Ps, Pt);
+                evalPatch(patch.basis, points, hull, s, t+ht, R, Rs, Rt);
+
+                float qss = 0.0f, qst = 0.0f, qtt = 0.0f;
+                for (int k=0; k<3; ++k) {
+                    qss += Q[k] * (Ps[k]-Qs[k]) / hs;
+                    qst += Q[k] * ((Pt[k]-Qt[k]) / hs + (Rs[k]-Qs[k]) / ht) * 0.5f;
+                    qtt += Q[k] * (Rt[k]-Qt[k]) / ht;
+                }
+
+                float nss = hss+qss, nst = hst+qst, ntt = htt+qtt,
+                      ndet = nss*ntt - nst*nst;
+
+                if (nss>0.0f and ndet>0.0f) {
+                    hss = nss;
+                    hst = nst;
+                    htt = ntt;
+                    det = ndet;
+                }
+            }
+
+            float ds = (gs*htt - gt*hst) / det,
+                  dt = (gt*hss - gs*hst) / det;
+
+            // minimize along the boundaries of the domain the descent
+            // leaves
+            bool sFixed = (s<=0.0f and gs>0.0f) or (s>=1.0f and gs<0.0f),
+                 tFixed = (t<=0.0f and gt>0.0f) or (t>=1.0f and gt<0.0f);
+
+            if (sFixed and tFixed) {
+                converged = true;
+                break;
+            } else if (sFixed) {
+                ds = 0.0f;
+                dt = gt / htt;
+            } else if (tFixed) {
+                ds = gs / hss;
+                dt = 0.0f;
+            }
+
+            float ns = s - ds,
+                  nt = t - dt;
+
+            ns = std::min(std::max(ns, 0.0f), 1.0f);
+            nt = std::min(std::max(nt, 0.0f), 1.0f);
+
+            if (std::fabs(ns-s)<kMinNewtonStep and std::fabs(nt-t)<kMinNewtonStep) {
+                converged = true;
+                break;
+            }
+
+            s = ns;
+            t = nt;
+        }
+
+        s = prevS;
+        t = prevT;
+
+        // any point of the patch bounds the distance
+        float d2 = prevD2;
+
+        if (d2 < *distance2) {
+
+            *distance2 = d2;
+
+            // the kernels evaluate the patches at (v,u)
+            coords->face = patch.param.faceIndex;
+            computePtexCoords(patch.param.bitField, t, s, coords->u, coords->v);
+
+            found = true;
+        }
+
+        // the descent from the sub-patch reached a minimum of the patch : the
+        // sub-patches are only searched when it does not converge
+        if (converged)
+            continue;
+
+        if (sub.depth<kMaxDepth)
+            sub.Split(stack, nstack);
+    }
+    return found;
+}
+
+bool
+OsdCpuEvalLimitBVH::Intersect(float const origin[3], float const direction[3],
+                              Hit * hit, float tmax) const {
+
+    if (_nodes.empty())
+        return false;
+
+    float len2 = direction[0]*direction[0] +
+                 direction[1]*direction[1] +
+                 direction[2]*direction[2];
+    if (len2==0.0f)
+        return false;
+
+    Ray ray;
+
+    float len = std::sqrt(len2),
+          dir[3] = { direction[0]/len, direction[1]/len, direction[2]/len };
+
+    // orthonormal frame : 2 axes orthogonal to the direction, and the
+    // direction scaled so that the z coordinate is the ray parameter
+    int axis = 0;
+    for (int k=1; k<3; ++k) {
+        if (std::fabs(dir[k]) < std::fabs(dir[axis]))
+            axis = k;
+    }
+    float a[3] = { 0.0f, 0.0f, 0.0f };
+    a[axis] = 1.0f;
+
+    float * x = ray.frame[0],
+          * y = ray.frame[1],
+          * z = ray.frame[2];
+
+    x[0] = dir[1]*a[2] - dir[2]*a[1];
+    x[1] = dir[2]*a[0] - dir[0]*a[2];
+    x[2] = dir[0]*a[1] - dir[1]*a[0];
+    float xlen = std::sqrt(x[0]*x[0] + x[1]*x[1] + x[2]*x[2]);
+    for (int k=0; k<3; ++k) {
+        x[k] /= xlen;
+    }
+
+    y[0] = dir[1]*x[2] - dir[2]*x[1];
+    y[1] = dir[2]*x[0] - dir[0]*x[2];
+    y[2] = dir[0]*x[1] - dir[1]*x[0];
+
+    for (int k=0; k<3; ++k) {
+        z[k] = direction[k] / len2;
+        ray.org[k] = origin[k];
+        ray.invDir[k] = 1.0f / direction[k];
+    }
+
+    Hit nearest;
+    nearest.t = tmax;
+
+    bool found = false;
+
+    int stack[64], nstack = 0;
+    stack[nstack++] = 0;
+
+    while (nstack>0) {
+
+        int index = stack[--nstack];
+
+        Node const & node = _nodes[index];
+
+        if (ray.Enter(node.bounds, nearest.t)<0.0f)
+            continue;
+
+        if (node.count>0) {
+            for (int i=0; i<node.count; ++i) {
+                int patch = _patchOrder[node.offset+i];
+                if (ray.Enter(&_patchBounds[patch*6], nearest.t)>=0.0f and
+                    intersectPatch(patch, ray, &nearest)) {
+                    found = true;
+                }
+            }
+        } else {
+            // visit the nearest child first
+            int first = index + 1,
+                second = node.offset;
+
+            float t0 = ray.Enter(_nodes[first].bounds, nearest.t),
+                  t1 = ray.Enter(_nodes[second].bounds, nearest.t);
+
+            if (t0>=0.0f and t1>=0.0f) {
+                if (t0<t1) std::swap(first, second);
+                stack[nstack++] = first;
+                stack[nstack++] = second;
+            } else if (t0>=0.0f) {
+                stack[nstack++] = first;
+            } else if (t1>=0.0f) {
+                stack[nstack++] = second;
+            }
+        }
+    }
+
+    if (found) {
+        *hit = nearest;
+    }
+    return found;
+}
+
+bool
+OsdCpuEvalLimitBVH::FindClosestPoint(float const point[3], OsdEvalCoords * coords,
+                                     float * distance, float maxDistance) const {
+
+    if (_nodes.empty())
+        return false;
+
+    float best = maxDistance<FLT_MAX ? maxDistance*maxDistance : FLT_MAX;
+
+    OsdEvalCoords closest;
+
+    bool found = false;
+
+    int stack[64], nstack = 0;
+    stack[nstack++] = 0;
+
+    while (nstack>0) {
+
+        int index = stack[--nstack];
+
+        Node const & node = _nodes[index];
+
+        if (boxDistance2(node.bounds, point) >= best)
+            continue;
+
+        if (node.count>0) {
+            for (int i=0; i<node.count; ++i) {
+                int patch = _patchOrder[node.offset+i];
+                if (boxDistance2(&_patchBounds[patch*6], point) < best and
+                    closestPointPatch(patch, point, &best, &closest)) {
+                    found = true;
+                }
+            }
+        } else {
+            // visit the nearest child first
+            int first = index + 1,
+                second = node.offset;
+
+            float d0 = boxDistance2(_nodes[first].bounds, point),
+                  d1 = boxDistance2(_nodes[second].bounds, point);
+
+            if (d0<d1) std::swap(first, second);
+
+            stack[nstack++] = first;
+            stack[nstack++] = second;
+        }
+    }
+
+    if (found) {
+        *coords = closest;
+        if (distance)
+            *distance = std::sqrt(best);
+    }
+    return found;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
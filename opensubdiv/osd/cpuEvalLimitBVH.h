@@ -0,0 +1,233 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OSD_CPU_EVAL_LIMIT_BVH_H
+#define OSD_CPU_EVAL_LIMIT_BVH_H
+
+#include "../version.h"
+
+#include "../osd/evalLimitContext.h"
+#include "../osd/nonCopyable.h"
+#include "../osd/vertexDescriptor.h"
+#include "../far/patchTables.h"
+
+#include <cfloat>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Bounding volume hierarchy of the limit surface patches
+///
+/// Intersects rays with the limit surface of a feature adaptive mesh and finds
+/// the closest points of the surface without tessellating it (picking,
+/// painting, binding to the surface...). The hierarchy is built over the
+/// patches of a FarPatchTables : each patch is bounded by its Bezier control
+/// hull, which contains its limit surface.
+///
+/// The bounds depend on the positions of the control vertices : Build creates
+/// the hierarchy for a first pose, and Refit updates the bounds for the new
+/// poses of the mesh, keeping the hierarchy. The vertex data of the pose is
+/// not copied and must remain valid while rays are intersected.
+///
+/// A ray is intersected with the patches of the leaves it reaches by
+/// subdividing their Bezier hulls until Newton iterations on the limit
+/// surface converge. Closest points are found in the same way, minimizing the
+/// distance in the sub-patches that may be closer than the closest point
+/// found so far.
+///
+/// The surface locations are returned as ptex coordinates, which can be
+/// evaluated with OsdCpuEvalLimitController. Faces without patches (holes) are
+/// not part of the hierarchy.
+///
+/// Supported patches : regular, boundary and corner B-spline patches, Gregory
+/// and boundary Gregory patches. Other patches (Loop) are ignored.
+///
+/// Ex :
+/// \code
+/// OsdCpuEvalLimitBVH * bvh = OsdCpuEvalLimitBVH::Create(patchTables);
+///
+/// bvh->Build(desc, vertexBuffer->BindCpuBuffer());
+///
+/// parallel_for( each ray ) {
+///     OsdCpuEvalLimitBVH::Hit hit;
+///     if (bvh->Intersect(origin, direction, &hit)) { ... }
+/// }
+///
+/// // new pose
+/// computeController->Refine( ... );
+/// bvh->Refit(desc, vertexBuffer->BindCpuBuffer());
+/// \endcode
+///
+class OsdCpuEvalLimitBVH : private OsdNonCopyable<OsdCpuEvalLimitBVH> {
+
+public:
+    /// \brief Factory
+    ///
+    /// Returns NULL if the patch tables are not feature adaptive.
+    ///
+    /// @param patchTables  a pointer to an initialized FarPatchTables
+    ///
+    static OsdCpuEvalLimitBVH * Create(FarPatchTables const *patchTables);
+
+    /// Destructor
+    ~OsdCpuEvalLimitBVH();
+
+    /// \brief Builds the hierarchy for the given pose
+    ///
+    /// @param desc  vertex data descriptor : the first 3 elements of the
+    ///              vertices are the positions
+    ///
+    /// @param data  refined vertex data of the FarMesh of the patch tables
+    ///
+    void Build(OsdVertexBufferDescriptor const & desc, float const * data);
+
+    /// \brief Updates the bounds of the hierarchy for a new pose
+    ///
+    /// Refitting is much cheaper than building, but the hierarchy degrades if
+    /// the pose is very different from the one it was built for. Builds the
+    /// hierarchy if it has not been built yet.
+    ///
+    /// @param desc  vertex data descriptor : the first 3 elements of the
+    ///              vertices are the positions
+    ///
+    /// @param data  refined vertex data of the FarMesh of the patch tables
+    ///
+    void Refit(OsdVertexBufferDescriptor const & desc, float const * data);
+
+    /// \brief Intersection of a ray with the limit surface
+    struct Hit {
+        OsdEvalCoords coords;  ///< ptex face and (u,v) of the hit point
+        float t;               ///< hit point = origin + t * direction
+    };
+
+    /// \brief Finds the nearest intersection of a ray with the limit surface
+    ///
+    /// This function is re-entrant : many threads can intersect rays
+    /// concurrently (but not while the hierarchy is built or refit).
+    ///
+    /// @param origin     origin of the ray
+    ///
+    /// @param direction  direction of the ray (not necessarily normalized)
+    ///
+    /// @param hit        the nearest intersection
+    ///
+    /// @param tmax       only intersections with t < tmax are returned
+    ///
+    /// @return true if the ray intersects the surface
+    ///
+    bool Intersect(float const origin[3], float const direction[3], Hit * hit,
+                   float tmax=FLT_MAX) const;
+
+    /// \brief Finds the closest point of the limit surface
+    ///
+    /// This function is re-entrant : many threads can search concurrently (but
+    /// not while the hierarchy is built or refit).
+    ///
+    /// @param point        query point
+    ///
+    /// @param coords       ptex face and (u,v) of the closest point
+    ///
+    /// @param distance     distance to the closest point (optional)
+    ///
+    /// @param maxDistance  only points closer than maxDistance are returned
+    ///
+    /// @return true if a point was found
+    ///
+    bool FindClosestPoint(float const point[3], OsdEvalCoords * coords,
+                          float * distance=0, float maxDistance=FLT_MAX) const;
+
+    /// Returns the number of patches of the hierarchy
+    int GetNumPatches() const {
+        return (int)_patches.size();
+    }
+
+    /// Returns the bounds of the limit surface { xmin, ymin, zmin, xmax, ymax, zmax }
+    /// (empty before Build)
+    void GetBounds(float bounds[6]) const;
+
+protected:
+    explicit OsdCpuEvalLimitBVH(FarPatchTables const *patchTables);
+
+private:
+
+    struct Patch {
+        int          basis;      // B-spline to Bezier matrix (-1 : Gregory,
+                                 // -2 : boundary Gregory)
+        unsigned int cvOffset;   // first control vertex
+        unsigned int quadOffset; // first quad offset (Gregory)
+        int          gregory;    // index of the Gregory patch (or -1)
+        FarPatchParam param;
+    };
+
+    struct Node {
+        float bounds[6];
+        int   offset,            // first patch (leaf) or second child
+              count;             // number of patches (0 : interior node)
+    };
+
+    struct Ray;
+
+    void computePatchBounds();
+
+    int buildNode(int begin, int end, std::vector<float> const & centers);
+
+    int getControlPoints(Patch const & patch, float points[20][3]) const;
+
+    bool intersectPatch(int patchIndex, Ray const & ray, Hit * hit) const;
+
+    bool closestPointPatch(int patchIndex, float const point[3],
+                           float * distance2, OsdEvalCoords * coords) const;
+
+    std::vector<Patch>         _patches;
+
+    std::vector<unsigned int>  _cvs;          // patch control vertices
+
+    FarPatchTables::VertexValenceTable _vertexValenceTable;
+    FarPatchTables::QuadOffsetTable    _quadOffsetTable;
+    int                                _maxValence;
+
+    // B-spline to Bezier conversion matrices of the regular, boundary and
+    // corner patches
+    std::vector<float>         _bases[3];
+
+    // control points of the Gregory patches of the current pose
+    std::vector<float>         _gregoryPoints;
+    int                        _numGregoryPatches;
+
+    std::vector<float>         _patchBounds;  // 6 floats per patch
+    std::vector<int>           _patchOrder;   // patches of the leaves
+    std::vector<Node>          _nodes;        // depth-first : the first child
+                                              // of a node follows it
+
+    OsdVertexBufferDescriptor  _desc;         // current pose
+    float const *              _data;
+};
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* OSD_CPU_EVAL_LIMIT_BVH_H */
@@ -30,9 +30,25 @@
 #include <cstdio>
 #include <cmath>
 
+#if defined(_WIN32)
+    #include <windows.h>
+#endif
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
+unsigned long long
+OsdCpuEvalLimitContext::newCacheKey() {
+
+    static unsigned long long lastKey = 0;
+
+#if defined(_WIN32)
+    return (unsigned long long)InterlockedIncrement64((LONGLONG volatile *)&lastKey);
+#else
+    return __sync_add_and_fetch(&lastKey, 1ULL);
+#endif
+}
+
 OsdCpuEvalLimitContext *
 OsdCpuEvalLimitContext::Create(FarPatchTables const *patchTables, bool requireFVarData) {
 
@@ -87,11 +103,34 @@ OsdCpuEvalLimitContext::OsdCpuEvalLimitContext(FarPatchTables const *patchTables
     if (requireFVarData) {
         _fvarwidth = patchTables->GetFVarData().GetFVarWidth();
         if (_fvarwidth>0) {
-            _fvarData = patchTables->GetFVarData().GetAllData();
+            FarPatchTables::FVarData const & fvarData = patchTables->GetFVarData();
+            if (fvarData.IsIndexed()) {
+                _fvarData = fvarData.GetValues();
+                _fvarIndices = fvarData.GetIndices();
+            } else {
+                _fvarData = fvarData.GetAllData();
+            }
         }
     }
     
     _patchMap = new FarPatchMap( *patchTables );
+
+    // Slots of the Gregory patches in the control points cache
+    _numGregoryPatches = 0;
+    _gregoryArrayOffsets.resize(_patchArrays.size(), -1);
+    for (int arrayId = 0; arrayId < (int)_patchArrays.size(); ++arrayId) {
+
+        FarPatchTables::PatchArray const & pa = _patchArrays[arrayId];
+
+        FarPatchTables::Type type = pa.GetDescriptor().GetType();
+
+        if (type==FarPatchTables::GREGORY or type==FarPatchTables::GREGORY_BOUNDARY) {
+            _gregoryArrayOffsets[arrayId] = _numGregoryPatches;
+            _numGregoryPatches += pa.GetNumPatches();
+        }
+    }
+
+    _cacheKey = newCacheKey();
 }
 
 OsdCpuEvalLimitContext::~OsdCpuEvalLimitContext() {
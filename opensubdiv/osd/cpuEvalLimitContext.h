@@ -81,10 +81,17 @@ public:
         return _quadOffsetTable;
     }
     
-    /// Returns the face-varying data patch table
+    /// Returns the face-varying data patch table (the unique face-varying
+    /// values if the data is indexed, see GetFVarIndices())
     std::vector<float> const & GetFVarData() const {
         return _fvarData;
     }
+
+    /// Returns the indices of the face-varying values of each vertex of each
+    /// patch (empty if the face-varying data of the patch tables is not indexed)
+    std::vector<unsigned int> const & GetFVarIndices() const {
+        return _fvarIndices;
+    }
     
     /// Returns the number of floats in a datum of the face-varying data table
     int GetFVarWidth() const {
@@ -101,10 +108,31 @@ public:
         return _maxValence;
     }
 
+    /// Returns the number of Gregory and boundary Gregory patches
+    int GetNumGregoryPatches() const {
+        return _numGregoryPatches;
+    }
+
+    /// \brief Discards the Gregory control points cached by the
+    /// OsdCpuEvalLimitController::UpdateGregoryCache of every controller
+    ///
+    /// Binding new vertex buffers to the controller already invalidates the
+    /// cache : this is only needed if the bound vertex data is modified in place.
+    void InvalidateGregoryCache() {
+        _cacheKey = newCacheKey();
+    }
+
 protected:
     explicit OsdCpuEvalLimitContext(FarPatchTables const *patchTables, bool requireFVarData);
 
 private:
+    friend class OsdCpuEvalLimitController;
+
+    // Returns a new key of the Gregory caches of the controllers : the keys
+    // are unique in the process (thread safe), so that a cache can't be
+    // mistaken for the cache of a context or a binding that reuses the
+    // address of a deleted one.
+    static unsigned long long newCacheKey();
 
     // Topology data for a mesh
     FarPatchTables::PatchArrayVector     _patchArrays;    // patch descriptor for each patch in the mesh
@@ -115,9 +143,16 @@ private:
     FarPatchTables::QuadOffsetTable      _quadOffsetTable;
 
     std::vector<float>                   _fvarData;
+    std::vector<unsigned int>            _fvarIndices;
 
     FarPatchMap * _patchMap;           // map of the sub-patches given a face index
 
+    std::vector<int> _gregoryArrayOffsets; // index of the first Gregory patch of
+                                           // each patch array in the cache (or -1)
+    int _numGregoryPatches;
+
+    unsigned long long _cacheKey;          // key of the cached Gregory points
+
     int _maxValence, 
         _fvarwidth;
 };
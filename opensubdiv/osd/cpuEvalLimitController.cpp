@@ -26,10 +26,13 @@
 #include "../osd/cpuEvalLimitKernel.h"
 #include "../far/patchTables.h"
 
+#include <vector>
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-OsdCpuEvalLimitController::OsdCpuEvalLimitController() {
+OsdCpuEvalLimitController::OsdCpuEvalLimitController(OsdScheduler * scheduler) :
+    _scheduler(scheduler) {
 }
 
 OsdCpuEvalLimitController::~OsdCpuEvalLimitController() {
@@ -47,6 +50,186 @@ computeSubPatchCoords( OsdCpuEvalLimitContext * context, unsigned int patchIdx,
     bits.Rotate( u, v );
 }
 
+// Computes the control points of a range of the Gregory patches of an array
+class OsdCpuGregoryCacheTask : public OsdScheduler::Task {
+
+public:
+
+    OsdCpuGregoryCacheTask(OsdCpuEvalLimitContext const * context,
+                           FarPatchTables::PatchArray const & parray,
+                           OsdVertexBufferDescriptor const & desc,
+                           float const * vertices, float * points) :
+        _context(context), _parray(parray), _desc(desc), _vertices(vertices),
+        _points(points) { }
+
+    virtual void Run(int begin, int end) const {
+
+        int length = _desc.length;
+
+        bool boundary = _parray.GetDescriptor().GetType()==FarPatchTables::GREGORY_BOUNDARY;
+
+        for (int j=begin; j<end; ++j) {
+
+            float * points = _points + j*20*length;
+
+            unsigned int const * cvs = &_context->GetControlVertices()[ _parray.GetVertIndex() + j*4 ];
+
+            unsigned int const * quadOffsets = &_context->GetQuadOffsetTable()[ _parray.GetQuadOffsetIndex() + j*4 ];
+
+            if (not boundary) {
+                computeGregoryPoints( cvs,
+                                      &_context->GetVertexValenceTable()[0],
+                                      quadOffsets,
+                                      _context->GetMaxValence(),
+                                      _desc,
+                                      _vertices,
+                                      points );
+            } else {
+                computeGregoryBoundaryPoints( cvs,
+                                              &_context->GetVertexValenceTable()[0],
+                                              quadOffsets,
+                                              _context->GetMaxValence(),
+                                              _desc,
+                                              _vertices,
+                                              points );
+            }
+        }
+    }
+
+private:
+
+    OsdCpuEvalLimitContext const * _context;
+    FarPatchTables::PatchArray const & _parray;
+    OsdVertexBufferDescriptor const & _desc;
+    float const * _vertices;
+    float * _points;
+};
+
+// Evaluates a range of samples of a batch
+class OsdCpuEvalLimitSamplesTask : public OsdScheduler::Task {
+
+public:
+
+    OsdCpuEvalLimitSamplesTask(OsdCpuEvalLimitController const * controller,
+                               OsdEvalCoords const * coords,
+                               OsdCpuEvalLimitContext * context,
+                               unsigned int firstIndex,
+                               unsigned char * found) :
+        _controller(controller), _coords(coords), _context(context),
+        _firstIndex(firstIndex), _found(found) { }
+
+    virtual void Run(int begin, int end) const {
+        for (int i=begin; i<end; ++i) {
+            _found[i] = (unsigned char)_controller->EvalLimitSample(
+                _coords[i], _context, _firstIndex + i);
+        }
+    }
+
+private:
+
+    OsdCpuEvalLimitController const * _controller;
+    OsdEvalCoords const * _coords;
+    OsdCpuEvalLimitContext * _context;
+    unsigned int _firstIndex;
+    unsigned char * _found;
+};
+
+static const int CPU_GREGORY_GRAIN_SIZE = 64,
+                 CPU_LIMIT_SAMPLES_GRAIN_SIZE = 64;
+
+// Computes the control points of the Gregory patches for the bound vertex data
+void
+OsdCpuEvalLimitController::UpdateGregoryCache( OsdCpuEvalLimitContext const * context ) {
+
+    VertexData const & vertexData = _currentBindState.bindings.vertexData;
+
+    if (not context or not vertexData.in)
+        return;
+
+    GregoryCache & cache = _gregoryCache;
+
+    if (cache.contextKey==context->_cacheKey and
+        cache.bindKey==_currentBindState.cacheKey)
+        return;
+
+    int length = vertexData.inDesc.length;
+
+    cache.points.resize(context->GetNumGregoryPatches() * 20 * length);
+    cache.length = length;
+
+    FarPatchTables::PatchArrayVector const & parrays = context->GetPatchArrayVector();
+
+    for (int i=0; i<(int)parrays.size(); ++i) {
+
+        FarPatchTables::PatchArray const & parray = parrays[i];
+
+        FarPatchTables::Type type = parray.GetDescriptor().GetType();
+
+        if (type!=FarPatchTables::GREGORY and type!=FarPatchTables::GREGORY_BOUNDARY)
+            continue;
+
+        float * points = &cache.points[context->_gregoryArrayOffsets[i] * 20 * length];
+
+        OsdCpuGregoryCacheTask task(context, parray, vertexData.inDesc,
+                                    vertexData.in, points);
+
+        if (_scheduler) {
+            _scheduler->ParallelFor(0, (int)parray.GetNumPatches(),
+                                    CPU_GREGORY_GRAIN_SIZE, task);
+        } else {
+            task.Run(0, (int)parray.GetNumPatches());
+        }
+    }
+
+    cache.contextKey = context->_cacheKey;
+    cache.bindKey = _currentBindState.cacheKey;
+}
+
+float const *
+OsdCpuEvalLimitController::getGregoryPoints( OsdCpuEvalLimitContext const * context,
+                                             int patchArrayIdx, int vertexOffset ) const {
+
+    GregoryCache const & cache = _gregoryCache;
+
+    if (cache.contextKey!=context->_cacheKey or
+        cache.bindKey!=_currentBindState.cacheKey)
+        return 0;
+
+    int first = context->_gregoryArrayOffsets[patchArrayIdx];
+    if (first<0)
+        return 0;
+
+    // Gregory patches have 4 control vertices
+    return &cache.points[(first + vertexOffset/4) * 20 * cache.length];
+}
+
+// Vertex interpolation of a batch of samples at the limit
+int
+OsdCpuEvalLimitController::EvalLimitSamples( OpenSubdiv::OsdEvalCoords const * coords,
+                                             int numSamples,
+                                             OsdCpuEvalLimitContext * context,
+                                             unsigned int firstIndex ) const {
+
+    if (not context or not coords or numSamples<=0)
+        return 0;
+
+    std::vector<unsigned char> found(numSamples, 0);
+
+    OsdCpuEvalLimitSamplesTask task(this, coords, context, firstIndex, &found[0]);
+
+    if (_scheduler) {
+        _scheduler->ParallelFor(0, numSamples, CPU_LIMIT_SAMPLES_GRAIN_SIZE, task);
+    } else {
+        task.Run(0, numSamples);
+    }
+
+    int result = 0;
+    for (int i=0; i<numSamples; ++i) {
+        result += found[i];
+    }
+    return result;
+}
+
 // Vertex interpolation of a sample at the limit
 int
 OsdCpuEvalLimitController::EvalLimitSample( OpenSubdiv::OsdEvalCoords const & coord,
@@ -72,9 +255,13 @@ OsdCpuEvalLimitController::EvalLimitSample( OpenSubdiv::OsdEvalCoords const & co
 
     unsigned int const * cvs = &context->GetControlVertices()[ parray.GetVertIndex() + handle->vertexOffset ];
 
-    VertexData const & vertexData = _currentBindState.vertexData;
+    VertexData const & vertexData = _currentBindState.bindings.vertexData;
 
     if (vertexData.in) {
+
+        // cached Gregory control points (see UpdateGregoryCache)
+        float const * points = getGregoryPoints( context, handle->patchArrayIdx,
+                                                 handle->vertexOffset );
     
         float * out   = outQ ? outQ + outDesc.offset : 0,
               * outDu = outDQU ? outDQU + outDesc.offset : 0,
@@ -104,7 +291,14 @@ OsdCpuEvalLimitController::EvalLimitSample( OpenSubdiv::OsdEvalCoords const & co
                                             break;
 
 
-            case FarPatchTables::GREGORY  : evalGregory( v, u, cvs,
+            case FarPatchTables::GREGORY  : if (points) {
+                                                evalGregoryPoints( v, u, points,
+                                                                   vertexData.inDesc.length,
+                                                                   outDesc,
+                                                                   out, outDu, outDv );
+                                                break;
+                                            }
+                                            evalGregory( v, u, cvs,
                                                          &context->GetVertexValenceTable()[0],
                                                          &context->GetQuadOffsetTable()[ parray.GetQuadOffsetIndex() + handle->vertexOffset ],
                                                          context->GetMaxValence(),
@@ -115,6 +309,13 @@ OsdCpuEvalLimitController::EvalLimitSample( OpenSubdiv::OsdEvalCoords const & co
                                             break;
 
             case FarPatchTables::GREGORY_BOUNDARY :
+                                            if (points) {
+                                                evalGregoryPoints( v, u, points,
+                                                                   vertexData.inDesc.length,
+                                                                   outDesc,
+                                                                   out, outDu, outDv );
+                                                break;
+                                            }
                                             evalGregoryBoundary( v, u, cvs,
                                                                  &context->GetVertexValenceTable()[0],
                                                                  &context->GetQuadOffsetTable()[ parray.GetQuadOffsetIndex() + handle->vertexOffset ],
@@ -125,6 +326,23 @@ OsdCpuEvalLimitController::EvalLimitSample( OpenSubdiv::OsdEvalCoords const & co
                                                                  out, outDu, outDv );
                                             break;
 
+            case FarPatchTables::LOOP     : evalLoop( u, v, cvs,
+                                                      vertexData.inDesc,
+                                                      vertexData.in,
+                                                      outDesc,
+                                                      out, outDu, outDv );
+                                            break;
+
+            case FarPatchTables::LOOP_IRREGULAR :
+                                            evalLoopIrregular( u, v, cvs,
+                                                               &context->GetVertexValenceTable()[0],
+                                                               context->GetMaxValence(),
+                                                               vertexData.inDesc,
+                                                               vertexData.in,
+                                                               outDesc,
+                                                               out, outDu, outDv );
+                                            break;
+
             default:
                 assert(0);
         }
@@ -137,6 +355,8 @@ OsdCpuEvalLimitController::EvalLimitSample( OpenSubdiv::OsdEvalCoords const & co
 int
 OsdCpuEvalLimitController::_EvalLimitSample( OpenSubdiv::OsdEvalCoords const & coords,
                                              OsdCpuEvalLimitContext * context,
+                                             Bindings const & bindings,
+                                             bool gregoryCache,
                                              unsigned int index ) const {
     float u=coords.u,
           v=coords.v;
@@ -154,10 +374,15 @@ OsdCpuEvalLimitController::_EvalLimitSample( OpenSubdiv::OsdEvalCoords const & c
 
     unsigned int const * cvs = &context->GetControlVertices()[ parray.GetVertIndex() + handle->vertexOffset ];
 
-    VertexData const & vertexData = _currentBindState.vertexData;
+    VertexData const & vertexData = bindings.vertexData;
 
     if (vertexData.in) {
 
+        // cached Gregory control points (see UpdateGregoryCache)
+        float const * points = gregoryCache ?
+            getGregoryPoints( context, handle->patchArrayIdx,
+                              handle->vertexOffset ) : 0;
+
         int offset = vertexData.outDesc.stride * index;
 
         if (vertexData.out) {
@@ -191,7 +416,14 @@ OsdCpuEvalLimitController::_EvalLimitSample( OpenSubdiv::OsdEvalCoords const & c
                                                 break;
 
 
-                case FarPatchTables::GREGORY  : evalGregory( v, u, cvs,
+                case FarPatchTables::GREGORY  : if (points) {
+                                                    evalGregoryPoints( v, u, points,
+                                                                       vertexData.inDesc.length,
+                                                                       vertexData.outDesc,
+                                                                       out, outDu, outDv );
+                                                    break;
+                                                }
+                                                evalGregory( v, u, cvs,
                                                              &context->GetVertexValenceTable()[0],
                                                              &context->GetQuadOffsetTable()[ parray.GetQuadOffsetIndex() + handle->vertexOffset ],
                                                              context->GetMaxValence(),
@@ -202,6 +434,13 @@ OsdCpuEvalLimitController::_EvalLimitSample( OpenSubdiv::OsdEvalCoords const & c
                                                 break;
 
                 case FarPatchTables::GREGORY_BOUNDARY :
+                                                if (points) {
+                                                    evalGregoryPoints( v, u, points,
+                                                                       vertexData.inDesc.length,
+                                                                       vertexData.outDesc,
+                                                                       out, outDu, outDv );
+                                                    break;
+                                                }
                                                 evalGregoryBoundary( v, u, cvs,
                                                                      &context->GetVertexValenceTable()[0],
                                                                      &context->GetQuadOffsetTable()[ parray.GetQuadOffsetIndex() + handle->vertexOffset ],
@@ -212,13 +451,30 @@ OsdCpuEvalLimitController::_EvalLimitSample( OpenSubdiv::OsdEvalCoords const & c
                                                                      out, outDu, outDv );
                                                 break;
 
+                case FarPatchTables::LOOP     : evalLoop( u, v, cvs,
+                                                          vertexData.inDesc,
+                                                          vertexData.in,
+                                                          vertexData.outDesc,
+                                                          out, outDu, outDv );
+                                                break;
+
+                case FarPatchTables::LOOP_IRREGULAR :
+                                                evalLoopIrregular( u, v, cvs,
+                                                                   &context->GetVertexValenceTable()[0],
+                                                                   context->GetMaxValence(),
+                                                                   vertexData.inDesc,
+                                                                   vertexData.in,
+                                                                   vertexData.outDesc,
+                                                                   out, outDu, outDv );
+                                                break;
+
                 default:
                     assert(0);
             }
         }
     }
 
-    VaryingData const & varyingData = _currentBindState.varyingData;
+    VaryingData const & varyingData = bindings.varyingData;
 
     if (varyingData.in and varyingData.out) {
 
@@ -228,20 +484,39 @@ OsdCpuEvalLimitController::_EvalLimitSample( OpenSubdiv::OsdEvalCoords const & c
                                      {0, 1, 2, 3},  // gregory
                                      {0, 1, 2, 3} };// gregory boundary
 
-        int type = (int)(parray.GetDescriptor().GetType() - FarPatchTables::REGULAR);
+        FarPatchTables::Type ptype = parray.GetDescriptor().GetType();
 
         int offset = varyingData.outDesc.stride * index;
 
-        unsigned int zeroRing[4] = { cvs[indices[type][0]],
-                                     cvs[indices[type][1]],
-                                     cvs[indices[type][2]],
-                                     cvs[indices[type][3]]  };
+        if (ptype==FarPatchTables::LOOP or ptype==FarPatchTables::LOOP_IRREGULAR) {
+
+            // triangle corners
+            bool regular = (ptype==FarPatchTables::LOOP);
 
-        evalBilinear( v, u, zeroRing,
-                      varyingData.inDesc,
-                      varyingData.in,
-                      varyingData.outDesc,
-                      varyingData.out+offset);
+            unsigned int zeroRing[3] = { cvs[regular ? 3 : 0],
+                                         cvs[regular ? 6 : 1],
+                                         cvs[regular ? 7 : 2] };
+
+            evalLinear( u, v, zeroRing,
+                        varyingData.inDesc,
+                        varyingData.in,
+                        varyingData.outDesc,
+                        varyingData.out+offset);
+        } else {
+
+            int type = (int)(ptype - FarPatchTables::REGULAR);
+
+            unsigned int zeroRing[4] = { cvs[indices[type][0]],
+                                         cvs[indices[type][1]],
+                                         cvs[indices[type][2]],
+                                         cvs[indices[type][3]]  };
+
+            evalBilinear( v, u, zeroRing,
+                          varyingData.inDesc,
+                          varyingData.in,
+                          varyingData.outDesc,
+                          varyingData.out+offset);
+        }
 
     }
 
@@ -250,7 +525,7 @@ OsdCpuEvalLimitController::_EvalLimitSample( OpenSubdiv::OsdEvalCoords const & c
     // sets, the feature-adaptive patch interpolation code currently does not
     // support them, and neither does this EvalContext.
 
-    FacevaryingData const & facevaryingData = _currentBindState.facevaryingData;
+    FacevaryingData const & facevaryingData = bindings.facevaryingData;
 
     if (facevaryingData.out) {
 
@@ -260,13 +535,26 @@ OsdCpuEvalLimitController::_EvalLimitSample( OpenSubdiv::OsdEvalCoords const & c
 
             int offset = facevaryingData.outDesc.stride * index;
 
-            static unsigned int zeroRing[4] = {0,1,2,3};
+            std::vector<unsigned int> const & fvarIndices = context->GetFVarIndices();
 
-            evalBilinear( v, u, zeroRing,
-                          facevaryingData.inDesc,
-                          &fvarData[ handle->patchIdx * 4 * context->GetFVarWidth() ],
-                          facevaryingData.outDesc,
-                          facevaryingData.out+offset);
+            if (fvarIndices.empty()) {
+
+                static unsigned int zeroRing[4] = {0,1,2,3};
+
+                evalBilinear( v, u, zeroRing,
+                              facevaryingData.inDesc,
+                              &fvarData[ handle->patchIdx * 4 * context->GetFVarWidth() ],
+                              facevaryingData.outDesc,
+                              facevaryingData.out+offset);
+            } else {
+
+                // indexed face-varying data
+                evalBilinear( v, u, &fvarIndices[ handle->patchIdx * 4 ],
+                              facevaryingData.inDesc,
+                              &fvarData[0],
+                              facevaryingData.outDesc,
+                              facevaryingData.out+offset);
+            }
         }
     }
 
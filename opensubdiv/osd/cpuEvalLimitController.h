@@ -29,8 +29,11 @@
 
 #include "../osd/evalLimitContext.h"
 #include "../osd/cpuEvalLimitContext.h"
+#include "../osd/scheduler.h"
 #include "../osd/vertexDescriptor.h"
 
+#include <vector>
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
@@ -56,11 +59,37 @@ namespace OPENSUBDIV_VERSION {
 /// evalCtroller->Unbind();
 /// \endcode
 ///
+/// The control points of the Gregory patches only depend on the control
+/// vertices : when evaluating many samples of a same pose, they can be computed
+/// once by calling UpdateGregoryCache after binding the vertex buffers.
+///
+/// The buffers can also be bound to a Bindings instance that is passed to each
+/// evaluation call : this leaves the controller stateless, so that a single
+/// controller can evaluate several meshes or primvars from many threads.
+///
+/// \code
+/// OsdCpuEvalLimitController::Bindings bindings;
+/// bindings.BindVertexBuffers( ... );
+///
+/// parallel_for( int index=0; i<nsamples; ++index ) {
+///    evalCtroller->EvalLimitSample( coord, evalCtxt, bindings, index );
+/// }
+/// \endcode
+///
+/// EvalLimitSamples evaluates a batch of samples into the bound buffers,
+/// split across the threads of the OsdScheduler given to the constructor
+/// (which also computes the Gregory patch cache).
+///
 class OsdCpuEvalLimitController {
 
 public:
-    /// Constructor.
-    OsdCpuEvalLimitController();
+    /// \brief Constructor.
+    ///
+    /// @param scheduler  the scheduler running EvalLimitSamples and
+    ///                   UpdateGregoryCache in parallel (not owned). If it's
+    ///                   null, they run in the calling thread.
+    ///
+    OsdCpuEvalLimitController(OsdScheduler * scheduler=NULL);
 
     /// Destructor.
     ~OsdCpuEvalLimitController();
@@ -90,15 +119,28 @@ public:
                             OsdVertexBufferDescriptor const & oDesc, OUTPUT_BUFFER *outQ,
                                                                      OUTPUT_BUFFER *outdQu=0,
                                                                      OUTPUT_BUFFER *outdQv=0 ) {
-        _currentBindState.vertexData.inDesc = iDesc;
-        _currentBindState.vertexData.in = inQ ? inQ->BindCpuBuffer() : 0;
+        _currentBindState.bindings.BindVertexBuffers(iDesc, inQ, oDesc, outQ, outdQu, outdQv);
 
-        _currentBindState.vertexData.outDesc = oDesc;
-        _currentBindState.vertexData.out = outQ ? outQ->BindCpuBuffer() : 0;
-        _currentBindState.vertexData.outDu = outdQu ? outdQu->BindCpuBuffer() : 0;
-        _currentBindState.vertexData.outDv = outdQv ? outdQv->BindCpuBuffer() : 0;
+        // the Gregory patches cached for the previous buffers are out of date
+        _currentBindState.cacheKey = OsdCpuEvalLimitContext::newCacheKey();
     }
 
+    /// \brief Computes the control points of the Gregory patches of the context
+    ///
+    /// The samples of the context that land on Gregory patches are then
+    /// evaluated from the cached points instead of gathering the 1-ring of the
+    /// patch vertices. Does nothing if the cache is already up to date with the
+    /// context and the bound vertex buffers.
+    ///
+    /// The cache belongs to the controller and holds the points of a single
+    /// context : controllers evaluating the same context don't share it.
+    /// Like the binding functions, this function must be called outside of the
+    /// parallel evaluation loop.
+    ///
+    /// @param context  the EvalLimitContext of the patches
+    ///
+    void UpdateGregoryCache( OsdCpuEvalLimitContext const * context );
+
     /// \brief Binds the varying-interpolated data streams
     ///
     /// @param iDesc  data descriptor shared by all input data buffers
@@ -112,11 +154,7 @@ public:
     template<class INPUT_BUFFER, class OUTPUT_BUFFER>
     void BindVaryingBuffers( OsdVertexBufferDescriptor const & iDesc, INPUT_BUFFER *inQ,
                              OsdVertexBufferDescriptor const & oDesc, OUTPUT_BUFFER *outQ ) {
-        _currentBindState.varyingData.inDesc = iDesc;
-        _currentBindState.varyingData.in = inQ ? inQ->BindCpuBuffer() : 0;
-
-        _currentBindState.varyingData.outDesc = oDesc;
-        _currentBindState.varyingData.out = outQ ? outQ->BindCpuBuffer() : 0;
+        _currentBindState.bindings.BindVaryingBuffers(iDesc, inQ, oDesc, outQ);
     }
 
     /// \brief Binds the face-varying-interpolated data streams
@@ -135,10 +173,7 @@ public:
     template<class OUTPUT_BUFFER>
     void BindFacevaryingBuffers( OsdVertexBufferDescriptor const & iDesc,
                                  OsdVertexBufferDescriptor const & oDesc, OUTPUT_BUFFER *outQ ) {
-        _currentBindState.facevaryingData.inDesc = iDesc;
-
-        _currentBindState.facevaryingData.outDesc = oDesc;
-        _currentBindState.facevaryingData.out = outQ ? outQ->BindCpuBuffer() : 0;
+        _currentBindState.bindings.BindFacevaryingBuffers(iDesc, oDesc, outQ);
     }
 
     /// \brief Vertex interpolation of a single sample at the limit
@@ -190,11 +225,33 @@ public:
         if (not context)
             return 0;
 
-        int n = _EvalLimitSample( coords, context, index );
+        int n = _EvalLimitSample( coords, context, _currentBindState.bindings,
+                                  /*gregoryCache*/ true, index );
 
         return n;
     }
 
+    /// \brief Vertex interpolation of a batch of samples at the limit
+    ///
+    /// Evaluates "vertex" interpolation of numSamples samples on the surface
+    /// limit, sample i to the vertex firstIndex+i of the output buffers bound
+    /// to the controller.
+    ///
+    /// @param coords      locations on the limit surface to be evaluated
+    ///
+    /// @param numSamples  the number of samples
+    ///
+    /// @param context     the EvalLimitContext that the controller will evaluate
+    ///
+    /// @param firstIndex  the index of the first vertex in the output buffers
+    ///
+    /// @return the number of samples found
+    ///
+    int EvalLimitSamples( OpenSubdiv::OsdEvalCoords const * coords,
+                          int numSamples,
+                          OsdCpuEvalLimitContext * context,
+                          unsigned int firstIndex=0 ) const;
+
     void Unbind() {
         _currentBindState.Reset();
     }
@@ -256,31 +313,148 @@ protected:
         float * out;
     };
     
+public:
+
+    /// \brief Set of data buffers to evaluate
+    ///
+    /// Unlike the buffers bound to the controller, a Bindings instance is
+    /// passed to each evaluation call and is not modified by the evaluation :
+    /// many threads can evaluate different Bindings (different meshes or
+    /// primvars) concurrently, with a single controller and shared contexts.
+    ///
+    /// The functions have the semantics of the Bind functions of the
+    /// controller. They must not be called while the Bindings are evaluated.
+    ///
+    class Bindings {
+    public:
+        /// \brief Binds control vertex data buffer (see
+        /// OsdCpuEvalLimitController::BindVertexBuffers)
+        template<class INPUT_BUFFER, class OUTPUT_BUFFER>
+        void BindVertexBuffers( OsdVertexBufferDescriptor const & iDesc, INPUT_BUFFER *inQ,
+                                OsdVertexBufferDescriptor const & oDesc, OUTPUT_BUFFER *outQ,
+                                                                         OUTPUT_BUFFER *outdQu=0,
+                                                                         OUTPUT_BUFFER *outdQv=0 ) {
+            vertexData.inDesc = iDesc;
+            vertexData.in = inQ ? inQ->BindCpuBuffer() : 0;
+
+            vertexData.outDesc = oDesc;
+            vertexData.out = outQ ? outQ->BindCpuBuffer() : 0;
+            vertexData.outDu = outdQu ? outdQu->BindCpuBuffer() : 0;
+            vertexData.outDv = outdQv ? outdQv->BindCpuBuffer() : 0;
+        }
+
+        /// \brief Binds the varying-interpolated data streams (see
+        /// OsdCpuEvalLimitController::BindVaryingBuffers)
+        template<class INPUT_BUFFER, class OUTPUT_BUFFER>
+        void BindVaryingBuffers( OsdVertexBufferDescriptor const & iDesc, INPUT_BUFFER *inQ,
+                                 OsdVertexBufferDescriptor const & oDesc, OUTPUT_BUFFER *outQ ) {
+            varyingData.inDesc = iDesc;
+            varyingData.in = inQ ? inQ->BindCpuBuffer() : 0;
+
+            varyingData.outDesc = oDesc;
+            varyingData.out = outQ ? outQ->BindCpuBuffer() : 0;
+        }
+
+        /// \brief Binds the face-varying-interpolated data streams (see
+        /// OsdCpuEvalLimitController::BindFacevaryingBuffers)
+        template<class OUTPUT_BUFFER>
+        void BindFacevaryingBuffers( OsdVertexBufferDescriptor const & iDesc,
+                                     OsdVertexBufferDescriptor const & oDesc, OUTPUT_BUFFER *outQ ) {
+            facevaryingData.inDesc = iDesc;
+
+            facevaryingData.outDesc = oDesc;
+            facevaryingData.out = outQ ? outQ->BindCpuBuffer() : 0;
+        }
+
+        /// \brief Unbinds all the buffers
+        void Reset() {
+            vertexData.Reset();
+            varyingData.Reset();
+            facevaryingData.Reset();
+        }
+
+    private:
+        friend class OsdCpuEvalLimitController;
+
+        VertexData       vertexData;      // vertex interpolated data descriptor
+        VaryingData      varyingData;     // varying interpolated data descriptor 
+        FacevaryingData  facevaryingData; // face-varying interpolated data descriptor 
+    };
+
+    /// \brief Vertex interpolation of samples at the limit
+    ///
+    /// Same as above, for the buffers of the given bindings instead of the
+    /// buffers bound to the controller. This function does not use any state
+    /// of the controller and can be called concurrently for any bindings and
+    /// contexts. It does not use the Gregory patches of UpdateGregoryCache,
+    /// which are tied to the buffers bound to the controller.
+    ///
+    /// @param coords    location on the limit surface to be evaluated
+    ///
+    /// @param context   the EvalLimitContext that the controller will evaluate
+    ///
+    /// @param bindings  the data buffers to evaluate
+    ///
+    /// @param index     the index of the vertex in the output buffers of the
+    ///                  bindings
+    ///
+    /// @return the number of samples found (0 if the location was tagged as a hole
+    ///         or the coordinate was invalid)
+    ///
+    int EvalLimitSample( OpenSubdiv::OsdEvalCoords const & coords,
+                         OsdCpuEvalLimitContext * context,
+                         Bindings const & bindings,
+                         unsigned int index ) const {
+        if (not context)
+            return 0;
+
+        return _EvalLimitSample( coords, context, bindings, /*gregoryCache*/ false, index );
+    }
 
 private:
 
     int _EvalLimitSample( OpenSubdiv::OsdEvalCoords const & coords,
                           OsdCpuEvalLimitContext * context,
+                          Bindings const & bindings,
+                          bool gregoryCache,
                           unsigned int index ) const;
 
+    // Returns the cached control points of a Gregory patch (or NULL)
+    float const * getGregoryPoints( OsdCpuEvalLimitContext const * context,
+                                    int patchArrayIdx, int vertexOffset ) const;
+
     // Bind state is a transitional state during refinement.
     // It doesn't take an ownership of vertex buffers.
     struct BindState {
 
-        BindState() { }
+        BindState() : cacheKey(0) { }
         
         void Reset() {
-            vertexData.Reset();
-            varyingData.Reset();
-            facevaryingData.Reset();
+            bindings.Reset();
         }
 
-        VertexData       vertexData;      // vertex interpolated data descriptor
-        VaryingData      varyingData;     // varying interpolated data descriptor 
-        FacevaryingData  facevaryingData; // face-varying interpolated data descriptor 
+        Bindings           bindings;      // bound data buffers
+
+        unsigned long long cacheKey;      // new key when the vertex data is bound
     };
 
     BindState _currentBindState;
+
+    // Control points of the Gregory patches of a context for the bound pose
+    struct GregoryCache {
+
+        GregoryCache() : contextKey(0), bindKey(0), length(0) { }
+
+        std::vector<float> points;        // 20 control points per patch
+
+        unsigned long long contextKey,    // keys of the context and the binding
+                           bindKey;       // that filled the cache (0 if none)
+        int                length;
+    };
+
+    GregoryCache _gregoryCache;
+
+    OsdScheduler * _scheduler;
 };
 
 } // end namespace OPENSUBDIV_VERSION
@@ -66,6 +66,35 @@ evalBilinear(float u, float v,
 }
 
 
+void
+evalLinear(float u, float v,
+           unsigned int const * vertexIndices,
+           OsdVertexBufferDescriptor const & inDesc,
+           float const * inQ,
+           OsdVertexBufferDescriptor const & outDesc,
+           float * outQ) {
+
+    assert( outQ and inDesc.length <= (outDesc.stride-outDesc.offset) );
+
+    float const * inOffset = inQ + inDesc.offset;
+
+    float * Q = outQ + outDesc.offset;
+
+    memset(Q, 0, inDesc.length*sizeof(float));
+
+    float w[3] = { 1.0f-u-v, u, v };
+
+    for (int i=0; i<3; ++i) {
+
+        float const * in = inOffset + vertexIndices[i]*inDesc.stride;
+
+        for (int k=0; k<inDesc.length; ++k) {
+            Q[k] += w[i] * in[k];
+        }
+    }
+}
+
+
 inline void
 evalCubicBSpline(float u, float B[4], float BU[4]) {
     float t = u;
@@ -425,25 +454,14 @@ csf(unsigned int n, unsigned int j)
 
 
 void
-evalGregory(float u, float v,
-            unsigned int const * vertexIndices,
-            int const * vertexValenceBuffer,
-            unsigned int const  * quadOffsetBuffer,
-            int maxValence,
-            OsdVertexBufferDescriptor const & inDesc,
-            float const * inQ,
-            OsdVertexBufferDescriptor const & outDesc,
-            float * outQ,
-            float * outDQU,
-            float * outDQV )
+computeGregoryPoints(unsigned int const * vertexIndices,
+                     int const * vertexValenceBuffer,
+                     unsigned int const  * quadOffsetBuffer,
+                     int maxValence,
+                     OsdVertexBufferDescriptor const & inDesc,
+                     float const * inQ,
+                     float * points )
 {
-    // vertex
-
-    // make sure that we have enough space to store results
-    assert( outQ and inDesc.length <= (outDesc.stride-outDesc.offset) );
-
-    bool evalDeriv = (outDQU or outDQV);
-
     int valences[4], length=inDesc.length;
 
     float const * inOffset = inQ + inDesc.offset;
@@ -591,117 +609,26 @@ evalGregory(float u, float v,
         }
     }
 
-    float * p[20];
-    for (int i=0, ofs=0; i<4; ++i, ofs+=length) {
-        p[i*5+0] = opos + ofs;
-        p[i*5+1] =   Ep + ofs;
-        p[i*5+2] =   Em + ofs;
-        p[i*5+3] =   Fp + ofs;
-        p[i*5+4] =   Fm + ofs;
-    }
-
-    float U = 1-u, V=1-v;
-#ifdef __INTEL_COMPILER // remark #1572: floating-point equality and inequality comparisons are unreliable
-#pragma warning disable 1572
-#endif
-    float d11 = u+v; if(u+v==0.0f) d11 = 1.0f;
-    float d12 = U+v; if(U+v==0.0f) d12 = 1.0f;
-    float d21 = u+V; if(u+V==0.0f) d21 = 1.0f;
-    float d22 = U+V; if(U+V==0.0f) d22 = 1.0f;
-#ifdef __INTEL_COMPILER
-#pragma warning enable 1572
-#endif
-
-    float *q=(float*)alloca(length*16*sizeof(float));
-    for (int k=0; k<length; ++k) {
-        q[ 5*length+k] = (u*p[ 3][k] + v*p[ 4][k])/d11;
-        q[ 6*length+k] = (U*p[ 9][k] + v*p[ 8][k])/d12;
-        q[ 9*length+k] = (u*p[19][k] + V*p[18][k])/d21;
-        q[10*length+k] = (U*p[13][k] + V*p[14][k])/d22;
-    }
-
-    memcpy(q+ 0*length, p[ 0], length*sizeof(float));
-    memcpy(q+ 1*length, p[ 1], length*sizeof(float));
-    memcpy(q+ 2*length, p[ 7], length*sizeof(float));
-    memcpy(q+ 3*length, p[ 5], length*sizeof(float));
-    memcpy(q+ 4*length, p[ 2], length*sizeof(float));
-    memcpy(q+ 7*length, p[ 6], length*sizeof(float));
-    memcpy(q+ 8*length, p[16], length*sizeof(float));
-    memcpy(q+11*length, p[12], length*sizeof(float));
-    memcpy(q+12*length, p[15], length*sizeof(float));
-    memcpy(q+13*length, p[17], length*sizeof(float));
-    memcpy(q+14*length, p[11], length*sizeof(float));
-    memcpy(q+15*length, p[10], length*sizeof(float));
-
-    float B[4], D[4],
-          *BU=(float*)alloca(inDesc.length*4*sizeof(float)),
-          *DU=(float*)alloca(inDesc.length*4*sizeof(float));
-    memset(BU, 0, inDesc.length*4*sizeof(float));
-    memset(DU, 0, inDesc.length*4*sizeof(float));
-
-    univar4x4(u, B, evalDeriv ? D : 0);
-
-    for (int i=0; i<4; ++i) {
-        for (int j=0; j<4; ++j) {
-
-            float const * in = q + (i+j*4)*length;
-
-            for (int k=0; k<inDesc.length; ++k) {
-
-                BU[i*inDesc.length+k] += in[k] * B[j];
-
-                if (evalDeriv)
-                    DU[i*inDesc.length+k] += in[k] * D[j];
-            }
-        }
-    }
-
-    univar4x4(v, B, evalDeriv ? D : 0);
-
-    float * Q = outQ + outDesc.offset;
-    float * dQU = outDQU + outDesc.offset;
-    float * dQV = outDQV + outDesc.offset;
-
-    // clear result
-    memset(Q, 0, outDesc.length*sizeof(float));
-    if (evalDeriv) {
-        memset(dQU, 0, outDesc.length*sizeof(float));
-        memset(dQV, 0, outDesc.length*sizeof(float));
-    }
-
-    for (int i=0; i<4; ++i) {
-        for (int k=0; k<inDesc.length; ++k) {
-            Q[k] += BU[inDesc.length*i+k] * B[i];
-
-            if (evalDeriv) {
-                dQU[k] += DU[inDesc.length*i+k] * B[i];
-                dQV[k] += BU[inDesc.length*i+k] * D[i];
-            }
-        }
+    // pack the 20 control points : P, Ep, Em, Fp, Fm for each corner
+    for (int vid=0, ofs=0; vid<4; ++vid, ofs+=length) {
+        memcpy(points + (vid*5+0)*length, opos + ofs, length*sizeof(float));
+        memcpy(points + (vid*5+1)*length,   Ep + ofs, length*sizeof(float));
+        memcpy(points + (vid*5+2)*length,   Em + ofs, length*sizeof(float));
+        memcpy(points + (vid*5+3)*length,   Fp + ofs, length*sizeof(float));
+        memcpy(points + (vid*5+4)*length,   Fm + ofs, length*sizeof(float));
     }
 }
 
 
 void
-evalGregoryBoundary(float u, float v,
-                    unsigned int const * vertexIndices,
-                    int const * vertexValenceBuffer,
-                    unsigned int const  * quadOffsetBuffer,
-                    int maxValence,
-                    OsdVertexBufferDescriptor const & inDesc,
-                    float const * inQ,
-                    OsdVertexBufferDescriptor const & outDesc,
-                    float * outQ,
-                    float * outDQU,
-                    float * outDQV )
+computeGregoryBoundaryPoints(unsigned int const * vertexIndices,
+                             int const * vertexValenceBuffer,
+                             unsigned int const  * quadOffsetBuffer,
+                             int maxValence,
+                             OsdVertexBufferDescriptor const & inDesc,
+                             float const * inQ,
+                             float * points )
 {
-    // vertex
-
-    // make sure that we have enough space to store results
-    assert( outQ and inDesc.length <= (outDesc.stride-outDesc.offset) );
-
-    bool evalDeriv = (outDQU or outDQV);
-
     int valences[4], zerothNeighbors[4], length=inDesc.length;
 
     float const * inOffset = inQ + inDesc.offset;
@@ -997,13 +924,34 @@ evalGregoryBoundary(float u, float v,
         }
     }
 
-    float * p[20];
+    // pack the 20 control points : P, Ep, Em, Fp, Fm for each corner
     for (int vid=0, ofs=0; vid<4; ++vid, ofs+=length) {
-        p[vid*5+0] = opos + ofs;
-        p[vid*5+1] =   Ep + ofs;
-        p[vid*5+2] =   Em + ofs;
-        p[vid*5+3] =   Fp + ofs;
-        p[vid*5+4] =   Fm + ofs;
+        memcpy(points + (vid*5+0)*length, opos + ofs, length*sizeof(float));
+        memcpy(points + (vid*5+1)*length,   Ep + ofs, length*sizeof(float));
+        memcpy(points + (vid*5+2)*length,   Em + ofs, length*sizeof(float));
+        memcpy(points + (vid*5+3)*length,   Fp + ofs, length*sizeof(float));
+        memcpy(points + (vid*5+4)*length,   Fm + ofs, length*sizeof(float));
+    }
+}
+
+
+void
+evalGregoryPoints(float u, float v,
+                  float const * points,
+                  int length,
+                  OsdVertexBufferDescriptor const & outDesc,
+                  float * outQ,
+                  float * outDQU,
+                  float * outDQV )
+{
+    // make sure that we have enough space to store results
+    assert( outQ and length <= (outDesc.stride-outDesc.offset) );
+
+    bool evalDeriv = (outDQU or outDQV);
+
+    float const * p[20];
+    for (int i=0; i<20; ++i) {
+        p[i] = points + i*length;
     }
 
     float U = 1-u, V=1-v;
@@ -1040,10 +988,10 @@ evalGregoryBoundary(float u, float v,
     memcpy(q+15*length, p[10], length*sizeof(float));
 
     float B[4], D[4],
-          *BU=(float*)alloca(inDesc.length*4*sizeof(float)),
-          *DU=(float*)alloca(inDesc.length*4*sizeof(float));
-    memset(BU, 0, inDesc.length*4*sizeof(float));
-    memset(DU, 0, inDesc.length*4*sizeof(float));
+          *BU=(float*)alloca(length*4*sizeof(float)),
+          *DU=(float*)alloca(length*4*sizeof(float));
+    memset(BU, 0, length*4*sizeof(float));
+    memset(DU, 0, length*4*sizeof(float));
 
     univar4x4(u, B, evalDeriv ? D : 0);
 
@@ -1052,12 +1000,12 @@ evalGregoryBoundary(float u, float v,
 
             float const * in = q + (i+j*4)*length;
 
-            for (int k=0; k<inDesc.length; ++k) {
+            for (int k=0; k<length; ++k) {
 
-                BU[i*inDesc.length+k] += in[k] * B[j];
+                BU[i*length+k] += in[k] * B[j];
 
                 if (evalDeriv)
-                    DU[i*inDesc.length+k] += in[k] * D[j];
+                    DU[i*length+k] += in[k] * D[j];
             }
         }
     }
@@ -1076,14 +1024,331 @@ evalGregoryBoundary(float u, float v,
     }
 
     for (int i=0; i<4; ++i) {
-        for (int k=0; k<inDesc.length; ++k) {
-            Q[k] += BU[inDesc.length*i+k] * B[i];
+        for (int k=0; k<length; ++k) {
+            Q[k] += BU[length*i+k] * B[i];
 
             if (evalDeriv) {
-                dQU[k] += DU[inDesc.length*i+k] * B[i];
-                dQV[k] += BU[inDesc.length*i+k] * D[i];
+                dQU[k] += DU[length*i+k] * B[i];
+                dQV[k] += BU[length*i+k] * D[i];
+            }
+        }
+    }
+}
+
+
+void
+evalGregory(float u, float v,
+            unsigned int const * vertexIndices,
+            int const * vertexValenceBuffer,
+            unsigned int const  * quadOffsetBuffer,
+            int maxValence,
+            OsdVertexBufferDescriptor const & inDesc,
+            float const * inQ,
+            OsdVertexBufferDescriptor const & outDesc,
+            float * outQ,
+            float * outDQU,
+            float * outDQV )
+{
+    float * points = (float*)alloca(20*inDesc.length*sizeof(float));
+
+    computeGregoryPoints(vertexIndices, vertexValenceBuffer, quadOffsetBuffer,
+                         maxValence, inDesc, inQ, points);
+
+    evalGregoryPoints(u, v, points, inDesc.length, outDesc, outQ, outDQU, outDQV);
+}
+
+
+void
+evalGregoryBoundary(float u, float v,
+                    unsigned int const * vertexIndices,
+                    int const * vertexValenceBuffer,
+                    unsigned int const  * quadOffsetBuffer,
+                    int maxValence,
+                    OsdVertexBufferDescriptor const & inDesc,
+                    float const * inQ,
+                    OsdVertexBufferDescriptor const & outDesc,
+                    float * outQ,
+                    float * outDQU,
+                    float * outDQV )
+{
+    float * points = (float*)alloca(20*inDesc.length*sizeof(float));
+
+    computeGregoryBoundaryPoints(vertexIndices, vertexValenceBuffer, quadOffsetBuffer,
+                                 maxValence, inDesc, inQ, points);
+
+    evalGregoryPoints(u, v, points, inDesc.length, outDesc, outQ, outDQU, outDQV);
+}
+
+
+// Monomials u^i v^j w^k (i+j+k=4) of the barycentric coordinates of a
+// triangle (u=1-s-t, v=s, w=t)
+static int loopMonomials[15][3] = {
+    {4,0,0}, {3,1,0}, {3,0,1}, {2,2,0}, {2,1,1},
+    {2,0,2}, {1,3,0}, {1,2,1}, {1,1,2}, {1,0,3},
+    {0,4,0}, {0,3,1}, {0,2,2}, {0,1,3}, {0,0,4} };
+
+// Coefficients (x12) of the quartic box-spline basis functions of a regular
+// Loop patch (J. Stam, "Evaluation of Loop Subdivision Surfaces", 1998)
+static float loopBasis[12][15] = {
+    {  1,  2,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0 },
+    {  1,  0,  2,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0 },
+    {  1,  6,  2, 12,  6,  0,  6,  6,  0,  0,  1,  2,  0,  0,  0 },
+    {  6, 24, 24, 24, 60, 24,  8, 36, 36,  8,  1,  6, 12,  6,  1 },
+    {  1,  2,  6,  0,  6, 12,  0,  0,  6,  6,  0,  0,  0,  2,  1 },
+    {  0,  0,  0,  0,  0,  0,  2,  0,  0,  0,  1,  0,  0,  0,  0 },
+    {  1,  8,  6, 24, 36, 12, 24, 60, 36,  6,  6, 24, 24,  8,  1 },
+    {  1,  6,  8, 12, 36, 24,  6, 36, 60, 24,  1,  8, 24, 24,  6 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  2,  0,  0,  0,  0,  1 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  2,  0,  0,  0 },
+    {  0,  0,  0,  0,  0,  0,  2,  6,  6,  2,  1,  6, 12,  6,  1 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  2,  1 } };
+
+inline void
+evalLoopBasis(float s, float t, float B[12], float BS[12], float BT[12]) {
+
+    float b[3] = { 1.0f-s-t, s, t }, p[3][5];
+
+    for (int i=0; i<3; ++i) {
+        p[i][0] = 1.0f;
+        for (int j=1; j<5; ++j)
+            p[i][j] = p[i][j-1] * b[i];
+    }
+
+    float M[15], MS[15], MT[15];
+    for (int m=0; m<15; ++m) {
+
+        int const * e = loopMonomials[m];
+
+        M[m] = p[0][e[0]] * p[1][e[1]] * p[2][e[2]];
+
+        // partial derivatives w.r.t. the barycentric coordinates
+        float du = e[0] ? e[0] * p[0][e[0]-1] * p[1][e[1]] * p[2][e[2]] : 0.0f,
+              dv = e[1] ? e[1] * p[0][e[0]] * p[1][e[1]-1] * p[2][e[2]] : 0.0f,
+              dw = e[2] ? e[2] * p[0][e[0]] * p[1][e[1]] * p[2][e[2]-1] : 0.0f;
+
+        MS[m] = dv - du;
+        MT[m] = dw - du;
+    }
+
+    for (int i=0; i<12; ++i) {
+        B[i] = 0.0f;
+        if (BS) BS[i] = BT[i] = 0.0f;
+        for (int m=0; m<15; ++m) {
+            float c = loopBasis[i][m] / 12.0f;
+            B[i] += c * M[m];
+            if (BS) {
+                BS[i] += c * MS[m];
+                BT[i] += c * MT[m];
+            }
+        }
+    }
+}
+
+
+void
+evalLoop(float u, float v,
+         unsigned int const * vertexIndices,
+         OsdVertexBufferDescriptor const & inDesc,
+         float const * inQ,
+         OsdVertexBufferDescriptor const & outDesc,
+         float * outQ,
+         float * outDQU,
+         float * outDQV ) {
+
+    // make sure that we have enough space to store results
+    assert( outQ and inDesc.length <= (outDesc.stride-outDesc.offset) );
+
+    bool evalDeriv = (outDQU or outDQV);
+
+    float B[12], BS[12], BT[12];
+
+    evalLoopBasis(u, v, B, evalDeriv ? BS : 0, BT);
+
+    float const * inOffset = inQ + inDesc.offset;
+
+    float * Q = outQ + outDesc.offset,
+          * dQU = outDQU ? outDQU + outDesc.offset : 0,
+          * dQV = outDQV ? outDQV + outDesc.offset : 0;
+
+    // clear result
+    memset(Q, 0, inDesc.length*sizeof(float));
+    if (dQU)
+        memset(dQU, 0, inDesc.length*sizeof(float));
+    if (dQV)
+        memset(dQV, 0, inDesc.length*sizeof(float));
+
+    for (int i=0; i<12; ++i) {
+
+        float const * in = inOffset + vertexIndices[i]*inDesc.stride;
+
+        for (int k=0; k<inDesc.length; ++k) {
+
+            Q[k] += B[i] * in[k];
+
+            if (dQU)
+                dQU[k] += BS[i] * in[k];
+            if (dQV)
+                dQV[k] += BT[i] * in[k];
+        }
+    }
+}
+
+
+void
+evalLoopIrregular(float u, float v,
+                  unsigned int const * vertexIndices,
+                  int const * vertexValenceBuffer,
+                  int maxValence,
+                  OsdVertexBufferDescriptor const & inDesc,
+                  float const * inQ,
+                  OsdVertexBufferDescriptor const & outDesc,
+                  float * outQ,
+                  float * outDQU,
+                  float * outDQV )
+{
+    // make sure that we have enough space to store results
+    assert( outQ and inDesc.length <= (outDesc.stride-outDesc.offset) );
+
+    int length = inDesc.length,
+        stride = inDesc.stride;
+
+    float const * inOffset = inQ + inDesc.offset;
+
+    // Cubic Bezier triangle : 3 corners (limit positions), 6 edge points
+    // (limit tangents) and a center point
+    //
+    //   0 : b300   3 : b210   6 : b021   9 : b111
+    //   1 : b030   4 : b201   7 : b102
+    //   2 : b003   5 : b120   8 : b012
+    //
+    float * b = (float*)alloca(10*length*sizeof(float)),
+          * tan = (float*)alloca(2*length*sizeof(float));
+    memset(b, 0, 10*length*sizeof(float));
+
+    // edge points next to each corner : toward the next and the previous corner
+    static int const edgePoints[3][2] = { {3, 4}, {6, 5}, {7, 8} };
+
+    for (int i=0; i<3; ++i) {
+
+        int const * valenceTable = vertexValenceBuffer + vertexIndices[i] * (2*maxValence+1);
+
+        int valence = *valenceTable,
+            n = abs(valence);
+
+        float const * pos = inOffset + vertexIndices[i]*stride;
+
+        // find the other 2 corners in the 1-ring of the vertex
+        int ring[2] = { -1, -1 };
+        for (int j=0; j<n; ++j) {
+            unsigned int idx = (unsigned int)valenceTable[1+2*j];
+            if (idx==vertexIndices[(i+1)%3]) ring[0]=j;
+            if (idx==vertexIndices[(i+2)%3]) ring[1]=j;
+        }
+        assert(ring[0]>=0 and ring[1]>=0);
+
+        float * L = b + i*length;
+
+        memset(tan, 0, 2*length*sizeof(float));
+
+        if (valence<0) {
+
+            // boundary vertex : the limit is the cubic B-spline of the boundary
+            float const * b0 = inOffset + valenceTable[1]*stride,
+                        * b1 = inOffset + valenceTable[1+2*(n-1)]*stride;
+
+            for (int k=0; k<length; ++k)
+                L[k] = (b0[k] + 4.0f*pos[k] + b1[k]) / 6.0f;
+
+            for (int e=0; e<2; ++e) {
+                float const * nj = inOffset + valenceTable[1+2*ring[e]]*stride;
+                for (int k=0; k<length; ++k) {
+                    if (ring[e]==0)
+                        tan[e*length+k] = 0.5f * (b0[k] - b1[k]);
+                    else if (ring[e]==n-1)
+                        tan[e*length+k] = 0.5f * (b1[k] - b0[k]);
+                    else
+                        tan[e*length+k] = nj[k] - pos[k];
+                }
+            }
+        } else {
+
+            float c = 0.375f + 0.25f * cosf(2.0f*float(M_PI)/float(n)),
+                  beta = (0.625f - c*c) / float(n),
+                  gamma = 1.0f / (0.375f/beta + float(n));
+
+            for (int k=0; k<length; ++k)
+                L[k] = (1.0f - float(n)*gamma) * pos[k];
+
+            for (int j=0; j<n; ++j) {
+
+                float const * nj = inOffset + valenceTable[1+2*j]*stride;
+
+                float w0 = 2.0f/float(n) * cosf(2.0f*float(M_PI)*float(j-ring[0])/float(n)),
+                      w1 = 2.0f/float(n) * cosf(2.0f*float(M_PI)*float(j-ring[1])/float(n));
+
+                for (int k=0; k<length; ++k) {
+                    L[k] += gamma * nj[k];
+                    tan[k] += w0 * nj[k];
+                    tan[length+k] += w1 * nj[k];
+                }
             }
         }
+
+        for (int e=0; e<2; ++e) {
+            float * E = b + edgePoints[i][e]*length;
+            for (int k=0; k<length; ++k)
+                E[k] = L[k] + tan[e*length+k] / 3.0f;
+        }
+    }
+
+    // center point
+    float * C = b + 9*length;
+    for (int k=0; k<length; ++k) {
+        float E = 0.0f, V = 0.0f;
+        for (int j=3; j<9; ++j)
+            E += b[j*length+k] / 6.0f;
+        for (int j=0; j<3; ++j)
+            V += b[j*length+k] / 3.0f;
+        C[k] = E + (E - V) * 0.5f;
+    }
+
+    // Bernstein polynomials & derivatives w.r.t. the barycentric coordinates
+    float x = 1.0f-u-v, y = u, z = v;
+
+    float B[10] = { x*x*x, y*y*y, z*z*z,
+                    3.0f*x*x*y, 3.0f*x*x*z, 3.0f*x*y*y,
+                    3.0f*y*y*z, 3.0f*x*z*z, 3.0f*y*z*z, 6.0f*x*y*z },
+          BX[10] = { 3.0f*x*x, 0.0f, 0.0f,
+                     6.0f*x*y, 6.0f*x*z, 3.0f*y*y,
+                     0.0f, 3.0f*z*z, 0.0f, 6.0f*y*z },
+          BY[10] = { 0.0f, 3.0f*y*y, 0.0f,
+                     3.0f*x*x, 0.0f, 6.0f*x*y,
+                     6.0f*y*z, 0.0f, 3.0f*z*z, 6.0f*x*z },
+          BZ[10] = { 0.0f, 0.0f, 3.0f*z*z,
+                     0.0f, 3.0f*x*x, 0.0f,
+                     3.0f*y*y, 6.0f*x*z, 6.0f*y*z, 6.0f*x*y };
+
+    float * Q = outQ + outDesc.offset,
+          * dQU = outDQU ? outDQU + outDesc.offset : 0,
+          * dQV = outDQV ? outDQV + outDesc.offset : 0;
+
+    // clear result
+    memset(Q, 0, length*sizeof(float));
+    if (dQU)
+        memset(dQU, 0, length*sizeof(float));
+    if (dQV)
+        memset(dQV, 0, length*sizeof(float));
+
+    for (int i=0; i<10; ++i) {
+        for (int k=0; k<length; ++k) {
+
+            Q[k] += B[i] * b[i*length+k];
+
+            if (dQU)
+                dQU[k] += (BY[i]-BX[i]) * b[i*length+k];
+            if (dQV)
+                dQV[k] += (BZ[i]-BX[i]) * b[i*length+k];
+        }
     }
 }
 
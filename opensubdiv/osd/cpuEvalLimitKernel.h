@@ -40,6 +40,14 @@ evalBilinear(float u, float v,
              OsdVertexBufferDescriptor const & outDesc,
              float * outQ);
 
+void
+evalLinear(float u, float v,
+           unsigned int const * vertexIndices,
+           OsdVertexBufferDescriptor const & inDesc,
+           float const * inQ,
+           OsdVertexBufferDescriptor const & outDesc,
+           float * outQ);
+
 void
 evalBSpline(float u, float v, 
             unsigned int const * vertexIndices,
@@ -96,6 +104,70 @@ evalGregoryBoundary(float u, float v,
                     float * outDQU,
                     float * outDQV );
 
+/// \brief Computes the 20 control points of a Gregory patch
+///
+/// The points are packed as { P, Ep, Em, Fp, Fm } for each of the 4 corners
+/// of the patch, with inDesc.length floats per point. They only depend on the
+/// control vertices : see evalGregoryPoints.
+void
+computeGregoryPoints(unsigned int const * vertexIndices,
+                     int const * vertexValenceBuffer,
+                     unsigned int const  * quadOffsetBuffer,
+                     int maxValence,
+                     OsdVertexBufferDescriptor const & inDesc,
+                     float const * inQ,
+                     float * points );
+
+/// \brief Computes the 20 control points of a boundary Gregory patch
+void
+computeGregoryBoundaryPoints(unsigned int const * vertexIndices,
+                             int const * vertexValenceBuffer,
+                             unsigned int const  * quadOffsetBuffer,
+                             int maxValence,
+                             OsdVertexBufferDescriptor const & inDesc,
+                             float const * inQ,
+                             float * points );
+
+/// \brief Evaluates a Gregory patch from its 20 control points
+void
+evalGregoryPoints(float u, float v,
+                  float const * points,
+                  int length,
+                  OsdVertexBufferDescriptor const & outDesc,
+                  float * outQ,
+                  float * outDQU,
+                  float * outDQV );
+
+/// \brief Evaluates a regular Loop patch (quartic box-spline, 12 control
+/// vertices)
+void
+evalLoop(float u, float v,
+         unsigned int const * vertexIndices,
+         OsdVertexBufferDescriptor const & inDesc,
+         float const * inQ,
+         OsdVertexBufferDescriptor const & outDesc,
+         float * outQ,
+         float * outDQU,
+         float * outDQV );
+
+/// \brief Evaluates an irregular Loop patch
+///
+/// The patch is approximated with a cubic Bezier triangle interpolating the
+/// limit positions and tangents of its 3 vertices, which are computed from the
+/// vertex valence table.
+void
+evalLoopIrregular(float u, float v,
+                  unsigned int const * vertexIndices,
+                  int const * vertexValenceBuffer,
+                  int maxValence,
+                  OsdVertexBufferDescriptor const & inDesc,
+                  float const * inQ,
+                  OsdVertexBufferDescriptor const & outDesc,
+                  float * outQ,
+                  float * outDQU,
+                  float * outDQV );
+
+
 }  // end namespace OPENSUBDIV_VERSION
 using namespace OPENSUBDIV_VERSION;
 
@@ -25,11 +25,277 @@
 #include "../osd/cpuEvalStencilsController.h"
 
 #include <cassert>
+#include <cmath>
+#include <cstring>
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-OsdCpuEvalStencilsController::OsdCpuEvalStencilsController() {
+// Computes the unit normal of the derivatives and, for tangent frames,
+// replaces the derivatives with the unit tangent and bitangent (degenerate
+// derivatives give null vectors)
+inline void
+computeFrame(float * du, float * dv, float * n, bool tangentFrame) {
+
+    n[0] = du[1]*dv[2]-du[2]*dv[1];
+    n[1] = du[2]*dv[0]-du[0]*dv[2];
+    n[2] = du[0]*dv[1]-du[1]*dv[0];
+
+    float len = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+    if (len>0.0f) {
+        float rn = 1.0f/len;
+        n[0] *= rn;
+        n[1] *= rn;
+        n[2] *= rn;
+    }
+
+    if (tangentFrame) {
+        len = sqrtf(du[0]*du[0] + du[1]*du[1] + du[2]*du[2]);
+        if (len>0.0f) {
+            float rt = 1.0f/len;
+            du[0] *= rt;
+            du[1] *= rt;
+            du[2] *= rt;
+        }
+        dv[0] = n[1]*du[2]-n[2]*du[1];
+        dv[1] = n[2]*du[0]-n[0]*du[2];
+        dv[2] = n[0]*du[1]-n[1]*du[0];
+    }
+}
+
+// The stencil kernels, applied to a range of stencils
+struct OsdCpuStencilsKernel {
+
+    OsdCpuStencilsKernel(FarStencilTables const * stencils) :
+        sizes(&stencils->GetSizes().at(0)),
+        offsets(&stencils->GetOffsets().at(0)),
+        indices(&stencils->GetControlIndices().at(0)),
+        weights(stencils->GetWeights().empty() ? 0 : &stencils->GetWeights()[0]),
+        duWeights(stencils->GetDuWeights().empty() ? 0 : &stencils->GetDuWeights()[0]),
+        dvWeights(stencils->GetDvWeights().empty() ? 0 : &stencils->GetDvWeights()[0]),
+        ctrl(0), out(0), du(0), dv(0), normal(0), tangentFrame(false) { }
+
+    void UpdateValues(int begin, int end) const;
+
+    void UpdateDerivs(int begin, int end) const;
+
+    void UpdateValuesAndDerivs(int begin, int end) const;
+
+    void UpdateFrames(int begin, int end) const;
+
+    int const * sizes,
+              * offsets,
+              * indices;
+
+    float const * weights,
+                * duWeights,
+                * dvWeights;
+
+    // control data (offset applied) and output buffers (offsets not applied)
+    float const * ctrl;
+
+    float * out,
+          * du,
+          * dv,
+          * normal;
+
+    OsdVertexBufferDescriptor ctrlDesc,
+                              outDesc,
+                              duDesc,
+                              dvDesc,
+                              normalDesc;
+
+    bool tangentFrame;
+};
+
+void
+OsdCpuStencilsKernel::UpdateValues(int begin, int end) const {
+
+    int const * index = indices + offsets[begin];
+
+    float const * weight = weights + offsets[begin];
+
+    float * result = out + begin*outDesc.stride + outDesc.offset;
+
+    for (int i=begin; i<end; ++i) {
+
+        memset(result, 0, outDesc.length*sizeof(float));
+
+        for (int j=0; j<sizes[i]; ++j, ++index, ++weight) {
+
+            float const * cv = ctrl + (*index)*ctrlDesc.stride;
+
+            for (int k=0; k<outDesc.length; ++k) {
+                result[k] += cv[k] * (*weight);
+            }
+        }
+        result += outDesc.stride;
+    }
+}
+
+void
+OsdCpuStencilsKernel::UpdateDerivs(int begin, int end) const {
+
+    int const * index = indices + offsets[begin];
+
+    float const * duweight = duWeights + offsets[begin],
+                * dvweight = dvWeights + offsets[begin];
+
+    float * duResult = du + begin*duDesc.stride + duDesc.offset,
+          * dvResult = dv + begin*dvDesc.stride + dvDesc.offset;
+
+    for (int i=begin; i<end; ++i) {
+
+        memset(duResult, 0, duDesc.length*sizeof(float));
+        memset(dvResult, 0, dvDesc.length*sizeof(float));
+
+        for (int j=0; j<sizes[i]; ++j, ++index, ++duweight, ++dvweight) {
+
+            float const * cv = ctrl + (*index)*ctrlDesc.stride;
+
+            for (int k=0; k<duDesc.length; ++k) {
+                duResult[k] += cv[k] * (*duweight);
+                dvResult[k] += cv[k] * (*dvweight);
+            }
+        }
+        duResult += duDesc.stride;
+        dvResult += dvDesc.stride;
+    }
+}
+
+void
+OsdCpuStencilsKernel::UpdateValuesAndDerivs(int begin, int end) const {
+
+    int const * index = indices + offsets[begin];
+
+    float const * weight = weights + offsets[begin],
+                * duweight = duWeights + offsets[begin],
+                * dvweight = dvWeights + offsets[begin];
+
+    float * result = out + begin*outDesc.stride + outDesc.offset,
+          * duResult = du + begin*duDesc.stride + duDesc.offset,
+          * dvResult = dv + begin*dvDesc.stride + dvDesc.offset;
+
+    for (int i=begin; i<end; ++i) {
+
+        memset(result, 0, outDesc.length*sizeof(float));
+        memset(duResult, 0, duDesc.length*sizeof(float));
+        memset(dvResult, 0, dvDesc.length*sizeof(float));
+
+        for (int j=0; j<sizes[i]; ++j, ++index, ++weight, ++duweight, ++dvweight) {
+
+            float const * cv = ctrl + (*index)*ctrlDesc.stride;
+
+            for (int k=0; k<outDesc.length; ++k) {
+                result[k] += cv[k] * (*weight);
+                duResult[k] += cv[k] * (*duweight);
+                dvResult[k] += cv[k] * (*dvweight);
+            }
+        }
+        result += outDesc.stride;
+        duResult += duDesc.stride;
+        dvResult += dvDesc.stride;
+    }
+}
+
+void
+OsdCpuStencilsKernel::UpdateFrames(int begin, int end) const {
+
+    bool hasFrames = du or dv or normal;
+
+    int const * index = indices + offsets[begin];
+
+    float const * weight = weights + offsets[begin],
+                * duweight = hasFrames ? duWeights + offsets[begin] : 0,
+                * dvweight = hasFrames ? dvWeights + offsets[begin] : 0;
+
+    for (int i=begin; i<end; ++i) {
+
+        float * result = out ? out + i*outDesc.stride + outDesc.offset : 0;
+
+        if (result) {
+            memset(result, 0, outDesc.length*sizeof(float));
+        }
+
+        float u[3] = { 0.0f, 0.0f, 0.0f },
+              v[3] = { 0.0f, 0.0f, 0.0f },
+              n[3];
+
+        for (int j=0; j<sizes[i]; ++j, ++index, ++weight) {
+
+            float const * cv = ctrl + (*index)*ctrlDesc.stride;
+
+            if (result) {
+                for (int k=0; k<outDesc.length; ++k) {
+                    result[k] += cv[k] * (*weight);
+                }
+            }
+
+            if (hasFrames) {
+                for (int k=0; k<3; ++k) {
+                    u[k] += cv[k] * (*duweight);
+                    v[k] += cv[k] * (*dvweight);
+                }
+                ++duweight;
+                ++dvweight;
+            }
+        }
+
+        if (hasFrames) {
+
+            computeFrame(u, v, n, tangentFrame);
+
+            if (du) {
+                memcpy(du + i*duDesc.stride + duDesc.offset, u, 3*sizeof(float));
+            }
+            if (dv) {
+                memcpy(dv + i*dvDesc.stride + dvDesc.offset, v, 3*sizeof(float));
+            }
+            if (normal) {
+                memcpy(normal + i*normalDesc.stride + normalDesc.offset, n, 3*sizeof(float));
+            }
+        }
+    }
+}
+
+// Runs a stencil kernel on a range of stencils
+class OsdCpuStencilsTask : public OsdScheduler::Task {
+
+public:
+
+    typedef void (OsdCpuStencilsKernel::*Function)(int begin, int end) const;
+
+    OsdCpuStencilsTask(OsdCpuStencilsKernel const & kernel, Function function) :
+        _kernel(kernel), _function(function) { }
+
+    virtual void Run(int begin, int end) const {
+        (_kernel.*_function)(begin, end);
+    }
+
+private:
+
+    OsdCpuStencilsKernel const & _kernel;
+    Function _function;
+};
+
+static const int CPU_STENCILS_GRAIN_SIZE = 256;
+
+// Applies a stencil kernel to all the stencils, split across the scheduler
+// if any
+static void
+runStencilsKernel(OsdScheduler * scheduler, OsdCpuStencilsKernel const & kernel,
+                  OsdCpuStencilsTask::Function function, int nstencils) {
+
+    if (scheduler) {
+        scheduler->ParallelFor(0, nstencils, CPU_STENCILS_GRAIN_SIZE,
+            OsdCpuStencilsTask(kernel, function));
+    } else {
+        (kernel.*function)(0, nstencils);
+    }
+}
+
+OsdCpuEvalStencilsController::OsdCpuEvalStencilsController(OsdScheduler * scheduler) :
+    _scheduler(scheduler) {
 }
 
 OsdCpuEvalStencilsController::~OsdCpuEvalStencilsController() {
@@ -53,33 +319,17 @@ OsdCpuEvalStencilsController::_UpdateValues( OsdCpuEvalStencilsContext * context
     if (not ctrlDesc.CanEval(outDesc))
         return 0;
 
-    float const * ctrl = _currentBindState.controlData + ctrlDesc.offset;
-
-    float * out = _currentBindState.outputData + outDesc.offset;
-
-    if ((not ctrl) or (not out))
+    if ((not _currentBindState.controlData) or (not _currentBindState.outputData))
         return result;
 
-    int const * sizes = &stencils->GetSizes().at(0),
-              * index = &stencils->GetControlIndices().at(0);
-    
-    float const * weight = &stencils->GetWeights().at(0);
-
-    for (int i=0; i<nstencils; ++i) {
+    OsdCpuStencilsKernel kernel(stencils);
+    kernel.ctrl = _currentBindState.controlData + ctrlDesc.offset;
+    kernel.ctrlDesc = ctrlDesc;
+    kernel.out = _currentBindState.outputData;
+    kernel.outDesc = outDesc;
 
-        memset(out, 0, outDesc.length*sizeof(float));
-        
-        for (int j=0; j<sizes[i]; ++j, ++index, ++weight) {
-        
-            float const * cv = ctrl + (*index)*ctrlDesc.stride;
+    runStencilsKernel(_scheduler, kernel, &OsdCpuStencilsKernel::UpdateValues, nstencils);
 
-            for (int k=0; k<outDesc.length; ++k) {
-                out[k] += cv[k] * (*weight);
-            }
-        }
-        out += outDesc.stride;
-    }
-    
     return nstencils;
 }
 
@@ -102,38 +352,122 @@ OsdCpuEvalStencilsController::_UpdateDerivs( OsdCpuEvalStencilsContext * context
     if (not (ctrlDesc.CanEval(duDesc) and ctrlDesc.CanEval(dvDesc)))
         return 0;
 
-    float const * ctrl = _currentBindState.controlData + ctrlDesc.offset;
+    if ((not _currentBindState.controlData) or
+        (not _currentBindState.outputUDeriv) or (not _currentBindState.outputVDeriv))
+        return result;
 
-    float * du = _currentBindState.outputUDeriv + duDesc.offset,
-          * dv = _currentBindState.outputVDeriv + dvDesc.offset;
+    OsdCpuStencilsKernel kernel(stencils);
+    kernel.ctrl = _currentBindState.controlData + ctrlDesc.offset;
+    kernel.ctrlDesc = ctrlDesc;
+    kernel.du = _currentBindState.outputUDeriv;
+    kernel.duDesc = duDesc;
+    kernel.dv = _currentBindState.outputVDeriv;
+    kernel.dvDesc = dvDesc;
 
-    if ((not ctrl) or (not du) or (not dv))
-        return result;
+    runStencilsKernel(_scheduler, kernel, &OsdCpuStencilsKernel::UpdateDerivs, nstencils);
 
-    int const * sizes = &stencils->GetSizes().at(0),
-              * index = &stencils->GetControlIndices().at(0);
+    return nstencils;
+}
+
+int 
+OsdCpuEvalStencilsController::_UpdateValuesAndDerivs( OsdCpuEvalStencilsContext * context ) {
+
+    int result=0;
+
+    FarStencilTables const * stencils = context->GetStencilTables();
+
+    int nstencils = stencils->GetNumStencils();
+    if (not nstencils)
+        return result;
     
-    float const * duweight = &stencils->GetDuWeights().at(0),
-                * dvweight = &stencils->GetDvWeights().at(0);
-                           
-    for (int i=0; i<nstencils; ++i) {
-
-        memset(du, 0, duDesc.length*sizeof(float));
-        memset(dv, 0, dvDesc.length*sizeof(float));
-        
-        for (int j=0; j<sizes[i]; ++j, ++index, ++duweight, ++dvweight) {
-        
-            float const * cv = ctrl + (*index)*ctrlDesc.stride;
-        
-            for (int k=0; k<duDesc.length; ++k) {
-                du[k] += cv[k] * (*duweight);
-                dv[k] += cv[k] * (*dvweight);
-            }
-        }
-        du += duDesc.stride;
-        dv += dvDesc.stride;
-    }
+    OsdVertexBufferDescriptor ctrlDesc = _currentBindState.controlDataDesc,
+                              outDesc = _currentBindState.outputDataDesc,
+                              duDesc = _currentBindState.outputDuDesc,
+                              dvDesc = _currentBindState.outputDvDesc;
+    
+    // make sure that we have control data to work with
+    if (not (ctrlDesc.CanEval(outDesc) and
+             ctrlDesc.CanEval(duDesc) and ctrlDesc.CanEval(dvDesc)))
+        return 0;
+
+    if ((not _currentBindState.controlData) or (not _currentBindState.outputData) or
+        (not _currentBindState.outputUDeriv) or (not _currentBindState.outputVDeriv))
+        return result;
+
+    OsdCpuStencilsKernel kernel(stencils);
+    kernel.ctrl = _currentBindState.controlData + ctrlDesc.offset;
+    kernel.ctrlDesc = ctrlDesc;
+    kernel.out = _currentBindState.outputData;
+    kernel.outDesc = outDesc;
+    kernel.du = _currentBindState.outputUDeriv;
+    kernel.duDesc = duDesc;
+    kernel.dv = _currentBindState.outputVDeriv;
+    kernel.dvDesc = dvDesc;
+
+    runStencilsKernel(_scheduler, kernel, &OsdCpuStencilsKernel::UpdateValuesAndDerivs, nstencils);
+
+    return nstencils;
+}
+
+int 
+OsdCpuEvalStencilsController::_UpdateFrames( OsdCpuEvalStencilsContext * context,
+                                             bool tangentFrame ) {
+
+    int result=0;
+
+    FarStencilTables const * stencils = context->GetStencilTables();
+
+    int nstencils = stencils->GetNumStencils();
+    if (not nstencils)
+        return result;
     
+    OsdVertexBufferDescriptor ctrlDesc = _currentBindState.controlDataDesc,
+                              outDesc = _currentBindState.outputDataDesc,
+                              duDesc = _currentBindState.outputDuDesc,
+                              dvDesc = _currentBindState.outputDvDesc,
+                              nDesc = _currentBindState.outputNormalDesc;
+
+    float * outData = _currentBindState.outputData,
+          * duData = _currentBindState.outputUDeriv,
+          * dvData = _currentBindState.outputVDeriv,
+          * nData = _currentBindState.outputNormal;
+
+    // make sure that we have control data to work with : the derivatives and
+    // the normals are computed from xyz control data
+    if (not ctrlDesc.IsValid() or ctrlDesc.length<3)
+        return 0;
+
+    if ((outData and not ctrlDesc.CanEval(outDesc)) or
+        (duData and not (duDesc.IsValid() and duDesc.length==3)) or
+        (dvData and not (dvDesc.IsValid() and dvDesc.length==3)) or
+        (nData and not (nDesc.IsValid() and nDesc.length==3)))
+        return 0;
+
+    bool hasFrames = duData or dvData or nData;
+
+    if (hasFrames and stencils->GetDuWeights().empty())
+        return 0;
+
+    float const * ctrl = _currentBindState.controlData + ctrlDesc.offset;
+
+    if ((not ctrl) or (not (outData or hasFrames)))
+        return result;
+
+    OsdCpuStencilsKernel kernel(stencils);
+    kernel.ctrl = ctrl;
+    kernel.ctrlDesc = ctrlDesc;
+    kernel.out = outData;
+    kernel.outDesc = outDesc;
+    kernel.du = duData;
+    kernel.duDesc = duDesc;
+    kernel.dv = dvData;
+    kernel.dvDesc = dvDesc;
+    kernel.normal = nData;
+    kernel.normalDesc = nDesc;
+    kernel.tangentFrame = tangentFrame;
+
+    runStencilsKernel(_scheduler, kernel, &OsdCpuStencilsKernel::UpdateFrames, nstencils);
+
     return nstencils;
 }
 
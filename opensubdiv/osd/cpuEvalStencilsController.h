@@ -28,6 +28,7 @@
 #include "../version.h"
 
 #include "../osd/cpuEvalStencilsContext.h"
+#include "../osd/scheduler.h"
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -42,11 +43,25 @@ namespace OPENSUBDIV_VERSION {
 /// common interfaces with. Controllers are attached to discrete compute devices
 /// and share the devices resources with Context entities.
 ///
+/// Several samples of the control vertex data (motion blur time samples for
+/// instance) can be interleaved in the vertex buffers, as for
+/// OsdCpuComputeController::RefineSamples : descriptors spanning all the
+/// samples then apply every stencil to all the samples in a single traversal
+/// of the stencil tables.
+///
+/// The stencils can be split across the threads of an OsdScheduler, given to
+/// the constructor.
+///
 class OsdCpuEvalStencilsController {
 public:
 
-    /// Constructor.
-    OsdCpuEvalStencilsController();
+    /// \brief Constructor.
+    ///
+    /// @param scheduler  the scheduler applying the stencils in parallel (not
+    ///                   owned). If it's null, the stencils are applied in the
+    ///                   calling thread.
+    ///
+    OsdCpuEvalStencilsController(OsdScheduler * scheduler=NULL);
 
     /// Destructor.
     ~OsdCpuEvalStencilsController();
@@ -125,6 +140,124 @@ public:
         return n;
     }
     
+    /// \brief Applies value and derivative stencil weights to the control
+    /// vertex data
+    ///
+    /// Same as UpdateValues followed by UpdateDerivs, but computes the values
+    /// and both derivatives in a single traversal of the stencils and of the
+    /// control vertices.
+    ///
+    /// @param context          the OsdCpuEvalStencilsContext with the stencil weights
+    ///
+    /// @param controlDataDesc  vertex buffer descriptor for the control vertex data 
+    ///
+    /// @param controlVertices  vertex buffer with the control vertices data
+    ///
+    /// @param outputDataDesc   vertex buffer descriptor for the output vertex data
+    ///
+    /// @param outputData       output vertex buffer for the interpolated data
+    ///
+    /// @param outputDuDesc     vertex buffer descriptor for the U derivative output data
+    ///
+    /// @param outputDuData     output vertex buffer for the U derivative data
+    ///
+    /// @param outputDvDesc     vertex buffer descriptor for the V deriv output data
+    ///
+    /// @param outputDvData     output vertex buffer for the V derivative data
+    ///
+    template<class CONTROL_BUFFER, class OUTPUT_BUFFER>
+    int UpdateValuesAndDerivs( OsdCpuEvalStencilsContext * context,
+                      OsdVertexBufferDescriptor const & controlDataDesc, CONTROL_BUFFER *controlVertices,
+                      OsdVertexBufferDescriptor const & outputDataDesc, OUTPUT_BUFFER *outputData,
+                      OsdVertexBufferDescriptor const & outputDuDesc, OUTPUT_BUFFER *outputDuData, 
+                      OsdVertexBufferDescriptor const & outputDvDesc, OUTPUT_BUFFER *outputDvData ) {
+                       
+        if (not context->GetStencilTables()->GetNumStencils())
+            return 0;
+
+        bindControlData( controlDataDesc, controlVertices );
+
+        bindOutputData( outputDataDesc, outputData );
+
+        bindOutputDerivData( outputDuDesc, outputDuData, outputDvDesc, outputDvData );
+        
+        int n = _UpdateValuesAndDerivs( context );
+        
+        unbind();
+        
+        return n;
+    }
+
+    /// \brief Applies the stencil weights to evaluate limit frames
+    ///
+    /// Computes the limit positions, the U and V derivatives and the unit
+    /// normals (cross product of the derivatives) at the parametric locations
+    /// of the stencils, in a single traversal of the stencils and of the
+    /// control vertices. With 'tangentFrame', the derivative outputs receive
+    /// the unit tangent (normalized U derivative) and bitangent (normal x
+    /// tangent) instead : tangent, bitangent and normal form an orthonormal
+    /// frame.
+    ///
+    /// The outputs can be interleaved in a same buffer, their descriptors
+    /// giving their offsets within the vertex stride. A NULL output buffer
+    /// skips the output. The derivatives and the normals are computed from
+    /// the first 3 elements of the control data, their descriptors must have
+    /// a length of 3.
+    ///
+    /// @param context          the OsdCpuEvalStencilsContext with the stencil weights
+    ///
+    /// @param controlDataDesc  vertex buffer descriptor for the control vertex data
+    ///
+    /// @param controlVertices  vertex buffer with the control vertices data
+    ///
+    /// @param outputDataDesc   vertex buffer descriptor for the output vertex data
+    ///
+    /// @param outputData       output vertex buffer for the interpolated data
+    ///
+    /// @param outputDuDesc     vertex buffer descriptor for the U derivative
+    ///                         (or tangent) output data
+    ///
+    /// @param outputDuData     output vertex buffer for the U derivative data
+    ///
+    /// @param outputDvDesc     vertex buffer descriptor for the V derivative
+    ///                         (or bitangent) output data
+    ///
+    /// @param outputDvData     output vertex buffer for the V derivative data
+    ///
+    /// @param outputNormalDesc vertex buffer descriptor for the normal output data
+    ///
+    /// @param outputNormalData output vertex buffer for the normal data
+    ///
+    /// @param tangentFrame     output an orthonormal frame instead of the
+    ///                         derivatives
+    ///
+    template<class CONTROL_BUFFER, class OUTPUT_BUFFER>
+    int UpdateFrames( OsdCpuEvalStencilsContext * context,
+                      OsdVertexBufferDescriptor const & controlDataDesc, CONTROL_BUFFER *controlVertices,
+                      OsdVertexBufferDescriptor const & outputDataDesc, OUTPUT_BUFFER *outputData,
+                      OsdVertexBufferDescriptor const & outputDuDesc, OUTPUT_BUFFER *outputDuData,
+                      OsdVertexBufferDescriptor const & outputDvDesc, OUTPUT_BUFFER *outputDvData,
+                      OsdVertexBufferDescriptor const & outputNormalDesc, OUTPUT_BUFFER *outputNormalData,
+                      bool tangentFrame=false ) {
+
+        if (not context->GetStencilTables()->GetNumStencils())
+            return 0;
+
+        bindControlData( controlDataDesc, controlVertices );
+
+        bindOutputData( outputDataDesc, outputData );
+
+        bindOutputDerivData( outputDuDesc, outputDuData, outputDvDesc, outputDvData );
+
+        bindOutputNormalData( outputNormalDesc, outputNormalData );
+
+        int n = _UpdateFrames( context, tangentFrame );
+
+        unbind();
+
+        return n;
+    }
+
     /// Waits until all running subdivision kernels finish.
     void Synchronize();
 
@@ -158,6 +291,14 @@ protected:
         _currentBindState.outputDvDesc = outputDvDesc;
     }
 
+    /// \brief Binds output normal vertex data buffer
+    template<class VERTEX_BUFFER>
+    void bindOutputNormalData( OsdVertexBufferDescriptor const & outputNormalDesc, VERTEX_BUFFER *outputNormal ) {
+
+        _currentBindState.outputNormal = outputNormal ? outputNormal->BindCpuBuffer() : 0;
+        _currentBindState.outputNormalDesc = outputNormalDesc;
+    }
+
     /// \brief Unbinds any previously bound vertex and varying data buffers.
     void unbind() {
         _currentBindState.Reset();
@@ -167,34 +308,42 @@ private:
 
     int _UpdateValues( OsdCpuEvalStencilsContext * context );
     int _UpdateDerivs( OsdCpuEvalStencilsContext * context );
+    int _UpdateValuesAndDerivs( OsdCpuEvalStencilsContext * context );
+    int _UpdateFrames( OsdCpuEvalStencilsContext * context, bool tangentFrame );
 
     // Bind state is a transitional state during refinement.
     // It doesn't take an ownership of vertex buffers.
     struct BindState {
 
-        BindState() : controlData(0), outputData(0), outputUDeriv(0), outputVDeriv(0) { }
+        BindState() : controlData(0), outputData(0), outputUDeriv(0), outputVDeriv(0),
+            outputNormal(0) { }
         
         void Reset() {
-            controlData = outputData = outputUDeriv = outputVDeriv = NULL;
+            controlData = outputData = outputUDeriv = outputVDeriv = outputNormal = NULL;
             controlDataDesc.Reset();
             outputDataDesc.Reset();
             outputDuDesc.Reset();
             outputDvDesc.Reset();
+            outputNormalDesc.Reset();
         }
 
         // transient mesh data
         OsdVertexBufferDescriptor controlDataDesc,
                                   outputDataDesc,
                                   outputDuDesc,
-                                  outputDvDesc;
+                                  outputDvDesc,
+                                  outputNormalDesc;
 
         float * controlData,
               * outputData,
               * outputUDeriv,
-              * outputVDeriv;
+              * outputVDeriv,
+              * outputNormal;
     };
     
     BindState _currentBindState;
+
+    OsdScheduler * _scheduler;
 };
 
 } // end namespace OPENSUBDIV_VERSION
@@ -582,7 +582,7 @@ void OsdCpuEditVertexAdd(
             float *dst = vertex + editIndex * vertexDesc.stride + primVarOffset;
 
             for (int j = 0; j < primVarWidth; ++j) {
-                dst[j] += editValues[j];
+                dst[j] += editValues[i*primVarWidth+j];
             }
         }
     }
@@ -602,11 +602,38 @@ void OsdCpuEditVertexSet(
             float *dst = vertex + editIndex * vertexDesc.stride + primVarOffset;
 
             for (int j = 0; j < primVarWidth; ++j) {
-                dst[j] = editValues[j];
+                dst[j] = editValues[i*primVarWidth+j];
             }
         }
     }
 }
 
+void OsdCpuComputeFVarStencils(
+    float *values,
+    const int *sizes, const int *offsets,
+    const int *destinations, const int *widths,
+    const int *sourceIndices, const float *weights,
+    int start, int end) {
+
+    // the stencils of a level only read values of the previous levels
+    for (int i = start; i < end; i++) {
+
+        float *dst = values + destinations[i];
+        int width = widths[i];
+
+        for (int k = 0; k < width; ++k)
+            dst[k] = 0.0f;
+
+        const int *index = sourceIndices + offsets[i];
+        const float *weight = weights + offsets[i];
+
+        for (int j = 0; j < sizes[i]; ++j) {
+            const float *src = values + index[j];
+            for (int k = 0; k < width; ++k)
+                dst[k] += weight[j] * src[k];
+        }
+    }
+}
+
 }  // end namespace OPENSUBDIV_VERSION
 }  // end namespace OpenSubdiv
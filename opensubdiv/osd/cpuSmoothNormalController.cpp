@@ -27,6 +27,8 @@
 #include <math.h>
 #include <string.h>
 
+#include <vector>
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
@@ -45,9 +47,133 @@ cross(float *n, const float *p0, const float *p1, const float *p2) {
     n[2] *= rn;
 }
 
+// Resets a range of normals to 0
+class OsdCpuResetNormalsTask : public OsdScheduler::Task {
+
+public:
+
+    OsdCpuResetNormalsTask(float * normals, OsdVertexBufferDescriptor const & desc) :
+        _normals(normals), _desc(desc) { }
+
+    virtual void Run(int begin, int end) const {
+        for (int i=begin; i<end; ++i) {
+            memset(_normals + i*_desc.stride, 0, _desc.length*sizeof(float));
+        }
+    }
+
+private:
+
+    float * _normals;
+    OsdVertexBufferDescriptor const & _desc;
+};
+
+// Computes the normals of a range of faces
+class OsdCpuFaceNormalsTask : public OsdScheduler::Task {
+
+public:
+
+    OsdCpuFaceNormalsTask(float const * positions, OsdVertexBufferDescriptor const & desc,
+                          unsigned int const * verts, int nverts, float * normals) :
+        _positions(positions), _desc(desc), _verts(verts), _nverts(nverts),
+        _normals(normals) { }
+
+    virtual void Run(int begin, int end) const {
+        for (int i=begin; i<end; ++i) {
+
+            unsigned int const * verts = _verts + i*_nverts;
+
+            cross( _normals + i*3, _positions + verts[0]*_desc.stride,
+                                   _positions + verts[1]*_desc.stride,
+                                   _positions + verts[2]*_desc.stride );
+        }
+    }
+
+private:
+
+    float const * _positions;
+    OsdVertexBufferDescriptor const & _desc;
+    unsigned int const * _verts;
+    int _nverts;
+    float * _normals;
+};
+
+static const int CPU_NORMALS_GRAIN_SIZE = 256;
+
+// The face normals are computed in parallel, then added to the vertices of
+// the faces in the calling thread (the faces share their vertices)
+void OsdCpuSmoothNormalController::_smootheNormalsScheduled(
+    OsdCpuSmoothNormalContext * context) {
+
+    OsdVertexBufferDescriptor const & iDesc = context->GetInputVertexDescriptor(),
+                                    & oDesc = context->GetOutputVertexDescriptor();
+
+    assert(iDesc.length==3 and oDesc.length==3);
+
+    float const * iBuffer = context->GetCurrentInputVertexBuffer() + iDesc.offset;
+    float * oBuffer = context->GetCurrentOutputVertexBuffer() + oDesc.offset;
+
+    std::vector<unsigned int> const & verts = context->GetControlVertices();
+
+    FarPatchTables::PatchArrayVector const & parrays = context->GetPatchArrayVector();
+
+    if (verts.empty() or parrays.empty() or (not iBuffer) or (not oBuffer)) {
+        return;
+    }
+
+    std::vector<float> faceNormals;
+
+    for (int i=0; i<(int)parrays.size(); ++i) {
+
+        FarPatchTables::PatchArray const & pa = parrays[i];
+
+        FarPatchTables::Type type = pa.GetDescriptor().GetType();
+
+        if (type==FarPatchTables::QUADS or type==FarPatchTables::TRIANGLES) {
+
+            int nv = FarPatchTables::Descriptor::GetNumControlVertices(type),
+                npatches = (int)pa.GetNumPatches();
+
+            // if necessary, reset all normal values to 0
+            if (context->GetResetMemory()) {
+                _scheduler->ParallelFor(0, context->GetNumVertices(), CPU_NORMALS_GRAIN_SIZE,
+                    OsdCpuResetNormalsTask(oBuffer, oDesc));
+            }
+
+            if (npatches==0)
+                continue;
+
+            faceNormals.resize(npatches*3);
+
+            _scheduler->ParallelFor(0, npatches, CPU_NORMALS_GRAIN_SIZE,
+                OsdCpuFaceNormalsTask(iBuffer, iDesc, &verts[pa.GetVertIndex()], nv,
+                    &faceNormals[0]));
+
+            // add normal to all vertices of the face
+            for (int j=0, idx=pa.GetVertIndex(); j<npatches; ++j, idx+=nv) {
+
+                float const * n = &faceNormals[j*3];
+
+                for (int k=0; k<nv; ++k) {
+
+                    float * dst = oBuffer + verts[idx+k]*oDesc.stride;
+
+                    dst[0] += n[0];
+                    dst[1] += n[1];
+                    dst[2] += n[2];
+                }
+            }
+        }
+    }
+}
+
 void OsdCpuSmoothNormalController::_smootheNormals(
     OsdCpuSmoothNormalContext * context) {
 
+    if (_scheduler) {
+        _smootheNormalsScheduled(context);
+        return;
+    }
+
     OsdVertexBufferDescriptor const & iDesc = context->GetInputVertexDescriptor(),
                                     & oDesc = context->GetOutputVertexDescriptor();
 
@@ -109,7 +235,8 @@ void OsdCpuSmoothNormalController::_smootheNormals(
 
 }
 
-OsdCpuSmoothNormalController::OsdCpuSmoothNormalController() {
+OsdCpuSmoothNormalController::OsdCpuSmoothNormalController(OsdScheduler * scheduler) :
+    _scheduler(scheduler) {
 }
 
 OsdCpuSmoothNormalController::~OsdCpuSmoothNormalController() {
@@ -29,6 +29,7 @@
 
 #include "../osd/nonCopyable.h"
 #include "../osd/cpuSmoothNormalContext.h"
+#include "../osd/scheduler.h"
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -37,8 +38,13 @@ class OsdCpuSmoothNormalController {
 
 public:
 
-    /// Constructor
-    OsdCpuSmoothNormalController();
+    /// \brief Constructor
+    ///
+    /// @param scheduler  the scheduler computing the face normals in parallel
+    ///                   (not owned). If it's null, the normals are computed
+    ///                   in the calling thread.
+    ///
+    OsdCpuSmoothNormalController(OsdScheduler * scheduler=NULL);
 
     /// Destructor
     ~OsdCpuSmoothNormalController();
@@ -64,6 +70,10 @@ public:
 private:
 
     void _smootheNormals(OsdCpuSmoothNormalContext * context);
+
+    void _smootheNormalsScheduled(OsdCpuSmoothNormalContext * context);
+
+    OsdScheduler * _scheduler;
 };
 
 }  // end namespace OPENSUBDIV_VERSION
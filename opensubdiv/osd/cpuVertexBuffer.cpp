@@ -24,22 +24,138 @@
 
 #include "../osd/cpuVertexBuffer.h"
 
+#include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32)
+    #include <malloc.h>
+#else
+    #include <sys/mman.h>
+#endif
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
+// alignment of the aligned and huge page allocations (a cache line)
+static const int kBufferAlignment = 64;
+
+#if defined(__linux__)
+// size of the huge pages (transparent huge pages of x86_64 and aarch64)
+static const size_t kHugePageSize = 2 * 1024 * 1024;
+#endif
+
 OsdCpuVertexBuffer::OsdCpuVertexBuffer(int numElements, int numVertices)
     : _numElements(numElements),
       _numVertices(numVertices),
-      _cpuBuffer(NULL) {
+      _cpuBuffer(NULL),
+      _storage(STORAGE_NEW),
+      _size(0) {
 
     _cpuBuffer = new float[numElements * numVertices];
 }
 
+OsdCpuVertexBuffer::OsdCpuVertexBuffer(int numElements, int numVertices,
+                                       Allocation allocation, int rowAlignment)
+    : _numElements(numElements),
+      _numVertices(numVertices),
+      _cpuBuffer(NULL),
+      _storage(STORAGE_NEW),
+      _size(0) {
+
+    // pad the rows up to the alignment
+    int rowFloats = rowAlignment / (int)sizeof(float);
+    if (rowFloats > 1) {
+        _numElements = ((numElements + rowFloats - 1) / rowFloats) * rowFloats;
+
+        // aligned rows need an aligned buffer
+        if (allocation==DEFAULT_ALLOCATION)
+            allocation = ALIGNED_ALLOCATION;
+    }
+
+    if (allocate(allocation, rowAlignment > kBufferAlignment ? rowAlignment : kBufferAlignment)) {
+        // the padding elements are carried by the compute kernels : keep them
+        // to zero
+        if (_numElements != numElements and _storage != STORAGE_MAPPED)
+            memset(_cpuBuffer, 0, _size);
+    }
+}
+
+OsdCpuVertexBuffer::OsdCpuVertexBuffer(float * buffer, int numElements, int numVertices)
+    : _numElements(numElements),
+      _numVertices(numVertices),
+      _cpuBuffer(buffer),
+      _storage(STORAGE_CLIENT),
+      _size(0) {
+}
+
 OsdCpuVertexBuffer::~OsdCpuVertexBuffer() {
 
-    delete[] _cpuBuffer;
+    release();
+}
+
+bool
+OsdCpuVertexBuffer::allocate(Allocation allocation, int alignment) {
+
+    _size = (size_t)_numElements * _numVertices * sizeof(float);
+
+    if (allocation==DEFAULT_ALLOCATION) {
+        _cpuBuffer = new float[_numElements * _numVertices];
+        _storage = STORAGE_NEW;
+        return true;
+    }
+
+#if !defined(_WIN32)
+    if (allocation==HUGE_PAGE_ALLOCATION and _size > 0) {
+        size_t size = _size;
+#if defined(__linux__)
+        // whole huge pages
+        size = ((size + kHugePageSize - 1) / kHugePageSize) * kHugePageSize;
+#endif
+        void * ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr != MAP_FAILED) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+            madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+            _cpuBuffer = (float *)ptr;
+            _storage = STORAGE_MAPPED;
+            _size = size;
+            return true;
+        }
+        // fall back to an aligned allocation
+    }
+#endif
+
+    void * ptr = NULL;
+#if defined(_WIN32)
+    ptr = _aligned_malloc(_size, alignment);
+#else
+    if (posix_memalign(&ptr, alignment, _size) != 0)
+        ptr = NULL;
+#endif
+    _cpuBuffer = (float *)ptr;
+    _storage = STORAGE_ALIGNED;
+    return ptr != NULL;
+}
+
+void
+OsdCpuVertexBuffer::release() {
+
+    switch (_storage) {
+        case STORAGE_NEW     : delete[] _cpuBuffer;
+                               break;
+#if defined(_WIN32)
+        case STORAGE_ALIGNED : _aligned_free(_cpuBuffer);
+                               break;
+#else
+        case STORAGE_ALIGNED : free(_cpuBuffer);
+                               break;
+        case STORAGE_MAPPED  : munmap(_cpuBuffer, _size);
+                               break;
+#endif
+        default : break;
+    }
+    _cpuBuffer = NULL;
 }
 
 OsdCpuVertexBuffer *
@@ -48,11 +164,75 @@ OsdCpuVertexBuffer::Create(int numElements, int numVertices) {
     return new OsdCpuVertexBuffer(numElements, numVertices);
 }
 
+OsdCpuVertexBuffer *
+OsdCpuVertexBuffer::Create(int numElements, int numVertices,
+                           Allocation allocation, int rowAlignment) {
+
+    if (rowAlignment < 0 or rowAlignment % (int)sizeof(float))
+        return NULL;
+
+    OsdCpuVertexBuffer * instance =
+        new OsdCpuVertexBuffer(numElements, numVertices, allocation, rowAlignment);
+
+    if (instance->_cpuBuffer or numElements*numVertices==0)
+        return instance;
+
+    delete instance;
+    return NULL;
+}
+
+OsdCpuVertexBuffer *
+OsdCpuVertexBuffer::Create(float * buffer, int numElements, int numVertices) {
+
+    if (not buffer)
+        return NULL;
+
+    return new OsdCpuVertexBuffer(buffer, numElements, numVertices);
+}
+
 void
 OsdCpuVertexBuffer::UpdateData(const float *src, int startVertex, int numVertices) {
 
-    memcpy(_cpuBuffer + startVertex * _numElements,
-           src, GetNumElements() * numVertices * sizeof(float));
+    float * dst = _cpuBuffer + startVertex * _numElements;
+
+    // nothing to copy when the buffer wraps the client data
+    if (dst == src)
+        return;
+
+    memcpy(dst, src, GetNumElements() * numVertices * sizeof(float));
+}
+
+void
+OsdCpuVertexBuffer::UpdateData(const float *src, int startVertex, int numVertices,
+                               int numSrcElements) {
+
+    if (numSrcElements == _numElements) {
+        UpdateData(src, startVertex, numVertices);
+        return;
+    }
+
+    int numCopied = numSrcElements < _numElements ? numSrcElements : _numElements;
+
+    float * dst = _cpuBuffer + startVertex * _numElements;
+    for (int i = 0; i < numVertices; ++i) {
+        memcpy(dst, src, numCopied * sizeof(float));
+        dst += _numElements;
+        src += numSrcElements;
+    }
+}
+
+void
+OsdCpuVertexBuffer::UpdateSampleData(const float *src, int sample, int numSamples,
+                                     int startVertex, int numVertices) {
+
+    int sampleLength = _numElements / numSamples;
+
+    float * dst = _cpuBuffer + startVertex * _numElements + sample * sampleLength;
+    for (int i = 0; i < numVertices; ++i) {
+        memcpy(dst, src, sampleLength * sizeof(float));
+        dst += _numElements;
+        src += sampleLength;
+    }
 }
 
 int
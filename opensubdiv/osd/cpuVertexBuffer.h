@@ -27,6 +27,8 @@
 
 #include "../version.h"
 
+#include <cstddef>
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
@@ -35,11 +37,45 @@ namespace OPENSUBDIV_VERSION {
 /// OsdCpuVertexBuffer implements the OsdVertexBufferInterface. An instance
 /// of this buffer class can be passed to OsdCpuComputeController
 ///
+/// The buffer can be allocated with a given alignment, or backed by huge
+/// pages where the system supports them. Its rows can be padded so that
+/// every vertex starts on an aligned address : the padding elements are
+/// counted by GetNumElements, so that they are carried (as zeros) by the
+/// compute controllers. Finally, the buffer can wrap memory owned by the
+/// client code, which removes the copy of UpdateData.
+///
 class OsdCpuVertexBuffer {
 public:
+    /// Memory allocation of the buffer
+    enum Allocation {
+        DEFAULT_ALLOCATION,     ///< new []
+        ALIGNED_ALLOCATION,     ///< aligned to the row alignment (or 64 bytes)
+        HUGE_PAGE_ALLOCATION    ///< huge pages, aligned allocation if unsupported
+    };
+
     /// Creator. Returns NULL if error.
     static OsdCpuVertexBuffer * Create(int numElements, int numVertices);
 
+    /// Creator. Returns NULL if error.
+    ///
+    /// @param numElements   number of elements of the vertex data
+    ///
+    /// @param numVertices   number of vertices allocated
+    ///
+    /// @param allocation    memory allocation of the buffer
+    ///
+    /// @param rowAlignment  alignment of every vertex row in bytes (multiple
+    ///                      of 4, 0 for packed rows) : the rows are padded up
+    ///                      to this alignment
+    ///
+    static OsdCpuVertexBuffer * Create(int numElements, int numVertices,
+                                       Allocation allocation, int rowAlignment=0);
+
+    /// Creator. Wraps a buffer of client memory holding numVertices rows of
+    /// numElements floats : the buffer is neither copied nor released.
+    /// Returns NULL if error.
+    static OsdCpuVertexBuffer * Create(float * buffer, int numElements, int numVertices);
+
     /// Destructor.
     ~OsdCpuVertexBuffer();
 
@@ -47,7 +83,18 @@ public:
     /// vertices data to Osd.
     void UpdateData(const float *src, int startVertex, int numVertices);
 
-    /// Returns how many elements defined in this vertex buffer.
+    /// Same as above, for source data of numSrcElements floats per vertex
+    /// (typically the unpadded vertex data of a padded buffer).
+    void UpdateData(const float *src, int startVertex, int numVertices, int numSrcElements);
+
+    /// Updates one sample of a buffer that interleaves numSamples samples of
+    /// the vertex data (GetNumElements() / numSamples floats each), as
+    /// refined by the RefineSamples functions of the CPU compute controllers.
+    void UpdateSampleData(const float *src, int sample, int numSamples,
+                          int startVertex, int numVertices);
+
+    /// Returns how many elements defined in this vertex buffer (including the
+    /// padding of the rows).
     int GetNumElements() const;
 
     /// Returns how many vertices allocated in this vertex buffer.
@@ -60,10 +107,31 @@ protected:
     /// Constructor.
     OsdCpuVertexBuffer(int numElements, int numVertices);
 
+    /// Constructor.
+    OsdCpuVertexBuffer(int numElements, int numVertices,
+                       Allocation allocation, int rowAlignment);
+
+    /// Constructor (wraps client memory).
+    OsdCpuVertexBuffer(float * buffer, int numElements, int numVertices);
+
 private:
+    bool allocate(Allocation allocation, int alignment);
+
+    void release();
+
     int _numElements;
     int _numVertices;
     float *_cpuBuffer;
+
+    enum Storage {
+        STORAGE_NEW,        // new []
+        STORAGE_ALIGNED,    // aligned malloc
+        STORAGE_MAPPED,     // mmap
+        STORAGE_CLIENT      // client memory
+    };
+
+    Storage _storage;
+    size_t _size;           // size of the allocation in bytes
 };
 
 
@@ -321,8 +321,8 @@ OsdGcdComputeController::ApplyVertexEdits(
                             batch.GetTableOffset(),
                             batch.GetStart(),
                             batch.GetEnd(),
-                            static_cast<unsigned int*>(primvarIndices->GetBuffer()),
-                            static_cast<float*>(editValues->GetBuffer()),
+                            static_cast<const unsigned int*>(primvarIndices->GetBuffer()),
+                            static_cast<const float*>(editValues->GetBuffer()),
                             _gcd_queue);
     } else if (edit->GetOperation() == FarVertexEdit::Set) {
         OsdGcdEditVertexSet(_currentBindState.vertexBuffer,
@@ -333,8 +333,8 @@ OsdGcdComputeController::ApplyVertexEdits(
                             batch.GetTableOffset(),
                             batch.GetStart(),
                             batch.GetEnd(),
-                            static_cast<unsigned int*>(primvarIndices->GetBuffer()),
-                            static_cast<float*>(editValues->GetBuffer()),
+                            static_cast<const unsigned int*>(primvarIndices->GetBuffer()),
+                            static_cast<const float*>(editValues->GetBuffer()),
                             _gcd_queue);
     }
 }
@@ -376,7 +376,7 @@ void OsdGcdComputeBilinearVertex(
 void OsdGcdEditVertexAdd(
     float * vertex,
     OsdVertexBufferDescriptor const &vertexDesc,
-    int primVarOffset, int /*primVarWidth*/,
+    int primVarOffset, int primVarWidth,
     int vertexOffset, int tableOffset,
     int start, int end,
     const unsigned int *editIndices, const float *editValues,
@@ -391,7 +391,9 @@ void OsdGcdEditVertexAdd(
             float *dst = vertex + editIndex * vertexDesc.stride
                 + vertexDesc.offset + primVarOffset;
 
-            dst[i] += editValues[i];
+            for (int j = 0; j < primVarWidth; ++j) {
+                dst[j] += editValues[i*primVarWidth+j];
+            }
         }
     });
 }
@@ -399,7 +401,7 @@ void OsdGcdEditVertexAdd(
 void OsdGcdEditVertexSet(
     float * vertex,
     OsdVertexBufferDescriptor const &vertexDesc,
-    int primVarOffset, int /*primVarWidth*/,
+    int primVarOffset, int primVarWidth,
     int vertexOffset, int tableOffset,
     int start, int end,
     const unsigned int *editIndices, const float *editValues,
@@ -414,7 +416,9 @@ void OsdGcdEditVertexSet(
             float *dst = vertex + editIndex * vertexDesc.stride
                 + vertexDesc.offset + primVarOffset;
 
-            dst[i] = editValues[i];
+            for (int j = 0; j < primVarWidth; ++j) {
+                dst[j] = editValues[i*primVarWidth+j];
+            }
         }
     });
 }
@@ -182,12 +182,17 @@ OsdGLDrawContext::create(FarPatchTables const * patchTables, int numVertexElemen
             _patchParamTextureBuffer = createTextureBuffer(patchParamTables, GL_RG32I);
 
 
-        // create fvar data buffer if requested
-        std::vector<float> const &
-            fvarData = patchTables->GetFVarData().GetAllData();
-
-        if (requireFVarData and not fvarData.empty())
-            _fvarDataTextureBuffer = createTextureBuffer(fvarData, GL_R32F);
+        // create fvar data buffer if requested (the shaders fetch the
+        // face-varying data per-face-per-vertex : expand indexed data)
+        FarPatchTables::FVarData const &
+            fvarData = patchTables->GetFVarData();
+
+        if (requireFVarData and fvarData.IsIndexed()) {
+            std::vector<float> expandedData;
+            fvarData.ExpandData(expandedData);
+            _fvarDataTextureBuffer = createTextureBuffer(expandedData, GL_R32F);
+        } else if (requireFVarData and not fvarData.GetAllData().empty())
+            _fvarDataTextureBuffer = createTextureBuffer(fvarData.GetAllData(), GL_R32F);
 
         glBindBuffer(GL_TEXTURE_BUFFER, 0);
     }
@@ -300,28 +300,57 @@ OsdOmpComputeController::ApplyVertexEdits(
     const OsdCpuTable * primvarIndices = edit->GetPrimvarIndices();
     const OsdCpuTable * editValues = edit->GetEditValues();
 
-    if (edit->GetOperation() == FarVertexEdit::Add) {
-        OsdOmpEditVertexAdd(_currentBindState.vertexBuffer,
-                            _currentBindState.vertexDesc,
-                            edit->GetPrimvarOffset(),
-                            edit->GetPrimvarWidth(),
-                            batch.GetVertexOffset(), 
-                            batch.GetTableOffset(), 
-                            batch.GetStart(), 
-                            batch.GetEnd(),
-                            static_cast<unsigned int*>(primvarIndices->GetBuffer()),
-                            static_cast<float*>(editValues->GetBuffer()));
-    } else if (edit->GetOperation() == FarVertexEdit::Set) {
-        OsdOmpEditVertexSet(_currentBindState.vertexBuffer,
-                            _currentBindState.vertexDesc,
-                            edit->GetPrimvarOffset(),
-                            edit->GetPrimvarWidth(),
-                            batch.GetVertexOffset(), 
-                            batch.GetTableOffset(), 
-                            batch.GetStart(), 
-                            batch.GetEnd(),
-                            static_cast<unsigned int*>(primvarIndices->GetBuffer()),
-                            static_cast<float*>(editValues->GetBuffer()));
+    // the edits apply to each of the interleaved samples
+    int numSamples = _currentBindState.numSamples,
+        sampleLength = _currentBindState.vertexDesc.length / numSamples;
+
+    for (int sample = 0; sample < numSamples; ++sample) {
+
+        float * vertex = _currentBindState.vertexBuffer ?
+            _currentBindState.vertexBuffer + sample * sampleLength : NULL;
+
+        if (edit->GetOperation() == FarVertexEdit::Add) {
+            OsdOmpEditVertexAdd(vertex,
+                                _currentBindState.vertexDesc,
+                                edit->GetPrimvarOffset(),
+                                edit->GetPrimvarWidth(),
+                                batch.GetVertexOffset(), 
+                                batch.GetTableOffset(), 
+                                batch.GetStart(), 
+                                batch.GetEnd(),
+                                static_cast<const unsigned int*>(primvarIndices->GetBuffer()),
+                                static_cast<const float*>(editValues->GetBuffer()));
+        } else if (edit->GetOperation() == FarVertexEdit::Set) {
+            OsdOmpEditVertexSet(vertex,
+                                _currentBindState.vertexDesc,
+                                edit->GetPrimvarOffset(),
+                                edit->GetPrimvarWidth(),
+                                batch.GetVertexOffset(), 
+                                batch.GetTableOffset(), 
+                                batch.GetStart(), 
+                                batch.GetEnd(),
+                                static_cast<const unsigned int*>(primvarIndices->GetBuffer()),
+                                static_cast<const float*>(editValues->GetBuffer()));
+        }
+    }
+}
+
+void
+OsdOmpComputeController::refineFVar(OsdCpuFVarTable const *table, float *values) const {
+
+    assert(table and values);
+
+    // the stencils of a level read the values of the previous levels
+    std::vector<int> const & levels = table->GetLevelOffsets();
+    for (int i = 0; i+1 < (int)levels.size(); ++i) {
+        OsdOmpComputeFVarStencils(values,
+            static_cast<const int*>(table->GetSizes()->GetBuffer()),
+            static_cast<const int*>(table->GetOffsets()->GetBuffer()),
+            static_cast<const int*>(table->GetDestinations()->GetBuffer()),
+            static_cast<const int*>(table->GetWidths()->GetBuffer()),
+            static_cast<const int*>(table->GetSourceIndices()->GetBuffer()),
+            static_cast<const float*>(table->GetWeights()->GetBuffer()),
+            levels[i], levels[i+1]);
     }
 }
 
@@ -88,6 +88,9 @@ public:
 
         if (batches.empty()) return;
 
+        // the number of threads is only changed for the kernels : restore
+        // the setting of the application afterwards
+        int numThreads = omp_get_max_threads();
         omp_set_num_threads(_numThreads);
 
         bind(vertexBuffer, varyingBuffer, vertexDesc, varyingDesc);
@@ -95,6 +98,8 @@ public:
         FarDispatcher::Refine(this, context, batches, /*maxlevel*/-1);
 
         unbind();
+
+        omp_set_num_threads(numThreads);
     }
 
     /// Launch subdivision kernels and apply to given vertex buffers.
@@ -113,6 +118,74 @@ public:
         Refine(context, batches, vertexBuffer, (VERTEX_BUFFER*)0);
     }
 
+    /// Launch subdivision kernels on several samples of the vertex data
+    /// (for instance the motion blur time samples of a mesh) in a single
+    /// traversal of the subdivision tables.
+    ///
+    /// The samples are interleaved in the vertex buffer : every vertex holds
+    /// the elements of each sample one after the other (see
+    /// OsdCpuVertexBuffer::UpdateSampleData), so that every index and weight
+    /// loaded from the tables is applied to all the samples.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  numSamples    the number of interleaved samples
+    ///
+    /// @param  vertexDesc    the descriptor of the elements of all the samples
+    ///                       (vertexDesc->length / numSamples elements per
+    ///                       sample). if it's null, all primvars in the vertex
+    ///                       buffer will be refined.
+    ///
+    template<class VERTEX_BUFFER>
+    void RefineSamples(OsdCpuComputeContext const *context,
+                       FarKernelBatchVector const & batches,
+                       VERTEX_BUFFER *vertexBuffer,
+                       int numSamples,
+                       OsdVertexBufferDescriptor const *vertexDesc=NULL) {
+
+        if (batches.empty() or numSamples < 1) return;
+
+        bind(vertexBuffer, (VERTEX_BUFFER*)0, vertexDesc, NULL);
+
+        _currentBindState.numSamples = numSamples;
+
+        FarDispatcher::Refine(this, context, batches, /*maxlevel*/-1);
+
+        unbind();
+    }
+
+    /// Refines face-varying values with the face-varying table of the context
+    ///
+    /// The buffer holds the coarse face-varying values, one per vertex of each
+    /// coarse face, followed by the refined values (see FarFVarTables) : it
+    /// must have GetFVarWidth() elements and GetNumValues() vertices, and its
+    /// coarse values must be set.
+    ///
+    /// @param  context       the OsdCpuContext holding the FarFVarTables
+    ///
+    /// @param  fvarBuffer    face-varying data buffer
+    ///
+    template<class FVAR_BUFFER>
+    void RefineFVar(OsdCpuComputeContext const *context,
+                    FVAR_BUFFER *fvarBuffer) {
+
+        if (not context or not context->GetFVarTable() or not fvarBuffer) return;
+
+        // the number of threads is only changed for the kernels : restore
+        // the setting of the application afterwards
+        int numThreads = omp_get_max_threads();
+        omp_set_num_threads(_numThreads);
+
+        refineFVar(context->GetFVarTable(), fvarBuffer->BindCpuBuffer());
+
+        omp_set_num_threads(numThreads);
+    }
+
     /// Waits until all running subdivision kernels finish.
     void Synchronize();
 
@@ -159,6 +232,9 @@ protected:
 
     void ApplyVertexEdits(FarKernelBatch const &batch, ComputeContext const *context) const;
 
+    // Applies the face-varying stencils level by level
+    void refineFVar(OsdCpuFVarTable const *table, float *values) const;
+
     template<class VERTEX_BUFFER, class VARYING_BUFFER>
     void bind(VERTEX_BUFFER *vertex, VARYING_BUFFER *varying,
               OsdVertexBufferDescriptor const *vertexDesc,
@@ -201,16 +277,18 @@ protected:
 
 private:
     struct BindState {
-        BindState() : vertexBuffer(NULL), varyingBuffer(NULL) {}
+        BindState() : vertexBuffer(NULL), varyingBuffer(NULL), numSamples(1) {}
         void Reset() {
             vertexBuffer = varyingBuffer = NULL;
             vertexDesc.Reset();
             varyingDesc.Reset();
+            numSamples = 1;
         }
         float *vertexBuffer;
         float *varyingBuffer;
         OsdVertexBufferDescriptor vertexDesc;
         OsdVertexBufferDescriptor varyingDesc;
+        int numSamples;     // interleaved samples of the vertex data
     };
 
     BindState _currentBindState;
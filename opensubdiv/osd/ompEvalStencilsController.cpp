@@ -25,10 +25,43 @@
 #include "../osd/ompEvalStencilsController.h"
 
 #include <cassert>
+#include <cmath>
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
+// Computes the unit normal of the derivatives and, for tangent frames,
+// replaces the derivatives with the unit tangent and bitangent (degenerate
+// derivatives give null vectors)
+inline void
+computeFrame(float * du, float * dv, float * n, bool tangentFrame) {
+
+    n[0] = du[1]*dv[2]-du[2]*dv[1];
+    n[1] = du[2]*dv[0]-du[0]*dv[2];
+    n[2] = du[0]*dv[1]-du[1]*dv[0];
+
+    float len = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+    if (len>0.0f) {
+        float rn = 1.0f/len;
+        n[0] *= rn;
+        n[1] *= rn;
+        n[2] *= rn;
+    }
+
+    if (tangentFrame) {
+        len = sqrtf(du[0]*du[0] + du[1]*du[1] + du[2]*du[2]);
+        if (len>0.0f) {
+            float rt = 1.0f/len;
+            du[0] *= rt;
+            du[1] *= rt;
+            du[2] *= rt;
+        }
+        dv[0] = n[1]*du[2]-n[2]*du[1];
+        dv[1] = n[2]*du[0]-n[0]*du[2];
+        dv[2] = n[0]*du[1]-n[1]*du[0];
+    }
+}
+
 OsdOmpEvalStencilsController::OsdOmpEvalStencilsController(int numThreads) {
 
     _numThreads = (numThreads == -1) ? omp_get_num_procs() : numThreads;
@@ -142,6 +175,172 @@ OsdOmpEvalStencilsController::_UpdateDerivs( OsdCpuEvalStencilsContext * context
     return nstencils;
 }
 
+int
+OsdOmpEvalStencilsController::_UpdateValuesAndDerivs( OsdCpuEvalStencilsContext * context ) {
+
+    int result=0;
+
+    FarStencilTables const * stencils = context->GetStencilTables();
+
+    int nstencils = stencils->GetNumStencils();
+    if (not nstencils)
+        return result;
+
+    OsdVertexBufferDescriptor ctrlDesc = _currentBindState.controlDataDesc,
+                              outDesc = _currentBindState.outputDataDesc,
+                              duDesc = _currentBindState.outputDuDesc,
+                              dvDesc = _currentBindState.outputDvDesc;
+    
+    // make sure that we have control data to work with
+    if (not (ctrlDesc.CanEval(outDesc) and
+             ctrlDesc.CanEval(duDesc) and ctrlDesc.CanEval(dvDesc)))
+        return 0;
+
+    float const * ctrl = _currentBindState.controlData + ctrlDesc.offset;
+
+    if (not ctrl)
+        return result;
+
+#pragma omp parallel for
+    for (int i=0; i<nstencils; ++i) {
+
+        int size = stencils->GetSizes()[i],
+            offset = stencils->GetOffsets()[i];
+
+        int const * index = &stencils->GetControlIndices().at(offset);
+
+        float const * weight = &stencils->GetWeights().at(offset),
+                    * duweight = &stencils->GetDuWeights().at(offset),
+                    * dvweight = &stencils->GetDvWeights().at(offset);
+
+        float * out = _currentBindState.outputData + i * outDesc.stride + outDesc.offset,
+              * du = _currentBindState.outputUDeriv + i * duDesc.stride + duDesc.offset,
+              * dv = _currentBindState.outputVDeriv + i * dvDesc.stride + dvDesc.offset;
+
+        memset(out, 0, outDesc.length*sizeof(float));
+        memset(du, 0, duDesc.length*sizeof(float));
+        memset(dv, 0, dvDesc.length*sizeof(float));
+
+        for (int j=0; j<size; ++j, ++index, ++weight, ++duweight, ++dvweight) {
+
+            float const * cv = ctrl + (*index)*ctrlDesc.stride;
+
+            for (int k=0; k<outDesc.length; ++k) {
+                out[k] += cv[k] * (*weight);
+                du[k] += cv[k] * (*duweight);
+                dv[k] += cv[k] * (*dvweight);
+            }
+        }
+    }
+
+    return nstencils;
+}
+
+int
+OsdOmpEvalStencilsController::_UpdateFrames( OsdCpuEvalStencilsContext * context,
+                                             bool tangentFrame ) {
+
+    int result=0;
+
+    FarStencilTables const * stencils = context->GetStencilTables();
+
+    int nstencils = stencils->GetNumStencils();
+    if (not nstencils)
+        return result;
+
+    OsdVertexBufferDescriptor ctrlDesc = _currentBindState.controlDataDesc,
+                              outDesc = _currentBindState.outputDataDesc,
+                              duDesc = _currentBindState.outputDuDesc,
+                              dvDesc = _currentBindState.outputDvDesc,
+                              nDesc = _currentBindState.outputNormalDesc;
+
+    float * outData = _currentBindState.outputData,
+          * duData = _currentBindState.outputUDeriv,
+          * dvData = _currentBindState.outputVDeriv,
+          * nData = _currentBindState.outputNormal;
+
+    // make sure that we have control data to work with : the derivatives and
+    // the normals are computed from xyz control data
+    if (not ctrlDesc.IsValid() or ctrlDesc.length<3)
+        return 0;
+
+    if ((outData and not ctrlDesc.CanEval(outDesc)) or
+        (duData and not (duDesc.IsValid() and duDesc.length==3)) or
+        (dvData and not (dvDesc.IsValid() and dvDesc.length==3)) or
+        (nData and not (nDesc.IsValid() and nDesc.length==3)))
+        return 0;
+
+    bool hasFrames = duData or dvData or nData;
+
+    if (hasFrames and stencils->GetDuWeights().empty())
+        return 0;
+
+    float const * ctrl = _currentBindState.controlData + ctrlDesc.offset;
+
+    if ((not ctrl) or (not (outData or hasFrames)))
+        return result;
+
+#pragma omp parallel for
+    for (int i=0; i<nstencils; ++i) {
+
+        int size = stencils->GetSizes()[i],
+            offset = stencils->GetOffsets()[i];
+
+        int const * index = &stencils->GetControlIndices().at(offset);
+
+        float const * weight = &stencils->GetWeights().at(offset),
+                    * duweight = hasFrames ? &stencils->GetDuWeights().at(offset) : 0,
+                    * dvweight = hasFrames ? &stencils->GetDvWeights().at(offset) : 0;
+
+        float * out = outData ? outData + i*outDesc.stride + outDesc.offset : 0;
+
+        if (out) {
+            memset(out, 0, outDesc.length*sizeof(float));
+        }
+
+        float du[3] = { 0.0f, 0.0f, 0.0f },
+              dv[3] = { 0.0f, 0.0f, 0.0f },
+              n[3];
+
+        for (int j=0; j<size; ++j, ++index, ++weight) {
+
+            float const * cv = ctrl + (*index)*ctrlDesc.stride;
+
+            if (out) {
+                for (int k=0; k<outDesc.length; ++k) {
+                    out[k] += cv[k] * (*weight);
+                }
+            }
+
+            if (hasFrames) {
+                for (int k=0; k<3; ++k) {
+                    du[k] += cv[k] * (*duweight);
+                    dv[k] += cv[k] * (*dvweight);
+                }
+                ++duweight;
+                ++dvweight;
+            }
+        }
+
+        if (hasFrames) {
+
+            computeFrame(du, dv, n, tangentFrame);
+
+            if (duData) {
+                memcpy(duData + i*duDesc.stride + duDesc.offset, du, 3*sizeof(float));
+            }
+            if (dvData) {
+                memcpy(dvData + i*dvDesc.stride + dvDesc.offset, dv, 3*sizeof(float));
+            }
+            if (nData) {
+                memcpy(nData + i*nDesc.stride + nDesc.offset, n, 3*sizeof(float));
+            }
+        }
+    }
+
+    return nstencils;
+}
+
 void
 OsdOmpEvalStencilsController::Synchronize() {
 }
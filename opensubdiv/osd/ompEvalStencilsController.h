@@ -83,6 +83,9 @@ public:
         if (not context->GetStencilTables()->GetNumStencils())
             return 0;
 
+        // the number of threads is only changed for the kernels : restore
+        // the setting of the application afterwards
+        int numThreads = omp_get_max_threads();
         omp_set_num_threads(_numThreads);
 
         bindControlData( controlDataDesc, controlVertices );
@@ -93,6 +96,8 @@ public:
         
         unbind();
 
+        omp_set_num_threads(numThreads);
+
         return n;
     }
 
@@ -135,6 +140,138 @@ public:
         return n;
     }
 
+    /// \brief Applies value and derivative stencil weights to the control
+    /// vertex data
+    ///
+    /// Same as UpdateValues followed by UpdateDerivs, but computes the values
+    /// and both derivatives in a single traversal of the stencils and of the
+    /// control vertices.
+    ///
+    /// @param context          the OsdCpuEvalStencilsContext with the stencil weights
+    ///
+    /// @param controlDataDesc  vertex buffer descriptor for the control vertex data 
+    ///
+    /// @param controlVertices  vertex buffer with the control vertices data
+    ///
+    /// @param outputDataDesc   vertex buffer descriptor for the output vertex data
+    ///
+    /// @param outputData       output vertex buffer for the interpolated data
+    ///
+    /// @param outputDuDesc     vertex buffer descriptor for the U derivative output data
+    ///
+    /// @param outputDuData     output vertex buffer for the U derivative data
+    ///
+    /// @param outputDvDesc     vertex buffer descriptor for the V deriv output data
+    ///
+    /// @param outputDvData     output vertex buffer for the V derivative data
+    ///
+    template<class CONTROL_BUFFER, class OUTPUT_BUFFER>
+    int UpdateValuesAndDerivs( OsdCpuEvalStencilsContext * context,
+                      OsdVertexBufferDescriptor const & controlDataDesc, CONTROL_BUFFER *controlVertices,
+                      OsdVertexBufferDescriptor const & outputDataDesc, OUTPUT_BUFFER *outputData,
+                      OsdVertexBufferDescriptor const & outputDuDesc, OUTPUT_BUFFER *outputDuData, 
+                      OsdVertexBufferDescriptor const & outputDvDesc, OUTPUT_BUFFER *outputDvData ) {
+                       
+        if (not context->GetStencilTables()->GetNumStencils())
+            return 0;
+
+        // the number of threads is only changed for the kernels : restore
+        // the setting of the application afterwards
+        int numThreads = omp_get_max_threads();
+        omp_set_num_threads(_numThreads);
+
+        bindControlData( controlDataDesc, controlVertices );
+
+        bindOutputData( outputDataDesc, outputData );
+
+        bindOutputDerivData( outputDuDesc, outputDuData, outputDvDesc, outputDvData );
+        
+        int n = _UpdateValuesAndDerivs( context );
+        
+        unbind();
+
+        omp_set_num_threads(numThreads);
+        
+        return n;
+    }
+
+    /// \brief Applies the stencil weights to evaluate limit frames
+    ///
+    /// Computes the limit positions, the U and V derivatives and the unit
+    /// normals (cross product of the derivatives) at the parametric locations
+    /// of the stencils, in a single traversal of the stencils and of the
+    /// control vertices. With 'tangentFrame', the derivative outputs receive
+    /// the unit tangent (normalized U derivative) and bitangent (normal x
+    /// tangent) instead : tangent, bitangent and normal form an orthonormal
+    /// frame.
+    ///
+    /// The outputs can be interleaved in a same buffer, their descriptors
+    /// giving their offsets within the vertex stride. A NULL output buffer
+    /// skips the output. The derivatives and the normals are computed from
+    /// the first 3 elements of the control data, their descriptors must have
+    /// a length of 3.
+    ///
+    /// @param context          the OsdCpuEvalStencilsContext with the stencil weights
+    ///
+    /// @param controlDataDesc  vertex buffer descriptor for the control vertex data
+    ///
+    /// @param controlVertices  vertex buffer with the control vertices data
+    ///
+    /// @param outputDataDesc   vertex buffer descriptor for the output vertex data
+    ///
+    /// @param outputData       output vertex buffer for the interpolated data
+    ///
+    /// @param outputDuDesc     vertex buffer descriptor for the U derivative
+    ///                         (or tangent) output data
+    ///
+    /// @param outputDuData     output vertex buffer for the U derivative data
+    ///
+    /// @param outputDvDesc     vertex buffer descriptor for the V derivative
+    ///                         (or bitangent) output data
+    ///
+    /// @param outputDvData     output vertex buffer for the V derivative data
+    ///
+    /// @param outputNormalDesc vertex buffer descriptor for the normal output data
+    ///
+    /// @param outputNormalData output vertex buffer for the normal data
+    ///
+    /// @param tangentFrame     output an orthonormal frame instead of the
+    ///                         derivatives
+    ///
+    template<class CONTROL_BUFFER, class OUTPUT_BUFFER>
+    int UpdateFrames( OsdCpuEvalStencilsContext * context,
+                      OsdVertexBufferDescriptor const & controlDataDesc, CONTROL_BUFFER *controlVertices,
+                      OsdVertexBufferDescriptor const & outputDataDesc, OUTPUT_BUFFER *outputData,
+                      OsdVertexBufferDescriptor const & outputDuDesc, OUTPUT_BUFFER *outputDuData,
+                      OsdVertexBufferDescriptor const & outputDvDesc, OUTPUT_BUFFER *outputDvData,
+                      OsdVertexBufferDescriptor const & outputNormalDesc, OUTPUT_BUFFER *outputNormalData,
+                      bool tangentFrame=false ) {
+
+        if (not context->GetStencilTables()->GetNumStencils())
+            return 0;
+
+        // the number of threads is only changed for the kernels : restore
+        // the setting of the application afterwards
+        int numThreads = omp_get_max_threads();
+        omp_set_num_threads(_numThreads);
+
+        bindControlData( controlDataDesc, controlVertices );
+
+        bindOutputData( outputDataDesc, outputData );
+
+        bindOutputDerivData( outputDuDesc, outputDuData, outputDvDesc, outputDvData );
+
+        bindOutputNormalData( outputNormalDesc, outputNormalData );
+
+        int n = _UpdateFrames( context, tangentFrame );
+
+        unbind();
+
+        omp_set_num_threads(numThreads);
+
+        return n;
+    }
+
     /// Waits until all running subdivision kernels finish.
     void Synchronize();
 
@@ -168,6 +305,14 @@ protected:
         _currentBindState.outputDvDesc = outputDvDesc;
     }
 
+    /// \brief Binds output normal vertex data buffer
+    template<class VERTEX_BUFFER>
+    void bindOutputNormalData( OsdVertexBufferDescriptor const & outputNormalDesc, VERTEX_BUFFER *outputNormal ) {
+
+        _currentBindState.outputNormal = outputNormal ? outputNormal->BindCpuBuffer() : 0;
+        _currentBindState.outputNormalDesc = outputNormalDesc;
+    }
+
     /// \brief Unbinds any previously bound vertex and varying data buffers.
     void unbind() {
         _currentBindState.Reset();
@@ -177,6 +322,8 @@ private:
 
     int _UpdateValues( OsdCpuEvalStencilsContext * context );
     int _UpdateDerivs( OsdCpuEvalStencilsContext * context );
+    int _UpdateValuesAndDerivs( OsdCpuEvalStencilsContext * context );
+    int _UpdateFrames( OsdCpuEvalStencilsContext * context, bool tangentFrame );
 
     int _numThreads;
 
@@ -184,26 +331,30 @@ private:
     // It doesn't take an ownership of vertex buffers.
     struct BindState {
 
-        BindState() : controlData(0), outputData(0), outputUDeriv(0), outputVDeriv(0) { }
+        BindState() : controlData(0), outputData(0), outputUDeriv(0), outputVDeriv(0),
+            outputNormal(0) { }
         
         void Reset() {
-            controlData = outputData = outputUDeriv = outputVDeriv = NULL;
+            controlData = outputData = outputUDeriv = outputVDeriv = outputNormal = NULL;
             controlDataDesc.Reset();
             outputDataDesc.Reset();
             outputDuDesc.Reset();
             outputDvDesc.Reset();
+            outputNormalDesc.Reset();
         }
 
         // transient mesh data
         OsdVertexBufferDescriptor controlDataDesc,
                                   outputDataDesc,
                                   outputDuDesc,
-                                  outputDvDesc;
+                                  outputDvDesc,
+                                  outputNormalDesc;
 
         float * controlData,
               * outputData,
               * outputUDeriv,
-              * outputVDeriv;
+              * outputVDeriv,
+              * outputNormal;
     };
     
     BindState _currentBindState;
@@ -141,6 +141,12 @@ void OsdOmpEditVertexSet(float *vertex,
                          const unsigned int *editIndices,
                          const float *editValues);
 
+void OsdOmpComputeFVarStencils(float *values,
+                             const int *sizes, const int *offsets,
+                             const int *destinations, const int *widths,
+                             const int *sourceIndices, const float *weights,
+                             int start, int end);
+
 }  // end namespace OPENSUBDIV_VERSION
 using namespace OPENSUBDIV_VERSION;
 
@@ -0,0 +1,70 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../osd/scheduler.h"
+
+#include <algorithm>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+OsdDefaultScheduler::OsdDefaultScheduler(int numThreads) :
+    _numThreads(std::max(1, numThreads)) {
+}
+
+OsdDefaultScheduler::~OsdDefaultScheduler() {
+}
+
+void
+OsdDefaultScheduler::ParallelFor(int begin, int end, int grainSize, Task const & task) {
+
+    if (begin>=end)
+        return;
+
+    grainSize = std::max(1, grainSize);
+
+    int nranges = (end - begin + grainSize - 1) / grainSize;
+
+    if (_numThreads==1 or nranges==1) {
+        task.Run(begin, end);
+        return;
+    }
+
+    int numThreads = std::min(_numThreads, nranges);
+
+    // the ranges are handed out dynamically : the threads that finish early
+    // take over the remaining ranges
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+#endif
+    for (int i=0; i<nranges; ++i) {
+        int first = begin + i*grainSize;
+        task.Run(first, std::min(first + grainSize, end));
+    }
+
+    (void)numThreads;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
@@ -0,0 +1,144 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OSD_SCHEDULER_H
+#define OSD_SCHEDULER_H
+
+#include "../version.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Interface of the task schedulers running the parallel loops of the
+/// CPU controllers
+///
+/// The OpenMP, TBB and GCD controllers each drive their own threading
+/// runtime. The CPU controllers (OsdCpuComputeController,
+/// OsdCpuEvalStencilsController, OsdCpuEvalLimitController and
+/// OsdCpuSmoothNormalController) can instead be given an OsdScheduler, which
+/// runs their loops : applications that already run a job system or a TBB
+/// arena can implement this interface to run the OpenSubdiv work in their own
+/// threads, so that OpenSubdiv does not create threads of its own.
+///
+/// Ex : running the loops in the current TBB arena
+/// \code
+/// class TbbScheduler : public OsdScheduler {
+/// public:
+///     virtual void ParallelFor(int begin, int end, int grainSize,
+///                              OsdScheduler::Task const & task) {
+///         tbb::parallel_for(tbb::blocked_range<int>(begin, end, grainSize),
+///                           Body(task));
+///     }
+/// private:
+///     struct Body {
+///         Body(OsdScheduler::Task const & t) : task(t) { }
+///         void operator()(tbb::blocked_range<int> const & r) const {
+///             task.Run(r.begin(), r.end());
+///         }
+///         OsdScheduler::Task const & task;
+///     };
+/// };
+///
+/// TbbScheduler scheduler;
+/// OsdCpuComputeController controller(&scheduler);
+/// \endcode
+///
+/// The controllers do not own their scheduler, which must outlive them.
+///
+class OsdScheduler {
+
+public:
+
+    /// \brief The body of a parallel loop
+    class Task {
+    public:
+        virtual ~Task() { }
+
+        /// \brief Runs the iterations [begin, end) of the loop
+        ///
+        /// Called concurrently by the scheduler on disjoint ranges.
+        ///
+        virtual void Run(int begin, int end) const = 0;
+    };
+
+    /// Destructor
+    virtual ~OsdScheduler() { }
+
+    /// \brief Runs the iterations [begin, end) of a parallel loop
+    ///
+    /// Splits the iterations in ranges of at least grainSize iterations (but
+    /// the last), runs the task on each range and returns when all the ranges
+    /// have been run.
+    ///
+    /// @param begin      the first iteration
+    ///
+    /// @param end        the iteration after the last
+    ///
+    /// @param grainSize  the minimum number of iterations of a range
+    ///
+    /// @param task       the body of the loop
+    ///
+    virtual void ParallelFor(int begin, int end, int grainSize, Task const & task) = 0;
+};
+
+/// \brief Default scheduler
+///
+/// Runs the loops in the calling thread with a single thread. With more
+/// threads (and OpenMP support), the ranges of a loop are distributed
+/// dynamically to an OpenMP team of that size, which is requested for the loop
+/// only : the number of threads of the application OpenMP regions is not
+/// modified.
+///
+class OsdDefaultScheduler : public OsdScheduler {
+
+public:
+
+    /// \brief Constructor
+    ///
+    /// @param numThreads  the number of threads running the loops (1 runs
+    ///                    them in the calling thread)
+    ///
+    OsdDefaultScheduler(int numThreads=1);
+
+    /// Destructor
+    virtual ~OsdDefaultScheduler();
+
+    /// Returns the number of threads running the loops
+    int GetNumThreads() const {
+        return _numThreads;
+    }
+
+    virtual void ParallelFor(int begin, int end, int grainSize, Task const & task);
+
+private:
+
+    int _numThreads;
+};
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // OSD_SCHEDULER_H
@@ -315,8 +315,8 @@ OsdTbbComputeController::ApplyVertexEdits(
                             batch.GetTableOffset(),
                             batch.GetStart(),
                             batch.GetEnd(),
-                            static_cast<unsigned int*>(primvarIndices->GetBuffer()),
-                            static_cast<float*>(editValues->GetBuffer()));
+                            static_cast<const unsigned int*>(primvarIndices->GetBuffer()),
+                            static_cast<const float*>(editValues->GetBuffer()));
     } else if (edit->GetOperation() == FarVertexEdit::Set) {
         OsdTbbEditVertexSet(_currentBindState.vertexBuffer,
                             _currentBindState.vertexDesc,
@@ -326,8 +326,8 @@ OsdTbbComputeController::ApplyVertexEdits(
                             batch.GetTableOffset(),
                             batch.GetStart(),
                             batch.GetEnd(),
-                            static_cast<unsigned int*>(primvarIndices->GetBuffer()),
-                            static_cast<float*>(editValues->GetBuffer()));
+                            static_cast<const unsigned int*>(primvarIndices->GetBuffer()),
+                            static_cast<const float*>(editValues->GetBuffer()));
     }
 }
 
@@ -22,6 +22,7 @@
 //   language governing permissions and limitations under the Apache License.
 //
 
+#include "../far/vertexEditTables.h"
 #include "../osd/cpuKernel.h"
 #include "../osd/tbbKernel.h"
 #include "../osd/vertexDescriptor.h"
@@ -1117,24 +1118,80 @@ void OsdTbbComputeBilinearVertex(
     tbb::parallel_for(range, kernel);
 }
 
-void OsdTbbEditVertexAdd(
-    float *vertex,
-    OsdVertexBufferDescriptor const &vertexDesc,
-    int primVarOffset, int primVarWidth, int vertexOffset, int tableOffset,
-    int start, int end,
-    unsigned int const *editIndices, float const *editValues) {
-
-    for (int i = start+tableOffset; i < end+tableOffset; i++) {
+template <FarVertexEdit::Operation OP>
+class TBBEditVertexKernel {
+    float        *vertex;
+    OsdVertexBufferDescriptor vertexDesc;
+    int           primVarOffset;
+    int           primVarWidth;
+    int           vertexOffset;
+    int           tableOffset;
+    unsigned int const *editIndices;
+    float const  *editValues;
 
-        if (vertex) {
+public:
+    // each vertex is edited at most once per batch (see
+    // FarVertexEditTablesFactory), so the edits can run concurrently
+    void operator() (tbb::blocked_range<int> const &r) const {
+        for (int i = r.begin() + tableOffset; i < r.end() + tableOffset; i++) {
             int editIndex = editIndices[i] + vertexOffset;
             float *dst = vertex + editIndex * vertexDesc.stride + primVarOffset;
 
             for (int j = 0; j < primVarWidth; ++j) {
-                dst[j] += editValues[j];
+                if (OP == FarVertexEdit::Add)
+                    dst[j] += editValues[i*primVarWidth+j];
+                else
+                    dst[j] = editValues[i*primVarWidth+j];
             }
         }
     }
+
+    TBBEditVertexKernel(TBBEditVertexKernel const &other)
+    {
+        this->vertex = other.vertex;
+        this->vertexDesc = other.vertexDesc;
+        this->primVarOffset = other.primVarOffset;
+        this->primVarWidth  = other.primVarWidth;
+        this->vertexOffset  = other.vertexOffset;
+        this->tableOffset   = other.tableOffset;
+        this->editIndices   = other.editIndices;
+        this->editValues    = other.editValues;
+    }
+
+    TBBEditVertexKernel(float                     *vertex_in,
+                        OsdVertexBufferDescriptor const &vertexDesc_in,
+                        int                        primVarOffset_in,
+                        int                        primVarWidth_in,
+                        int                        vertexOffset_in,
+                        int                        tableOffset_in,
+                        unsigned int const        *editIndices_in,
+                        float const               *editValues_in) :
+                        vertex (vertex_in),
+                        vertexDesc(vertexDesc_in),
+                        primVarOffset(primVarOffset_in),
+                        primVarWidth(primVarWidth_in),
+                        vertexOffset(vertexOffset_in),
+                        tableOffset(tableOffset_in),
+                        editIndices(editIndices_in),
+                        editValues(editValues_in)
+    {};
+};
+
+void OsdTbbEditVertexAdd(
+    float *vertex,
+    OsdVertexBufferDescriptor const &vertexDesc,
+    int primVarOffset, int primVarWidth, int vertexOffset, int tableOffset,
+    int start, int end,
+    unsigned int const *editIndices, float const *editValues) {
+
+    if (not vertex) return;
+
+    tbb::blocked_range<int> range(start, end, grain_size);
+    TBBEditVertexKernel<FarVertexEdit::Add> kernel(vertex, vertexDesc,
+                                                   primVarOffset, primVarWidth,
+                                                   vertexOffset, tableOffset,
+                                                   editIndices, editValues);
+    tbb::parallel_for(range, kernel);
 }
 
 void OsdTbbEditVertexSet(
@@ -1144,17 +1201,14 @@ void OsdTbbEditVertexSet(
     int start, int end,
     unsigned int const *editIndices, float const *editValues) {
 
-    for (int i = start+tableOffset; i < end+tableOffset; i++) {
+    if (not vertex) return;
 
-        if (vertex) {
-            int editIndex = editIndices[i] + vertexOffset;
-            float *dst = vertex + editIndex * vertexDesc.stride + primVarOffset;
-
-            for (int j = 0; j < primVarWidth; ++j) {
-                dst[j] = editValues[j];
-            }
-        }
-    }
+    tbb::blocked_range<int> range(start, end, grain_size);
+    TBBEditVertexKernel<FarVertexEdit::Set> kernel(vertex, vertexDesc,
+                                                   primVarOffset, primVarWidth,
+                                                   vertexOffset, tableOffset,
+                                                   editIndices, editValues);
+    tbb::parallel_for(range, kernel);
 }
 
 }  // end namespace OPENSUBDIV_VERSION
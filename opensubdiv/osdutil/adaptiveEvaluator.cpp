@@ -23,6 +23,7 @@
 //
 
 #include "adaptiveEvaluator.h"
+#include "tessellator.h"
 
 #define HBR_ADAPTIVE
 #include "../hbr/mesh.h"
@@ -51,7 +52,9 @@ OsdUtilAdaptiveEvaluator::OsdUtilAdaptiveEvaluator():
     _computeContext(NULL),
     _evalLimitContext(NULL),
     _vertexBuffer(NULL),
-    _vvBuffer(NULL)
+    _vvBuffer(NULL),
+    _limitBVH(NULL),
+    _limitBVHValid(false)
 {
 }
 
@@ -68,6 +71,8 @@ OsdUtilAdaptiveEvaluator::~OsdUtilAdaptiveEvaluator()
         delete _vertexBuffer;
     if (_vvBuffer)
         delete _vvBuffer;
+    if (_limitBVH)
+        delete _limitBVH;
 }
 
 
@@ -155,21 +160,32 @@ OsdUtilAdaptiveEvaluator::Initialize(
     _evalLimitContext = OsdCpuEvalLimitContext::Create(
         fmesh->GetPatchTables(), /*requierFVarData*/ false);
 
+    // The limit evaluations read the refined vertices through these
+    // bindings : they are set once rather than for each sample
+    _evalLimitController.BindVertexBuffers<OsdCpuVertexBuffer,OsdCpuVertexBuffer>(
+        OsdVertexBufferDescriptor(0, 3, 3), _vertexBuffer,
+        OsdVertexBufferDescriptor(0, 0, 0), NULL);
+
     return true;
 }
 
 
-void
+bool
 OsdUtilAdaptiveEvaluator::SetCoarsePositions(
         const float *coords, int numFloats, string *errorMessage )
 {
-    //XXX: should be >= num coarse vertices
-    if (numFloats/3 >= _refiner->GetFarMesh()->GetNumVertices()) {
+    // The vertex buffer holds the coarse vertices followed by the refined
+    // ones : fully regular meshes have no refined vertices
+    if (numFloats % 3 or numFloats/3 > _refiner->GetTopology().numVertices) {
         if (errorMessage)
             *errorMessage = "Indexing error in tesselator";
-    } else {
+        return false;
+    }
+
+    if (numFloats) {
         _vertexBuffer->UpdateData(coords, 0, numFloats / 3);
     }
+    return true;
 }
 
 bool
@@ -179,41 +195,127 @@ OsdUtilAdaptiveEvaluator::Refine(
     const FarMesh<OsdVertex> *fmesh = _refiner->GetFarMesh();
 
 
-    if (numThreads > 1) {
 #ifdef OPENSUBDIV_HAS_OPENMP
+    if (numThreads > 1) {
         OsdOmpComputeController ompComputeController(numThreads);
         ompComputeController.Refine(_computeContext,
                                     fmesh->GetKernelBatches(),
                                     _vertexBuffer, _vvBuffer);
-        return true;
+    } else
 #endif
+    {
+        OsdCpuComputeController cpuComputeController;
+        cpuComputeController.Refine(_computeContext,
+                                    fmesh->GetKernelBatches(),
+                                    _vertexBuffer, _vvBuffer);
     }
 
+    // Rebinding marks the Gregory patches cached for the previous pose out
+    // of date : compute the control points of the new pose once for all
+    // the limit evaluations
+    _evalLimitController.BindVertexBuffers<OsdCpuVertexBuffer,OsdCpuVertexBuffer>(
+        OsdVertexBufferDescriptor(0, 3, 3), _vertexBuffer,
+        OsdVertexBufferDescriptor(0, 0, 0), NULL);
+
+    _evalLimitController.UpdateGregoryCache(_evalLimitContext);
 
-    OsdCpuComputeController cpuComputeController;
-    cpuComputeController.Refine(_computeContext,
-                                fmesh->GetKernelBatches(),
-                                _vertexBuffer, _vvBuffer);
+    _limitBVHValid = false;
 
     return true;
 }
 
 void
 OsdUtilAdaptiveEvaluator::EvaluateLimit(
-    const OsdEvalCoords &coords, float P[3], float dPdu[3], float dPdv[3])
+    const OsdEvalCoords &coords, float P[3], float dPdu[3], float dPdv[3]) const
+{
+    OsdVertexBufferDescriptor desc(0,3,3);
+
+    _evalLimitController.EvalLimitSample(coords, _evalLimitContext, desc, P, dPdu, dPdv);
+}
+
+int
+OsdUtilAdaptiveEvaluator::EvaluateLimit(
+    int numSamples,
+    const int *faces, const float *u, const float *v,
+    float *P, float *dPdu, float *dPdv,
+    int numThreads) const
 {
+    OsdVertexBufferDescriptor desc(0,3,3);
+
+    int numFound = 0;
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #pragma omp parallel for reduction(+:numFound) num_threads(numThreads) if (numThreads > 1)
+#endif
+    for (int i = 0; i < numSamples; ++i) {
+
+        OsdEvalCoords coords;
+        coords.face = faces[i];
+        coords.u = u[i];
+        coords.v = v[i];
+
+        numFound += _evalLimitController.EvalLimitSample(
+            coords, _evalLimitContext, desc,
+            P + 3*i,
+            dPdu ? dPdu + 3*i : NULL,
+            dPdv ? dPdv + 3*i : NULL);
+    }
 
-    // This controller is an empty object, essentially a namespace.
-    OsdCpuEvalLimitController cpuEvalLimitController;
-    
-    static OsdVertexBufferDescriptor desc(0,3,3);
-
-    // Setup evaluation controller. Values are offset, length, stride */
-    OsdVertexBufferDescriptor in_desc(0, 3, 3), out_desc(0, 0, 0);
-    
-    cpuEvalLimitController.BindVertexBuffers<OsdCpuVertexBuffer,OsdCpuVertexBuffer>(in_desc, _vertexBuffer, out_desc, NULL);
-    
-    cpuEvalLimitController.EvalLimitSample(coords, _evalLimitContext, desc, P, dPdu, dPdv);
+    (void)numThreads;
+
+    return numFound;
+}
+
+int
+OsdUtilAdaptiveEvaluator::ProjectPoints(
+    int numPoints, const float *points,
+    int *faces, float *u, float *v, float *distances,
+    float maxDistance, int numThreads)
+{
+    if (not _limitBVH and _refiner and _refiner->GetFarMesh()) {
+        _limitBVH = OsdCpuEvalLimitBVH::Create(
+            _refiner->GetFarMesh()->GetPatchTables());
+    }
+
+    if (not _limitBVH) {
+        for (int i = 0; i < numPoints; ++i) {
+            faces[i] = -1;
+        }
+        return 0;
+    }
+
+    if (not _limitBVHValid) {
+        _limitBVH->Refit(OsdVertexBufferDescriptor(0, 3, 3),
+                         _vertexBuffer->BindCpuBuffer());
+        _limitBVHValid = true;
+    }
+
+    int numFound = 0;
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #pragma omp parallel for reduction(+:numFound) num_threads(numThreads) if (numThreads > 1)
+#endif
+    for (int i = 0; i < numPoints; ++i) {
+
+        OsdEvalCoords coords;
+        float distance = 0.0f;
+
+        if (_limitBVH->FindClosestPoint(points + 3*i, &coords, &distance,
+                                        maxDistance)) {
+            faces[i] = coords.face;
+            u[i] = coords.u;
+            v[i] = coords.v;
+            if (distances)
+                distances[i] = distance;
+            ++numFound;
+        } else {
+            faces[i] = -1;
+        }
+    }
+
+    (void)numThreads;
+
+    return numFound;
 }
 
 
@@ -252,99 +354,29 @@ OsdUtilAdaptiveEvaluator::GetRefinedTopology(
     OsdUtilSubdivTopology *out,
     //positions will have three floats * t->numVertices
     std::vector<float> *positions,
-    std::string *errorMessage)
+    std::string *errorMessage,
+    int tessRate,
+    const std::vector<int> *edgeRates,
+    int numThreads)
 {
+    OsdUtilTessellator tessellator;
 
-    const OsdUtilSubdivTopology &t = GetTopology();
-
-    positions->clear();
-
-    // XXX: dirk
-    // What are correct values for subfaceGridSize?
-    // These look good.
-    // Power of 2 + 1?
-    int gridSize = 5;
-    int subfaceGridSize = 3;
-
-    int coarseFaceIndex = 0;
-    int ptexFaceIndex = 0;
-    int numSubfacesToProcess = 0;
-
-    bool done = false;
-
-    while (not done ) {
-
-        // iterate through faces in coarse topology.  Four sided
-        // faces are traversed in one pass, sub-faces of non quads
-        // are traversed in order, i.e. three subfaces for each triangle
-        // These are the indices used by ptex and the eval API
-        bool subface = false;
-
-        if (numSubfacesToProcess > 0) {
-            // We are iterating over sub-faces of a non-quad
-            numSubfacesToProcess--;
-            subface = true;
-        } else {
-            int vertsInCoarseFace = t.nverts[coarseFaceIndex++];
-
-            if (vertsInCoarseFace != 4) {
-                // Non quads are subdivided by putting a point
-                // in the middle of the face and creating
-                // subfaces.
-                numSubfacesToProcess = vertsInCoarseFace-1;
-                subface = true;
-            }
-        }
-
-        int startingPositionIndex = (int) positions->size();
-        int currentGridSize = gridSize;
-
-        // Subfaces have a smaller gridsize so tessellation lines up.
-        if (subface)
-            currentGridSize = subfaceGridSize;
-
-        OsdEvalCoords coords;
-        coords.face = ptexFaceIndex;
-
-        for (int x = 0; x < currentGridSize; x++) {
-            for (int y = 0; y < currentGridSize; y++) {
-                float grid_u = (float) x / (currentGridSize - 1),
-                      grid_v = (float) y / (currentGridSize - 1);
-
-                float P[3];
-
-                coords.u = grid_u;
-                coords.v = grid_v;
-
-                EvaluateLimit(coords, P, NULL, NULL);
-                positions->push_back(P[0]);
-                positions->push_back(P[1]);
-                positions->push_back(P[2]);
-
-                // If not on edges, add a quad
-                if ( (x<currentGridSize-1) and (y<currentGridSize-1)) {
-                    int v[4];
-                    int vBase = startingPositionIndex/3;
-                    v[0] = vBase + x*currentGridSize + y;
-                    v[1] = vBase + x*currentGridSize + y+1;
-                    v[2] = vBase + (x+1)*currentGridSize+y+1;
-                    v[3] = vBase + (x+1)*currentGridSize+y;
-                    out->AddFace(4, v);
-                }
-            }
-        }
+    if (not tessellator.Initialize(GetTopology(), GetFarMesh()->GetPatchTables(),
+                                   tessRate, edgeRates, errorMessage)) {
+        return false;
+    }
 
-        ptexFaceIndex++;
+    tessellator.GetTopology(out);
 
-        if ((numSubfacesToProcess == 0) and
-            (coarseFaceIndex == (int)t.nverts.size())) {
-            done = true; // last face
-        }
+    positions->resize(tessellator.GetNumVertices() * 3);
 
-    } // while (not done)
+    if (not positions->empty()) {
+        OsdVertexBufferDescriptor desc(0, 3, 3);
+        tessellator.Evaluate(desc, _vertexBuffer->BindCpuBuffer(),
+                             desc, &(*positions)[0], numThreads);
+    }
 
     out->name = GetTopology().name + "_refined";
-    out->numVertices = (int) positions->size()/3;
     out->refinementLevel = GetTopology().refinementLevel;
 
     return out->IsValid(errorMessage);
@@ -37,10 +37,13 @@
 
 #include "../osd/cpuVertexBuffer.h"
 #include "../osd/cpuComputeContext.h"
+#include "../osd/cpuEvalLimitBVH.h"
 #include "../osd/cpuEvalLimitController.h"
 #include "../osd/cpuEvalLimitContext.h"
 #include "../far/mesh.h"
 
+#include <cfloat>
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
@@ -79,8 +82,9 @@ class OsdUtilAdaptiveEvaluator {
 
     // Set new coarse-mesh CV positions, need to call Refine
     // before calling Get* methods.  Three floats per
-    // point packed.
-    void SetCoarsePositions(
+    // point packed.  Returns false if the positions do not fit the
+    // coarse vertices.
+    bool SetCoarsePositions(
         const float *coords, int numFloats,
         std::string *errorMessage = NULL
         );
@@ -95,13 +99,63 @@ class OsdUtilAdaptiveEvaluator {
 
     void EvaluateLimit(
         const OpenSubdiv::OsdEvalCoords &coords,
-	float P[3], float dPdu[3], float dPdv[3]);
+	float P[3], float dPdu[3], float dPdv[3]) const;
 
+    // Evaluates the limit surface at numSamples locations given by their
+    // ptex face, u and v. P, dPdu and dPdv hold three floats per sample,
+    // the derivative pointers can be NULL. The samples that land in holes
+    // or on invalid faces are left untouched. Returns the number of samples
+    // evaluated.
+    //
+    // The limit evaluation methods only read the evaluator : several
+    // threads can evaluate concurrently, as long as the positions are not
+    // set or refined meanwhile.
+    //
+    // If numThreads is 1, use single cpu.  If numThreads > 1 use Omp and set
+    // number of omp threads.
+    //
+    int EvaluateLimit(
+        int numSamples,
+        const int *faces, const float *u, const float *v,
+        float *P, float *dPdu, float *dPdv,
+        int numThreads = 1) const;
+
+    // Projects numPoints points (three floats per point) onto the closest
+    // point of the limit surface and returns its ptex face, u and v (which
+    // can be passed to EvaluateLimit) and optionally the distance to the
+    // surface. The points farther than maxDistance from the surface, or
+    // which cannot be projected (no patches, holes), get a face of -1.
+    // Returns the number of points projected.
+    //
+    // The patch hierarchy used by the projection (OsdCpuEvalLimitBVH) is
+    // built or refit by the first projection after a Refine : unlike the
+    // limit evaluation, the first projection of a pose must not run
+    // concurrently with other projections.
+    //
+    // If numThreads is 1, use single cpu.  If numThreads > 1 use Omp and set
+    // number of omp threads.
+    //
+    int ProjectPoints(
+        int numPoints, const float *points,
+        int *faces, float *u, float *v, float *distances,
+        float maxDistance = FLT_MAX,
+        int numThreads = 1);
+
+    // Tessellates the limit surface (see OsdUtilTessellator) : tessRate
+    // segments along each coarse edge, or the optional per face-edge
+    // edgeRates. The shared vertices of the faces are only output once.
+    //
+    // If numThreads is 1, use single cpu.  If numThreads > 1 use Omp and set
+    // number of omp threads.
+    //
     bool GetRefinedTopology(
         OsdUtilSubdivTopology *t,
         //positions will have three floats * t->numVertices
 	std::vector<float> *positions,
-        std::string *errorMessage = NULL);    
+        std::string *errorMessage = NULL,
+        int tessRate = 4,
+        const std::vector<int> *edgeRates = NULL,
+        int numThreads = 1);    
     
     // Forward these calls through to the refiner, which may forward
     // to the mesh.  Make these top level API calls on the evaluator
@@ -132,8 +186,16 @@ class OsdUtilAdaptiveEvaluator {
 
     OpenSubdiv::OsdCpuComputeContext *_computeContext;
     OpenSubdiv::OsdCpuEvalLimitContext *_evalLimitContext;
+    // Bound to the refined vertices, with the Gregory patches of the last
+    // Refine cached
+    OpenSubdiv::OsdCpuEvalLimitController _evalLimitController;
     OpenSubdiv::OsdCpuVertexBuffer *_vertexBuffer;
     OpenSubdiv::OsdCpuVertexBuffer *_vvBuffer; // not yet used
+
+    // Patch hierarchy of the closest point projections, created by the
+    // first projection and refit for the new poses
+    OpenSubdiv::OsdCpuEvalLimitBVH *_limitBVH;
+    bool _limitBVHValid;
 };
 
 
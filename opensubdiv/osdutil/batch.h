@@ -28,8 +28,20 @@
 #include "../version.h"
 #include "../far/patchTables.h"
 #include "../osd/vertexDescriptor.h"
+#include "../osd/cpuComputeController.h"
 #include "../osdutil/multiMeshFactory.h"
 
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #include <omp.h>
+#endif
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <sys/time.h>
+#endif
+
+#include <algorithm>
 #include <vector>
 
 namespace OpenSubdiv {
@@ -87,6 +99,15 @@ public:
 
     int GetNumPtexFaces() const { return _numPtexFaces; }
 
+    int GetNumMeshes() const { return (int)_entries.size(); }
+
+    bool IsMeshDirty(int meshIndex) const { return _dirtyFlags[meshIndex]; }
+
+    // returns the time (in seconds) spent refining the mesh during the last
+    // parallel update, or 0 if the mesh was not dirty
+    double GetMeshRefineTime(int meshIndex) const
+        { return _refineTimes[meshIndex]; }
+
 protected:
     OsdUtilMeshBatchBase() {}
 
@@ -102,6 +123,13 @@ protected:
 
     void populateDirtyKernelBatches(FarKernelBatchVector &result);
 
+    // splits the dirty kernel batches by mesh index (clean meshes get an
+    // empty vector)
+    void populateDirtyKernelBatches(std::vector<FarKernelBatchVector> &result);
+
+    void setMeshRefineTime(int meshIndex, double seconds)
+        { _refineTimes[meshIndex] = seconds; }
+
 private:
     // compute batch
     FarKernelBatchVector _allKernelBatches;
@@ -112,6 +140,9 @@ private:
     // update flags
     std::vector<bool>          _dirtyFlags;   // same size as _entries
 
+    // timings of the last parallel update
+    std::vector<double>        _refineTimes;  // same size as _entries
+
     int _numVertices;
     int _numPtexFaces;
     int _batchIndex;
@@ -200,6 +231,20 @@ public:
         _computeController->Refine(_computeContext, batches, _vertexBuffer, _varyingBuffer);
     }
 
+    // Refines the dirty meshes as independent tasks : the kernel batches of
+    // each mesh only touch the vertices of that mesh, so instead of running
+    // the batches of all the meshes back to back, every mesh is refined
+    // serially by its own task and the tasks are spread over the threads.
+    //
+    // This path requires a CPU compute context and a vertex buffer exposing
+    // its data through BindCpuBuffer(). The compute controller of the batch
+    // is not used.
+    //
+    // numThreads : number of threads (-1 uses the OpenMP default). Without
+    //              OpenMP the meshes are refined serially.
+    //
+    void FinalizeUpdateParallel(int numThreads=-1);
+
     VertexBuffer *GetVertexBuffer() const { return _vertexBuffer; }
 
     VertexBuffer *GetVaryingBuffer() const { return _varyingBuffer; }
@@ -224,6 +269,28 @@ private:
                     int batchIndex,
                     bool requireFVarData);
 
+    // Binds a vertex buffer once for all the tasks of a parallel update :
+    // some buffers (e.g. OsdCpuGLVertexBuffer) flag themselves dirty when
+    // bound, which must not happen concurrently.
+    class CpuBufferBinding {
+    public:
+        CpuBufferBinding(VertexBuffer *buffer) :
+            _data(buffer ? buffer->BindCpuBuffer() : NULL),
+            _numElements(buffer ? buffer->GetNumElements() : 0) { }
+
+        float * BindCpuBuffer() const { return _data; }
+
+        int GetNumElements() const { return _numElements; }
+
+    private:
+        float *_data;
+        int _numElements;
+    };
+
+    // wall clock time (in seconds) : the tasks run concurrently, so the CPU
+    // time of the process would not measure them
+    static double getTime();
+
     ComputeController *_computeController;
     ComputeContext *_computeContext;
 
@@ -256,6 +323,8 @@ OsdUtilMeshBatchBase<DRAW_CONTEXT>::initialize(OsdUtilMeshBatchEntryVector const
     _dirtyFlags.resize(entries.size());
     resetMeshDirty();
 
+    _refineTimes.resize(entries.size(), 0.0);
+
     return true;
 }
 
@@ -292,6 +361,20 @@ OsdUtilMeshBatchBase<DRAW_CONTEXT>::populateDirtyKernelBatches(FarKernelBatchVec
     }
 }
 
+template <typename DRAW_CONTEXT> void
+OsdUtilMeshBatchBase<DRAW_CONTEXT>::populateDirtyKernelBatches(std::vector<FarKernelBatchVector> &result) {
+
+    result.clear();
+    result.resize(_entries.size());
+    for (FarKernelBatchVector::const_iterator it = _allKernelBatches.begin();
+         it != _allKernelBatches.end(); ++it) {
+        int meshIndex = it->GetMeshIndex();
+        if (_dirtyFlags[meshIndex]) {
+            result[meshIndex].push_back(*it);
+        }
+    }
+}
+
 // -----------------------------------------------------------------------------
 inline FarMesh<OsdVertex> *
 createMultiMesh(std::vector<FarMesh<OsdVertex> const * > const & meshVector,
@@ -415,6 +498,74 @@ OsdUtilMeshBatch<VERTEX_BUFFER, DRAW_CONTEXT, COMPUTE_CONTROLLER>::initialize(Fa
     return true;
 }
 
+template <typename VERTEX_BUFFER, typename DRAW_CONTEXT, typename COMPUTE_CONTROLLER> double
+OsdUtilMeshBatch<VERTEX_BUFFER, DRAW_CONTEXT, COMPUTE_CONTROLLER>::getTime() {
+#if defined(_WIN32)
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timeval t;
+    gettimeofday(&t, 0);
+    return t.tv_sec + t.tv_usec/1000000.0;
+#endif
+}
+
+template <typename VERTEX_BUFFER, typename DRAW_CONTEXT, typename COMPUTE_CONTROLLER> void
+OsdUtilMeshBatch<VERTEX_BUFFER, DRAW_CONTEXT, COMPUTE_CONTROLLER>::FinalizeUpdateParallel(int numThreads) {
+
+    if (not _computeContext)
+        return;
+
+    std::vector<FarKernelBatchVector> meshBatches;
+    Base::populateDirtyKernelBatches(meshBatches);
+    Base::resetMeshDirty();
+
+    // one task per dirty mesh, weighted by the number of vertices it refines.
+    // the most expensive tasks are scheduled first so that the tail of the
+    // loop is made of small tasks that balance the load.
+    std::vector<std::pair<int, int> > tasks;
+    for (int i = 0; i < (int)meshBatches.size(); ++i) {
+        Base::setMeshRefineTime(i, 0.0);
+        if (meshBatches[i].empty())
+            continue;
+        int cost = 0;
+        for (int j = 0; j < (int)meshBatches[i].size(); ++j) {
+            cost += meshBatches[i][j].GetEnd() - meshBatches[i][j].GetStart();
+        }
+        tasks.push_back(std::make_pair(-cost, i));
+    }
+    std::sort(tasks.begin(), tasks.end());
+
+    CpuBufferBinding vertexBinding(_vertexBuffer),
+                     varyingBinding(_varyingBuffer);
+
+    ComputeContext const *context = _computeContext;
+    int numTasks = (int)tasks.size();
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    if (numThreads < 1)
+        numThreads = omp_get_max_threads();
+#pragma omp parallel for schedule(dynamic, 1) num_threads(numThreads)
+#else
+    (void)numThreads;
+#endif
+    for (int i = 0; i < numTasks; ++i) {
+        int meshIndex = tasks[i].second;
+
+        double start = getTime();
+
+        // the controller holds the bind state, so each task needs its own
+        OsdCpuComputeController controller;
+        controller.Refine(context, meshBatches[meshIndex],
+                          _vertexBuffer ? &vertexBinding : NULL,
+                          _varyingBuffer ? &varyingBinding : NULL);
+
+        Base::setMeshRefineTime(meshIndex, getTime() - start);
+    }
+}
+
 template <typename VERTEX_BUFFER, typename DRAW_CONTEXT, typename COMPUTE_CONTROLLER>
 OsdUtilMeshBatch<VERTEX_BUFFER, DRAW_CONTEXT, COMPUTE_CONTROLLER>::~OsdUtilMeshBatch() {
     delete _computeContext;
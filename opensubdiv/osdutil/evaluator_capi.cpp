@@ -53,6 +53,10 @@ typedef struct OpenSubdiv_EvaluatorDescr {
     OsdUtilSubdivTopology topology;
     OsdUtilAdaptiveEvaluator evaluator;
     // std::vector<float> coarsePositions;
+
+    // tessellation returned by openSubdiv_getEvaluatorRefinedTopology
+    OsdUtilSubdivTopology refinedTopology;
+    std::vector<float> refinedPositions;
 } OpenSubdiv_EvaluatorDescr;
 
 
@@ -133,14 +137,12 @@ int openSubdiv_setEvaluatorCoarsePositions(
 {
     std::string errorMessage;
 
-    // TODO: returns void, need error check on length of positions?
-    evaluator_descr->evaluator.SetCoarsePositions(
-        positions, 3 * numVertices, &errorMessage);
-
-    if (not errorMessage.empty()) {
-        std::cout << "OpenSubdiv set coarse positions failed due to " << errorMessage << std::endl;	
+    if (not evaluator_descr->evaluator.SetCoarsePositions(
+            positions, 3 * numVertices, &errorMessage)) {
+        std::cout << "OpenSubdiv set coarse positions failed due to " << errorMessage << std::endl;
+        return 0;
     }
-    
+
     // Refine with 1 thread for now
     if (not evaluator_descr->evaluator.Refine(1, &errorMessage)) {
         std::cout << "OpenSubdiv refinement failed due to " << errorMessage << std::endl;
@@ -164,6 +166,27 @@ void openSubdiv_evaluateLimit(
     evaluation_descr->evaluator.EvaluateLimit(coords, P, dPdu, dPdv);
 }
 
+int openSubdiv_evaluateLimitArray(
+    OpenSubdiv_EvaluatorDescr *evaluation_descr,
+    int numSamples,
+    const int *face_ids, const float *u, const float *v,
+    float *P, float *dPdu, float *dPdv,
+    int numThreads)
+{
+    return evaluation_descr->evaluator.EvaluateLimit(
+        numSamples, face_ids, u, v, P, dPdu, dPdv, numThreads);
+}
+
+int openSubdiv_projectPointsToLimit(
+    OpenSubdiv_EvaluatorDescr *evaluation_descr,
+    int numPoints, const float *points, float maxDistance,
+    int *face_ids, float *u, float *v, float *distances,
+    int numThreads)
+{
+    return evaluation_descr->evaluator.ProjectPoints(
+        numPoints, points, face_ids, u, v, distances, maxDistance, numThreads);
+}
+
 void openSubdiv_getEvaluatorTopology(
     OpenSubdiv_EvaluatorDescr *evaluation_descr,
     int *numVertices,
@@ -184,6 +207,41 @@ void openSubdiv_getEvaluatorTopology(
     *nverts =  &evaluation_descr->topology.nverts[0];
 }
 
+int openSubdiv_getEvaluatorRefinedTopology(
+    OpenSubdiv_EvaluatorDescr *evaluation_descr,
+    int tessRate,
+    int numThreads,
+    int *numVertices,
+    float **positions,
+    int *numIndices,
+    int **indices,
+    int *numNVerts,
+    int **nverts)
+{
+    std::string errorMessage;
+
+    OsdUtilSubdivTopology & refined = evaluation_descr->refinedTopology;
+    std::vector<float> & refinedPositions = evaluation_descr->refinedPositions;
+
+    refined = OsdUtilSubdivTopology();
+
+    if (not evaluation_descr->evaluator.GetRefinedTopology(
+            &refined, &refinedPositions, &errorMessage,
+            tessRate, NULL, numThreads)) {
+        std::cout << "OpenSubdiv tessellation failed due to " << errorMessage << std::endl;
+        return 0;
+    }
+
+    *numVertices = refined.numVertices;
+    *positions = refinedPositions.empty() ? NULL : &refinedPositions[0];
+    *numIndices = (int)refined.indices.size();
+    *indices = refined.indices.empty() ? NULL : &refined.indices[0];
+    *numNVerts = (int)refined.nverts.size();
+    *nverts = refined.nverts.empty() ? NULL : &refined.nverts[0];
+
+    return 1;
+}
+
 OpenSubdiv_EvaluatorDescr *openSubdiv_getEvaluatorTopologyDescr(
     OpenSubdiv_EvaluatorDescr *evaluator_descr)
 {
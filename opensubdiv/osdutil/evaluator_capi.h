@@ -49,6 +49,7 @@ int openSubdiv_finishEvaluatorDescr(struct OpenSubdiv_EvaluatorDescr *evaluator_
 /* Set the positions of points on the coarse mesh and refine. This method    */
 /* will perform catmull/clark refinement on the CVs to be ready to call      */
 /* openSubdiv_evaluateDescr.  Points here are 3 floats/point.                */
+/* Returns 0 if the points do not match the coarse vertices or on error.     */
 int openSubdiv_setEvaluatorCoarsePositions(
     struct OpenSubdiv_EvaluatorDescr *evaluator_descr,
     const float *positions, int numVertices);
@@ -62,6 +63,39 @@ void openSubdiv_evaluateLimit(
     int face_id, float u, float v,
     float P[3], float dPdu[3], float dPdv[3]);
 
+/* Evaluate the limit surface at numSamples ptex faces and u/v, as        */
+/* openSubdiv_evaluateLimit does for a single sample.  P, dPdu and dPdv    */
+/* hold 3 floats/sample and the derivative pointers can be NULL.  Samples  */
+/* which fall into holes or on invalid faces are left untouched.  If       */
+/* numThreads > 1 the samples are evaluated with that many OpenMP threads. */
+/* Returns the number of samples evaluated.                                */
+/*                                                                         */
+/* The limit evaluation functions are reentrant : several threads can      */
+/* evaluate the same evaluator descriptor concurrently, as long as its     */
+/* coarse positions are not set at the same time.                          */
+int openSubdiv_evaluateLimitArray(
+    struct OpenSubdiv_EvaluatorDescr *evaluation_descr,
+    int numSamples,
+    const int *face_ids, const float *u, const float *v,
+    float *P, float *dPdu, float *dPdv,
+    int numThreads);
+
+/* Project numPoints points (3 floats/point) onto the closest point of the  */
+/* limit surface, returning its ptex face and u/v, which can be passed to   */
+/* openSubdiv_evaluateLimit, and the distance to the surface (distances can */
+/* be NULL).  Points farther than maxDistance (or with no surface to        */
+/* project onto, such as holes) get a face_id of -1.  If numThreads > 1 the */
+/* points are projected with that many OpenMP threads.  Returns the number  */
+/* of points projected.                                                     */
+/*                                                                          */
+/* The first projection after the coarse positions are set updates the     */
+/* bounds of the patches : it must not run concurrently with others.        */
+int openSubdiv_projectPointsToLimit(
+    struct OpenSubdiv_EvaluatorDescr *evaluation_descr,
+    int numPoints, const float *points, float maxDistance,
+    int *face_ids, float *u, float *v, float *distances,
+    int numThreads);
+
 /* Get topology stored in the evaluator descriptor in order to be able */
 /* to check whether it still matches the mesh topology one is going to */
 /* evaluate.                                                           */
@@ -74,6 +108,22 @@ void openSubdiv_getEvaluatorTopology(
     int *numNVerts,
     int **nverts);
 
+/* Tessellate the limit surface with tessRate segments along each edge of  */
+/* the coarse faces. The vertices shared by the faces are only output once. */
+/* The returned arrays are owned by the evaluator descriptor and are valid  */
+/* until the next call or until the descriptor is deleted. Positions are 3  */
+/* floats/point. Returns 0 on error.                                        */
+int openSubdiv_getEvaluatorRefinedTopology(
+    struct OpenSubdiv_EvaluatorDescr *evaluation_descr,
+    int tessRate,
+    int numThreads,
+    int *numVertices,
+    float **positions,
+    int *numIndices,
+    int **indices,
+    int *numNVerts,
+    int **nverts);
+
 /* Get pointer to a topology descriptor object.                            */
 /* Useful for cases when some parts of the pipeline needs to know the      */
 /* topology object. For example this way it's possible to create a HbrMesh */
@@ -0,0 +1,204 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OSDUTIL_ISOLATION_LEVELS_H
+#define OSDUTIL_ISOLATION_LEVELS_H
+
+#include "../version.h"
+#include "topology.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+// OsdUtilIsolationLevels computes per-face isolation budgets for the coarse
+// faces of a subdivision surface. The budgets can be passed to the
+// FarMeshFactory constructor, so that the features of the faces that are far
+// away from the camera (or small) are isolated less deeply than the faces that
+// fill the screen.
+//
+// The budgets are only baked into the FarMesh when it is created : a new
+// FarMesh has to be built when the camera moves significantly.
+//
+class OsdUtilIsolationLevels {
+public:
+
+    // Computes the number of levels of subdivision required for the longest
+    // edge of each coarse face to be shorter than targetEdgeLength, clamped
+    // to [0, maxLevel].
+    //
+    // positions : 3 floats per vertex of the topology
+    //
+    // viewProjection : optional column-major (OpenGL) 4x4 matrix. If it is
+    //                  specified, the edge lengths are measured in normalized
+    //                  device coordinates and the faces outside of the view
+    //                  frustum are not isolated. Faces crossing the eye plane
+    //                  are isolated to maxLevel.
+    //
+    static void ComputeFaceLevels(OsdUtilSubdivTopology const &topology,
+                                  float const *positions,
+                                  float targetEdgeLength,
+                                  int maxLevel,
+                                  std::vector<int> *faceLevels,
+                                  float const *viewProjection = NULL);
+
+    // Converts per-vertex isolation levels into per-face isolation levels
+    // (each face receives the highest level of its vertices).
+    static void ComputeFaceLevels(OsdUtilSubdivTopology const &topology,
+                                  std::vector<int> const &vertexLevels,
+                                  std::vector<int> *faceLevels);
+
+private:
+
+    // Number of halvings required for 'length' to fall below 'target'
+    static int computeLevel(float length, float target, int maxLevel) {
+        int level = 0;
+        while (length > target and level < maxLevel) {
+            length *= 0.5f;
+            ++level;
+        }
+        return level;
+    }
+};
+
+inline void
+OsdUtilIsolationLevels::ComputeFaceLevels(OsdUtilSubdivTopology const &topology,
+                                          float const *positions,
+                                          float targetEdgeLength,
+                                          int maxLevel,
+                                          std::vector<int> *faceLevels,
+                                          float const *viewProjection) {
+
+    assert(positions and faceLevels and targetEdgeLength > 0.0f);
+
+    int nfaces = (int)topology.nverts.size();
+
+    faceLevels->resize(nfaces);
+
+    // Transform the vertices into clip space
+    std::vector<float> clip;
+    if (viewProjection) {
+        float const *m = viewProjection;
+        clip.resize(topology.numVertices * 4);
+        for (int i = 0; i < topology.numVertices; ++i) {
+            float const *p = positions + i * 3;
+            for (int j = 0; j < 4; ++j) {
+                clip[i*4+j] = m[j]*p[0] + m[4+j]*p[1] + m[8+j]*p[2] + m[12+j];
+            }
+        }
+    }
+
+    int const *indices = topology.indices.empty() ? NULL : &topology.indices[0];
+
+    for (int face = 0; face < nfaces; indices += topology.nverts[face++]) {
+
+        int nv = topology.nverts[face];
+
+        float maxLength = 0.0f;
+
+        if (viewProjection) {
+
+            // Cull the faces which have all their vertices on the outer side
+            // of one of the frustum planes
+            bool culled = false, crossesEyePlane = false;
+            for (int plane = 0; plane < 6 and (not culled); ++plane) {
+                int axis = plane / 2;
+                float sign = (plane % 2) ? -1.0f : 1.0f;
+
+                culled = true;
+                for (int j = 0; j < nv and culled; ++j) {
+                    float const *c = &clip[indices[j]*4];
+                    culled = (sign * c[axis] > c[3]);
+                }
+            }
+
+            for (int j = 0; j < nv; ++j) {
+                if (clip[indices[j]*4+3] <= 0.0f)
+                    crossesEyePlane = true;
+            }
+
+            if (culled) {
+                (*faceLevels)[face] = 0;
+                continue;
+            }
+
+            if (crossesEyePlane) {
+                (*faceLevels)[face] = maxLevel;
+                continue;
+            }
+
+            for (int j = 0; j < nv; ++j) {
+                float const *c0 = &clip[indices[j]*4],
+                            *c1 = &clip[indices[(j+1)%nv]*4];
+                float dx = c0[0]/c0[3] - c1[0]/c1[3],
+                      dy = c0[1]/c0[3] - c1[1]/c1[3];
+                maxLength = std::max(maxLength, sqrtf(dx*dx + dy*dy));
+            }
+        } else {
+
+            for (int j = 0; j < nv; ++j) {
+                float const *p0 = positions + indices[j]*3,
+                            *p1 = positions + indices[(j+1)%nv]*3;
+                float dx = p0[0]-p1[0],
+                      dy = p0[1]-p1[1],
+                      dz = p0[2]-p1[2];
+                maxLength = std::max(maxLength, sqrtf(dx*dx + dy*dy + dz*dz));
+            }
+        }
+
+        (*faceLevels)[face] = computeLevel(maxLength, targetEdgeLength, maxLevel);
+    }
+}
+
+inline void
+OsdUtilIsolationLevels::ComputeFaceLevels(OsdUtilSubdivTopology const &topology,
+                                          std::vector<int> const &vertexLevels,
+                                          std::vector<int> *faceLevels) {
+
+    assert(faceLevels and (int)vertexLevels.size() >= topology.numVertices);
+
+    int nfaces = (int)topology.nverts.size();
+
+    faceLevels->assign(nfaces, 0);
+
+    int const *indices = topology.indices.empty() ? NULL : &topology.indices[0];
+
+    for (int face = 0; face < nfaces; indices += topology.nverts[face++]) {
+        for (int j = 0; j < topology.nverts[face]; ++j) {
+            (*faceLevels)[face] = std::max((*faceLevels)[face],
+                                           vertexLevels[indices[j]]);
+        }
+    }
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSDUTIL_ISOLATION_LEVELS_H
@@ -205,9 +205,10 @@ OsdUtilMesh<T>::Initialize(const OsdUtilSubdivTopology &topology,
 
         // The ptex index isn't a straight-up polygon index; rather,
         // it's an index into a "minimally quadrangulated" base mesh.
-        // Take all non-rect polys and subdivide them once.
+        // Take all non-rect polys and subdivide them once (Loop faces
+        // are triangular ptex faces).
         hface->SetPtexIndex(ptexIndex);
-        ptexIndex += (nv == 4) ? 1 : nv;
+        ptexIndex += (nv == 4 or scheme == SCHEME_LOOP) ? 1 : nv;
 
         // prideout: 3/21/2013 - Inspired by "GetFVarData" in examples/mayaViewer/hbrUtil.cpp
         if (!_t.fvNames.empty()) {
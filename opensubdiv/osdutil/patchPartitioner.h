@@ -128,10 +128,17 @@ OsdUtilPatchPartitioner::OsdUtilPatchPartitioner(FarPatchTables const *srcPatchT
     FarPatchTables::PTable newPTable;
     FarPatchTables::QuadOffsetTable newQuadOffsetTable;
     std::vector<float> newFVarDataTable;
-    bool hasFVarData = !srcFVarData.GetAllData().empty() &&
-        srcFVarData.GetData(1) == NULL; // multi-level face-varying data not supported
+    std::vector<unsigned int> newFVarIndexTable;
+    bool hasFVarData = srcFVarData.GetNumVertices() > 0 &&
+        srcFVarData.GetNumLevels() == 1; // multi-level face-varying data not supported
     int fvarWidth = hasFVarData ? srcFVarData.GetFVarWidth() : 0;
 
+    // indexed face-varying data : only the indices are reordered, the
+    // values are shared by all the partitions
+    bool isFVarIndexed = hasFVarData && srcFVarData.IsIndexed();
+    if (isFVarIndexed)
+        newFVarDataTable = srcFVarData.GetValues();
+
     // iterate over all patch
     for (FarPatchTables::PatchArrayVector::const_iterator paIt =
         srcPatchTables->GetPatchArrayVector().begin();
@@ -143,6 +150,7 @@ OsdUtilPatchPartitioner::OsdUtilPatchPartitioner(FarPatchTables const *srcPatchT
         int patchOffset = (int)newPatchParamTable.size();
         int quadOffsetOffset = (int)newQuadOffsetTable.size();
         int fvarOffset = (int)newFVarDataTable.size();
+        int fvarIndexOffset = (int)newFVarIndexTable.size();
 
         // shuffle this range in partition order
         std::vector<std::pair<int, int> > sortProxy(paIt->GetNumPatches());
@@ -185,7 +193,13 @@ OsdUtilPatchPartitioner::OsdUtilPatchPartitioner(FarPatchTables const *srcPatchT
             }
 
             // reorder corresponding face-varying table entry
-            if (hasFVarData) {
+            if (isFVarIndexed) {
+                int fvarVerts = desc.GetType() == FarPatchTables::TRIANGLES ? 3 : 4;
+                for (int j = 0; j < fvarVerts; ++j) {
+                    newFVarIndexTable.push_back(
+                        srcFVarData.GetIndices()[patchIndex*fvarVerts+j + fvarIndexOffset]);
+                }
+            } else if (hasFVarData) {
                 int fvarVerts = desc.GetType() == FarPatchTables::TRIANGLES ? 3 : 4;
                 for (int j = 0; j < fvarVerts * fvarWidth; ++j) {
                     newFVarDataTable.push_back(
@@ -217,7 +231,8 @@ OsdUtilPatchPartitioner::OsdUtilPatchPartitioner(FarPatchTables const *srcPatchT
                                   &newPatchParamTable,
                                   hasFVarData ? &newFVarDataTable : NULL,
                                   fvarWidth,
-                                  srcPatchTables->GetMaxValence());
+                                  srcPatchTables->GetMaxValence(),
+                                  isFVarIndexed ? &newFVarIndexTable : NULL);
 }
 
 }  // end namespace OPENSUBDIV_VERSION
@@ -80,6 +80,7 @@ OsdUtilRefiner::Initialize(
             _mesh->GetHbrMesh(), t.refinementLevel, true);
 
         _farMesh = adaptiveMeshFactory.Create();
+        _remapTable = adaptiveMeshFactory.GetRemappingTable();
 
     } else {
         // XXX:gelder
@@ -89,6 +90,7 @@ OsdUtilRefiner::Initialize(
             _mesh->GetHbrMesh(), t.refinementLevel, false, /*firstLevel*/1);
 
         _farMesh = uniformMeshFactory.Create();
+        _remapTable = uniformMeshFactory.GetRemappingTable();
     }
 
     //
@@ -111,6 +111,9 @@ class OsdUtilRefiner  {
 
     int GetNumRefinedVertices() { return _numRefinedVerts;}
     int GetFirstVertexOffset() { return _firstVertexOffset;}    
+
+    // Maps Hbr vertex IDs to the vertex indices of the FarMesh
+    const std::vector<int> &GetRemappingTable() const { return _remapTable; }
            
   private:
 
@@ -134,6 +137,9 @@ class OsdUtilRefiner  {
     // adaptive code in far result in very different meshes
     OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex>*  _farMesh;
 
+    // Hbr vertex ID to FarMesh vertex index, kept from the mesh factory
+    std::vector<int> _remapTable;
+
     // Cached counts within _farMesh
     /// XXX: Maybe not cache, get from far mesh each time?    
     int _firstVertexOffset; 
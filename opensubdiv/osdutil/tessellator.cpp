@@ -0,0 +1,649 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "tessellator.h"
+
+#include "../far/patchMap.h"
+#include "../osd/cpuEvalLimitKernel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <map>
+
+using namespace std;
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+OsdUtilTessellator::OsdUtilTessellator() :
+    _patchTables(NULL),
+    _numGregoryPatches(0)
+{
+}
+
+// Ptex face and (u,v) of the point at 't' along the edge 'edge' of a coarse
+// face with 'nsides' vertices (t==0 is the first vertex of the edge)
+static void
+_EdgeCoord(int nsides, bool triangles, int edge, float t,
+           int *subface, float *u, float *v)
+{
+    *subface = 0;
+
+    if (triangles) {
+        switch (edge) {
+            case 0 : *u=t;      *v=0.0f;   break;
+            case 1 : *u=1.0f-t; *v=t;      break;
+            case 2 : *u=0.0f;   *v=1.0f-t; break;
+        }
+    } else if (nsides==4) {
+        switch (edge) {
+            case 0 : *u=t;      *v=0.0f;   break;
+            case 1 : *u=1.0f;   *v=t;      break;
+            case 2 : *u=1.0f-t; *v=1.0f;   break;
+            case 3 : *u=0.0f;   *v=1.0f-t; break;
+        }
+    } else {
+        // sub-face i covers vertex i : u runs along the first half of edge i
+        // and v along the second half of edge i-1
+        if (t<=0.5f) {
+            *subface = edge;
+            *u = 2.0f*t;
+            *v = 0.0f;
+        } else {
+            *subface = (edge+1)%nsides;
+            *u = 0.0f;
+            *v = 2.0f*(1.0f-t);
+        }
+    }
+}
+
+// Computes the weights of the control vertices of a patch at (u,v) by
+// evaluating the patch kernel on an identity matrix. Returns the number of
+// weights (0 if the patch has to be evaluated with its kernel)
+static int
+_ComputeBasis(FarPatchTables::Type type, float u, float v, vector<float> & weights)
+{
+    int ncvs=0;
+    switch (type) {
+        case FarPatchTables::REGULAR          : ncvs=16; break;
+        case FarPatchTables::BOUNDARY         : ncvs=12; break;
+        case FarPatchTables::CORNER           : ncvs=9;  break;
+        case FarPatchTables::GREGORY          :
+        case FarPatchTables::GREGORY_BOUNDARY : ncvs=20; break;
+        case FarPatchTables::LOOP             : ncvs=12; break;
+        default:
+            return 0;
+    }
+
+    vector<float> identity(ncvs*ncvs, 0.0f);
+    vector<unsigned int> indices(ncvs);
+    for (int i=0; i<ncvs; ++i) {
+        identity[i*ncvs+i] = 1.0f;
+        indices[i] = i;
+    }
+
+    OsdVertexBufferDescriptor desc(0, ncvs, ncvs);
+
+    weights.resize(ncvs);
+
+    // note : the kernels of quad patches take (v,u)
+    switch (type) {
+        case FarPatchTables::REGULAR  :
+            evalBSpline(v, u, &indices[0], desc, &identity[0], desc, &weights[0], 0, 0); break;
+        case FarPatchTables::BOUNDARY :
+            evalBoundary(v, u, &indices[0], desc, &identity[0], desc, &weights[0], 0, 0); break;
+        case FarPatchTables::CORNER   :
+            evalCorner(v, u, &indices[0], desc, &identity[0], desc, &weights[0], 0, 0); break;
+        case FarPatchTables::GREGORY  :
+        case FarPatchTables::GREGORY_BOUNDARY :
+            evalGregoryPoints(v, u, &identity[0], ncvs, desc, &weights[0], 0, 0); break;
+        case FarPatchTables::LOOP     :
+            evalLoop(u, v, &indices[0], desc, &identity[0], desc, &weights[0], 0, 0); break;
+        default:
+            assert(0);
+    }
+    return ncvs;
+}
+
+bool
+OsdUtilTessellator::Initialize(const OsdUtilSubdivTopology &topology,
+                               const FarPatchTables *patchTables,
+                               int tessRate,
+                               const vector<int> *edgeRates,
+                               string *errorMessage)
+{
+    if (not (patchTables and patchTables->IsFeatureAdaptive())) {
+        if (errorMessage)
+            *errorMessage = "Tessellator requires feature adaptive patch tables";
+        return false;
+    }
+
+    if (tessRate<1) {
+        if (errorMessage)
+            *errorMessage = "Invalid tessellation rate";
+        return false;
+    }
+
+    if (edgeRates and edgeRates->size()!=topology.indices.size()) {
+        if (errorMessage)
+            *errorMessage = "Edge rates do not match the topology";
+        return false;
+    }
+
+    _patchTables = patchTables;
+
+    _coords.clear();
+    _samples.clear();
+    _basisOffsets.clear();
+    _weights.clear();
+    _nverts.clear();
+    _indices.clear();
+
+    FarPatchTables::PatchArrayVector const & parrays = patchTables->GetPatchArrayVector();
+
+    // Loop meshes have one triangular ptex face per coarse face
+    bool triangles = false;
+    for (int i=0; i<(int)parrays.size(); ++i) {
+        FarPatchTables::Type type = parrays[i].GetDescriptor().GetType();
+        if (type==FarPatchTables::LOOP or type==FarPatchTables::LOOP_IRREGULAR)
+            triangles = true;
+    }
+
+    int nfaces = (int)topology.nverts.size();
+
+    // Coarse edges and their rates
+    map<pair<int, int>, int> edgeMap;
+    vector<int> faceEdges(topology.indices.size()),
+                rates;
+
+    for (int face=0, ofs=0; face<nfaces; ofs+=topology.nverts[face++]) {
+        int nv = topology.nverts[face];
+        for (int i=0; i<nv; ++i) {
+            int a = topology.indices[ofs+i],
+                b = topology.indices[ofs+(i+1)%nv];
+
+            pair<int, int> key(min(a,b), max(a,b));
+
+            map<pair<int, int>, int>::iterator it = edgeMap.find(key);
+            if (it==edgeMap.end()) {
+                it = edgeMap.insert(make_pair(key, (int)rates.size())).first;
+                rates.push_back(1);
+            }
+            faceEdges[ofs+i] = it->second;
+
+            int rate = edgeRates ? max(1, (*edgeRates)[ofs+i]) : tessRate;
+            rates[it->second] = max(rates[it->second], rate);
+        }
+    }
+
+    // the edges of non-quads are split between 2 sub-faces
+    if (not triangles) {
+        for (int face=0, ofs=0; face<nfaces; ofs+=topology.nverts[face++]) {
+            int nv = topology.nverts[face];
+            if (nv!=4) {
+                for (int i=0; i<nv; ++i) {
+                    int & rate = rates[faceEdges[ofs+i]];
+                    rate += rate & 1;
+                }
+            }
+        }
+    }
+
+    FarPatchMap patchMap(*patchTables);
+
+    // Tessellate the faces : the corner and edge vertices are created by the
+    // first face that uses them
+    vector<int> cornerVerts(topology.numVertices, -1),
+                edgeVerts(rates.size(), -1);
+
+    _faceVertexOffsets.resize(nfaces+1);
+
+    for (int face=0, ofs=0, ptex=0; face<nfaces; ofs+=topology.nverts[face++]) {
+
+        _faceVertexOffsets[face] = (int)_coords.size();
+
+        int nv = topology.nverts[face],
+            nptex = (triangles or nv==4) ? 1 : nv;
+
+        int const * fverts = &topology.indices[ofs];
+
+        // skip holes
+        if (not patchMap.FindPatch(ptex, triangles ? 0.25f : 0.5f,
+                                         triangles ? 0.25f : 0.5f)) {
+            ptex += nptex;
+            continue;
+        }
+
+        int rate = 1;
+
+        for (int i=0; i<nv; ++i) {
+            if (cornerVerts[fverts[i]]<0) {
+                int subface; float u, v;
+                _EdgeCoord(nv, triangles, i, 0.0f, &subface, &u, &v);
+                cornerVerts[fverts[i]] = addVertex(ptex+subface, u, v);
+            }
+            rate = max(rate, rates[faceEdges[ofs+i]]);
+        }
+
+        // vertices along each edge of the face, in the face winding
+        vector<vector<int> > edges(nv);
+
+        for (int i=0; i<nv; ++i) {
+
+            int edge = faceEdges[ofs+i],
+                r = rates[edge];
+
+            // edge vertices are created from the first to the last vertex ID
+            bool forward = fverts[i] < fverts[(i+1)%nv];
+
+            if (edgeVerts[edge]<0) {
+                edgeVerts[edge] = (int)_coords.size();
+                for (int j=1; j<r; ++j) {
+                    float t = float(j)/float(r);
+                    int subface; float u, v;
+                    _EdgeCoord(nv, triangles, i, forward ? t : 1.0f-t, &subface, &u, &v);
+                    addVertex(ptex+subface, u, v);
+                }
+            }
+
+            vector<int> & points = edges[i];
+            points.push_back(cornerVerts[fverts[i]]);
+            for (int j=1; j<r; ++j)
+                points.push_back(edgeVerts[edge] + (forward ? j-1 : r-1-j));
+            points.push_back(cornerVerts[fverts[(i+1)%nv]]);
+        }
+
+        if (triangles) {
+
+            tessellateTriangle(ptex, rate, &edges[0]);
+
+        } else if (nv==4) {
+
+            tessellateQuad(ptex, rate, &edges[0]);
+
+        } else {
+
+            // sub-faces : half of the face rate, with the edges between
+            // sub-faces running from the edge mid-points to the center
+            int subrate = max(1, (rate+1)/2);
+
+            int center = addVertex(ptex, 1.0f, 1.0f);
+
+            vector<vector<int> > spokes(nv);
+            for (int i=0; i<nv; ++i) {
+                spokes[i].push_back(edges[i][edges[i].size()/2]);
+                for (int j=1; j<subrate; ++j)
+                    spokes[i].push_back(addVertex(ptex+i, 1.0f, float(j)/float(subrate)));
+                spokes[i].push_back(center);
+            }
+
+            for (int i=0; i<nv; ++i) {
+
+                vector<int> const & next = edges[i],
+                                 & prev = edges[(i+nv-1)%nv];
+
+                vector<int> sides[4];
+                sides[0].assign(next.begin(), next.begin()+next.size()/2+1);
+                sides[1] = spokes[i];
+                sides[2].assign(spokes[(i+nv-1)%nv].rbegin(), spokes[(i+nv-1)%nv].rend());
+                sides[3].assign(prev.begin()+prev.size()/2, prev.end());
+
+                tessellateQuad(ptex+i, subrate, sides);
+            }
+        }
+
+        ptex += nptex;
+    }
+    _faceVertexOffsets[nfaces] = (int)_coords.size();
+
+    // Locate the vertices in the patches and share the basis weights of the
+    // vertices that land at the same location of a same type of patch
+    typedef pair<int, pair<float, float> > BasisKey;
+    map<BasisKey, int> bases;
+
+    FarPatchTables::PatchParamTable const & params = patchTables->GetPatchParamTable();
+
+    _basisOffsets.push_back(0);
+    _samples.resize(_coords.size());
+
+    vector<float> weights;
+    for (int i=0; i<(int)_coords.size(); ++i) {
+
+        Coord const & coord = _coords[i];
+        Sample & sample = _samples[i];
+
+        sample.basis = -1;
+        sample.patchArray = -1;
+        sample.vertexOffset = 0;
+        sample.u = coord.u;
+        sample.v = coord.v;
+
+        FarPatchMap::Handle const * handle = patchMap.FindPatch(coord.face, coord.u, coord.v);
+        if (not handle)
+            continue;
+
+        FarPatchParam::BitField bits = params[handle->patchIdx].bitField;
+        bits.Normalize(sample.u, sample.v);
+        bits.Rotate(sample.u, sample.v);
+
+        sample.patchArray = handle->patchArrayIdx;
+        sample.vertexOffset = handle->vertexOffset;
+
+        FarPatchTables::Type type = parrays[handle->patchArrayIdx].GetDescriptor().GetType();
+
+        BasisKey key(type, make_pair(sample.u, sample.v));
+
+        map<BasisKey, int>::iterator it = bases.find(key);
+        if (it!=bases.end()) {
+            sample.basis = it->second;
+        } else if (_ComputeBasis(type, sample.u, sample.v, weights)) {
+            sample.basis = (int)_basisOffsets.size()-1;
+            _weights.insert(_weights.end(), weights.begin(), weights.end());
+            _basisOffsets.push_back((int)_weights.size());
+            bases[key] = sample.basis;
+        }
+    }
+
+    vector<Coord>().swap(_coords);
+
+    // Gregory patches
+    _numGregoryPatches = 0;
+    _gregoryOffsets.assign(parrays.size(), -1);
+    for (int i=0; i<(int)parrays.size(); ++i) {
+        FarPatchTables::Type type = parrays[i].GetDescriptor().GetType();
+        if (type==FarPatchTables::GREGORY or type==FarPatchTables::GREGORY_BOUNDARY) {
+            _gregoryOffsets[i] = _numGregoryPatches;
+            _numGregoryPatches += parrays[i].GetNumPatches();
+        }
+    }
+
+    return true;
+}
+
+int
+OsdUtilTessellator::addVertex(int ptexFace, float u, float v)
+{
+    Coord coord;
+    coord.face = ptexFace;
+    coord.u = u;
+    coord.v = v;
+    _coords.push_back(coord);
+    return (int)_coords.size()-1;
+}
+
+void
+OsdUtilTessellator::addFace(int a, int b, int c, int d)
+{
+    _nverts.push_back(d<0 ? 3 : 4);
+    _indices.push_back(a);
+    _indices.push_back(b);
+    _indices.push_back(c);
+    if (d>=0)
+        _indices.push_back(d);
+}
+
+void
+OsdUtilTessellator::tessellateQuad(int ptexFace, int rate, vector<int> const sides[4])
+{
+    bool uniform = true;
+    for (int i=0; i<4; ++i)
+        uniform &= ((int)sides[i].size()==rate+1);
+
+    if (uniform) {
+
+        int n = rate+1;
+        vector<int> grid(n*n);
+        for (int i=0; i<n; ++i) {
+            grid[i]                 = sides[0][i];
+            grid[i*n+rate]          = sides[1][i];
+            grid[rate*n+rate-i]     = sides[2][i];
+            grid[(rate-i)*n]        = sides[3][i];
+        }
+        for (int j=1; j<rate; ++j)
+            for (int i=1; i<rate; ++i)
+                grid[j*n+i] = addVertex(ptexFace, float(i)/rate, float(j)/rate);
+
+        for (int j=0; j<rate; ++j)
+            for (int i=0; i<rate; ++i)
+                addFace(grid[j*n+i], grid[j*n+i+1], grid[(j+1)*n+i+1], grid[(j+1)*n+i]);
+        return;
+    }
+
+    // interior grid, inset by one segment
+    rate = max(rate, 2);
+
+    int n = rate-1;
+    vector<int> grid(n*n);
+    for (int j=0; j<n; ++j)
+        for (int i=0; i<n; ++i)
+            grid[j*n+i] = addVertex(ptexFace, float(i+1)/rate, float(j+1)/rate);
+
+    for (int j=0; j<n-1; ++j)
+        for (int i=0; i<n-1; ++i)
+            addFace(grid[j*n+i], grid[j*n+i+1], grid[(j+1)*n+i+1], grid[(j+1)*n+i]);
+
+    vector<int> inner[4];
+    for (int i=0; i<n; ++i) {
+        inner[0].push_back(grid[i]);
+        inner[1].push_back(grid[i*n+n-1]);
+        inner[2].push_back(grid[(n-1)*n+n-1-i]);
+        inner[3].push_back(grid[(n-1-i)*n]);
+    }
+
+    for (int i=0; i<4; ++i)
+        stitch(sides[i], inner[i]);
+}
+
+void
+OsdUtilTessellator::tessellateTriangle(int ptexFace, int rate, vector<int> const sides[3])
+{
+    bool uniform = true;
+    for (int i=0; i<3; ++i)
+        uniform &= ((int)sides[i].size()==rate+1);
+
+    // (i,j) grid, i+j <= rate
+    int n = uniform ? rate : max(rate, 3);
+    vector<int> grid((n+1)*(n+1), -1);
+
+    if (uniform) {
+
+        for (int k=0; k<=n; ++k) {
+            grid[k]             = sides[0][k];
+            grid[k*(n+1)+n-k]   = sides[1][k];
+            grid[(n-k)*(n+1)]   = sides[2][k];
+        }
+        for (int j=1; j<n; ++j)
+            for (int i=1; i+j<n; ++i)
+                grid[j*(n+1)+i] = addVertex(ptexFace, float(i)/n, float(j)/n);
+
+        for (int j=0; j<n; ++j) {
+            for (int i=0; i+j<n; ++i) {
+                addFace(grid[j*(n+1)+i], grid[j*(n+1)+i+1], grid[(j+1)*(n+1)+i]);
+                if (i+j+2<=n)
+                    addFace(grid[j*(n+1)+i+1], grid[(j+1)*(n+1)+i+1], grid[(j+1)*(n+1)+i]);
+            }
+        }
+        return;
+    }
+
+    // interior grid, inset by one segment
+    for (int j=1; j<n; ++j)
+        for (int i=1; i+j<n; ++i)
+            grid[j*(n+1)+i] = addVertex(ptexFace, float(i)/n, float(j)/n);
+
+    for (int j=1; j<n; ++j) {
+        for (int i=1; i+j+1<n; ++i) {
+            addFace(grid[j*(n+1)+i], grid[j*(n+1)+i+1], grid[(j+1)*(n+1)+i]);
+            if (i+j+2<n)
+                addFace(grid[j*(n+1)+i+1], grid[(j+1)*(n+1)+i+1], grid[(j+1)*(n+1)+i]);
+        }
+    }
+
+    vector<int> inner[3];
+    for (int k=1; k<n-1; ++k) {
+        inner[0].push_back(grid[1*(n+1)+k]);
+        inner[1].push_back(grid[k*(n+1)+n-1-k]);
+        inner[2].push_back(grid[(n-1-k)*(n+1)+1]);
+    }
+
+    for (int i=0; i<3; ++i)
+        stitch(sides[i], inner[i]);
+}
+
+void
+OsdUtilTessellator::stitch(vector<int> const & outer, vector<int> const & inner)
+{
+    int r = (int)outer.size()-1,
+        m = (int)inner.size();
+
+    // advance along the side whose next vertex comes first
+    for (int a=0, b=0; a<r or b<m-1; ) {
+        if (b==m-1 or (a<r and (a+1)*(m+1) <= (b+2)*r)) {
+            addFace(outer[a], outer[a+1], inner[b]);
+            ++a;
+        } else {
+            addFace(outer[a], inner[b+1], inner[b]);
+            ++b;
+        }
+    }
+}
+
+void
+OsdUtilTessellator::GetTopology(OsdUtilSubdivTopology *out) const
+{
+    out->numVertices = GetNumVertices();
+    out->nverts = _nverts;
+    out->indices = _indices;
+}
+
+void
+OsdUtilTessellator::Evaluate(const OsdVertexBufferDescriptor &inDesc, const float *in,
+                             const OsdVertexBufferDescriptor &outDesc, float *out,
+                             int numThreads) const
+{
+    if (not (_patchTables and in and out))
+        return;
+
+    int length = inDesc.length;
+
+    assert(length <= (outDesc.stride-outDesc.offset));
+
+    FarPatchTables::PatchArrayVector const & parrays = _patchTables->GetPatchArrayVector();
+    FarPatchTables::PTable const & cvs = _patchTables->GetPatchTable();
+
+    int const * valences = _patchTables->GetVertexValenceTable().empty() ?
+        0 : &_patchTables->GetVertexValenceTable()[0];
+
+    int maxValence = _patchTables->GetMaxValence();
+
+    // control points of the Gregory patches
+    vector<float> points(_numGregoryPatches*20*length);
+
+    for (int i=0; i<(int)parrays.size(); ++i) {
+
+        if (_gregoryOffsets[i]<0)
+            continue;
+
+        FarPatchTables::PatchArray const & parray = parrays[i];
+
+        bool boundary = parray.GetDescriptor().GetType()==FarPatchTables::GREGORY_BOUNDARY;
+
+        int npatches = (int)parray.GetNumPatches();
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+#pragma omp parallel for num_threads(numThreads) if (numThreads > 1)
+#endif
+        for (int j=0; j<npatches; ++j) {
+
+            unsigned int const * patchCVs = &cvs[parray.GetVertIndex()+j*4];
+            unsigned int const * quadOffsets = &_patchTables->GetQuadOffsetTable()[parray.GetQuadOffsetIndex()+j*4];
+
+            float * dst = &points[(_gregoryOffsets[i]+j)*20*length];
+
+            if (boundary) {
+                computeGregoryBoundaryPoints(patchCVs, valences, quadOffsets, maxValence, inDesc, in, dst);
+            } else {
+                computeGregoryPoints(patchCVs, valences, quadOffsets, maxValence, inDesc, in, dst);
+            }
+        }
+    }
+
+    int nfaces = (int)_faceVertexOffsets.size()-1;
+
+    float const * inQ = in + inDesc.offset;
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+#pragma omp parallel for schedule(dynamic, 16) num_threads(numThreads) if (numThreads > 1)
+#endif
+    for (int face=0; face<nfaces; ++face) {
+
+        for (int i=_faceVertexOffsets[face]; i<_faceVertexOffsets[face+1]; ++i) {
+
+            Sample const & sample = _samples[i];
+
+            float * dst = out + i*outDesc.stride + outDesc.offset;
+
+            memset(dst, 0, length*sizeof(float));
+
+            if (sample.patchArray<0)
+                continue;
+
+            FarPatchTables::PatchArray const & parray = parrays[sample.patchArray];
+
+            unsigned int const * patchCVs = &cvs[parray.GetVertIndex()+sample.vertexOffset];
+
+            if (sample.basis<0) {
+                // Loop end patches
+                evalLoopIrregular(sample.u, sample.v, patchCVs, valences, maxValence,
+                                  inDesc, in, outDesc, out + i*outDesc.stride, 0, 0);
+                continue;
+            }
+
+            float const * weights = &_weights[_basisOffsets[sample.basis]];
+
+            int nweights = _basisOffsets[sample.basis+1]-_basisOffsets[sample.basis];
+
+            if (_gregoryOffsets[sample.patchArray]>=0) {
+
+                float const * p = &points[(_gregoryOffsets[sample.patchArray]+sample.vertexOffset/4)*20*length];
+
+                for (int j=0; j<nweights; ++j, p+=length) {
+                    for (int k=0; k<length; ++k)
+                        dst[k] += weights[j] * p[k];
+                }
+            } else {
+
+                for (int j=0; j<nweights; ++j) {
+                    float const * p = inQ + patchCVs[j]*inDesc.stride;
+                    for (int k=0; k<length; ++k)
+                        dst[k] += weights[j] * p[k];
+                }
+            }
+        }
+    }
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
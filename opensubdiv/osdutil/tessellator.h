@@ -0,0 +1,166 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OSDUTIL_TESSELLATOR_H
+#define OSDUTIL_TESSELLATOR_H
+
+#include "../version.h"
+
+#include "topology.h"
+
+#include "../far/patchTables.h"
+#include "../osd/vertexDescriptor.h"
+
+#include <string>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+// OsdUtilTessellator samples the limit surface of feature adaptive patch
+// tables on a regular grid over each coarse face and connects the samples
+// into a watertight mesh.
+//
+// The coarse vertices and the samples along the coarse edges are shared by
+// the faces around them. Each edge is split into the same number of segments
+// on both sides, so that the output is crack-free even when the faces are
+// tessellated at different rates : the interior grid of a face is stitched to
+// its edges with a strip of triangles.
+//
+// Initialize locates the samples in the patches once : the basis weights of
+// the samples are computed then and shared by all the samples that land at
+// the same location of a same patch type. Evaluate only accumulates the
+// weighted control vertices and can be called for each new pose (or for
+// other primvars interpolated like the vertices).
+//
+// Quads are tessellated in quads, the sub-faces of non-quads (one per vertex)
+// in quads at half the rate, and the triangles of Loop meshes in triangles.
+//
+class OsdUtilTessellator {
+public:
+
+    OsdUtilTessellator();
+
+    // Builds the tessellation of the coarse faces of 'topology'.
+    //
+    // patchTables : feature adaptive patch tables of the topology
+    //
+    // tessRate : number of segments along the edges of the coarse faces
+    //
+    // edgeRates : optional number of segments of each face-edge, in the
+    //             order of topology.indices (the edge from the vertex to the
+    //             next vertex of the face). The highest of the rates of the
+    //             two faces of an edge is used. The interior of the faces is
+    //             tessellated at the highest rate of their edges.
+    //
+    // Returns false on error.
+    //
+    bool Initialize(const OsdUtilSubdivTopology &topology,
+                    const FarPatchTables *patchTables,
+                    int tessRate,
+                    const std::vector<int> *edgeRates = NULL,
+                    std::string *errorMessage = NULL);
+
+    // Number of tessellated vertices
+    int GetNumVertices() const { return (int)_samples.size(); }
+
+    // Tessellated topology (quads and triangles)
+    void GetTopology(OsdUtilSubdivTopology *out) const;
+
+    // Evaluates the vertex data of the tessellated vertices.
+    //
+    // inDesc, in : refined vertex data of the FarMesh the patch tables were
+    //              created with
+    //
+    // outDesc, out : GetNumVertices() elements
+    //
+    // If numThreads is 1, use single cpu. If numThreads > 1 use Omp and set
+    // number of omp threads.
+    //
+    void Evaluate(const OsdVertexBufferDescriptor &inDesc, const float *in,
+                  const OsdVertexBufferDescriptor &outDesc, float *out,
+                  int numThreads = 1) const;
+
+private:
+
+    // A tessellated vertex : location in a patch and basis weights
+    struct Sample {
+        int basis;                 // index of the basis weights, -1 if the
+                                   // patch is evaluated with its kernel
+        int patchArray;            // patch map handle
+        unsigned int vertexOffset;
+        float u, v;                // patch coordinates (kernel evaluation)
+    };
+
+    // Location of a tessellated vertex in the ptex faces (only used while the
+    // tessellation is built)
+    struct Coord {
+        int face;
+        float u, v;
+    };
+
+    // Creates a vertex sampled at (u,v) in the given ptex face
+    int addVertex(int ptexFace, float u, float v);
+
+    // Tessellates a quad (or triangle) parametric domain. 'sides' holds the
+    // vertices along each side of the domain, in counter-clockwise order and
+    // with the corners at both ends.
+    void tessellateQuad(int ptexFace, int rate, std::vector<int> const sides[4]);
+
+    void tessellateTriangle(int ptexFace, int rate, std::vector<int> const sides[3]);
+
+    // Connects the vertices of a side of a domain to the matching side of its
+    // interior grid with triangles
+    void stitch(std::vector<int> const & outer, std::vector<int> const & inner);
+
+    void addFace(int a, int b, int c, int d=-1);
+
+    const FarPatchTables *_patchTables;
+
+    std::vector<Coord> _coords;
+
+    std::vector<Sample> _samples;
+
+    // tessellated vertices evaluated by each coarse face
+    std::vector<int> _faceVertexOffsets;
+
+    // shared basis weights
+    std::vector<int> _basisOffsets;
+    std::vector<float> _weights;
+
+    // first Gregory patch of each patch array (Gregory patches are evaluated
+    // from their 20 control points)
+    std::vector<int> _gregoryOffsets;
+    int _numGregoryPatches;
+
+    std::vector<int> _nverts,
+                     _indices;
+};
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSDUTIL_TESSELLATOR_H
@@ -32,10 +32,13 @@
 #ifdef OPENSUBDIV_HAS_OPENMP
 #include <omp.h>
 #include "../osd/ompComputeController.h"
+#include "../osd/ompEvalStencilsController.h"
 #endif
 
 
 #include "../osd/cpuComputeController.h"
+#include "../osd/cpuEvalStencilsController.h"
+#include "../far/subdivisionStencilTablesFactory.h"
 
 #include <fstream>
 #include <iostream>
@@ -50,7 +53,19 @@ OsdUtilUniformEvaluator::OsdUtilUniformEvaluator():
     _ownsRefiner(false),
     _computeContext(NULL),
     _vertexBuffer(NULL),
-    _vvBuffer(NULL)
+    _vvBuffer(NULL),
+    _useStencils(false),
+    _vertexStencils(NULL),
+    _vvStencils(NULL),
+    _vertexStencilsContext(NULL),
+    _vvStencilsContext(NULL),
+    _refinedVertexBuffer(NULL),
+    _refinedVVBuffer(NULL),
+    _computeLimit(false),
+    _limitStencils(NULL),
+    _limitStencilsContext(NULL),
+    _limitDuBuffer(NULL),
+    _limitDvBuffer(NULL)
 {
 }
 
@@ -65,6 +80,17 @@ OsdUtilUniformEvaluator::~OsdUtilUniformEvaluator()
         delete _vertexBuffer;
     if (_vvBuffer)
         delete _vvBuffer;
+
+    delete _vertexStencilsContext;
+    delete _vvStencilsContext;
+    delete _vertexStencils;
+    delete _vvStencils;
+    delete _refinedVertexBuffer;
+    delete _refinedVVBuffer;
+    delete _limitStencilsContext;
+    delete _limitStencils;
+    delete _limitDuBuffer;
+    delete _limitDvBuffer;
 }
 
 
@@ -137,6 +163,10 @@ OsdUtilUniformEvaluator::Initialize(
         return true;
     }
 
+    if (_useStencils and initializeStencils(errorMessage)) {
+        return _computeLimit ? initializeLimit(errorMessage) : true;
+    }
+
     _computeContext = OsdCpuComputeContext::Create(fmesh->GetSubdivisionTables(), fmesh->GetVertexEditTables());
     
     // Three elements per refined point    
@@ -160,43 +190,172 @@ OsdUtilUniformEvaluator::Initialize(
                 vvNames.size() * fmesh->GetNumVertices() * sizeof(float));
     }
 
+    if (_computeLimit) {
+        return initializeLimit(errorMessage);
+    }
+
     return true;
 }
 
+bool
+OsdUtilUniformEvaluator::initializeStencils(string * /* errorMessage */)
+{
+    const FarMesh<OsdVertex> *fmesh = _refiner->GetFarMesh();
+    const vector<string> &vvNames   = _refiner->GetTopology().vvNames;
+    int level = _refiner->GetTopology().refinementLevel;
 
-void
+    // Returns NULL if the mesh has hierarchical edits : fall back to the
+    // level by level refinement
+    _vertexStencils = FarSubdivisionStencilTablesFactory::Create(
+        fmesh, level, FarSubdivisionStencilTablesFactory::INTERPOLATE_VERTEX);
+    if (not _vertexStencils) {
+        return false;
+    }
+
+    if (vvNames.size()) {
+        _vvStencils = FarSubdivisionStencilTablesFactory::Create(fmesh, level,
+            FarSubdivisionStencilTablesFactory::INTERPOLATE_VARYING);
+        if (not _vvStencils) {
+            delete _vertexStencils;
+            _vertexStencils = NULL;
+            return false;
+        }
+    }
+
+    int numCoarseVerts = fmesh->GetSubdivisionTables()->GetNumVertices(0),
+        numRefinedVerts = _vertexStencils->GetNumStencils();
+
+    _vertexStencilsContext = OsdCpuEvalStencilsContext::Create(_vertexStencils);
+
+    // Three elements per coarse and refined point
+    _vertexBuffer = OsdCpuVertexBuffer::Create(3, numCoarseVerts);
+    _refinedVertexBuffer = OsdCpuVertexBuffer::Create(3, numRefinedVerts);
+
+    // zeros
+    memset( _vertexBuffer->BindCpuBuffer(), 0,
+            3 * numCoarseVerts * sizeof(float));
+    memset( _refinedVertexBuffer->BindCpuBuffer(), 0,
+            3 * numRefinedVerts * sizeof(float));
+
+    if (_vvStencils) {
+
+        int numElements = (int)vvNames.size();
+
+        _vvStencilsContext = OsdCpuEvalStencilsContext::Create(_vvStencils);
+
+        _vvBuffer = OsdCpuVertexBuffer::Create(numElements, numCoarseVerts);
+        _refinedVVBuffer = OsdCpuVertexBuffer::Create(numElements, numRefinedVerts);
+
+        // zeros
+        memset( _vvBuffer->BindCpuBuffer(), 0,
+                numElements * numCoarseVerts * sizeof(float));
+        memset( _refinedVVBuffer->BindCpuBuffer(), 0,
+                numElements * numRefinedVerts * sizeof(float));
+    }
+
+    return true;
+}
+
+
+bool
+OsdUtilUniformEvaluator::initializeLimit(string *errorMessage)
+{
+    const FarMesh<OsdVertex> *fmesh = _refiner->GetFarMesh();
+    int level = _refiner->GetTopology().refinementLevel;
+
+    // In stencil mode the limit masks are composed with the refinement
+    // stencils and index the coarse vertices, otherwise they index the
+    // finest level of _vertexBuffer
+    _limitStencils = FarSubdivisionStencilTablesFactory::CreateLimit(
+        _refiner->GetHbrMesh(), _refiner->GetRemappingTable(),
+        fmesh->GetSubdivisionTables(), level, _vertexStencils);
+
+    if (not _limitStencils) {
+        if (errorMessage)
+            *errorMessage = "Limit evaluation requires a quad refined mesh";
+        return false;
+    }
+
+    _limitStencilsContext = OsdCpuEvalStencilsContext::Create(_limitStencils);
+
+    int numRefinedVerts = _limitStencils->GetNumStencils();
+
+    if (not _refinedVertexBuffer) {
+        _refinedVertexBuffer = OsdCpuVertexBuffer::Create(3, numRefinedVerts);
+        memset( _refinedVertexBuffer->BindCpuBuffer(), 0,
+                3 * numRefinedVerts * sizeof(float));
+    }
+
+    _limitDuBuffer = OsdCpuVertexBuffer::Create(3, numRefinedVerts);
+    _limitDvBuffer = OsdCpuVertexBuffer::Create(3, numRefinedVerts);
+
+    // zeros
+    memset( _limitDuBuffer->BindCpuBuffer(), 0,
+            3 * numRefinedVerts * sizeof(float));
+    memset( _limitDvBuffer->BindCpuBuffer(), 0,
+            3 * numRefinedVerts * sizeof(float));
+
+    return true;
+}
+
+
+int
+OsdUtilUniformEvaluator::getNumCoarseVertices() const
+{
+    // The level by level buffers hold the coarse vertices followed by the
+    // refined ones, the stencil buffers only the coarse vertices
+    return _refiner->GetTopology().numVertices;
+}
+
+
+bool
 OsdUtilUniformEvaluator::SetCoarsePositions(
     const vector<float>& coords, string *errorMessage ) 
 {
-    const float* pFloats = &coords.front();
     int numFloats = (int) coords.size();
 
-    //XXX: should be >= num coarse vertices
-    if (numFloats/3 >= _refiner->GetFarMesh()->GetNumVertices()) {
+    if (numFloats % 3 or numFloats/3 > getNumCoarseVertices()) {
         if (errorMessage)
             *errorMessage = "Indexing error in tesselator";
-    } else {
-        _vertexBuffer->UpdateData(pFloats, 0, numFloats / 3);
+        return false;
+    }
+
+    if (numFloats) {
+        _vertexBuffer->UpdateData(&coords.front(), 0, numFloats / 3);
     }
+    return true;
 }
 
 
-void
+bool
 OsdUtilUniformEvaluator::SetCoarseVVData(
     const vector<float>& data, string *errorMessage
     ) 
 {
     if (!_vvBuffer) {
-        if (!data.empty() and errorMessage)
-            *errorMessage = 
-                "Mesh was not constructed with VV variables.";
-        return;                 
+        if (!data.empty()) {
+            if (errorMessage)
+                *errorMessage = 
+                    "Mesh was not constructed with VV variables.";
+            return false;
+        }
+        return true;
     }
     
     int numElements = _vvBuffer->GetNumElements();
     int numVertices = (int) data.size() / numElements;
-    const float* pFloats = &data.front();
-    _vvBuffer->UpdateData(pFloats, 0, numVertices);
+
+    if ((int) data.size() % numElements or
+        numVertices > getNumCoarseVertices()) {
+        if (errorMessage)
+            *errorMessage = "VV data doesn't match the coarse vertices";
+        return false;
+    }
+
+    if (numVertices) {
+        _vvBuffer->UpdateData(&data.front(), 0, numVertices);
+    }
+    return true;
 }
 
 
@@ -205,7 +364,11 @@ OsdUtilUniformEvaluator::Refine(
     int numThreads, string * /* errorMessage */)
 {
     const FarMesh<OsdVertex> *fmesh = _refiner->GetFarMesh();
-    
+
+    if (_vertexStencils) {
+        refineStencils(numThreads);
+        return true;
+    }
     
     if (numThreads > 1) {
 #ifdef OPENSUBDIV_HAS_OPENMP
@@ -213,6 +376,9 @@ OsdUtilUniformEvaluator::Refine(
         ompComputeController.Refine(_computeContext,
                                     fmesh->GetKernelBatches(),
                                     _vertexBuffer, _vvBuffer);
+        if (_limitStencils) {
+            refineLimit(numThreads);
+        }
         return true;
 #endif
     }
@@ -223,9 +389,81 @@ OsdUtilUniformEvaluator::Refine(
                                 fmesh->GetKernelBatches(),
                                 _vertexBuffer, _vvBuffer);        
 
+    if (_limitStencils) {
+        refineLimit(numThreads);
+    }
+
     return true;
 }
 
+void
+OsdUtilUniformEvaluator::refineStencils(int numThreads)
+{
+    OsdVertexBufferDescriptor vertexDesc(0, 3, 3);
+
+    int numElements = _vvBuffer ? _vvBuffer->GetNumElements() : 0;
+    OsdVertexBufferDescriptor vvDesc(0, numElements, numElements);
+
+    if (_limitStencils) {
+        refineLimit(numThreads);
+    }
+
+    if (numThreads > 1) {
+#ifdef OPENSUBDIV_HAS_OPENMP
+        OsdOmpEvalStencilsController ompController(numThreads);
+        if (not _limitStencils) {
+            ompController.UpdateValues(_vertexStencilsContext,
+                                       vertexDesc, _vertexBuffer,
+                                       vertexDesc, _refinedVertexBuffer);
+        }
+        if (_vvStencilsContext) {
+            ompController.UpdateValues(_vvStencilsContext,
+                                       vvDesc, _vvBuffer,
+                                       vvDesc, _refinedVVBuffer);
+        }
+        return;
+#endif
+    }
+
+    OsdCpuEvalStencilsController cpuController;
+    if (not _limitStencils) {
+        cpuController.UpdateValues(_vertexStencilsContext,
+                                   vertexDesc, _vertexBuffer,
+                                   vertexDesc, _refinedVertexBuffer);
+    }
+    if (_vvStencilsContext) {
+        cpuController.UpdateValues(_vvStencilsContext,
+                                   vvDesc, _vvBuffer,
+                                   vvDesc, _refinedVVBuffer);
+    }
+}
+
+void
+OsdUtilUniformEvaluator::refineLimit(int numThreads)
+{
+    // positions, du and dv in a single pass over the stencils
+    OsdVertexBufferDescriptor desc(0, 3, 3);
+
+    if (numThreads > 1) {
+#ifdef OPENSUBDIV_HAS_OPENMP
+        OsdOmpEvalStencilsController ompController(numThreads);
+        ompController.UpdateValuesAndDerivs(_limitStencilsContext,
+                                            desc, _vertexBuffer,
+                                            desc, _refinedVertexBuffer,
+                                            desc, _limitDuBuffer,
+                                            desc, _limitDvBuffer);
+        return;
+#endif
+    }
+
+    OsdCpuEvalStencilsController cpuController;
+    cpuController.UpdateValuesAndDerivs(_limitStencilsContext,
+                                        desc, _vertexBuffer,
+                                        desc, _refinedVertexBuffer,
+                                        desc, _limitDuBuffer,
+                                        desc, _limitDvBuffer);
+}
+
 bool
 OsdUtilUniformEvaluator::GetRefinedPositions(
     const float **positions, int *numFloats,
@@ -261,7 +499,12 @@ OsdUtilUniformEvaluator::GetRefinedPositions(
     // The vertexBuffer has all subdivision levels, here we are skipping
     // past the vertices on lower subdivision levels and returning
     // a pointer to the start of the most refined level
-    *positions = _vertexBuffer->BindCpuBuffer() + (3*firstVertexOffset);
+    // (stencil refinement only outputs the most refined level)
+    if (_refinedVertexBuffer) {
+        *positions = _refinedVertexBuffer->BindCpuBuffer();
+    } else {
+        *positions = _vertexBuffer->BindCpuBuffer() + (3*firstVertexOffset);
+    }
     *numFloats = numRefinedVerts*3;
 
     return true;
@@ -308,8 +551,12 @@ OsdUtilUniformEvaluator::GetRefinedVVData(
     // The vertexBuffer has all subdivision levels, here we are skipping
     // past the vertices on lower subdivision levels and returning
     // a pointer to the start of the most refined level
-    *data =
+    if (_refinedVVBuffer) {
+        *data = _refinedVVBuffer->BindCpuBuffer();
+    } else {
+        *data =
             _vvBuffer->BindCpuBuffer() + (numElements * firstVertexOffset);
+    }
     *numFloats = numElements * numRefinedVerts;
 
     return true;
@@ -318,6 +565,35 @@ OsdUtilUniformEvaluator::GetRefinedVVData(
 
 
 
+bool
+OsdUtilUniformEvaluator::GetRefinedLimitTangents(
+    const float **du, const float **dv, int *numFloats,
+    string *errorMessage) const
+{
+    if (not (du and dv and numFloats)) {
+        if (errorMessage) {
+            *errorMessage =
+                "GetRefinedLimitTangents: du, dv and/or numFloats was NULL";
+        }
+        return false;
+    }
+
+    if (not _limitStencils) {
+        if (errorMessage) {
+            *errorMessage =
+                "GetRefinedLimitTangents: limit evaluation is not enabled.";
+        }
+        return false;
+    }
+
+    *du = _limitDuBuffer->BindCpuBuffer();
+    *dv = _limitDvBuffer->BindCpuBuffer();
+    *numFloats = _limitStencils->GetNumStencils() * 3;
+
+    return true;
+}
+
+
 bool
 OsdUtilUniformEvaluator::GetRefinedTopology(
     OsdUtilSubdivTopology *t,
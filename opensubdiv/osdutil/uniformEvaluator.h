@@ -36,7 +36,9 @@
 
 #include "../osd/cpuVertexBuffer.h"
 #include "../osd/cpuComputeContext.h"
+#include "../osd/cpuEvalStencilsContext.h"
 #include "../far/mesh.h"
+#include "../far/stencilTables.h"
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -55,6 +57,49 @@ class OsdUtilUniformEvaluator {
 
     ~OsdUtilUniformEvaluator();    
 
+    // When enabled, Initialize precomputes stencils mapping the coarse
+    // vertices directly to the vertices of the finest level, and Refine
+    // applies them instead of running the subdivision kernels level by
+    // level. The intermediate levels are then neither computed nor stored
+    // and every refined vertex only depends on the coarse vertices.
+    //
+    // This is not faster : a stencil reads many more coarse vertices than
+    // a subdivision kernel reads vertices of the previous level, so the
+    // stencil tables are about 4 times larger than the subdivision tables
+    // and Refine is slower (see uniform_perf : catmark_car at level 5 takes
+    // 241 ms with 200 MB of stencils, against 158 ms with 52 MB of tables).
+    // The level by level refinement remains the default.
+    //
+    // Must be called before Initialize. Meshes with hierarchical edits
+    // can't be represented by stencils and silently revert to the level
+    // by level refinement.
+    //
+    void SetUseStencils(bool useStencils) { _useStencils = useStencils; }
+
+    // Returns true if the evaluator refines with stencils
+    bool IsUsingStencils() const { return _vertexStencils != NULL; }
+
+    // When enabled, Refine also pushes the vertices of the finest level to
+    // the limit surface and computes their limit tangents:
+    // GetRefinedPositions then returns limit positions and
+    // GetRefinedLimitTangents the du/dv derivatives, so that clients don't
+    // need a separate limit evaluation or normal smoothing pass.
+    //
+    // With stencils, the limit masks are folded into the refinement
+    // stencils and positions and tangents come out of a single pass over
+    // the coarse vertices.
+    //
+    // Level by level, the limit masks are not fused with the refinement :
+    // Refine runs the subdivision kernels up to the finest level, then
+    // applies the limit stencils to that level in a second pass. Fusing
+    // them would need limit variants of the subdivision kernels of every
+    // compute controller, and could not apply the hierarchical edits of
+    // the finest level before the projection.
+    //
+    // Must be called before Initialize. Requires a Catmark mesh.
+    //
+    void SetComputeLimit(bool computeLimit) { _computeLimit = computeLimit; }
+
     // Initialize returns false on error.  If errorMessage is non-NULL it'll
     // be populated upon error.
     //
@@ -76,15 +121,18 @@ class OsdUtilUniformEvaluator {
         std::string *errorMessage = NULL);    
 
     // Set new coarse-mesh CV positions, need to call Refine
-    // before calling Get* methods
-    void SetCoarsePositions(
+    // before calling Get* methods. Returns false if there are more
+    // positions than coarse vertices.
+    bool SetCoarsePositions(
         const std::vector<float>& coords,
         std::string *errorMessage = NULL
         );
 
     // Set new coarse-mesh vertex varying values, need to call Refine
-    // before calling Get* methods    
-    void SetCoarseVVData(
+    // before calling Get* methods. Returns false if there are more
+    // values than coarse vertices or if the size of the data is not a
+    // multiple of the number of vertex varying attributes.
+    bool SetCoarseVVData(
         const std::vector<float>& data,
         std::string *errorMessage = NULL
         );
@@ -113,6 +161,14 @@ class OsdUtilUniformEvaluator {
                           int *numElements = NULL,
                           std::string *errorMessage = NULL) const;    
 
+    // Grab the limit tangents computed by Refine when SetComputeLimit is
+    // enabled, packed as 3 floats per point in the same order as
+    // GetRefinedPositions.
+    //
+    bool GetRefinedLimitTangents(const float **du, const float **dv,
+                                 int *numFloats,
+                                 std::string *errorMessage = NULL) const;
+
     // Fetch the face varying attribute values on refined quads, call
     // through to the refiner but keep in evaluator API for 
     // one-stop-service for user API
@@ -183,6 +239,35 @@ class OsdUtilUniformEvaluator {
     OpenSubdiv::OsdCpuComputeContext *_computeContext;
     OpenSubdiv::OsdCpuVertexBuffer *_vertexBuffer;
     OpenSubdiv::OsdCpuVertexBuffer *_vvBuffer;
+
+    // Stencil refinement : _vertexBuffer and _vvBuffer only hold the
+    // coarse vertices, the finest level is written into the refined
+    // buffers.
+    bool _useStencils;
+    OpenSubdiv::FarStencilTables *_vertexStencils;
+    OpenSubdiv::FarStencilTables *_vvStencils;
+    OpenSubdiv::OsdCpuEvalStencilsContext *_vertexStencilsContext;
+    OpenSubdiv::OsdCpuEvalStencilsContext *_vvStencilsContext;
+    OpenSubdiv::OsdCpuVertexBuffer *_refinedVertexBuffer;
+    OpenSubdiv::OsdCpuVertexBuffer *_refinedVVBuffer;
+
+    // Limit projection : the limit positions are written into
+    // _refinedVertexBuffer
+    bool _computeLimit;
+    OpenSubdiv::FarStencilTables *_limitStencils;
+    OpenSubdiv::OsdCpuEvalStencilsContext *_limitStencilsContext;
+    OpenSubdiv::OsdCpuVertexBuffer *_limitDuBuffer;
+    OpenSubdiv::OsdCpuVertexBuffer *_limitDvBuffer;
+
+    bool initializeStencils(std::string *errorMessage);
+
+    bool initializeLimit(std::string *errorMessage);
+
+    void refineStencils(int numThreads);
+
+    void refineLimit(int numThreads);
+
+    int getNumCoarseVertices() const;
 };
 
 }  // end namespace OPENSUBDIV_VERSION
@@ -75,7 +75,6 @@ OsdUtilVertexSplit<T>::OsdUtilVertexSplit(FarMesh<T> * mesh)
         mesh->GetSubdivisionTables();
     const FarPatchTables::PTable& patchTable = patchTables->GetPatchTable();
     const FarPatchTables::FVarData& fvarData = patchTables->GetFVarData();
-    const std::vector<float>& fvarDataTable = fvarData.GetAllData();
     int fvarWidth = fvarData.GetFVarWidth();
     if (fvarWidth == 0)
         return;
@@ -94,9 +93,9 @@ OsdUtilVertexSplit<T>::OsdUtilVertexSplit(FarMesh<T> * mesh)
             ++vertexRange.first, ++j)
         {
             int fvar = vertexRange.first->second;
-            const float* fvarData = &fvarDataTable[fvar * fvarWidth];
-            if (std::equal(fvarData, fvarData + fvarWidth,
-                &fvarDataTable[i * fvarWidth]))
+            const float* fvarValue = fvarData.GetVertexData(fvar);
+            if (std::equal(fvarValue, fvarValue + fvarWidth,
+                fvarData.GetVertexData(i)))
             {
                 splitTable[i] = j;
                 goto split_vertex;
@@ -176,7 +175,7 @@ OsdUtilVertexSplit<T>::OsdUtilVertexSplit(FarMesh<T> * mesh)
         int fvar = vertexToFVarMap.find(vertex)->second;
         for (int j = 0; j < fvarWidth; ++j) {
             _vvarDataTable[(vertex - firstVertex) * fvarWidth + j] =
-                fvarDataTable[fvar * fvarWidth + j];
+                fvarData.GetVertexData(fvar)[j];
         }
     }
 }
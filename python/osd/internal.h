@@ -45,4 +45,8 @@ struct SubdividerImpl {
     OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex>* farMesh;
     OpenSubdiv::OsdCpuComputeContext* computeContext;
     OpenSubdiv::OsdCpuVertexBuffer* vertexBuffer;
+    // Each subdivider has its own controller, since refine() runs without
+    // the GIL and the controllers hold the buffers bound while refining.
+    OpenSubdiv::OsdCpuComputeController computeController;
+    int numCoarseVertices;
 };
@@ -215,5 +215,30 @@ _ShimLayoutFromObject(PyObject* obj)
     delete $1;
 }
 
+// Passes the memory of a numpy array without copying it : the array must be
+// a contiguous array of float32 (or of a record of float32 fields).
+%typemap(in) (const float* FLOATARRAY, int FLOATARRAYSIZE) {
+    if (!PyArray_Check($input) || !PyArray_ISCARRAY_RO((PyArrayObject*) $input)) {
+        PyErr_SetString(PyExc_TypeError, "This requires a contiguous numpy array.");
+        SWIG_fail;
+    }
+    shim::Layout layout = _ShimLayoutFromObject((PyObject*) PyArray_DESCR($input));
+    for (size_t i = 0; i < layout.size(); ++i) {
+        if (layout[i] != shim::float32) {
+            PyErr_SetString(PyExc_TypeError, "This requires an array of float32.");
+            SWIG_fail;
+        }
+    }
+    $1 = (const float*) PyArray_BYTES($input);
+    $2 = (int) (PyArray_NBYTES($input) / sizeof(float));
+}
+
+// Refinement does not touch any Python object : let the other threads run
+%exception shim::Subdivider::refine {
+    Py_BEGIN_ALLOW_THREADS
+    $action
+    Py_END_ALLOW_THREADS
+}
+
 %include "subdivider.h"
 %include "topology.h"
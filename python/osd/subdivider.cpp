@@ -29,7 +29,39 @@
 using namespace std;
 using namespace shim;
 
-OpenSubdiv::OsdCpuComputeController* g_osdComputeController = 0;
+// Returns the vertex indices of the refined quads (4 per quad), or NULL if
+// the mesh is not made of uniformly refined quads
+static unsigned int const *
+_GetRefinedQuads(SubdividerImpl* self, int* numQuads)
+{
+    *numQuads = 0;
+
+    OpenSubdiv::FarPatchTables const * patchTables =
+        self->farMesh->GetPatchTables();
+
+    if (!patchTables) {
+        return 0;
+    }
+
+    if (patchTables->IsFeatureAdaptive()) {
+        cerr << "Feature adaptive not supported" << endl;
+        return 0;
+    }
+
+    const OpenSubdiv::FarSubdivisionTables *tables =
+        self->farMesh->GetSubdivisionTables();
+
+    bool loop = (tables->GetScheme() == OpenSubdiv::FarSubdivisionTables::LOOP);
+
+    if (loop) {
+        cerr << "loop subdivision not supported" << endl;
+        return 0;
+    }
+
+    int level = tables->GetMaxLevel();
+    *numQuads = patchTables->GetNumFaces(level-1);
+    return patchTables->GetFaceVertices(level-1);
+}
 
 shim::Subdivider::Subdivider(
     const Topology& topo,
@@ -39,10 +71,6 @@ shim::Subdivider::Subdivider(
 {
     self = new SubdividerImpl();
 
-    if (!g_osdComputeController) {
-        g_osdComputeController = new OpenSubdiv::OsdCpuComputeController();
-    }
-
     int numFloatsPerVertex = 0;
     Layout::const_iterator it;
     for (it = refinedLayout.begin(); it != refinedLayout.end(); ++it) {
@@ -61,6 +89,7 @@ shim::Subdivider::Subdivider(
         self->farMesh->GetVertexEditTables());
     self->vertexBuffer = OpenSubdiv::OsdCpuVertexBuffer::Create(
         numFloatsPerVertex, self->farMesh->GetNumVertices());
+    self->numCoarseVertices = topo.getNumVertices();
 }
 
 shim::Subdivider::~Subdivider()
@@ -76,13 +105,24 @@ shim::Subdivider::setCoarseVertices(const HeterogeneousBuffer& cage)
 {
     float* pFloats = (float*) &cage.Buffer[0];
     int numFloats = cage.Buffer.size() / sizeof(float);
-    self->vertexBuffer->UpdateData(pFloats, /*start vertex*/ 0, numFloats);
+    updateCoarseVertices(pFloats, numFloats);
+}
+
+void
+shim::Subdivider::updateCoarseVertices(const float* pFloats, int numFloats)
+{
+    int numVertices = numFloats / self->vertexBuffer->GetNumElements();
+    if (numVertices > self->numCoarseVertices) {
+        cerr << "Too many coarse vertices (" << numVertices << ")" << endl;
+        numVertices = self->numCoarseVertices;
+    }
+    self->vertexBuffer->UpdateData(pFloats, /*start vertex*/ 0, numVertices);
 }
 
 void
 shim::Subdivider::refine()
 {
-    g_osdComputeController->Refine(self->computeContext,
+    self->computeController.Refine(self->computeContext,
                                    self->farMesh->GetKernelBatches(),
                                    self->vertexBuffer);
 }
@@ -103,29 +143,53 @@ shim::Subdivider::getRefinedVertices(Buffer* refinedVertices)
 void
 shim::Subdivider::getRefinedQuads(Buffer* refinedQuads)
 {
-    OpenSubdiv::FarPatchTables const * patchTables =
-        self->farMesh->GetPatchTables();
+    int numQuads = 0;
+    unsigned int const * indices = _GetRefinedQuads(self, &numQuads);
 
-    if (patchTables) {
-        cerr << "Feature adaptive not supported" << endl;
+    if (!indices) {
         return;
     }
 
-    const OpenSubdiv::FarSubdivisionTables *tables =
-        self->farMesh->GetSubdivisionTables();
+    unsigned char const * srcBegin = reinterpret_cast<unsigned char const *>(indices);
+    unsigned char const * srcEnd = srcBegin + numQuads * 4 * sizeof(unsigned int);
+    refinedQuads->assign(srcBegin, srcEnd);
+}
 
-    bool loop = (tables->GetScheme() == OpenSubdiv::FarSubdivisionTables::LOOP);
+size_t
+shim::Subdivider::getVertexBufferAddress()
+{
+    return (size_t) self->vertexBuffer->BindCpuBuffer();
+}
 
-    if (loop) {
-        cerr << "loop subdivision not supported" << endl;
-        return;
-    }
+int
+shim::Subdivider::getNumVertices() const
+{
+    return self->vertexBuffer->GetNumVertices();
+}
 
-    int level = tables->GetMaxLevel();
-    unsigned int const * indices = self->farMesh->GetPatchTables()->GetFaceVertices(level-1);
-    int numInts = self->farMesh->GetPatchTables()->GetNumFaces(level-1)*4;
+int
+shim::Subdivider::getNumCoarseVertices() const
+{
+    return self->numCoarseVertices;
+}
 
-    unsigned char const * srcBegin = reinterpret_cast<unsigned char const *>(indices);
-    unsigned char const * srcEnd = srcBegin + numInts * 4;
-    refinedQuads->assign(srcBegin, srcEnd);
+int
+shim::Subdivider::getNumFloatsPerVertex() const
+{
+    return self->vertexBuffer->GetNumElements();
+}
+
+size_t
+shim::Subdivider::getRefinedQuadsAddress()
+{
+    int numQuads = 0;
+    return (size_t) _GetRefinedQuads(self, &numQuads);
+}
+
+int
+shim::Subdivider::getNumRefinedQuads() const
+{
+    int numQuads = 0;
+    _GetRefinedQuads(self, &numQuads);
+    return numQuads;
 }
@@ -42,6 +42,12 @@ namespace shim {
         ~Subdivider();
         
         void setCoarseVertices(const shim::HeterogeneousBuffer& cage);
+
+        // Copies the coarse vertices straight from the memory of a
+        // contiguous float32 numpy array (see the FLOATARRAY typemap).
+        void updateCoarseVertices(const float* FLOATARRAY, int FLOATARRAYSIZE);
+
+        // Runs without holding the GIL (see osdshim.i).
         void refine();
 
         // These argument names must be INOUT to inform SWIG that
@@ -49,6 +55,19 @@ namespace shim {
         void getRefinedVertices(shim::Buffer* INOUT);
         void getRefinedQuads(shim::Buffer* INOUT);
 
+        // Zero-copy access : addresses of the vertex buffer (coarse vertices
+        // first, then the refined vertices of every level) and of the
+        // vertex indices of the refined quads. They remain valid as long as
+        // the subdivider is alive ; subdivider.py wraps them into numpy
+        // arrays that keep a reference to it.
+        size_t getVertexBufferAddress();
+        int getNumVertices() const;
+        int getNumCoarseVertices() const;
+        int getNumFloatsPerVertex() const;
+
+        size_t getRefinedQuadsAddress();
+        int getNumRefinedQuads() const;
+
     private:
         SubdividerImpl* self;
     };
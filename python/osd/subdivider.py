@@ -81,13 +81,17 @@ class Subdivider(object):
             if not listType:
                 raise TopoError("listType must be supplied")
             coarseVerts = numpy.array(coarseVerts, listType)
-        coarseVerts = coarseVerts.view(self.vertexLayout)
-        self.shim.setCoarseVertices(coarseVerts)
+        coarseVerts = numpy.ascontiguousarray(coarseVerts).view(self.vertexLayout)
+        self.shim.updateCoarseVertices(coarseVerts)
 
     # Calls Refine on the compute controller, passing it the compute
     # context and vertexBuffer.
     def refine(self):
-        '''Performs the actual subdivision work.'''
+        '''Performs the actual subdivision work.
+
+        The GIL is released during the subdivision, so that other Python
+        threads can run (or refine other subdividers) meanwhile.
+        '''
         self.shim.refine()
 
     # Calls the strangely-named "BindCpuBuffer" on the
@@ -112,5 +116,59 @@ class Subdivider(object):
         empty = numpy.empty(0, self.indexType)
         return self.shim.getRefinedQuads(empty)
 
+    def getCoarseVerticesView(self):
+        '''Returns a writable numpy array that shares its memory with the
+        coarse vertices of the subdivider: writing the positions of a new
+        pose into this array replaces :meth:`setCoarseVertices` without
+        any copy.
+
+        The array holds a record of ``vertexLayout`` per coarse vertex and
+        keeps the subdivider alive.
+        '''
+        return self._view(self.shim.getVertexBufferAddress(),
+                          self.shim.getNumCoarseVertices())
+
+    def getRefinedVerticesView(self):
+        '''Same as :meth:`getRefinedVertices`, without copying the vertex
+        data: the returned numpy array shares its memory with the
+        subdivider, so it reflects the result of each :meth:`refine`.
+
+        The array holds a record of ``vertexLayout`` per vertex and keeps
+        the subdivider alive.
+        '''
+        return self._view(self.shim.getVertexBufferAddress(),
+                          self.shim.getNumVertices())
+
+    def getRefinedQuadsView(self):
+        '''Same as :meth:`getRefinedQuads`, without copying the indices:
+        returns a read-only ``numpy.uint32`` array of shape (quads, 4)
+        that shares its memory with the subdivider.
+        '''
+        numQuads = self.shim.getNumRefinedQuads()
+        if numQuads == 0:
+            return numpy.empty((0, 4), numpy.uint32)
+        view = _ArrayView(self.shim, self.shim.getRefinedQuadsAddress(),
+                          numQuads * 4, numpy.uint32, readonly = True)
+        return numpy.asarray(view).reshape(-1, 4)
+
+    def _view(self, address, numVertices):
+        numFloats = numVertices * self.shim.getNumFloatsPerVertex()
+        if numFloats == 0:
+            return numpy.empty(0, self.vertexLayout)
+        view = _ArrayView(self.shim, address, numFloats, numpy.float32)
+        return numpy.asarray(view).view(self.vertexLayout)
+
     def __del__(self):
         pass
+
+# Exposes memory owned by a shim object through the numpy array
+# interface: numpy.asarray wraps it without copying, and the resulting
+# array references the view, which references the shim object.
+class _ArrayView(object):
+    def __init__(self, owner, address, count, dtype, readonly = False):
+        self.owner = owner
+        self.__array_interface__ = {
+            'shape': (count,),
+            'typestr': numpy.dtype(dtype).str,
+            'data': (address, readonly),
+            'version': 3 }
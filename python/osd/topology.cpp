@@ -53,7 +53,7 @@ shim::Topology::Topology(
     switch (valences.Type) {
     case uint8: {
         const unsigned char *d = (const unsigned char*) &valences.Buffer[0];
-        maxValence = (size_t) *max_element(d, d + byteCount);
+        maxValence = (size_t) *max_element(d, d + valences.Buffer.size());
         break;
     }
     default:
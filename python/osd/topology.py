@@ -50,6 +50,9 @@ class Topology(object):
     .. note:: Input data is always copied to internal storage,
        rather than referenced.
 
+    .. note:: numpy arrays are processed in bulk, which is much faster
+       than Python lists for large meshes.
+
     :param indices: Defines each face as a list of vertex indices.
     :type indices: list or numpy array
     :param valences: If ``indices`` is 2D, this should be :const:`None`.  If every face has the same valence, this can be a single integer. Otherwise this is a list of integers that specify the valence of each face.
@@ -130,11 +133,10 @@ class Topology(object):
 # Checks that no valence is less than 3, and that the sum of all valences
 # equal to the # of indices.
 def _check_topology(indices, valences):
-    acc = 0
-    for v in valences:
-        if v < 3:
-            raise TopoError("all valences must be 3 or greater")
-        acc = acc + v
+    valences = np.asarray(valences)
+    if len(valences) and valences.min() < 3:
+        raise TopoError("all valences must be 3 or greater")
+    acc = int(valences.sum())
     if len(indices) != acc:
         msg = "sum of valences ({0}) isn't equal to the number of indices ({1})"
         raise TopoError(msg.format(acc, len(indices)))
@@ -149,6 +151,18 @@ def _flatten(faces):
 # If indices is two-dimensional, splits it into two lists.
 # Otherwise returns the lists unchanged.
 def _flatten_args(indices, valences):
+    if isinstance(indices, np.ndarray) and indices.ndim == 2:
+        if valences is not None:
+            raise OsdTypeError(
+               "valences must be None if indices is two-dimensional")
+        lengths = np.empty(indices.shape[0], 'uint8')
+        lengths.fill(indices.shape[1])
+        return (indices.reshape(-1), lengths)
+    if isinstance(indices, np.ndarray) and indices.ndim == 1:
+        if valences is None:
+            raise OsdTypeError(
+                "valences must be provided if indices is one-dimensional")
+        return (indices, valences)
     try:
         flattened, lengths = _flatten(indices)
         if valences is not None:
@@ -171,7 +185,8 @@ def _process_valences(indices, valences):
             msg = "Scalar provided for valences argument ({0}) that " \
                 "does evenly divide the number of indices ({1})"
             raise OsdTypeError(msg.format(len(indices), v))
-        valences = [v] * faceCount
+        valences = np.empty(faceCount, 'uint8')
+        valences.fill(v)
     except TypeError:
         pass
     return valences
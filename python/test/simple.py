@@ -81,6 +81,46 @@ class SimpleTest(unittest.TestCase):
         self.assertEqual(numQuads, 1536, "Unexpected number of refined quads")
         self.assertEqual(numVerts, 2056, "Unexpected number of refined verts")
 
+    def test_views(self):
+        mesh = osd.Topology(faces)
+        mesh.finalize()
+
+        subdivider = osd.Subdivider(
+            mesh,
+            vertexLayout = dtype,
+            indexType = np.uint32,
+            levels = 4)
+
+        coarse = subdivider.getCoarseVerticesView()
+        self.assertEqual(len(coarse), len(verts) / len(dtype))
+
+        # writing into the view replaces setCoarseVertices
+        coarse.view(np.float32)[:] = verts
+        subdivider.refine()
+
+        vertices = subdivider.getRefinedVerticesView()
+        quads = subdivider.getRefinedQuadsView()
+
+        self.assertEqual(quads.shape, (1536, 4))
+        self.assertEqual(len(vertices), 2056)
+        self.assertTrue(np.all(quads < len(vertices)))
+
+        # the views share the memory of the copies
+        self.assertTrue(np.all(
+            vertices.view(np.float32) == subdivider.getRefinedVertices()))
+        self.assertTrue(np.all(
+            quads.reshape(-1) == subdivider.getRefinedQuads()))
+
+        # and reflect the next refinement
+        subdivider.setCoarseVertices(np.array(verts, np.float32) * 2)
+        subdivider.refine()
+        self.assertTrue(np.all(
+            vertices.view(np.float32) == subdivider.getRefinedVertices()))
+
+        # the views keep the subdivider alive
+        del subdivider
+        self.assertEqual(len(vertices.view(np.float32)), 2056 * len(dtype))
+
     # For now, disable the leak test by prepending "do_not_".
     def do_not_test_leaks(self):
         self.test_usage()
@@ -0,0 +1,84 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef CPU_BATCH_UTILS_H
+#define CPU_BATCH_UTILS_H
+
+#include <osd/drawContext.h>
+#include <osd/cpuComputeController.h>
+
+#include <osdutil/batch.h>
+
+#include <string.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Minimal vertex buffer and draw context, so that OsdUtilMeshBatch can be
+// instantiated (and refined on the CPU) without a graphics API
+class CpuBatchVertexBuffer {
+public:
+    static CpuBatchVertexBuffer * Create(int numElements, int numVertices) {
+        return new CpuBatchVertexBuffer(numElements, numVertices);
+    }
+
+    void UpdateData(const float *src, int startVertex, int numVertices) {
+        memcpy(&_data[startVertex*_numElements], src,
+               numVertices*_numElements*sizeof(float));
+    }
+
+    int GetNumElements() const { return _numElements; }
+
+    int GetNumVertices() const { return _numVertices; }
+
+    float * BindCpuBuffer() { return &_data[0]; }
+
+    int BindVBO() { return 0; }
+
+private:
+    CpuBatchVertexBuffer(int numElements, int numVertices) :
+        _numElements(numElements), _numVertices(numVertices),
+        _data(numElements*numVertices, 0.0f) { }
+
+    int _numElements,
+        _numVertices;
+    std::vector<float> _data;
+};
+
+class CpuBatchDrawContext : public OpenSubdiv::OsdDrawContext {
+public:
+    typedef int VertexBufferBinding;
+
+    static CpuBatchDrawContext * Create(OpenSubdiv::FarPatchTables const *, int, bool) {
+        return new CpuBatchDrawContext;
+    }
+
+    void UpdateVertexTexture(CpuBatchVertexBuffer *) { }
+};
+
+typedef OpenSubdiv::OsdUtilMeshBatch<CpuBatchVertexBuffer,
+                                     CpuBatchDrawContext,
+                                     OpenSubdiv::OsdCpuComputeController> CpuMeshBatch;
+
+#endif /* CPU_BATCH_UTILS_H */
@@ -0,0 +1,242 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef LIMIT_UTILS_H
+#define LIMIT_UTILS_H
+
+#include <cmath>
+#include <set>
+#include <vector>
+
+#include "shape_utils.h"
+#include "vertex_utils.h"
+
+//------------------------------------------------------------------------------
+// Reference limit positions : the faces of an Hbr mesh are refined uniformly
+// and the vertices of the last level are projected onto the limit surface
+// with the limit masks of the subdivision scheme. Each sample is located
+// with the ptex coordinates of the vertex, so that it can be compared to the
+// limit evaluation of the patches.
+struct LimitSample {
+    int face;
+    float u, v;
+    float position[3];
+};
+
+typedef OpenSubdiv::HbrMesh<xyzVV>     xyzLimitMesh;
+typedef OpenSubdiv::HbrFace<xyzVV>     xyzLimitFace;
+typedef OpenSubdiv::HbrHalfedge<xyzVV> xyzLimitHalfedge;
+typedef OpenSubdiv::HbrVertex<xyzVV>   xyzLimitVertex;
+
+// Collects the faces around a vertex
+struct LimitFaceCollector : public OpenSubdiv::HbrFaceOperator<xyzVV> {
+    std::vector<xyzLimitFace *> faces;
+    virtual void operator() (xyzLimitFace &face) { faces.push_back(&face); }
+};
+
+// Computes the limit position of a refined vertex (the faces around it must
+// be triangles with Loop and quads with Catmark). Returns false if the vertex
+// has semi-sharp edges or sharpness : its limit mask is not known yet.
+static bool
+getLimitPosition(xyzLimitVertex const * v, Scheme scheme, float * result) {
+
+    float sharpness = v->GetSharpness();
+    if (sharpness>xyzLimitVertex::k_Smooth and sharpness<xyzLimitVertex::k_InfinitelySharp)
+        return false;
+
+    LimitFaceCollector collector;
+    v->ApplyOperatorSurroundingFaces(collector);
+
+    float edgeSum[3] = {0.0f, 0.0f, 0.0f},
+          faceSum[3] = {0.0f, 0.0f, 0.0f};
+
+    std::set<xyzLimitVertex const *> creases;
+
+    int valence = (int)collector.faces.size();
+    for (int i=0; i<valence; ++i) {
+
+        xyzLimitFace const * f = collector.faces[i];
+
+        int nv = f->GetNumVertices(), k = 0;
+        while (f->GetVertex(k)!=v)
+            ++k;
+
+        xyzLimitVertex const * next = f->GetVertex((k+1)%nv);
+        for (int j=0; j<3; ++j)
+            edgeSum[j] += next->GetData().GetPos()[j];
+
+        if (nv==4) {
+            xyzLimitVertex const * diag = f->GetVertex((k+2)%nv);
+            for (int j=0; j<3; ++j)
+                faceSum[j] += diag->GetData().GetPos()[j];
+        }
+
+        // boundaries and infinitely sharp edges are creases
+        xyzLimitHalfedge const * edges[2] = { f->GetEdge(k), f->GetEdge((k+nv-1)%nv) };
+        for (int j=0; j<2; ++j) {
+            float esharp = edges[j]->GetSharpness();
+            if (esharp>xyzLimitHalfedge::k_Smooth and esharp<xyzLimitHalfedge::k_InfinitelySharp)
+                return false;
+            if (edges[j]->IsBoundary() or esharp>=xyzLimitHalfedge::k_InfinitelySharp)
+                creases.insert(edges[j]->GetOrgVertex()==v ?
+                    edges[j]->GetDestVertex() : edges[j]->GetOrgVertex());
+        }
+    }
+
+    float const * pos = v->GetData().GetPos();
+
+    if (sharpness>=xyzLimitVertex::k_InfinitelySharp or creases.size()>2) {
+
+        // corner
+        for (int j=0; j<3; ++j)
+            result[j] = pos[j];
+
+    } else if (creases.size()==2) {
+
+        // crease : cubic B-spline limit of the crease curve
+        xyzLimitVertex const * e0 = *creases.begin(),
+                             * e1 = *creases.rbegin();
+        for (int j=0; j<3; ++j)
+            result[j] = (4.0f*pos[j] + e0->GetData().GetPos()[j] + e1->GetData().GetPos()[j]) / 6.0f;
+
+    } else if (scheme==kLoop) {
+
+        float n = (float)valence,
+              c = 0.375f + 0.25f*cosf(6.28318530717958647692f/n),
+              beta = (0.625f - c*c) / n,
+              chi = 1.0f / (0.375f/beta + n);
+        for (int j=0; j<3; ++j)
+            result[j] = (1.0f-n*chi)*pos[j] + chi*edgeSum[j];
+
+    } else {
+
+        float n = (float)valence;
+        for (int j=0; j<3; ++j)
+            result[j] = (n*n*pos[j] + 4.0f*edgeSum[j] + faceSum[j]) / (n*(n+5.0f));
+    }
+    return true;
+}
+
+// Locates the vertices of the faces refined from 'f' at 'level' in the ptex
+// face of 'f' ; 'corners' are the ptex coordinates of the vertices of 'f'
+static void
+addLimitSamples(xyzLimitFace * f, float const (*corners)[2], int ptexIndex, int level,
+                Scheme scheme, std::set<xyzLimitVertex const *> & visited,
+                std::vector<LimitSample> & samples) {
+
+    int nv = f->GetNumVertices();
+
+    if (f->GetDepth()==level) {
+        for (int i=0; i<nv; ++i) {
+            xyzLimitVertex const * v = f->GetVertex(i);
+
+            LimitSample sample;
+            if (visited.count(v) or (not getLimitPosition(v, scheme, sample.position)))
+                continue;
+            visited.insert(v);
+
+            sample.face = ptexIndex;
+            sample.u = corners[i][0];
+            sample.v = corners[i][1];
+            samples.push_back(sample);
+        }
+        return;
+    }
+
+    for (int i=0; i<(scheme==kLoop ? 4 : nv); ++i) {
+
+        xyzLimitFace * child = f->GetChild(i);
+        if (not child)
+            continue;
+
+        // the child vertices are the children of the vertices, edges or
+        // face of 'f' : locate them from the corners of 'f'
+        float childCorners[4][2];
+        for (int j=0; j<child->GetNumVertices(); ++j) {
+
+            xyzLimitVertex const * cv = child->GetVertex(j);
+            childCorners[j][0] = childCorners[j][1] = 0.0f;
+
+            for (int k=0; k<nv; ++k) {
+                xyzLimitHalfedge const * e = f->GetEdge(k);
+                if (cv->GetParentVertex()==f->GetVertex(k)) {
+                    childCorners[j][0] = corners[k][0];
+                    childCorners[j][1] = corners[k][1];
+                } else if (cv->GetParentEdge()==e or
+                           (e->GetOpposite() and cv->GetParentEdge()==e->GetOpposite())) {
+                    childCorners[j][0] = 0.5f*(corners[k][0] + corners[(k+1)%nv][0]);
+                    childCorners[j][1] = 0.5f*(corners[k][1] + corners[(k+1)%nv][1]);
+                } else if (cv->GetParentFace()==f) {
+                    childCorners[j][0] += corners[k][0]/nv;
+                    childCorners[j][1] += corners[k][1]/nv;
+                }
+            }
+        }
+        addLimitSamples(child, childCorners, ptexIndex, level, scheme, visited, samples);
+    }
+}
+
+// Refines the faces of 'mesh' uniformly up to 'level' and returns the limit
+// positions of the vertices of that level (level must be at least 1 with
+// Catmark : the limit masks expect quads)
+static void
+getLimitSamples(xyzLimitMesh * mesh, Scheme scheme, int level, std::vector<LimitSample> & samples) {
+
+    for (int l=0; l<level; ++l) {
+        int nfaces = mesh->GetNumFaces();
+        for (int i=0; i<nfaces; ++i) {
+            xyzLimitFace * f = mesh->GetFace(i);
+            if (f->GetDepth()==l and (not f->IsHole()))
+                f->Refine();
+        }
+    }
+
+    static float const quad[4][2] = { {0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f} },
+                       tri[3][2] = { {0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f} };
+
+    std::set<xyzLimitVertex const *> visited;
+
+    int nfaces = mesh->GetNumCoarseFaces();
+    for (int i=0; i<nfaces; ++i) {
+
+        xyzLimitFace * f = mesh->GetFace(i);
+        if (f->IsHole())
+            continue;
+
+        if (scheme==kLoop) {
+            addLimitSamples(f, tri, f->GetPtexIndex(), level, scheme, visited, samples);
+        } else if (f->GetNumVertices()==4) {
+            addLimitSamples(f, quad, f->GetPtexIndex(), level, scheme, visited, samples);
+        } else {
+            // the children of non-quads are ptex faces of their own
+            for (int j=0; j<f->GetNumVertices(); ++j) {
+                xyzLimitFace * child = f->GetChild(j);
+                if (child)
+                    addLimitSamples(child, quad, child->GetPtexIndex(), level, scheme, visited, samples);
+            }
+        }
+    }
+}
+
+#endif /* LIMIT_UTILS_H */
@@ -0,0 +1,103 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef VERTEX_UTILS_H
+#define VERTEX_UTILS_H
+
+#include <hbr/vertexEdit.h>
+#include <far/vertexEditTables.h>
+
+//------------------------------------------------------------------------------
+// Vertex class implementation : a position, with the Hbr and Far
+// hierarchical edits applied in the same way so that both can be compared
+struct xyzVV {
+
+    xyzVV() { }
+
+    xyzVV( int /*i*/ ) { }
+
+    xyzVV( float x, float y, float z ) { _pos[0]=x; _pos[1]=y; _pos[2]=z; }
+
+    xyzVV( const xyzVV & src ) { _pos[0]=src._pos[0]; _pos[1]=src._pos[1]; _pos[2]=src._pos[2]; }
+
+   ~xyzVV( ) { }
+
+    void AddWithWeight(const xyzVV& src, float weight) { 
+        _pos[0]+=weight*src._pos[0]; 
+        _pos[1]+=weight*src._pos[1]; 
+        _pos[2]+=weight*src._pos[2]; 
+    }
+
+    void AddVaryingWithWeight(const xyzVV& , float) { }
+
+    void Clear( void * =0 ) { _pos[0]=_pos[1]=_pos[2]=0.0f; }
+
+    void SetPosition(float x, float y, float z) { _pos[0]=x; _pos[1]=y; _pos[2]=z; }
+
+    void ApplyVertexEdit(const OpenSubdiv::HbrVertexEdit<xyzVV> & edit) {
+        const float *src = edit.GetEdit();
+        switch(edit.GetOperation()) {
+          case OpenSubdiv::HbrHierarchicalEdit<xyzVV>::Set:
+            _pos[0] = src[0];
+            _pos[1] = src[1];
+            _pos[2] = src[2];
+            break;
+          case OpenSubdiv::HbrHierarchicalEdit<xyzVV>::Add:
+            _pos[0] += src[0];
+            _pos[1] += src[1];
+            _pos[2] += src[2];
+            break;
+          case OpenSubdiv::HbrHierarchicalEdit<xyzVV>::Subtract:
+            _pos[0] -= src[0];
+            _pos[1] -= src[1];
+            _pos[2] -= src[2];
+            break;
+        }
+    }
+
+    void ApplyVertexEdit(OpenSubdiv::FarVertexEdit const & edit) {
+        const float *src = edit.GetEdit();
+        switch(edit.GetOperation()) {
+          case OpenSubdiv::FarVertexEdit::Set:
+            _pos[0] = src[0];
+            _pos[1] = src[1];
+            _pos[2] = src[2];
+            break;
+          case OpenSubdiv::FarVertexEdit::Add:
+            _pos[0] += src[0];
+            _pos[1] += src[1];
+            _pos[2] += src[2];
+            break;
+        }
+    }
+    
+    void ApplyMovingVertexEdit(const OpenSubdiv::HbrMovingVertexEdit<xyzVV> &) { }
+
+    const float * GetPos() const { return _pos; }
+
+private:
+    float _pos[3];
+};
+
+#endif /* VERTEX_UTILS_H */
@@ -0,0 +1,1218 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include <far/meshFactory.h>
+#include <far/patchMap.h>
+
+#include <osd/vertex.h>
+#include <osd/cpuComputeContext.h>
+#include <osd/cpuComputeController.h>
+#include <osd/cpuEvalLimitContext.h>
+#include <osd/cpuEvalLimitController.h>
+#include <osd/scheduler.h>
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #include <osd/ompComputeController.h>
+#endif
+
+#include <osdutil/adaptiveEvaluator.h>
+#include <osdutil/uniformEvaluator.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../common/cpu_batch_utils.h"
+#include "../common/limit_utils.h"
+#include "../common/shape_utils.h"
+
+//
+// Regression testing of the CPU evaluation paths of Osd and OsdUtil (the code
+// that does not require a GPU API) :
+//
+// - the parallel paths are compared to their serial counterparts, which the
+//   other regressions check against Hbr.
+//
+// - the evaluation and query paths are compared to reference results (limit
+//   positions of refined Hbr meshes, brute force searches).
+//
+// Usage : cpu_regression [-v]
+//
+
+using namespace OpenSubdiv;
+
+static int g_verbose = 0;
+
+//------------------------------------------------------------------------------
+// Compares FinalizeUpdateParallel to FinalizeUpdate on a batch of meshes :
+// both refine the same kernel batches of a mesh in the same order, so the
+// results must be identical. The second update only dirties some of the
+// meshes.
+static int
+checkBatchParallel(char const * msg, std::vector<std::string> const & shapes,
+                   int level, int numThreads) {
+
+    int count = 0;
+
+    std::vector<HbrMesh<OsdVertex> *> hmeshes;
+    std::vector<FarMesh<OsdVertex> const *> fmeshes;
+    std::vector<std::vector<float> > positions(shapes.size());
+
+    for (int i=0; i<(int)shapes.size(); ++i) {
+        hmeshes.push_back(simpleHbr<OsdVertex>(shapes[i].c_str(), kCatmark, positions[i]));
+        FarMeshFactory<OsdVertex> factory(hmeshes[i], level);
+        fmeshes.push_back(factory.Create());
+    }
+
+    OsdCpuComputeController controller;
+
+    CpuMeshBatch * serial = CpuMeshBatch::Create(&controller, fmeshes, 3, 0, 0),
+                  * parallel = CpuMeshBatch::Create(&controller, fmeshes, 3, 0, 0);
+
+    int numMeshes = (int)shapes.size();
+
+    for (int pass=0; pass<2; ++pass) {
+
+        // the second pass moves every other mesh
+        for (int i=0; i<numMeshes; ++i) {
+            if (pass==1 and (i%2)==0)
+                continue;
+            std::vector<float> & p = positions[i];
+            for (int j=0; j<(int)p.size(); ++j) {
+                p[j] = p[j]*(1.0f+0.25f*pass) + 0.1f*pass;
+            }
+            serial->UpdateCoarseVertices(i, &p[0], (int)p.size()/3);
+            parallel->UpdateCoarseVertices(i, &p[0], (int)p.size()/3);
+        }
+
+        serial->FinalizeUpdate();
+        parallel->FinalizeUpdateParallel(numThreads);
+
+        float const * a = serial->GetVertexBuffer()->BindCpuBuffer(),
+                    * b = parallel->GetVertexBuffer()->BindCpuBuffer();
+
+        int numFloats = serial->GetNumVertices()*3, mismatches = 0;
+        for (int j=0; j<numFloats; ++j) {
+            if (a[j]!=b[j]) {
+                ++mismatches;
+            }
+        }
+        if (mismatches) {
+            printf("// %s pass %d : %d values differ from the serial update\n",
+                msg, pass, mismatches);
+            ++count;
+        }
+
+        // clean meshes are not refined
+        for (int i=0; i<numMeshes; ++i) {
+            bool dirty = pass==0 or (i%2)==1;
+            if (parallel->GetMeshRefineTime(i)<0.0 or
+                (not dirty and parallel->GetMeshRefineTime(i)!=0.0)) {
+                printf("// %s pass %d : unexpected refine time %f for mesh %d\n",
+                    msg, pass, parallel->GetMeshRefineTime(i), i);
+                ++count;
+            }
+        }
+    }
+
+    if (g_verbose or count) {
+        printf("%s : %d meshes, %d threads, %s\n", msg, numMeshes, numThreads,
+            count ? "failed" : "passed");
+    }
+
+    delete serial;
+    delete parallel;
+    for (int i=0; i<numMeshes; ++i) {
+        delete fmeshes[i];
+        delete hmeshes[i];
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Compares the stencil refinement of OsdUtilUniformEvaluator to the level by
+// level refinement (positions and vertex varying data), and checks that the
+// coarse data setters reject data that doesn't fit the coarse vertices.
+static int
+checkUniformEvaluator(char const * msg, std::string const & shape, int level) {
+
+    int count = 0;
+
+    OsdUtilSubdivTopology topology;
+    std::vector<float> positions;
+    std::string errorMessage;
+    if (not topology.ParseFromObjString(shape.c_str(), 1, &positions, &errorMessage)) {
+        printf("// %s : %s\n", msg, errorMessage.c_str());
+        return 1;
+    }
+    topology.refinementLevel = level;
+    topology.vvNames.push_back("u");
+    topology.vvNames.push_back("v");
+
+    int numCoarse = topology.numVertices;
+
+    std::vector<float> vvData(numCoarse*2);
+    for (int i=0; i<numCoarse*2; ++i) {
+        vvData[i] = (float)(i%7) * 0.125f;
+    }
+
+    OsdUtilUniformEvaluator evaluators[2];
+    evaluators[1].SetUseStencils(true);
+
+    for (int i=0; i<2; ++i) {
+        OsdUtilUniformEvaluator & e = evaluators[i];
+
+        if (not e.Initialize(topology, &errorMessage) or
+            not e.SetCoarsePositions(positions, &errorMessage) or
+            not e.SetCoarseVVData(vvData, &errorMessage) or
+            not e.Refine(1, &errorMessage)) {
+            printf("// %s : %s\n", msg, errorMessage.c_str());
+            return 1;
+        }
+
+        // one vertex too many, and a partial vertex
+        std::vector<float> tooMany(positions);
+        tooMany.resize(tooMany.size()+3, 0.0f);
+        if (e.SetCoarsePositions(tooMany)) {
+            printf("// %s : accepted %d positions for %d coarse vertices\n",
+                msg, (int)tooMany.size()/3, numCoarse);
+            ++count;
+        }
+
+        std::vector<float> badVV(vvData);
+        badVV.resize(badVV.size()+2, 0.0f);
+        if (e.SetCoarseVVData(badVV)) {
+            printf("// %s : accepted VV data for %d coarse vertices\n",
+                msg, (int)badVV.size()/2);
+            ++count;
+        }
+        badVV.resize(vvData.size()-1);
+        if (e.SetCoarseVVData(badVV)) {
+            printf("// %s : accepted a partial VV data vertex\n", msg);
+            ++count;
+        }
+    }
+
+    if (evaluators[1].IsUsingStencils()==false) {
+        printf("// %s : the evaluator did not use stencils\n", msg);
+        ++count;
+    }
+
+    float const * p[2];
+    float * vv[2];
+    int numFloats[2], numVVFloats[2];
+    for (int i=0; i<2; ++i) {
+        if (not evaluators[i].GetRefinedPositions(&p[i], &numFloats[i]) or
+            not evaluators[i].GetRefinedVVData(&vv[i], &numVVFloats[i])) {
+            printf("// %s : no refined data\n", msg);
+            return count+1;
+        }
+    }
+
+    if (numFloats[0]!=numFloats[1] or numVVFloats[0]!=numVVFloats[1]) {
+        printf("// %s : refined sizes differ (%d/%d, %d/%d)\n", msg,
+            numFloats[0], numFloats[1], numVVFloats[0], numVVFloats[1]);
+        return count+1;
+    }
+
+    float maxdiff = 0.0f;
+    for (int i=0; i<numFloats[0]; ++i) {
+        maxdiff = std::max(maxdiff, std::abs(p[0][i]-p[1][i]));
+    }
+    for (int i=0; i<numVVFloats[0]; ++i) {
+        maxdiff = std::max(maxdiff, std::abs(vv[0][i]-vv[1][i]));
+    }
+    if (maxdiff>1e-5f) {
+        printf("// %s : stencils differ from the level by level refinement by %e\n",
+            msg, maxdiff);
+        ++count;
+    }
+
+    if (g_verbose or count) {
+        printf("%s : level %d, max difference %e, %s\n", msg, level, maxdiff,
+            count ? "failed" : "passed");
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Refines a mesh with a compute context that copies the Far tables and with
+// one that shares them : the results must be identical, and the shared tables
+// must reference the Far storage.
+static int
+checkTableStorage(char const * msg, std::string const & shape, int level) {
+
+    int count = 0;
+
+    std::vector<float> positions;
+    HbrMesh<OsdVertex> * hmesh = simpleHbr<OsdVertex>(shape.c_str(), kCatmark, positions);
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level);
+    FarMesh<OsdVertex> * fmesh = factory.Create();
+
+    FarSubdivisionTables const * tables = fmesh->GetSubdivisionTables();
+    FarVertexEditTables const * edits = fmesh->GetVertexEditTables();
+
+    OsdCpuComputeContext * contexts[2] = {
+        OsdCpuComputeContext::Create(tables, edits, OsdCpuComputeContext::COPY_TABLES),
+        OsdCpuComputeContext::Create(tables, edits, OsdCpuComputeContext::SHARE_TABLES) };
+
+    if (contexts[0]->GetTable(FarSubdivisionTables::E_IT)->GetBuffer()==&tables->Get_E_IT()[0] or
+        contexts[1]->GetTable(FarSubdivisionTables::E_IT)->GetBuffer()!=&tables->Get_E_IT()[0] or
+        contexts[1]->GetTable(FarSubdivisionTables::V_W)->GetBuffer()!=&tables->Get_V_W()[0]) {
+        printf("// %s : the tables are not copied or shared as requested\n", msg);
+        ++count;
+    }
+    if (edits and edits->GetNumBatches()>0 and
+        contexts[1]->GetEditTable(0)->GetEditValues()->GetBuffer()!=&edits->GetBatch(0).GetValues()[0]) {
+        printf("// %s : the vertex edit tables are not shared\n", msg);
+        ++count;
+    }
+
+    OsdCpuComputeController controller;
+
+    int nverts = fmesh->GetNumVertices(),
+        ncoarse = (int)positions.size()/3;
+
+    OsdCpuVertexBuffer * buffers[2];
+    for (int i=0; i<2; ++i) {
+        buffers[i] = OsdCpuVertexBuffer::Create(3, nverts);
+        buffers[i]->UpdateData(&positions[0], 0, ncoarse);
+        controller.Refine(contexts[i], fmesh->GetKernelBatches(), buffers[i]);
+    }
+
+    if (memcmp(buffers[0]->BindCpuBuffer(), buffers[1]->BindCpuBuffer(),
+               nverts*3*sizeof(float))!=0) {
+        printf("// %s : refining with shared tables differs from copied tables\n", msg);
+        ++count;
+    }
+
+    if (g_verbose or count) {
+        printf("%s : level %d, %d vertices, %s\n", msg, level, nverts,
+            count ? "failed" : "passed");
+    }
+
+    for (int i=0; i<2; ++i) {
+        delete buffers[i];
+        delete contexts[i];
+    }
+    delete fmesh;
+    delete hmesh;
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Refines face-varying values with the compute controllers (serial, on a
+// scheduler and OpenMP) and compares them to FarFVarTables::RefineValues,
+// which far_regression checks against Hbr : the stencils are applied in the
+// same order, so the results must be identical.
+template <class CONTROLLER> static int
+compareFVarRefinement(char const * msg, char const * name, CONTROLLER & controller,
+                      OsdCpuComputeContext const * context,
+                      std::vector<float> const & coarse, std::vector<float> const & reference) {
+
+    OsdCpuFVarTable const * table = context->GetFVarTable();
+
+    OsdCpuVertexBuffer * buffer =
+        OsdCpuVertexBuffer::Create(table->GetFVarWidth(), table->GetNumValues());
+
+    buffer->UpdateData(&coarse[0], 0, (int)coarse.size()/table->GetFVarWidth());
+
+    controller.RefineFVar(context, buffer);
+
+    int count = 0;
+    if (memcmp(buffer->BindCpuBuffer(), &reference[0], reference.size()*sizeof(float))!=0) {
+        printf("// %s : %s face-varying refinement differs from FarFVarTables\n", msg, name);
+        count = 1;
+    }
+    delete buffer;
+    return count;
+}
+
+static int
+checkFVarRefinement(char const * msg, std::string const & shape, int level, bool adaptive) {
+
+    int count = 0;
+
+    std::vector<float> positions;
+    HbrMesh<OsdVertex> * hmesh =
+        simpleHbr<OsdVertex>(shape.c_str(), kCatmark, positions, /*fvar*/ true);
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level, adaptive);
+    FarMesh<OsdVertex> * fmesh = factory.Create(/*requireFVarData*/ true,
+                                                /*requireFVarTables*/ true);
+
+    FarFVarTables const * tables = fmesh->GetFVarTables();
+    if (not tables) {
+        printf("// %s : no face-varying tables\n", msg);
+        delete fmesh;
+        delete hmesh;
+        return 1;
+    }
+
+    int width = tables->GetFVarWidth();
+
+    // coarse values : one per face-vertex of each coarse face
+    std::vector<float> coarse;
+    for (int i=0; i<hmesh->GetNumCoarseFaces(); ++i) {
+        HbrFace<OsdVertex> * f = hmesh->GetFace(i);
+        for (int j=0; j<f->GetNumVertices(); ++j) {
+            float const * data = f->GetFVarData(j).GetData(0);
+            coarse.insert(coarse.end(), data, data+width);
+        }
+    }
+
+    std::vector<float> reference(tables->GetNumValues()*width);
+    std::copy(coarse.begin(), coarse.end(), reference.begin());
+    tables->RefineValues(&reference[0]);
+
+    OsdCpuComputeContext * context = OsdCpuComputeContext::Create(
+        fmesh->GetSubdivisionTables(), fmesh->GetVertexEditTables(), tables);
+
+    {   OsdCpuComputeController controller;
+        count += compareFVarRefinement(msg, "cpu", controller, context, coarse, reference);
+    }
+    {   OsdDefaultScheduler scheduler(4);
+        OsdCpuComputeController controller(&scheduler);
+        count += compareFVarRefinement(msg, "scheduler", controller, context, coarse, reference);
+    }
+#ifdef OPENSUBDIV_HAS_OPENMP
+    {   OsdOmpComputeController controller(4);
+        count += compareFVarRefinement(msg, "omp", controller, context, coarse, reference);
+    }
+#endif
+
+    if (g_verbose or count) {
+        printf("%s : level %d %s, %d face-varying values, %s\n", msg, level,
+            adaptive ? "adaptive" : "uniform", tables->GetNumValues(),
+            count ? "failed" : "passed");
+    }
+
+    delete context;
+    delete fmesh;
+    delete hmesh;
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Evaluates samples of every ptex face with the buffers bound to the
+// controller (using its Gregory cache if it is up to date) and returns the
+// largest difference with the reference positions
+static float
+evalLimitDiff(OsdCpuEvalLimitController & controller, OsdCpuEvalLimitContext * context,
+              std::vector<OsdEvalCoords> const & coords, OsdCpuVertexBuffer * output,
+              std::vector<float> const & reference) {
+
+    for (int i=0; i<(int)coords.size(); ++i) {
+        controller.EvalLimitSample(coords[i], context, i);
+    }
+
+    float const * p = output->BindCpuBuffer();
+    float maxdiff = 0.0f;
+    for (int i=0; i<(int)reference.size(); ++i) {
+        maxdiff = std::max(maxdiff, std::abs(p[i]-reference[i]));
+    }
+    return maxdiff;
+}
+
+// Checks that the Gregory patches cached by OsdCpuEvalLimitController are
+// never used for another pose or context : two controllers sharing a
+// context, a controller and a context created where deleted ones were, and
+// vertex data modified in place. The reference positions are evaluated
+// without the cache.
+static int
+checkGregoryCache(char const * msg, std::string const & shape, int level) {
+
+    int count = 0;
+
+    std::vector<float> positions;
+    HbrMesh<OsdVertex> * hmesh = simpleHbr<OsdVertex>(shape.c_str(), kCatmark, positions);
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level, /*adaptive*/ true);
+    FarMesh<OsdVertex> * fmesh = factory.Create();
+
+    int nverts = fmesh->GetNumVertices(),
+        ncoarse = (int)positions.size()/3;
+
+    // two poses of the mesh
+    OsdCpuComputeContext * computeContext = OsdCpuComputeContext::Create(
+        fmesh->GetSubdivisionTables(), fmesh->GetVertexEditTables());
+    OsdCpuComputeController computeController;
+
+    OsdCpuVertexBuffer * poses[2];
+    for (int i=0; i<2; ++i) {
+        std::vector<float> p(positions);
+        for (int j=0; j<(int)p.size(); ++j) {
+            p[j] = p[j]*(1.0f+0.5f*i) + (float)((j*7)%5)*0.05f*i;
+        }
+        poses[i] = OsdCpuVertexBuffer::Create(3, nverts);
+        poses[i]->UpdateData(&p[0], 0, ncoarse);
+        computeController.Refine(computeContext, fmesh->GetKernelBatches(), poses[i]);
+    }
+
+    std::vector<OsdEvalCoords> coords;
+    int nfaces = fmesh->GetPatchTables()->GetNumPtexFaces();
+    for (int face=0; face<nfaces; ++face) {
+        coords.push_back(OsdEvalCoords(face, 0.5f, 0.5f));
+        coords.push_back(OsdEvalCoords(face, 0.1f, 0.8f));
+        coords.push_back(OsdEvalCoords(face, 0.9f, 0.3f));
+    }
+    int nsamples = (int)coords.size();
+
+    OsdVertexBufferDescriptor desc(0, 3, 3);
+
+    OsdCpuEvalLimitContext * context =
+        OsdCpuEvalLimitContext::Create(fmesh->GetPatchTables());
+
+    if (context->GetNumGregoryPatches()==0) {
+        printf("// %s : no Gregory patches to cache\n", msg);
+        ++count;
+    }
+
+    OsdCpuVertexBuffer * outputs[2] = { OsdCpuVertexBuffer::Create(3, nsamples),
+                                        OsdCpuVertexBuffer::Create(3, nsamples) };
+
+    // reference positions, evaluated without the cache
+    std::vector<float> reference[2];
+    {   OsdCpuEvalLimitController controller;
+        for (int i=0; i<2; ++i) {
+            OsdCpuEvalLimitController::Bindings bindings;
+            bindings.BindVertexBuffers(desc, poses[i], desc, outputs[i]);
+            for (int j=0; j<nsamples; ++j) {
+                controller.EvalLimitSample(coords[j], context, bindings, j);
+            }
+            float const * p = outputs[i]->BindCpuBuffer();
+            reference[i].assign(p, p+nsamples*3);
+        }
+    }
+
+    float const tolerance = 1e-6f;
+    float diff;
+
+    // two controllers evaluating the same context, each with its own pose
+    {   OsdCpuEvalLimitController a, b;
+        a.BindVertexBuffers(desc, poses[0], desc, outputs[0]);
+        b.BindVertexBuffers(desc, poses[1], desc, outputs[1]);
+        a.UpdateGregoryCache(context);
+        b.UpdateGregoryCache(context);
+        if ((diff=evalLimitDiff(a, context, coords, outputs[0], reference[0]))>tolerance or
+            (diff=evalLimitDiff(b, context, coords, outputs[1], reference[1]))>tolerance) {
+            printf("// %s : controllers sharing a context differ by %e\n", msg, diff);
+            ++count;
+        }
+    }
+
+    // a new controller, likely allocated where the previous one was, binding
+    // another pose without updating the cache
+    OsdCpuEvalLimitController * controller = new OsdCpuEvalLimitController;
+    controller->BindVertexBuffers(desc, poses[0], desc, outputs[0]);
+    controller->UpdateGregoryCache(context);
+    delete controller;
+
+    controller = new OsdCpuEvalLimitController;
+    controller->BindVertexBuffers(desc, poses[1], desc, outputs[1]);
+    if ((diff=evalLimitDiff(*controller, context, coords, outputs[1], reference[1]))>tolerance) {
+        printf("// %s : a new controller used a stale cache (difference %e)\n", msg, diff);
+        ++count;
+    }
+
+    // a new context, likely allocated where the previous one was
+    controller->UpdateGregoryCache(context);
+    delete context;
+    context = OsdCpuEvalLimitContext::Create(fmesh->GetPatchTables());
+    controller->BindVertexBuffers(desc, poses[0], desc, outputs[0]);
+    controller->UpdateGregoryCache(context);
+    if ((diff=evalLimitDiff(*controller, context, coords, outputs[0], reference[0]))>tolerance) {
+        printf("// %s : a new context used a stale cache (difference %e)\n", msg, diff);
+        ++count;
+    }
+
+    // the bound vertex data modified in place
+    poses[0]->UpdateData(poses[1]->BindCpuBuffer(), 0, nverts);
+    context->InvalidateGregoryCache();
+    if ((diff=evalLimitDiff(*controller, context, coords, outputs[0], reference[1]))>tolerance) {
+        printf("// %s : the invalidated cache was used (difference %e)\n", msg, diff);
+        ++count;
+    }
+
+    if (g_verbose or count) {
+        printf("%s : level %d, %d Gregory patches, %s\n", msg, level,
+            context->GetNumGregoryPatches(), count ? "failed" : "passed");
+    }
+
+    delete controller;
+    delete context;
+    for (int i=0; i<2; ++i) {
+        delete poses[i];
+        delete outputs[i];
+    }
+    delete computeContext;
+    delete fmesh;
+    delete hmesh;
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Refines the coarse positions of an adaptive mesh and evaluates its limit
+// surface at the given ptex coordinates
+static void
+evalLimitPositions(FarMesh<OsdVertex> * fmesh, std::vector<float> const & positions,
+                   std::vector<OsdEvalCoords> const & coords, std::vector<float> & result) {
+
+    OsdCpuComputeContext * computeContext = OsdCpuComputeContext::Create(
+        fmesh->GetSubdivisionTables(), fmesh->GetVertexEditTables());
+
+    OsdCpuVertexBuffer * vertices = OsdCpuVertexBuffer::Create(3, fmesh->GetNumVertices()),
+                       * output = OsdCpuVertexBuffer::Create(3, std::max(1, (int)coords.size()));
+    vertices->UpdateData(&positions[0], 0, (int)positions.size()/3);
+
+    OsdCpuComputeController computeController;
+    computeController.Refine(computeContext, fmesh->GetKernelBatches(), vertices);
+
+    OsdCpuEvalLimitContext * context = OsdCpuEvalLimitContext::Create(fmesh->GetPatchTables());
+
+    OsdVertexBufferDescriptor desc(0, 3, 3);
+    OsdCpuEvalLimitController controller;
+    controller.BindVertexBuffers(desc, vertices, desc, output);
+
+    for (int i=0; i<(int)coords.size(); ++i) {
+        controller.EvalLimitSample(coords[i], context, i);
+    }
+
+    float const * p = output->BindCpuBuffer();
+    result.assign(p, p+coords.size()*3);
+
+    delete context;
+    delete computeContext;
+    delete vertices;
+    delete output;
+}
+
+static float
+distance(float const * a, float const * b) {
+    float d[3] = { a[0]-b[0], a[1]-b[1], a[2]-b[2] };
+    return sqrtf(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+}
+
+// Evaluates the limit surface of an adaptive mesh at the samples of a
+// uniformly refined Hbr mesh (see limit_utils.h) and returns the largest
+// distance to the reference limit positions on the B-spline and box-spline
+// patches. The distance on the Gregory and irregular Loop patches, which
+// only approximate the limit surface, is returned in 'approximation'.
+static float
+limitDistance(FarMesh<OsdVertex> * fmesh, std::vector<float> const & positions,
+              std::string const & shape, Scheme scheme, int level,
+              float * approximation=0, int * nsamples=0) {
+
+    xyzLimitMesh * reference = simpleHbr<xyzVV>(shape.c_str(), scheme);
+
+    std::vector<LimitSample> samples;
+    getLimitSamples(reference, scheme, level, samples);
+
+    std::vector<OsdEvalCoords> coords;
+    for (int i=0; i<(int)samples.size(); ++i) {
+        coords.push_back(OsdEvalCoords(samples[i].face, samples[i].u, samples[i].v));
+    }
+
+    std::vector<float> result;
+    evalLimitPositions(fmesh, positions, coords, result);
+
+    FarPatchTables const * patchTables = fmesh->GetPatchTables();
+    FarPatchMap patchMap(*patchTables);
+
+    float maxdist = 0.0f, maxapprox = 0.0f;
+    for (int i=0; i<(int)samples.size(); ++i) {
+
+        FarPatchMap::Handle const * handle =
+            patchMap.FindPatch(samples[i].face, samples[i].u, samples[i].v);
+        assert(handle);
+
+        FarPatchTables::Type type =
+            patchTables->GetPatchArrayVector()[handle->patchArrayIdx].GetDescriptor().GetType();
+
+        float dist = distance(&result[i*3], samples[i].position);
+        if (type==FarPatchTables::GREGORY or type==FarPatchTables::GREGORY_BOUNDARY or
+            type==FarPatchTables::LOOP_IRREGULAR)
+            maxapprox = std::max(maxapprox, dist);
+        else
+            maxdist = std::max(maxdist, dist);
+    }
+
+    if (approximation)
+        *approximation = maxapprox;
+    if (nsamples)
+        *nsamples = (int)samples.size();
+
+    delete reference;
+    return maxdist;
+}
+
+//------------------------------------------------------------------------------
+// Checks the patches of faces along regular infinitely sharp creases : they
+// are evaluated as B-spline boundary patches without isolating the creases,
+// so the patches are regular or boundary patches of depth 1 at most, and
+// their limit positions match the Hbr crease rules.
+static int
+checkRegularCreases(char const * msg, std::string const & shape, int level) {
+
+    int count = 0;
+
+    std::vector<float> positions;
+    HbrMesh<OsdVertex> * hmesh = simpleHbr<OsdVertex>(shape.c_str(), kCatmark, positions);
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level, /*adaptive*/ true);
+    FarMesh<OsdVertex> * fmesh = factory.Create();
+
+    FarPatchTables const * patchTables = fmesh->GetPatchTables();
+    FarPatchTables::PatchArrayVector const & parrays = patchTables->GetPatchArrayVector();
+    FarPatchTables::PatchParamTable const & params = patchTables->GetPatchParamTable();
+
+    int nboundaries = 0;
+    for (int i=0; i<(int)parrays.size(); ++i) {
+        FarPatchTables::Type type = parrays[i].GetDescriptor().GetType();
+        if (type==FarPatchTables::BOUNDARY) {
+            nboundaries += parrays[i].GetNumPatches();
+        } else if (type!=FarPatchTables::REGULAR) {
+            printf("// %s : unexpected patches of type %d\n", msg, type);
+            ++count;
+        }
+    }
+    if (nboundaries==0) {
+        printf("// %s : the creases are not evaluated as boundary patches\n", msg);
+        ++count;
+    }
+
+    int maxdepth = 0;
+    for (int i=0; i<(int)params.size(); ++i) {
+        maxdepth = std::max(maxdepth, (int)params[i].bitField.GetDepth());
+    }
+    if (maxdepth>1) {
+        printf("// %s : the creases are isolated down to level %d\n", msg, maxdepth);
+        ++count;
+    }
+
+    int nsamples = 0;
+    float dist = limitDistance(fmesh, positions, shape, kCatmark, 4, 0, &nsamples);
+    if (nsamples==0 or dist>1e-5f) {
+        printf("// %s : the limit positions differ from Hbr by %e (%d samples)\n",
+            msg, dist, nsamples);
+        ++count;
+    }
+
+    if (g_verbose or count) {
+        printf("%s : level %d, %d patches (%d boundary), max depth %d, "
+            "limit distance %e, %s\n", msg, level, (int)params.size(), nboundaries,
+            maxdepth, dist, count ? "failed" : "passed");
+    }
+
+    delete fmesh;
+    delete hmesh;
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Compares the limit evaluation of adaptive Loop patches to the limit
+// positions of a refined Hbr mesh (far_regression checks that the patches
+// tile the ptex faces). The box-spline patches must match the limit surface.
+// The irregular patches around extraordinary vertices only approximate it :
+// their error must decrease with each level of isolation.
+static int
+checkLoopLimit(char const * msg, std::string const & shape, int level) {
+
+    int count = 0;
+
+    float dist[2], approx[2];
+    int npatches = 0;
+    for (int i=0; i<2; ++i) {
+
+        std::vector<float> positions;
+        HbrMesh<OsdVertex> * hmesh = simpleHbr<OsdVertex>(shape.c_str(), kLoop, positions);
+
+        FarMeshFactory<OsdVertex> factory(hmesh, level+i, /*adaptive*/ true);
+        FarMesh<OsdVertex> * fmesh = factory.Create();
+
+        npatches = fmesh->GetPatchTables()->GetNumPatches();
+
+        // sample the irregular patches of both levels inside
+        dist[i] = limitDistance(fmesh, positions, shape, kLoop, level+3, &approx[i]);
+
+        delete fmesh;
+        delete hmesh;
+    }
+
+    if (std::max(dist[0], dist[1])>1e-5f) {
+        printf("// %s : the Loop patches differ from Hbr by %e\n", msg,
+            std::max(dist[0], dist[1]));
+        ++count;
+    }
+
+    // the surface around a vertex of valence n behaves like s^a in the ptex
+    // coordinates, with 2^-a the subdominant eigenvalue of the Loop scheme :
+    // no polynomial patch converges faster than 2^a per level (a>1)
+    if (approx[0]==0.0f or approx[1]>0.5f*approx[0]) {
+        printf("// %s : the irregular Loop patches do not converge (%e %e)\n", msg,
+            approx[0], approx[1]);
+        ++count;
+    }
+
+    if (g_verbose or count) {
+        printf("%s : levels %d-%d, %d patches, limit distance %e, irregular "
+            "patches %e -> %e, %s\n", msg, level, level+1, npatches,
+            std::max(dist[0], dist[1]), approx[0], approx[1],
+            count ? "failed" : "passed");
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns the ptex coordinates at 't' along the edge 'edge' of a quad
+static OsdEvalCoords
+quadEdgeCoords(int face, int edge, float t) {
+    switch (edge) {
+        case 0 : return OsdEvalCoords(face, t, 0.0f);
+        case 1 : return OsdEvalCoords(face, 1.0f, t);
+        case 2 : return OsdEvalCoords(face, 1.0f-t, 1.0f);
+        default: return OsdEvalCoords(face, 0.0f, 1.0f-t);
+    }
+}
+
+// Checks that the limit surface of an adaptive mesh has no cracks : the
+// positions evaluated on both sides of the boundaries between the patches
+// of each ptex face must match, as well as the positions evaluated from both
+// quads that share a coarse edge. With 'perFaceIsolation', the coarse faces
+// are given isolation levels between 0 and 'level', so that the faces of
+// deeply isolated features are next to faces that are not isolated.
+static int
+checkWatertight(char const * msg, std::string const & shape, int level,
+                bool perFaceIsolation) {
+
+    int count = 0;
+
+    std::vector<float> positions;
+    HbrMesh<OsdVertex> * hmesh = simpleHbr<OsdVertex>(shape.c_str(), kCatmark, positions);
+
+    std::vector<int> faceIsolation(hmesh->GetNumCoarseFaces());
+    for (int i=0; i<(int)faceIsolation.size(); ++i) {
+        faceIsolation[i] = (i*5)%(level+1);
+    }
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level, /*adaptive*/ true, -1,
+        FarPatchTables::QUADS, NULL, perFaceIsolation ? &faceIsolation : NULL);
+    FarMesh<OsdVertex> * fmesh = factory.Create();
+
+    // pairs of samples on both sides of the lines of the patches of the
+    // deepest level
+    std::vector<OsdEvalCoords> inner;
+    float const eps = 1e-5f;
+    int const nsamples = 8,
+              nlines = 1<<level;
+    for (int face=0; face<fmesh->GetPatchTables()->GetNumPtexFaces(); ++face) {
+        for (int i=1; i<nlines; ++i) {
+            float x = float(i)/nlines;
+            for (int j=0; j<nsamples; ++j) {
+                float t = (j+0.5f)/nsamples;
+                inner.push_back(OsdEvalCoords(face, x-eps, t));
+                inner.push_back(OsdEvalCoords(face, x+eps, t));
+                inner.push_back(OsdEvalCoords(face, t, x-eps));
+                inner.push_back(OsdEvalCoords(face, t, x+eps));
+            }
+        }
+    }
+
+    // pairs of samples along the coarse edges shared by two quads
+    std::vector<OsdEvalCoords> edges;
+    for (int i=0; i<hmesh->GetNumCoarseFaces(); ++i) {
+        HbrFace<OsdVertex> * f = hmesh->GetFace(i);
+        if (f->GetNumVertices()!=4 or f->IsHole())
+            continue;
+        for (int k=0; k<4; ++k) {
+            HbrHalfedge<OsdVertex> * e = f->GetEdge(k)->GetOpposite();
+            HbrFace<OsdVertex> * g = e ? e->GetFace() : 0;
+            if ((not g) or g->GetNumVertices()!=4 or g->IsHole())
+                continue;
+            int m = 0;
+            while (g->GetVertex(m)!=f->GetVertex((k+1)%4))
+                ++m;
+            for (int j=0; j<=nsamples; ++j) {
+                float t = float(j)/nsamples;
+                edges.push_back(quadEdgeCoords(f->GetPtexIndex(), k, t));
+                edges.push_back(quadEdgeCoords(g->GetPtexIndex(), m, 1.0f-t));
+            }
+        }
+    }
+
+    std::vector<float> innerPositions, edgePositions;
+    evalLimitPositions(fmesh, positions, inner, innerPositions);
+    evalLimitPositions(fmesh, positions, edges, edgePositions);
+
+    float innerGap = 0.0f, edgeGap = 0.0f;
+    for (int i=0; i<(int)inner.size(); i+=2) {
+        innerGap = std::max(innerGap, distance(&innerPositions[i*3], &innerPositions[(i+1)*3]));
+    }
+    for (int i=0; i<(int)edges.size(); i+=2) {
+        edgeGap = std::max(edgeGap, distance(&edgePositions[i*3], &edgePositions[(i+1)*3]));
+    }
+
+    // the samples inside the ptex faces are 2*eps apart
+    if (innerGap>1e-4f or edgeGap>1e-5f) {
+        printf("// %s : the limit surface has cracks (%e inside the ptex faces, "
+            "%e along the coarse edges)\n", msg, innerGap, edgeGap);
+        ++count;
+    }
+
+    if (g_verbose or count) {
+        printf("%s : level %d%s, %d patches, gaps %e %e, %s\n", msg, level,
+            perFaceIsolation ? " (per-face isolation)" : "",
+            fmesh->GetPatchTables()->GetNumPatches(), innerGap, edgeGap,
+            count ? "failed" : "passed");
+    }
+
+    delete fmesh;
+    delete hmesh;
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of half-edges of a tessellated mesh that are not matched
+// by exactly one opposite half-edge
+static int
+countOpenEdges(OsdUtilSubdivTopology const & t) {
+
+    std::map<std::pair<int,int>, int> halfedges;
+    for (int i=0, ofs=0; i<(int)t.nverts.size(); ofs+=t.nverts[i++]) {
+        for (int j=0; j<t.nverts[i]; ++j) {
+            int a = t.indices[ofs+j],
+                b = t.indices[ofs+(j+1)%t.nverts[i]];
+            ++halfedges[std::make_pair(a,b)];
+        }
+    }
+
+    int count = 0;
+    std::map<std::pair<int,int>, int>::const_iterator it;
+    for (it=halfedges.begin(); it!=halfedges.end(); ++it) {
+        std::map<std::pair<int,int>, int>::const_iterator opposite =
+            halfedges.find(std::make_pair(it->first.second, it->first.first));
+        if (it->second!=1 or opposite==halfedges.end() or opposite->second!=1)
+            ++count;
+    }
+    return count;
+}
+
+// Returns the number of segments the tessellator splits the boundary edges of
+// a coarse mesh into (the edges of non-quads have an even rate with Catmark)
+static int
+countBoundarySegments(OsdUtilSubdivTopology const & t, bool loop,
+                      int tessRate, std::vector<int> const * edgeRates) {
+
+    std::map<std::pair<int,int>, int> edges;
+    for (int i=0, ofs=0; i<(int)t.nverts.size(); ofs+=t.nverts[i++]) {
+        for (int j=0; j<t.nverts[i]; ++j) {
+            int a = t.indices[ofs+j],
+                b = t.indices[ofs+(j+1)%t.nverts[i]];
+            ++edges[std::make_pair(std::min(a,b), std::max(a,b))];
+        }
+    }
+
+    int count = 0;
+    for (int i=0, ofs=0; i<(int)t.nverts.size(); ofs+=t.nverts[i++]) {
+        for (int j=0; j<t.nverts[i]; ++j) {
+            int a = t.indices[ofs+j],
+                b = t.indices[ofs+(j+1)%t.nverts[i]];
+            if (edges[std::make_pair(std::min(a,b), std::max(a,b))]==1) {
+                int rate = edgeRates ? std::max(1, (*edgeRates)[ofs+j]) : tessRate;
+                if ((not loop) and t.nverts[i]!=4)
+                    rate += rate & 1;
+                count += rate;
+            }
+        }
+    }
+    return count;
+}
+
+// Checks the tessellation of the limit surface of a mesh by
+// OsdUtilAdaptiveEvaluator::GetRefinedTopology :
+//
+//   - the coarse positions setter rejects the positions that do not match
+//     the coarse vertices (and accepts the fully regular meshes, which have
+//     no refined vertices)
+//   - the tessellated meshes are watertight (only the segments of the coarse
+//     boundary edges are open), at a uniform rate and at different rates for
+//     each face-edge
+//   - at a uniform rate, the tessellated vertices are the limit positions of
+//     the grid of each ptex face (evaluated with EvaluateLimit), each of
+//     them output once
+//   - the evaluation on several threads gives the same positions
+static int
+checkTessellator(char const * msg, std::string const & shape,
+                 OsdUtilMesh<OsdVertex>::Scheme scheme, int level, int tessRate) {
+
+    int count = 0;
+
+    OsdUtilSubdivTopology topology;
+    std::vector<float> positions;
+    std::string errorMessage;
+    if (not topology.ParseFromObjString(shape.c_str(), 1, &positions, &errorMessage)) {
+        printf("// %s : %s\n", msg, errorMessage.c_str());
+        return 1;
+    }
+    topology.refinementLevel = level;
+
+    OsdUtilAdaptiveEvaluator evaluator;
+    if (not evaluator.Initialize(topology, &errorMessage, scheme) or
+        not evaluator.SetCoarsePositions(&positions[0], (int)positions.size(), &errorMessage) or
+        not evaluator.Refine(1, &errorMessage)) {
+        printf("// %s : %s\n", msg, errorMessage.c_str());
+        return 1;
+    }
+
+    // one vertex too many, and a partial vertex
+    std::vector<float> tooMany(positions);
+    tooMany.resize(tooMany.size()+3, 0.0f);
+    if (evaluator.SetCoarsePositions(&tooMany[0], (int)tooMany.size()) or
+        evaluator.SetCoarsePositions(&positions[0], (int)positions.size()-1)) {
+        printf("// %s : accepted positions that do not match %d coarse vertices\n",
+            msg, topology.numVertices);
+        ++count;
+    }
+
+    bool loop = scheme==OsdUtilMesh<OsdVertex>::SCHEME_LOOP;
+
+    // uniform rate, evaluated on 1 and 4 threads
+    OsdUtilSubdivTopology tess[2];
+    std::vector<float> tessPositions[2];
+    for (int i=0; i<2; ++i) {
+        if (not evaluator.GetRefinedTopology(&tess[i], &tessPositions[i],
+                &errorMessage, tessRate, NULL, i==0 ? 1 : 4)) {
+            printf("// %s : %s\n", msg, errorMessage.c_str());
+            return count+1;
+        }
+    }
+    if (tessPositions[0]!=tessPositions[1]) {
+        printf("// %s : the tessellation differs on 4 threads\n", msg);
+        ++count;
+    }
+
+    int openEdges = countOpenEdges(tess[0]) -
+        countBoundarySegments(topology, loop, tessRate, NULL);
+
+    // different rates along each face-edge
+    OsdUtilSubdivTopology tessEdgeRates;
+    std::vector<float> tessEdgeRatesPositions;
+    std::vector<int> edgeRates(topology.indices.size());
+    for (int i=0; i<(int)edgeRates.size(); ++i) {
+        edgeRates[i] = 1 + (i*7)%(2*tessRate);
+    }
+    if (not evaluator.GetRefinedTopology(&tessEdgeRates, &tessEdgeRatesPositions,
+            &errorMessage, tessRate, &edgeRates)) {
+        printf("// %s : %s\n", msg, errorMessage.c_str());
+        return count+1;
+    }
+    int openEdgesRates = countOpenEdges(tessEdgeRates) -
+        countBoundarySegments(topology, loop, tessRate, &edgeRates);
+
+    if (openEdges or openEdgesRates) {
+        printf("// %s : the tessellation has %d cracks (%d with edge rates)\n",
+            msg, openEdges, openEdgesRates);
+        ++count;
+    }
+
+    // the grid of each ptex face (the sub-faces of the non-quads at half rate)
+    std::vector<int> faces;
+    std::vector<float> u, v;
+    for (int i=0, ptex=0; i<(int)topology.nverts.size(); ++i) {
+        int nv = topology.nverts[i],
+            nptex = (loop or nv==4) ? 1 : nv,
+            rate = (loop or nv==4) ? tessRate : tessRate/2;
+        for (int j=0; j<nptex; ++j, ++ptex) {
+            for (int y=0; y<=rate; ++y) {
+                for (int x=0; x<=(loop ? rate-y : rate); ++x) {
+                    faces.push_back(ptex);
+                    u.push_back(float(x)/rate);
+                    v.push_back(float(y)/rate);
+                }
+            }
+        }
+    }
+
+    int nsamples = (int)faces.size();
+    std::vector<float> limit(nsamples*3);
+    evaluator.EvaluateLimit(nsamples, &faces[0], &u[0], &v[0], &limit[0], NULL, NULL);
+
+    // every sample matches a tessellated vertex, and every tessellated vertex
+    // matches a sample
+    int ntess = (int)tessPositions[0].size()/3;
+    std::vector<float> closest(ntess, FLT_MAX);
+    float maxDistance = 0.0f;
+    for (int i=0; i<nsamples; ++i) {
+        float d = FLT_MAX;
+        for (int j=0; j<ntess; ++j) {
+            float dj = distance(&limit[i*3], &tessPositions[0][j*3]);
+            closest[j] = std::min(closest[j], dj);
+            d = std::min(d, dj);
+        }
+        maxDistance = std::max(maxDistance, d);
+    }
+    for (int j=0; j<ntess; ++j) {
+        maxDistance = std::max(maxDistance, closest[j]);
+    }
+
+    if (maxDistance>1e-5f) {
+        printf("// %s : the tessellated vertices are %e away from the limit surface\n",
+            msg, maxDistance);
+        ++count;
+    }
+
+    if (g_verbose or count) {
+        printf("%s : level %d, rate %d, %d vertices, %d with edge rates, "
+            "max distance %e, %s\n", msg, level, tessRate, ntess,
+            (int)tessEdgeRatesPositions.size()/3, maxDistance,
+            count ? "failed" : "passed");
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+static void
+parseArgs(int argc, char ** argv) {
+    for (int i=1; i<argc; ++i) {
+        if (not strcmp(argv[i],"-v")) {
+            g_verbose = 1;
+        } else {
+            printf("Unknown argument \"%s\".\n", argv[i]);
+            exit(1);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+int
+main(int argc, char ** argv) {
+
+    int total=0;
+
+    parseArgs(argc, argv);
+
+#define test_batch_parallel
+#define test_uniform_evaluator
+#define test_gregory_cache
+#define test_table_storage
+#define test_fvar_refinement
+#define test_regular_creases
+#define test_watertight
+#define test_loop_limit
+#define test_tessellator
+
+#include "../shapes/catmark_cube.h"
+#include "../shapes/catmark_car.h"
+#include "../shapes/catmark_pawn.h"
+#include "../shapes/catmark_pyramid.h"
+#include "../shapes/catmark_torus.h"
+#include "../shapes/catmark_square_hedit1.h"
+#include "../shapes/catmark_square_hedit2.h"
+#include "../shapes/catmark_torus_creases0.h"
+#include "../shapes/catmark_torus_creases2.h"
+#include "../shapes/loop_cube.h"
+#include "../shapes/loop_icosahedron.h"
+
+#ifdef test_batch_parallel
+    {   std::vector<std::string> shapes;
+        shapes.push_back(catmark_car);
+        shapes.push_back(catmark_cube);
+        shapes.push_back(catmark_pawn);
+        shapes.push_back(catmark_square_hedit1);
+        shapes.push_back(catmark_torus_creases0);
+        total += checkBatchParallel("test_batch_parallel", shapes, 3, 1);
+        total += checkBatchParallel("test_batch_parallel", shapes, 3, 4);
+    }
+#endif
+
+#ifdef test_uniform_evaluator
+    total += checkUniformEvaluator("test_uniform_evaluator_catmark_cube", catmark_cube, 3);
+    total += checkUniformEvaluator("test_uniform_evaluator_catmark_pawn", catmark_pawn, 3);
+    total += checkUniformEvaluator("test_uniform_evaluator_catmark_torus_creases0", catmark_torus_creases0, 4);
+#endif
+
+#ifdef test_gregory_cache
+    total += checkGregoryCache("test_gregory_cache_catmark_cube", catmark_cube, 2);
+    total += checkGregoryCache("test_gregory_cache_catmark_car", catmark_car, 2);
+#endif
+
+#ifdef test_table_storage
+    total += checkTableStorage("test_table_storage_catmark_car", catmark_car, 3);
+    total += checkTableStorage("test_table_storage_catmark_square_hedit2", catmark_square_hedit2, 3);
+#endif
+
+#ifdef test_fvar_refinement
+    total += checkFVarRefinement("test_fvar_refinement_catmark_cube", catmark_cube, 3, false);
+    total += checkFVarRefinement("test_fvar_refinement_catmark_car", catmark_car, 3, false);
+    total += checkFVarRefinement("test_fvar_refinement_catmark_car", catmark_car, 3, true);
+#endif
+
+#ifdef test_regular_creases
+    total += checkRegularCreases("test_regular_creases_catmark_torus_creases2", catmark_torus_creases2, 3);
+    total += checkRegularCreases("test_regular_creases_catmark_torus_creases2", catmark_torus_creases2, 5);
+#endif
+
+#ifdef test_watertight
+    total += checkWatertight("test_watertight_catmark_cube", catmark_cube, 3, false);
+    total += checkWatertight("test_watertight_catmark_cube", catmark_cube, 3, true);
+    total += checkWatertight("test_watertight_catmark_pawn", catmark_pawn, 3, true);
+    total += checkWatertight("test_watertight_catmark_car", catmark_car, 3, false);
+    total += checkWatertight("test_watertight_catmark_car", catmark_car, 3, true);
+#endif
+
+#ifdef test_loop_limit
+    total += checkLoopLimit("test_loop_limit_loop_icosahedron", loop_icosahedron, 2);
+    total += checkLoopLimit("test_loop_limit_loop_cube", loop_cube, 2);
+#endif
+
+#ifdef test_tessellator
+    total += checkTessellator("test_tessellator_catmark_cube", catmark_cube,
+        OsdUtilMesh<OsdVertex>::SCHEME_CATMARK, 3, 8);
+    total += checkTessellator("test_tessellator_catmark_pyramid", catmark_pyramid,
+        OsdUtilMesh<OsdVertex>::SCHEME_CATMARK, 3, 6);
+    total += checkTessellator("test_tessellator_catmark_pawn", catmark_pawn,
+        OsdUtilMesh<OsdVertex>::SCHEME_CATMARK, 2, 4);
+    total += checkTessellator("test_tessellator_catmark_torus", catmark_torus,
+        OsdUtilMesh<OsdVertex>::SCHEME_CATMARK, 3, 4);
+    total += checkTessellator("test_tessellator_loop_cube", loop_cube,
+        OsdUtilMesh<OsdVertex>::SCHEME_LOOP, 3, 5);
+#endif
+
+    if (total==0)
+        printf("All tests passed.\n");
+    else
+        printf("Total failures : %d\n", total);
+
+    return total==0 ? 0 : 1;
+}
+
+//------------------------------------------------------------------------------
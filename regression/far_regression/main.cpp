@@ -23,11 +23,16 @@
 //
 
 #include <stdio.h>
+#include <string.h>
+
+#include <map>
 
 #include <far/meshFactory.h>
 #include <far/dispatcher.h>
+#include <far/patchMap.h>
 
 #include "../common/shape_utils.h"
+#include "../common/vertex_utils.h"
 
 //
 // Regression testing matching Far to Hbr (default CPU implementation)
@@ -38,81 +43,12 @@
 // - results cannot be bitwise identical as some vertex interpolations
 //   are not happening in the same order.
 //
-// - only vertex interpolation is being tested at the moment.
+// - only vertex interpolation is being tested at the moment, along with the
+//   face-varying refinement tables (checked against the face-varying data
+//   interpolated by Hbr).
 //
 #define PRECISION 1e-6
 
-//------------------------------------------------------------------------------
-// Vertex class implementation
-struct xyzVV {
-
-    xyzVV() { }
-
-    xyzVV( int /*i*/ ) { }
-
-    xyzVV( float x, float y, float z ) { _pos[0]=x; _pos[1]=y; _pos[2]=z; }
-
-    xyzVV( const xyzVV & src ) { _pos[0]=src._pos[0]; _pos[1]=src._pos[1]; _pos[2]=src._pos[2]; }
-
-   ~xyzVV( ) { }
-
-    void AddWithWeight(const xyzVV& src, float weight) { 
-        _pos[0]+=weight*src._pos[0]; 
-        _pos[1]+=weight*src._pos[1]; 
-        _pos[2]+=weight*src._pos[2]; 
-    }
-
-    void AddVaryingWithWeight(const xyzVV& , float) { }
-
-    void Clear( void * =0 ) { _pos[0]=_pos[1]=_pos[2]=0.0f; }
-
-    void SetPosition(float x, float y, float z) { _pos[0]=x; _pos[1]=y; _pos[2]=z; }
-
-    void ApplyVertexEdit(const OpenSubdiv::HbrVertexEdit<xyzVV> & edit) {
-        const float *src = edit.GetEdit();
-        switch(edit.GetOperation()) {
-          case OpenSubdiv::HbrHierarchicalEdit<xyzVV>::Set:
-            _pos[0] = src[0];
-            _pos[1] = src[1];
-            _pos[2] = src[2];
-            break;
-          case OpenSubdiv::HbrHierarchicalEdit<xyzVV>::Add:
-            _pos[0] += src[0];
-            _pos[1] += src[1];
-            _pos[2] += src[2];
-            break;
-          case OpenSubdiv::HbrHierarchicalEdit<xyzVV>::Subtract:
-            _pos[0] -= src[0];
-            _pos[1] -= src[1];
-            _pos[2] -= src[2];
-            break;
-        }
-    }
-
-    void ApplyVertexEdit(OpenSubdiv::FarVertexEdit const & edit) {
-        const float *src = edit.GetEdit();
-        switch(edit.GetOperation()) {
-          case OpenSubdiv::FarVertexEdit::Set:
-            _pos[0] = src[0];
-            _pos[1] = src[1];
-            _pos[2] = src[2];
-            break;
-          case OpenSubdiv::FarVertexEdit::Add:
-            _pos[0] += src[0];
-            _pos[1] += src[1];
-            _pos[2] += src[2];
-            break;
-        }
-    }
-    
-    void ApplyMovingVertexEdit(const OpenSubdiv::HbrMovingVertexEdit<xyzVV> &) { }
-
-    const float * GetPos() const { return _pos; }
-
-private:
-    float _pos[3];
-};
-
 //------------------------------------------------------------------------------
 class xyzFV;
 typedef OpenSubdiv::HbrMesh<xyzVV>           xyzmesh;
@@ -396,6 +332,227 @@ int checkMesh( char const * msg, xyzmesh * hmesh, int levels, Scheme scheme=kCat
     return count;
 }
 
+//------------------------------------------------------------------------------
+int checkFVarTables( char const * msg, xyzmesh * hmesh, int levels, bool adaptive=false ) {
+
+    assert(msg);
+
+    int count=0;
+
+    fMeshFactory fact( hmesh, levels, adaptive );
+    fMesh * m = fact.Create( /*requireFVarData*/ true, /*requireFVarTables*/ true );
+
+    OpenSubdiv::FarFVarTables const * tables = m->GetFVarTables();
+    assert(tables);
+
+    int width = tables->GetFVarWidth();
+
+    // coarse values : one per face-vertex of each coarse face
+    std::vector<float> values(tables->GetNumValues()*width);
+    for (int i=0, ofs=0; i<hmesh->GetNumCoarseFaces(); ++i) {
+        xyzface * f = hmesh->GetFace(i);
+        for (int j=0; j<f->GetNumVertices(); ++j, ofs+=width)
+            memcpy(&values[ofs], f->GetFVarData(j).GetData(0), width*sizeof(float));
+    }
+
+    tables->RefineValues(&values[0]);
+
+    std::vector<float> const & hbrData = m->GetPatchTables()->GetFVarData().GetAllData();
+
+    std::vector<float> fvarData(tables->GetFVarDataIndices().size()*width);
+    if (not fvarData.empty())
+        tables->GatherFVarData(&values[0], &fvarData[0]);
+
+    if (not g_debugmode)
+        printf("- %s (fvar, %s)\n", msg, adaptive ? "adaptive" : "uniform");
+
+    if (fvarData.size()!=hbrData.size()) {
+        printf("// face-varying data size mismatch : %d %d\n", (int)fvarData.size(), (int)hbrData.size());
+        ++count;
+    } else {
+        for (int i=0; i<(int)fvarData.size(); ++i) {
+            float delta = fabsf(fvarData[i]-hbrData[i]);
+            if (delta > PRECISION) {
+                if (not g_debugmode)
+                    printf("// face-varying datum %d fails : delta=%.10f (%.10f %.10f)\n",
+                           i, delta, hbrData[i], fvarData[i]);
+                ++count;
+            }
+        }
+    }
+
+    if (not g_debugmode and count==0)
+        printf("  success !\n");
+
+    delete hmesh;
+    delete m;
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Compares indexed face-varying data to the per-face-per-vertex data and
+// reports the memory footprint of both representations
+int checkIndexedFVarData( char const * msg, std::string const & shapestr, int levels, bool adaptive=false, bool fvarTables=false ) {
+
+    assert(msg);
+
+    int count=0;
+
+    xyzmesh * hmesh = simpleHbr<xyzVV>(shapestr.c_str(), kCatmark, 0, true),
+            * hmeshIndexed = simpleHbr<xyzVV>(shapestr.c_str(), kCatmark, 0, true);
+
+    fMeshFactory fact( hmesh, levels, adaptive ),
+                 factIndexed( hmeshIndexed, levels, adaptive );
+
+    fMesh * m = fact.Create( /*requireFVarData*/ true ),
+          * mIndexed = factIndexed.Create( /*requireFVarData*/ true, fvarTables, /*indexFVarData*/ true );
+
+    OpenSubdiv::FarPatchTables::FVarData const & fvarData = m->GetPatchTables()->GetFVarData(),
+                                               & fvarIndexed = mIndexed->GetPatchTables()->GetFVarData();
+
+    std::vector<float> expanded;
+    fvarIndexed.ExpandData(expanded);
+
+    // the patches are not sorted in the same order by both meshes : match them
+    // with their patch param
+    typedef std::map<std::pair<unsigned int, unsigned int>, int> PatchMap;
+
+    OpenSubdiv::FarPatchTables::PatchParamTable const & params = m->GetPatchTables()->GetPatchParamTable(),
+                                                      & paramsIndexed = mIndexed->GetPatchTables()->GetPatchParamTable();
+    PatchMap patches;
+    for (int i=0; i<(int)params.size(); ++i)
+        patches[std::make_pair(params[i].faceIndex, params[i].bitField.field)] = i;
+
+    int patchSize = params.empty() ? 0 : (int)fvarData.GetAllData().size()/(int)params.size();
+
+    if (expanded.size()!=fvarData.GetAllData().size() or paramsIndexed.size()!=params.size()) {
+        printf("// face-varying data size mismatch : %d %d\n", (int)expanded.size(), (int)fvarData.GetAllData().size());
+        ++count;
+    } else {
+        for (int i=0; i<(int)paramsIndexed.size(); ++i) {
+            PatchMap::const_iterator it = patches.find(std::make_pair(paramsIndexed[i].faceIndex, paramsIndexed[i].bitField.field));
+            if (it==patches.end() or
+                memcmp(&expanded[i*patchSize], &fvarData.GetAllData()[it->second*patchSize], patchSize*sizeof(float))) {
+                if (not g_debugmode)
+                    printf("// indexed face-varying data of patch %d fails\n", i);
+                ++count;
+            }
+        }
+    }
+
+    // the refinement tables update the unique values of indexed data, or the
+    // per-face-per-vertex data when indexing was skipped
+    OpenSubdiv::FarFVarTables const * tables = mIndexed->GetFVarTables();
+    std::vector<float> const & tableData = fvarIndexed.IsIndexed() ?
+        fvarIndexed.GetValues() : fvarIndexed.GetAllData();
+    if (tables and tables->GetFVarDataIndices().size()*fvarIndexed.GetFVarWidth()!=tableData.size()) {
+        printf("// face-varying tables do not match the indexed data\n");
+        ++count;
+    }
+
+    // indexing never increases the memory footprint
+    if (fvarIndexed.GetMemoryUsage() > fvarData.GetMemoryUsage()) {
+        printf("// indexed face-varying data is larger than per-face-per-vertex data\n");
+        ++count;
+    }
+
+    if (not g_debugmode) {
+        printf("- %s (indexed fvar, %s%s)\n", msg, adaptive ? "adaptive" : "uniform", fvarTables ? ", fvar tables" : "");
+        printf("  memory : %d bytes per-face-per-vertex, %d bytes %s (%.1f%%)\n",
+               fvarData.GetMemoryUsage(), fvarIndexed.GetMemoryUsage(),
+               fvarIndexed.IsIndexed() ? "indexed" : "kept per-face-per-vertex",
+               100.0f * fvarIndexed.GetMemoryUsage() / std::max(1, fvarData.GetMemoryUsage()));
+        if (count==0)
+            printf("  success !\n");
+    }
+
+    delete m;
+    delete mIndexed;
+    delete hmesh;
+    delete hmeshIndexed;
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Checks that the adaptive Loop patches tile the ptex faces of the coarse
+// triangles and that the patch map resolves (u,v) samples to the patch that
+// covers them (the limit positions of the patches are checked against Hbr in
+// cpu_regression, as Far cannot evaluate them)
+int checkLoopPatches( char const * msg, xyzmesh * hmesh, int levels ) {
+
+    assert(msg);
+
+    int count=0;
+
+    fMeshFactory fact( hmesh, levels, /*adaptive*/ true );
+    fMesh * m = fact.Create();
+
+    fPatches const * patches = m->GetPatchTables();
+    assert(patches);
+
+    fPatches::PatchParamTable const & params = patches->GetPatchParamTable();
+
+    // the sub-triangles of each ptex face should cover half of its (u,v) square
+    std::vector<double> area(patches->GetNumPtexFaces(), 0.0);
+    for (int i=0; i<(int)params.size(); ++i) {
+        double frac = params[i].bitField.GetParamFraction();
+        area[params[i].faceIndex] += 0.5*frac*frac;
+    }
+
+    for (int i=0; i<(int)area.size(); ++i) {
+        if (fabs(area[i]-0.5) > PRECISION) {
+            if (not g_debugmode)
+                printf("// ptex face %d is not covered : area=%f\n", i, area[i]);
+            ++count;
+        }
+    }
+
+    OpenSubdiv::FarPatchMap patchMap(*patches);
+
+    int const nsamples=16;
+    for (int face=0; face<(int)area.size(); ++face) {
+        for (int i=0; i<=nsamples; ++i) {
+            for (int j=0; i+j<=nsamples; ++j) {
+
+                float u = float(i)/nsamples,
+                      v = float(j)/nsamples;
+
+                OpenSubdiv::FarPatchMap::Handle const * handle = patchMap.FindPatch(face, u, v);
+                if (not handle) {
+                    if (not g_debugmode)
+                        printf("// no patch found at face %d (%f %f)\n", face, u, v);
+                    ++count;
+                    continue;
+                }
+
+                OpenSubdiv::FarPatchParam::BitField bits = params[handle->patchIdx].bitField;
+                bits.Normalize(u, v);
+                bits.Rotate(u, v);
+
+                if (params[handle->patchIdx].faceIndex!=(unsigned int)face or
+                    u<-PRECISION or v<-PRECISION or u+v>1.0f+PRECISION) {
+                    if (not g_debugmode)
+                        printf("// patch %d does not cover face %d (%f %f)\n", handle->patchIdx, face, u, v);
+                    ++count;
+                }
+            }
+        }
+    }
+
+    if (not g_debugmode) {
+        printf("- %s (adaptive, %d patches)\n", msg, patches->GetNumPatches());
+        if (count==0)
+            printf("  success !\n");
+    }
+
+    delete hmesh;
+    delete m;
+
+    return count;
+}
+
 //------------------------------------------------------------------------------
 static void parseArgs(int argc, char ** argv) {
     if (argc>1) {
@@ -453,6 +610,11 @@ int main(int argc, char ** argv) {
 
 #define test_bilinear_cube
 
+#define test_loop_patches
+
+#define test_fvar_tables
+#define test_indexed_fvar_data
+
   if (g_debugmode)
       printf("[ ");
   else
@@ -622,6 +784,43 @@ int main(int argc, char ** argv) {
     total += checkMesh( "test_bilinear_cube", simpleHbr<xyzVV>(bilinear_cube.c_str(), kBilinear, 0), levels, kBilinear );
 #endif
 
+#ifdef test_loop_patches
+#include "../shapes/loop_chaikin0.h"
+#include "../shapes/loop_saddle_edgeonly.h"
+    total += checkLoopPatches( "test_loop_icosahedron", simpleHbr<xyzVV>(loop_icosahedron.c_str(), kLoop, 0), levels );
+    total += checkLoopPatches( "test_loop_cube", simpleHbr<xyzVV>(loop_cube.c_str(), kLoop, 0), levels );
+    total += checkLoopPatches( "test_loop_cube_creases0", simpleHbr<xyzVV>(loop_cube_creases0.c_str(), kLoop, 0), levels );
+    total += checkLoopPatches( "test_loop_saddle_edgeonly", simpleHbr<xyzVV>(loop_saddle_edgeonly.c_str(), kLoop, 0), levels );
+    total += checkLoopPatches( "test_loop_chaikin0", simpleHbr<xyzVV>(loop_chaikin0.c_str(), kLoop, 0), levels );
+#endif
+
+#ifdef test_fvar_tables
+    total += checkFVarTables( "test_catmark_cube", simpleHbr<xyzVV>(catmark_cube.c_str(), kCatmark, 0, true), levels );
+    total += checkFVarTables( "test_catmark_cube_corner4", simpleHbr<xyzVV>(catmark_cube_corner4.c_str(), kCatmark, 0, true), levels );
+    total += checkFVarTables( "test_catmark_dart_edgecorner", simpleHbr<xyzVV>(catmark_dart_edgecorner.c_str(), kCatmark, 0, true), levels );
+    total += checkFVarTables( "test_catmark_dart_edgeonly", simpleHbr<xyzVV>(catmark_dart_edgeonly.c_str(), kCatmark, 0, true), levels );
+    total += checkFVarTables( "test_catmark_pyramid_creases1", simpleHbr<xyzVV>(catmark_pyramid_creases1.c_str(), kCatmark, 0, true), levels );
+    total += checkFVarTables( "test_catmark_tent_creases1", simpleHbr<xyzVV>(catmark_tent_creases1.c_str(), kCatmark, 0, true), levels );
+    total += checkFVarTables( "test_catmark_cube_creases1", simpleHbr<xyzVV>(catmark_cube_creases1.c_str(), kCatmark, 0, true), levels, true );
+    total += checkFVarTables( "test_catmark_tent", simpleHbr<xyzVV>(catmark_tent.c_str(), kCatmark, 0, true), levels, true );
+    total += checkFVarTables( "test_bilinear_cube", simpleHbr<xyzVV>(bilinear_cube.c_str(), kBilinear, 0, true), levels );
+#endif
+
+#ifdef test_indexed_fvar_data
+#include "../shapes/catmark_car.h"
+#include "../shapes/catmark_pawn.h"
+#include "../shapes/catmark_torus.h"
+    total += checkIndexedFVarData( "test_catmark_cube", catmark_cube, 3 );
+    total += checkIndexedFVarData( "test_catmark_cube_corner4", catmark_cube_corner4, 3 );
+    total += checkIndexedFVarData( "test_catmark_torus", catmark_torus, 3 );
+    total += checkIndexedFVarData( "test_catmark_torus", catmark_torus, 3, true );
+    total += checkIndexedFVarData( "test_catmark_pawn", catmark_pawn, 3 );
+    total += checkIndexedFVarData( "test_catmark_car", catmark_car, 3 );
+    total += checkIndexedFVarData( "test_catmark_car", catmark_car, 3, true );
+    total += checkIndexedFVarData( "test_catmark_cube", catmark_cube, 3, false, true );
+    total += checkIndexedFVarData( "test_catmark_car", catmark_car, 3, true, true );
+#endif
+
 
     if (g_debugmode)
         printf("]\n");
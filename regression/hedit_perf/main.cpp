@@ -0,0 +1,364 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include <far/meshFactory.h>
+#include <far/dispatcher.h>
+
+#include <osd/vertex.h>
+#include <osd/cpuComputeContext.h>
+#include <osd/cpuComputeController.h>
+#include <osd/cpuVertexBuffer.h>
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #include <omp.h>
+    #include <osd/ompComputeController.h>
+#endif
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../common/shape_utils.h"
+#include "../common/timing_utils.h"
+#include "../common/vertex_utils.h"
+
+//
+// Hierarchical edits benchmark : times the application of the vertex edit
+// batches with the CPU and OpenMP compute controllers.
+//
+// Each shape is refined by the Osd kernels and compared to the positions of
+// the Hbr mesh refined to the same level, which applies the edits one by one
+// (the merged Far tables can't be their own reference).
+//
+// "edits" is the number of Hbr vertex edits and "entries" the number of
+// entries left in the FarVertexEditTables once the edits of a same vertex
+// have been merged.
+//
+// Usage : hedit_perf [-t numThreads] [-n iterations] [-l level]
+//
+
+using namespace OpenSubdiv;
+
+//------------------------------------------------------------------------------
+struct TestShape {
+    TestShape(char const * n, std::string const & d) : name(n), data(d) { }
+
+    char const * name;
+    std::string  data;
+};
+
+#include "../shapes/catmark_square_hedit0.h"
+#include "../shapes/catmark_square_hedit1.h"
+#include "../shapes/catmark_square_hedit2.h"
+#include "../shapes/catmark_square_hedit3.h"
+#include "../shapes/catmark_square_hedit4.h"
+#include "../shapes/catmark_pawn.h"
+
+static std::vector<TestShape> g_shapes;
+
+//------------------------------------------------------------------------------
+// Appends a dense "sculpt layer" of Add edits to a quad mesh : every vertex
+// of the first two levels of every face is displaced. Most of the edited
+// vertices are shared by several faces and receive several edits.
+//
+// Note : the shape parser reads lines of at most 256 characters, so each edit
+// is written as a separate tag.
+static std::string
+addSculptLayer(std::string const & shape, int numFaces) {
+
+    std::ostringstream s;
+    s << shape;
+
+    unsigned int seed = 1;
+
+    for (int face=0; face<numFaces; ++face) {
+        for (int child=0; child<4; ++child) {
+            for (int grandchild=-1; grandchild<4; ++grandchild) {
+                for (int vert=0; vert<4; ++vert) {
+                    if (grandchild<0) {
+                        s << "t vertexedit 4/3/3 3 " << face << " " << child;
+                    } else {
+                        s << "t vertexedit 5/3/3 4 " << face << " " << child << " " << grandchild;
+                    }
+                    s << " " << vert;
+
+                    for (int k=0; k<3; ++k) {
+                        seed = seed * 1103515245u + 12345u;
+                        s << " " << (((seed>>16)&0x7fff) / 32767.0f * 0.02f - 0.01f);
+                    }
+                    s << " add P value\n";
+                }
+            }
+        }
+    }
+    return s.str();
+}
+
+// Appends a stack of edits to a quad mesh that writes the first level
+// vertices of the first faces several times : two Set edits (the last one
+// wins) then two Add edits on the face-vertices, and Add edits on the
+// edge-vertices and vertex-vertices through every face that shares them.
+//
+// Note : Hbr applies the edits of a vertex face by face around the vertex, so
+// the result of a Set mixed with other edits through a different path
+// depends on that traversal order. The Set edits of the stack go through a
+// single path (the first child of each face) to keep the result well defined.
+static std::string
+addEditStack(std::string const & shape, int numFaces) {
+
+    std::ostringstream s;
+    s << shape;
+
+    unsigned int seed = 7;
+
+    char const * ops[4] = { "set", "set", "add", "add" };
+
+    for (int op=0; op<4; ++op) {
+        for (int face=0; face<numFaces; ++face) {
+            for (int child=0; child<4; ++child) {
+                for (int vert=0; vert<4; ++vert) {
+                    // the child faces of a quad rotate its vertices
+                    bool faceVertex = (vert==(child+2)%4);
+                    if (faceVertex and child>0)
+                        continue;
+                    if (not faceVertex and op<2)
+                        continue;
+                    s << "t vertexedit 4/3/3 3 " << face << " " << child << " " << vert;
+                    for (int k=0; k<3; ++k) {
+                        seed = seed * 1103515245u + 12345u;
+                        s << " " << (((seed>>16)&0x7fff) / 32767.0f * 0.2f - 0.1f);
+                    }
+                    s << " " << ops[op] << " P value\n";
+                }
+            }
+        }
+    }
+    return s.str();
+}
+
+static void
+initShapes() {
+    g_shapes.push_back(TestShape("catmark_square_hedit0", catmark_square_hedit0));
+    g_shapes.push_back(TestShape("catmark_square_hedit1", catmark_square_hedit1));
+    g_shapes.push_back(TestShape("catmark_square_hedit2", catmark_square_hedit2));
+    g_shapes.push_back(TestShape("catmark_square_hedit3", catmark_square_hedit3));
+    g_shapes.push_back(TestShape("catmark_square_hedit4", catmark_square_hedit4));
+    g_shapes.push_back(TestShape("catmark_pawn_sculpt", addSculptLayer(catmark_pawn, 588)));
+    g_shapes.push_back(TestShape("catmark_pawn_stack", addEditStack(catmark_pawn, 32)));
+}
+
+//------------------------------------------------------------------------------
+// returns the average time (in ms) of a Refine call. The hierarchical edits
+// are not idempotent : the coarse vertices are reset before each call.
+template <class CONTROLLER> static double
+timeRefine(CONTROLLER & controller, OsdCpuComputeContext const * context,
+           FarKernelBatchVector const & batches, OsdCpuVertexBuffer * vbuffer,
+           std::vector<float> const & coarse, int iterations) {
+
+    double elapsed = 0.0;
+    for (int i=0; i<=iterations; ++i) {
+        vbuffer->UpdateData(&coarse[0], 0, (int)coarse.size()/3);
+
+        double start = getTime();
+        controller.Refine(context, batches, vbuffer);
+        controller.Synchronize();
+
+        // the first call warms up
+        if (i>0) {
+            elapsed += getTime() - start;
+        }
+    }
+    return elapsed * 1000.0 / iterations;
+}
+
+//------------------------------------------------------------------------------
+static float
+compareVertices(float const * a, float const * b, int n) {
+
+    float maxdiff = 0.0f;
+    for (int i=0; i<n; ++i) {
+        maxdiff = std::max(maxdiff, std::abs(a[i]-b[i]));
+    }
+    return maxdiff;
+}
+
+//------------------------------------------------------------------------------
+static bool
+runShape(TestShape const & shape, int level, int numThreads, int iterations) {
+
+    std::vector<float> coarse;
+
+    // Osd refinement
+    HbrMesh<OsdVertex> * hmesh = simpleHbr<OsdVertex>(shape.data.c_str(), kCatmark, coarse);
+
+    int numEdits = (int)hmesh->GetHierarchicalEdits().size();
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level);
+    FarMesh<OsdVertex> * fmesh = factory.Create();
+
+    FarVertexEditTables const * editTables = fmesh->GetVertexEditTables();
+
+    int numEntries = 0;
+    for (int i=0; editTables and i<editTables->GetNumBatches(); ++i) {
+        numEntries += (int)editTables->GetBatch(i).GetVertexIndices().size();
+    }
+
+    // the edit batches alone
+    FarKernelBatchVector const & batches = fmesh->GetKernelBatches();
+    FarKernelBatchVector editBatches;
+    for (int i=0; i<(int)batches.size(); ++i) {
+        if (batches[i].GetKernelType()==FarKernelBatch::HIERARCHICAL_EDIT) {
+            editBatches.push_back(batches[i]);
+        }
+    }
+
+    int numVertices = fmesh->GetNumVertices();
+
+    OsdCpuComputeContext * context =
+        OsdCpuComputeContext::Create(fmesh->GetSubdivisionTables(), editTables);
+
+    OsdCpuVertexBuffer * vbuffer = OsdCpuVertexBuffer::Create(3, numVertices);
+
+    OsdCpuComputeController cpuController;
+
+    double cpuRefine = timeRefine(cpuController, context, batches, vbuffer, coarse, iterations),
+           cpuEdits = timeRefine(cpuController, context, editBatches, vbuffer, coarse, iterations);
+
+    vbuffer->UpdateData(&coarse[0], 0, (int)coarse.size()/3);
+    cpuController.Refine(context, batches, vbuffer);
+
+    std::vector<float> cpuResult(vbuffer->BindCpuBuffer(),
+                                 vbuffer->BindCpuBuffer() + numVertices*3);
+
+    double ompRefine = 0.0,
+           ompEdits = 0.0;
+    float ompDiff = 0.0f;
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    OsdOmpComputeController ompController(numThreads);
+
+    ompRefine = timeRefine(ompController, context, batches, vbuffer, coarse, iterations);
+    ompEdits = timeRefine(ompController, context, editBatches, vbuffer, coarse, iterations);
+
+    vbuffer->UpdateData(&coarse[0], 0, (int)coarse.size()/3);
+    ompController.Refine(context, batches, vbuffer);
+
+    std::vector<float> ompResult(vbuffer->BindCpuBuffer(),
+                                 vbuffer->BindCpuBuffer() + numVertices*3);
+#else
+    (void)numThreads;
+#endif
+
+    // Hbr reference : the factory refines the Hbr mesh, which applies the
+    // edits to the Hbr vertices as they are created
+    HbrMesh<xyzVV> * refmesh = simpleHbr<xyzVV>(shape.data.c_str(), kCatmark, 0);
+
+    FarMeshFactory<xyzVV> refFactory(refmesh, level);
+    FarMesh<xyzVV> * refFarMesh = refFactory.Create();
+
+    std::vector<int> const & remap = refFactory.GetRemappingTable();
+
+    std::vector<float> refResult(numVertices*3, 0.0f);
+    for (int i=0; i<refmesh->GetNumVertices(); ++i) {
+        HbrVertex<xyzVV> * v = refmesh->GetVertex(i);
+        if (not v or v->GetID()>=(int)remap.size())
+            continue;
+        int index = remap[v->GetID()];
+        if (index<0 or index>=numVertices)
+            continue;
+        for (int k=0; k<3; ++k) {
+            refResult[index*3+k] = v->GetData().GetPos()[k];
+        }
+    }
+
+    float cpuDiff = compareVertices(&cpuResult[0], &refResult[0], numVertices*3);
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    ompDiff = compareVertices(&ompResult[0], &refResult[0], numVertices*3);
+#endif
+
+    printf("%-24s %2d %8d %7d %7d %9.3f %9.3f %9.3f %9.3f %8.1e %8.1e\n",
+        shape.name, level, numVertices, numEdits, numEntries,
+        cpuRefine, cpuEdits, ompRefine, ompEdits, cpuDiff, ompDiff);
+
+    delete refFarMesh;
+    delete refmesh;
+    delete vbuffer;
+    delete context;
+    delete fmesh;
+    delete hmesh;
+
+    return cpuDiff < 1e-5f and ompDiff < 1e-5f;
+}
+
+//------------------------------------------------------------------------------
+static void
+usage(char const * name) {
+    printf("Usage : %s [-t numThreads] [-n iterations] [-l level]\n", name);
+}
+
+//------------------------------------------------------------------------------
+int
+main(int argc, char ** argv) {
+
+    int numThreads = -1,
+        iterations = 20,
+        level = 4;
+
+    for (int i=1; i<argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg=="-t" and i+1<argc) {
+            numThreads = atoi(argv[++i]);
+        } else if (arg=="-n" and i+1<argc) {
+            iterations = std::max(1, atoi(argv[++i]));
+        } else if (arg=="-l" and i+1<argc) {
+            level = std::max(2, atoi(argv[++i]));
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    initShapes();
+
+    printf("%-24s %2s %8s %7s %7s %9s %9s %9s %9s %8s %8s\n",
+        "shape", "lv", "verts", "edits", "entries",
+        "cpu", "cpu edit", "omp", "omp edit", "cpu diff", "omp diff");
+    printf("%-24s %2s %8s %7s %7s %9s %9s %9s %9s %8s %8s\n",
+        "", "", "", "", "", "(ms)", "(ms)", "(ms)", "(ms)", "", "");
+
+    int failures = 0;
+    for (int i=0; i<(int)g_shapes.size(); ++i) {
+        if (not runShape(g_shapes[i], level, numThreads, iterations)) {
+            ++failures;
+        }
+    }
+
+    if (failures) {
+        printf("%d test(s) failed\n", failures);
+    }
+    return failures ? 1 : 0;
+}
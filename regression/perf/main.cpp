@@ -0,0 +1,1722 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include <far/limitStencilTablesFactory.h>
+#include <far/meshFactory.h>
+#include <far/stencilTablesFactory.h>
+#include <far/stencilTablesOptimizer.h>
+
+#include <osd/vertex.h>
+#include <osd/cpuComputeContext.h>
+#include <osd/cpuComputeController.h>
+#include <osd/cpuEvalLimitContext.h>
+#include <osd/cpuEvalLimitBVH.h>
+#include <osd/cpuEvalLimitController.h>
+#include <osd/cpuEvalStencilsContext.h>
+#include <osd/cpuEvalStencilsController.h>
+#include <osd/cpuSmoothNormalContext.h>
+#include <osd/cpuSmoothNormalController.h>
+#include <osd/cpuVertexBuffer.h>
+#include <osd/scheduler.h>
+
+#include <osdutil/evaluator_capi.h>
+#include <osdutil/refiner.h>
+#include <osdutil/tessellator.h>
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #include <omp.h>
+    #include <osd/ompComputeController.h>
+    #include <osd/ompSmoothNormalController.h>
+#endif
+
+#ifdef OPENSUBDIV_HAS_TBB
+    #include <osd/tbbComputeController.h>
+    #include <osd/tbbSmoothNormalController.h>
+#endif
+
+#ifdef OPENSUBDIV_HAS_GCD
+    #include <osd/gcdComputeController.h>
+#endif
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../common/cpu_batch_utils.h"
+#include "../common/shape_utils.h"
+#include "../common/timing_utils.h"
+
+//
+// Headless performance suite : times the main CPU code paths of the library
+// and writes the results as JSON, so that they can be compared between
+// builds.
+//
+// Benchmarks :
+//
+//   far_create       FarMeshFactory::Create (uniform and adaptive)
+//   stencils         FarStencilTablesFactory::AppendStencils
+//   stencils_grid    FarStencilTablesFactory::AppendGridStencils, with a
+//                    grid of about as many samples per face
+//   stencils_limit   FarLimitStencilTablesFactory::Create, for as many
+//                    random samples of every ptex face of an adaptive mesh
+//   stencils_eval_random  OsdCpuEvalStencilsController::UpdateValues on the
+//                    limit stencils of samples of random faces : "original"
+//                    tables, "reordered" by FarStencilTablesOptimizer and
+//                    "renumbered" (control vertices renumbered too, "speedup"
+//                    is relative to the original tables)
+//   stencils_eval_grid  same, with the samples of each face in a grid, face
+//                    after face
+//   stencils_frames  OsdCpuEvalStencilsController::UpdateFrames : positions,
+//                    derivatives and normals interleaved, in one pass
+//                    ("speedup" is relative to UpdateValues, UpdateDerivs and
+//                    a normalization pass)
+//   refine           Refine of every CPU compute controller ("scheduler" is
+//                    the CPU controller running on an OsdDefaultScheduler)
+//   batch_refine     OsdUtilMeshBatch refining 8 copies of the mesh, with
+//                    FinalizeUpdate ("cpu") and FinalizeUpdateParallel
+//                    ("parallel")
+//   refine_poses     Refine of 4 poses, one by one and with RefineSamples
+//                    (refine_poses_batched, "speedup" is relative to the
+//                    separate refines)
+//   limit_eval       OsdCpuEvalLimitController::EvalLimitSample
+//   limit_eval_cached  same, with the Gregory patches cached once per pose
+//   limit_eval_stateless  same, every thread evaluating its own Bindings
+//                    (throughput scaling, use -t 32 for 32 threads)
+//   capi_limit_eval  openSubdiv_evaluateLimit, one call per sample
+//   capi_limit_eval_array  openSubdiv_evaluateLimitArray ("speedup" is
+//                    relative to the calls per sample)
+//   tessellate_init  OsdUtilTessellator::Initialize, 8 segments per coarse
+//                    edge
+//   tessellate_limit_eval  OsdCpuEvalLimitController::EvalLimitSample on the
+//                    grid of every ptex face
+//   tessellate_eval  OsdUtilTessellator::Evaluate ("speedup" is relative to
+//                    tessellate_limit_eval)
+//   limit_bvh_build  OsdCpuEvalLimitBVH::Build
+//   limit_bvh_refit  OsdCpuEvalLimitBVH::Refit
+//   limit_bvh_intersect  OsdCpuEvalLimitBVH::Intersect, with rays shot from
+//                    around the mesh at random limit samples
+//   limit_bvh_closest  OsdCpuEvalLimitBVH::FindClosestPoint, with points
+//                    scattered near random limit samples
+//   smooth_normals   SmootheNormals of every CPU smooth normal controller
+//                    (and the CPU controller on an OsdDefaultScheduler)
+//
+// The OpenMP benchmarks are run with 1, 2, 4 ... threads up to the maximum
+// thread count, which gives their scaling curve ("speedup" is relative to the
+// single thread run of the same series). TBB and GCD run with their default
+// scheduler.
+//
+// Each result records the peak resident set size reached since the previous
+// result ("peak_rss_kb", which includes the memory still allocated, or kept by
+// the allocator, at the end of the previous result) and its growth over the
+// resident set size at that time ("rss_growth_kb"). Resetting the peak
+// requires Linux : elsewhere both are based on the peak of the whole process,
+// which can only grow from one result to the next ("per_case_rss" is false).
+//
+// Usage : perf_regression [-l level] [-n iterations] [-s samples]
+//                         [-t maxThreads] [-o file.json]
+//
+
+using namespace OpenSubdiv;
+
+//------------------------------------------------------------------------------
+struct TestShape {
+    TestShape(std::string const & n, std::string const & d) : name(n), data(d) { }
+
+    std::string name;
+    std::string data;
+};
+
+#include "../shapes/catmark_cube.h"
+#include "../shapes/catmark_car.h"
+#include "../shapes/catmark_pawn.h"
+#include "../shapes/catmark_rook.h"
+#include "../shapes/catmark_torus_creases0.h"
+
+static std::vector<TestShape> g_shapes;
+
+//------------------------------------------------------------------------------
+// Returns an obj string for a torus of n x n quads : a synthetic mesh that
+// can be scaled to any face count.
+static std::string
+createTorus(int n) {
+
+    std::ostringstream s;
+
+    float const R = 1.0f, r = 0.3f, twoPi = 6.28318531f;
+
+    for (int i=0; i<n; ++i) {
+        float a = twoPi * i / n;
+        for (int j=0; j<n; ++j) {
+            float b = twoPi * j / n;
+            s << "v " << (R + r*cosf(b))*cosf(a) << " "
+                      << (R + r*cosf(b))*sinf(a) << " "
+                      << r*sinf(b) << "\n";
+        }
+    }
+
+    for (int i=0; i<n; ++i) {
+        for (int j=0; j<n; ++j) {
+            int i1 = (i+1)%n, j1 = (j+1)%n;
+            s << "f " << i*n+j+1  << " " << i1*n+j+1  << " "
+                      << i1*n+j1+1 << " " << i*n+j1+1  << "\n";
+        }
+    }
+    return s.str();
+}
+
+static void
+initShapes() {
+    g_shapes.push_back(TestShape("catmark_cube",           catmark_cube));
+    g_shapes.push_back(TestShape("catmark_car",            catmark_car));
+    g_shapes.push_back(TestShape("catmark_pawn",           catmark_pawn));
+    g_shapes.push_back(TestShape("catmark_rook",           catmark_rook));
+    g_shapes.push_back(TestShape("catmark_torus_creases0", catmark_torus_creases0));
+
+    for (int n=32; n<=128; n*=2) {
+        std::ostringstream name;
+        name << "synthetic_torus_" << n;
+        g_shapes.push_back(TestShape(name.str(), createTorus(n)));
+    }
+}
+
+//------------------------------------------------------------------------------
+#if defined(__linux__)
+// returns a "Vm..." field of /proc/self/status (in KB), or -1
+static long
+readProcStatus(char const * field) {
+
+    FILE * f = fopen("/proc/self/status", "r");
+    if (not f)
+        return -1;
+
+    size_t len = strlen(field);
+    char line[256];
+    long value = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, field, len)==0 and line[len]==':') {
+            value = atol(line+len+1);
+            break;
+        }
+    }
+    fclose(f);
+    return value;
+}
+#endif
+
+// returns the peak resident set size (in KB) : since the last resetPeakRSS
+// on Linux, of the whole process elsewhere
+static long
+getPeakRSS() {
+#if defined(__linux__)
+    // ru_maxrss isn't reset by clear_refs, VmHWM is
+    long peak = readProcStatus("VmHWM");
+    if (peak>=0)
+        return peak;
+#endif
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return (long)(counters.PeakWorkingSetSize / 1024);
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage)!=0)
+        return 0;
+#if defined(__APPLE__)
+    return (long)(usage.ru_maxrss / 1024);  // bytes
+#else
+    return (long)usage.ru_maxrss;           // kilobytes
+#endif
+#endif
+}
+
+static bool g_perCaseRSS = false;
+
+static long g_baseRSS = 0;
+
+// Starts the memory measurement of a new result : resets the peak resident
+// set size of the process to its current resident set size, which becomes the
+// base of the growth of the next result. Only Linux can reset the peak
+// (/proc/self/clear_refs) : elsewhere the growth is the growth of the peak of
+// the process, which misses the memory the previous results freed. Returns
+// false if the peak was not reset.
+static bool
+resetPeakRSS() {
+#if defined(__linux__)
+    FILE * f = fopen("/proc/self/clear_refs", "w");
+    if (f) {
+        bool reset = fputs("5", f)>=0;
+        if ((fclose(f)==0) and reset) {
+            g_baseRSS = std::max(0L, readProcStatus("VmRSS"));
+            return true;
+        }
+    }
+#endif
+    g_baseRSS = getPeakRSS();
+    return false;
+}
+
+//------------------------------------------------------------------------------
+struct Result {
+
+    std::string shape,
+                benchmark,
+                controller;
+
+    int level,
+        threads;
+
+    double timeMs,      // average time of one iteration
+           throughput,  // items per second
+           speedup;     // relative to the single thread run (0 if n/a)
+
+    char const * unit;
+
+    long peakRSS,       // peak resident set size (KB)
+         growthRSS;     // growth of the peak over the resident set size
+                        // at the end of the previous result
+};
+
+static std::vector<Result> g_results;
+
+static Result &
+addResult(std::string const & shape, char const * benchmark, char const * controller,
+          int level, int threads, double timeMs, int numItems, char const * unit) {
+
+    Result r;
+    r.shape = shape;
+    r.benchmark = benchmark;
+    r.controller = controller;
+    r.level = level;
+    r.threads = threads;
+    r.timeMs = timeMs;
+    r.throughput = timeMs>0.0 ? numItems / (timeMs/1000.0) : 0.0;
+    r.speedup = 0.0;
+    r.unit = unit;
+    r.peakRSS = getPeakRSS();
+    r.growthRSS = std::max(0L, r.peakRSS - g_baseRSS);
+    g_results.push_back(r);
+
+    // the next result measures its own peak
+    resetPeakRSS();
+
+    fprintf(stderr, "  %-16s %-10s %2d threads %10.3f ms %14.0f %s\n",
+        benchmark, controller, threads, timeMs, r.throughput, unit);
+
+    return g_results.back();
+}
+
+// sets the speedups of the results of a thread scaling series
+static void
+setSpeedups(int first) {
+
+    if (first>=(int)g_results.size() or g_results[first].threads!=1)
+        return;
+
+    for (int i=first; i<(int)g_results.size(); ++i) {
+        if (g_results[i].timeMs>0.0) {
+            g_results[i].speedup = g_results[first].timeMs / g_results[i].timeMs;
+        }
+    }
+}
+
+// a benchmark that cannot be set up would silently leave its results out :
+// stop the suite instead
+static void
+abortBenchmark(std::string const & shape, char const * benchmark, std::string const & error) {
+
+    fprintf(stderr, "Error : %s %s : %s\n", shape.c_str(), benchmark, error.c_str());
+    exit(1);
+}
+
+//------------------------------------------------------------------------------
+static std::vector<int> g_threadCounts;
+
+static void
+initThreadCounts(int maxThreads) {
+    for (int n=1; n<maxThreads; n*=2) {
+        g_threadCounts.push_back(n);
+    }
+    g_threadCounts.push_back(maxThreads);
+}
+
+//------------------------------------------------------------------------------
+// FarMeshFactory::Create : the Hbr mesh is rebuilt before each iteration,
+// since the factory refines it.
+static void
+benchFarCreate(TestShape const & shape, int level, int iterations) {
+
+    for (int adaptive=0; adaptive<2; ++adaptive) {
+
+        double elapsed = 0.0;
+        int numVertices = 0;
+
+        for (int i=0; i<iterations; ++i) {
+            std::vector<float> positions;
+            HbrMesh<OsdVertex> * hmesh =
+                simpleHbr<OsdVertex>(shape.data.c_str(), kCatmark, positions);
+
+            double start = getTime();
+
+            FarMeshFactory<OsdVertex> factory(hmesh, level, adaptive!=0);
+            FarMesh<OsdVertex> * fmesh = factory.Create();
+
+            elapsed += getTime() - start;
+
+            numVertices = fmesh->GetNumVertices();
+
+            delete fmesh;
+            delete hmesh;
+        }
+
+        addResult(shape.name, adaptive ? "far_create_adaptive" : "far_create_uniform",
+            "far", level, 1, elapsed*1000.0/iterations, numVertices, "vertices/s");
+    }
+}
+
+//------------------------------------------------------------------------------
+// FarStencilTablesFactory::AppendStencils on random samples of every face,
+// and AppendGridStencils on grids of about as many samples
+static void
+benchStencils(TestShape const & shape, int level, int numSamples) {
+
+    std::vector<float> positions;
+    HbrMesh<FarStencilFactoryVertex> * hmesh =
+        simpleHbr<FarStencilFactoryVertex>(shape.data.c_str(), kCatmark, positions);
+
+    if (hmesh->HasVertexEdits()) {
+        delete hmesh;
+        return;
+    }
+
+    std::vector<float> u(numSamples), v(numSamples);
+
+    srand( static_cast<int>(2147483647) ); // use a large Pell prime number
+    for (int i=0; i<numSamples; ++i) {
+        u[i] = (float)rand()/(float)RAND_MAX;
+        v[i] = (float)rand()/(float)RAND_MAX;
+    }
+
+    FarStencilTables stencils;
+    FarStencilTablesFactory<> factory(hmesh);
+
+    int nfaces = hmesh->GetNumCoarseFaces();
+
+    double start = getTime();
+
+    for (int i=0; i<nfaces; ++i) {
+        int nv = hmesh->GetFace(i)->GetNumVertices();
+        if (nv==4) {
+            if (factory.SetCurrentFace(i))
+                factory.AppendStencils(&stencils, numSamples, &u[0], &v[0], level);
+        } else {
+            for (int j=0; j<nv; ++j) {
+                if (factory.SetCurrentFace(i, j))
+                    factory.AppendStencils(&stencils, numSamples, &u[0], &v[0], level);
+            }
+        }
+    }
+
+    double elapsed = getTime() - start;
+
+    addResult(shape.name, "stencils", "far", level, 1, elapsed*1000.0,
+        stencils.GetNumStencils(), "stencils/s");
+
+    // regular grids of samples, with the boundary samples shared
+    int gridsize = std::max(2, (int)std::sqrt((float)numSamples));
+
+    FarStencilTables gridStencils;
+
+    start = getTime();
+
+    factory.AppendGridStencils(&gridStencils, gridsize, level);
+
+    elapsed = getTime() - start;
+
+    addResult(shape.name, "stencils_grid", "far", level, 1, elapsed*1000.0,
+        gridStencils.GetNumStencils(), "stencils/s");
+
+    delete hmesh;
+}
+
+//------------------------------------------------------------------------------
+// Limit stencils of random samples of every ptex face, generated from the
+// tables of an adaptive FarMesh (vertex stencils included)
+static void
+benchLimitStencils(TestShape const & shape, int level, int numSamples) {
+
+    std::vector<float> positions;
+    HbrMesh<OsdVertex> * hmesh =
+        simpleHbr<OsdVertex>(shape.data.c_str(), kCatmark, positions);
+
+    if (hmesh->HasVertexEdits()) {
+        delete hmesh;
+        return;
+    }
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level, /*adaptive*/ true);
+    FarMesh<OsdVertex> * fmesh = factory.Create();
+
+    int nptexfaces = fmesh->GetPatchTables()->GetNumPtexFaces(),
+        nsamples = nptexfaces * numSamples;
+
+    std::vector<int> faces(nsamples);
+    std::vector<float> u(nsamples), v(nsamples);
+
+    srand( static_cast<int>(2147483647) ); // use a large Pell prime number
+    for (int i=0; i<nsamples; ++i) {
+        faces[i] = i / numSamples;
+        u[i] = (float)rand()/(float)RAND_MAX;
+        v[i] = (float)rand()/(float)RAND_MAX;
+    }
+
+    int first = (int)g_results.size();
+    for (int i=0; i<(int)g_threadCounts.size(); ++i) {
+
+        int numThreads = g_threadCounts[i];
+#ifndef OPENSUBDIV_HAS_OPENMP
+        if (numThreads>1)
+            break;
+#endif
+        double start = getTime();
+
+        FarStencilTables * stencils = FarLimitStencilTablesFactory::Create(
+            fmesh, nsamples, &faces[0], &u[0], &v[0], numThreads);
+
+        double elapsed = getTime() - start;
+
+        if (stencils) {
+            addResult(shape.name, "stencils_limit", "far", level, numThreads,
+                elapsed*1000.0, stencils->GetNumStencils(), "stencils/s");
+        }
+        delete stencils;
+    }
+    setSpeedups(first);
+
+    delete fmesh;
+    delete hmesh;
+}
+
+//------------------------------------------------------------------------------
+static double
+timeEvalStencils(FarStencilTables const * stencils, OsdCpuVertexBuffer * controls,
+                 OsdCpuVertexBuffer * results, int iterations) {
+
+    OsdCpuEvalStencilsContext * context = OsdCpuEvalStencilsContext::Create(stencils);
+
+    OsdCpuEvalStencilsController controller;
+
+    OsdVertexBufferDescriptor desc(0, 3, 3);
+
+    // warm up
+    controller.UpdateValues(context, desc, controls, desc, results);
+
+    double start = getTime();
+    for (int i=0; i<iterations; ++i) {
+        controller.UpdateValues(context, desc, controls, desc, results);
+    }
+    double elapsed = (getTime() - start) * 1000.0 / iterations;
+
+    delete context;
+
+    return elapsed;
+}
+
+// OsdCpuEvalStencilsController::UpdateValues on the limit stencils of random
+// and grid ordered samples, before and after FarStencilTablesOptimizer
+static void
+benchEvalStencils(TestShape const & shape, int level, int numSamples, int iterations) {
+
+    std::vector<float> positions;
+    HbrMesh<OsdVertex> * hmesh =
+        simpleHbr<OsdVertex>(shape.data.c_str(), kCatmark, positions);
+
+    if (hmesh->HasVertexEdits()) {
+        delete hmesh;
+        return;
+    }
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level, /*adaptive*/ true);
+    FarMesh<OsdVertex> * fmesh = factory.Create();
+
+    // the limit stencils read the coarse vertices
+    int nptexfaces = fmesh->GetPatchTables()->GetNumPtexFaces(),
+        nverts = (int)positions.size()/3,
+        nsamples = nptexfaces * numSamples,
+        gridsize = std::max(1, (int)sqrtf((float)numSamples));
+
+    std::vector<float> const & controlData = positions;
+
+    OsdCpuVertexBuffer * controls = OsdCpuVertexBuffer::Create(3, nverts),
+                       * renumbered = OsdCpuVertexBuffer::Create(3, nverts),
+                       * results = OsdCpuVertexBuffer::Create(3, nsamples);
+
+    controls->UpdateData(&controlData[0], 0, nverts);
+
+    std::vector<int> faces(nsamples);
+    std::vector<float> u(nsamples), v(nsamples);
+
+    srand( static_cast<int>(2147483647) ); // use a large Pell prime number
+
+    for (int grid=0; grid<2; ++grid) {
+
+        for (int i=0; i<nsamples; ++i) {
+            if (grid) {
+                int j = i % numSamples;
+                faces[i] = i / numSamples;
+                u[i] = (float)(j % gridsize) / (float)gridsize;
+                v[i] = (float)(j / gridsize % gridsize) / (float)gridsize;
+            } else {
+                faces[i] = rand() % nptexfaces;
+                u[i] = (float)rand()/(float)RAND_MAX;
+                v[i] = (float)rand()/(float)RAND_MAX;
+            }
+        }
+
+        FarStencilTables * stencils = FarLimitStencilTablesFactory::Create(
+            fmesh, nsamples, &faces[0], &u[0], &v[0]);
+
+        if (not stencils)
+            continue;
+
+        std::vector<int> permutation, controlPermutation;
+
+        FarStencilTables * reordered =
+            FarStencilTablesOptimizer::Create(stencils, &permutation),
+                         * renumberedStencils =
+            FarStencilTablesOptimizer::Create(stencils, &permutation, 0, 10000,
+                &controlPermutation);
+
+        // the vertices after the highest index read keep their index
+        std::vector<float> renumberedData(controlData);
+        for (int i=0; i<(int)controlPermutation.size(); ++i) {
+            for (int k=0; k<3; ++k) {
+                renumberedData[controlPermutation[i]*3+k] = controlData[i*3+k];
+            }
+        }
+        renumbered->UpdateData(&renumberedData[0], 0, nverts);
+
+        char const * name = grid ? "stencils_eval_grid" : "stencils_eval_random";
+
+        double original = timeEvalStencils(stencils, controls, results, iterations),
+               optimized = timeEvalStencils(reordered, controls, results, iterations),
+               optimizedRenumbered = timeEvalStencils(renumberedStencils, renumbered,
+                   results, iterations);
+
+        int n = stencils->GetNumStencils();
+
+        addResult(shape.name, name, "original", level, 1, original, n, "stencils/s");
+        addResult(shape.name, name, "reordered", level, 1, optimized, n,
+            "stencils/s").speedup = original / optimized;
+        addResult(shape.name, name, "renumbered", level, 1, optimizedRenumbered, n,
+            "stencils/s").speedup = original / optimizedRenumbered;
+
+        delete stencils;
+        delete reordered;
+        delete renumberedStencils;
+    }
+
+    delete controls;
+    delete renumbered;
+    delete results;
+    delete fmesh;
+    delete hmesh;
+}
+
+//------------------------------------------------------------------------------
+// Limit frames (positions, derivatives and normals) of a grid of samples of
+// every ptex face : separate passes and UpdateFrames
+static void
+benchStencilFrames(TestShape const & shape, int level, int numSamples, int iterations) {
+
+    std::vector<float> positions;
+    HbrMesh<OsdVertex> * hmesh =
+        simpleHbr<OsdVertex>(shape.data.c_str(), kCatmark, positions);
+
+    if (hmesh->HasVertexEdits()) {
+        delete hmesh;
+        return;
+    }
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level, /*adaptive*/ true);
+    FarMesh<OsdVertex> * fmesh = factory.Create();
+
+    int nptexfaces = fmesh->GetPatchTables()->GetNumPtexFaces(),
+        nverts = (int)positions.size()/3,
+        nsamples = nptexfaces * numSamples,
+        gridsize = std::max(1, (int)sqrtf((float)numSamples));
+
+    std::vector<int> faces(nsamples);
+    std::vector<float> u(nsamples), v(nsamples);
+
+    for (int i=0; i<nsamples; ++i) {
+        int j = i % numSamples;
+        faces[i] = i / numSamples;
+        u[i] = (float)(j % gridsize) / (float)gridsize;
+        v[i] = (float)(j / gridsize % gridsize) / (float)gridsize;
+    }
+
+    FarStencilTables * stencils = FarLimitStencilTablesFactory::Create(
+        fmesh, nsamples, &faces[0], &u[0], &v[0]);
+
+    if (stencils) {
+
+        OsdCpuEvalStencilsContext * context = OsdCpuEvalStencilsContext::Create(stencils);
+
+        OsdCpuVertexBuffer * controls = OsdCpuVertexBuffer::Create(3, nverts),
+                           * values = OsdCpuVertexBuffer::Create(3, nsamples),
+                           * du = OsdCpuVertexBuffer::Create(3, nsamples),
+                           * dv = OsdCpuVertexBuffer::Create(3, nsamples),
+                           * normals = OsdCpuVertexBuffer::Create(3, nsamples),
+                           * frames = OsdCpuVertexBuffer::Create(12, nsamples);
+
+        controls->UpdateData(&positions[0], 0, nverts);
+
+        OsdCpuEvalStencilsController controller;
+
+        OsdVertexBufferDescriptor desc(0, 3, 3);
+
+        double start = getTime();
+        for (int i=0; i<iterations; ++i) {
+
+            controller.UpdateValues(context, desc, controls, desc, values);
+            controller.UpdateDerivs(context, desc, controls, desc, du, desc, dv);
+
+            float const * pu = du->BindCpuBuffer(),
+                        * pv = dv->BindCpuBuffer();
+            float * n = normals->BindCpuBuffer();
+
+            for (int j=0; j<nsamples; ++j, pu+=3, pv+=3, n+=3) {
+                n[0] = pu[1]*pv[2]-pu[2]*pv[1];
+                n[1] = pu[2]*pv[0]-pu[0]*pv[2];
+                n[2] = pu[0]*pv[1]-pu[1]*pv[0];
+                float len = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+                if (len>0.0f) {
+                    n[0] /= len;
+                    n[1] /= len;
+                    n[2] /= len;
+                }
+            }
+        }
+        double separate = (getTime() - start) * 1000.0 / iterations;
+
+        start = getTime();
+        for (int i=0; i<iterations; ++i) {
+            controller.UpdateFrames(context, desc, controls,
+                OsdVertexBufferDescriptor(0, 3, 12), frames,
+                OsdVertexBufferDescriptor(3, 3, 12), frames,
+                OsdVertexBufferDescriptor(6, 3, 12), frames,
+                OsdVertexBufferDescriptor(9, 3, 12), frames);
+        }
+        double fused = (getTime() - start) * 1000.0 / iterations;
+
+        int n = stencils->GetNumStencils();
+
+        addResult(shape.name, "stencils_frames", "separate", level, 1, separate, n, "frames/s");
+        addResult(shape.name, "stencils_frames", "fused", level, 1, fused, n,
+            "frames/s").speedup = separate / fused;
+
+        delete controls;
+        delete values;
+        delete du;
+        delete dv;
+        delete normals;
+        delete frames;
+        delete context;
+        delete stencils;
+    }
+
+    delete fmesh;
+    delete hmesh;
+}
+
+//------------------------------------------------------------------------------
+template <class CONTROLLER> static double
+timeRefine(CONTROLLER & controller, OsdCpuComputeContext const * context,
+           FarKernelBatchVector const & batches, OsdCpuVertexBuffer * vbuffer,
+           int iterations) {
+
+    // warm up
+    controller.Refine(context, batches, vbuffer);
+    controller.Synchronize();
+
+    double start = getTime();
+    for (int i=0; i<iterations; ++i) {
+        controller.Refine(context, batches, vbuffer);
+    }
+    controller.Synchronize();
+    return (getTime() - start) * 1000.0 / iterations;
+}
+
+//------------------------------------------------------------------------------
+template <class CONTROLLER> static double
+timeSmoothNormals(CONTROLLER & controller, OsdCpuSmoothNormalContext * context,
+                  OsdCpuVertexBuffer * vbuffer, int iterations) {
+
+    // warm up
+    controller.SmootheNormals(context, vbuffer, 0, vbuffer, 3);
+    controller.Synchronize();
+
+    double start = getTime();
+    for (int i=0; i<iterations; ++i) {
+        controller.SmootheNormals(context, vbuffer, 0, vbuffer, 3);
+    }
+    controller.Synchronize();
+    return (getTime() - start) * 1000.0 / iterations;
+}
+
+//------------------------------------------------------------------------------
+// Refines kNumPoseSamples samples (poses) of the positions : one Refine per
+// sample, against a single RefineSamples of the interleaved samples
+static int const kNumPoseSamples = 4;
+
+template <class CONTROLLER> static void
+benchRefineSamples(TestShape const & shape, CONTROLLER & controller,
+                   char const * controllerName, int numThreads,
+                   OsdCpuComputeContext const * context,
+                   FarKernelBatchVector const & batches,
+                   std::vector<float> const & positions,
+                   int level, int numVertices, int numRefined, int iterations) {
+
+    int numCoarse = (int)positions.size()/3;
+
+    std::vector<OsdCpuVertexBuffer *> sampleBuffers(kNumPoseSamples);
+    for (int i=0; i<kNumPoseSamples; ++i) {
+        sampleBuffers[i] = OsdCpuVertexBuffer::Create(3, numVertices);
+        sampleBuffers[i]->UpdateData(&positions[0], 0, numCoarse);
+    }
+
+    OsdCpuVertexBuffer * interleaved =
+        OsdCpuVertexBuffer::Create(3*kNumPoseSamples, numVertices);
+    for (int i=0; i<kNumPoseSamples; ++i) {
+        interleaved->UpdateSampleData(&positions[0], i, kNumPoseSamples, 0, numCoarse);
+    }
+
+    // warm up
+    for (int i=0; i<kNumPoseSamples; ++i) {
+        controller.Refine(context, batches, sampleBuffers[i]);
+    }
+    controller.RefineSamples(context, batches, interleaved, kNumPoseSamples);
+    controller.Synchronize();
+
+    double start = getTime();
+    for (int it=0; it<iterations; ++it) {
+        for (int i=0; i<kNumPoseSamples; ++i) {
+            controller.Refine(context, batches, sampleBuffers[i]);
+        }
+    }
+    controller.Synchronize();
+    double separate = (getTime() - start) * 1000.0 / iterations;
+
+    start = getTime();
+    for (int it=0; it<iterations; ++it) {
+        controller.RefineSamples(context, batches, interleaved, kNumPoseSamples);
+    }
+    controller.Synchronize();
+    double batched = (getTime() - start) * 1000.0 / iterations;
+
+    addResult(shape.name, "refine_poses", controllerName, level, numThreads,
+        separate, numRefined*kNumPoseSamples, "vertices/s");
+
+    // speedup relative to the separate refines
+    addResult(shape.name, "refine_poses_batched", controllerName, level, numThreads,
+        batched, numRefined*kNumPoseSamples, "vertices/s").speedup = separate / batched;
+
+    for (int i=0; i<kNumPoseSamples; ++i) {
+        delete sampleBuffers[i];
+    }
+    delete interleaved;
+}
+
+//------------------------------------------------------------------------------
+// Refine of every CPU compute controller, followed by the smooth normals of
+// the finest level
+static void
+benchRefine(TestShape const & shape, int level, int iterations) {
+
+    std::vector<float> positions;
+    HbrMesh<OsdVertex> * hmesh =
+        simpleHbr<OsdVertex>(shape.data.c_str(), kCatmark, positions);
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level);
+    FarMesh<OsdVertex> * fmesh = factory.Create();
+
+    int numVertices = fmesh->GetNumVertices(),
+        numRefined = numVertices - (int)positions.size()/3;
+
+    OsdCpuComputeContext * context =
+        OsdCpuComputeContext::Create(fmesh->GetSubdivisionTables(),
+                                     fmesh->GetVertexEditTables());
+
+    // interleaved position & normal
+    OsdCpuVertexBuffer * vbuffer = OsdCpuVertexBuffer::Create(6, numVertices);
+
+    std::vector<float> coarse(positions.size()*2, 0.0f);
+    for (int i=0; i<(int)positions.size()/3; ++i) {
+        for (int k=0; k<3; ++k) {
+            coarse[i*6+k] = positions[i*3+k];
+        }
+    }
+    vbuffer->UpdateData(&coarse[0], 0, (int)positions.size()/3);
+
+    FarKernelBatchVector const & batches = fmesh->GetKernelBatches();
+
+    {   OsdCpuComputeController controller;
+        benchRefineSamples(shape, controller, "cpu", 1, context, batches,
+            positions, level, numVertices, numRefined, iterations);
+    }
+#ifdef OPENSUBDIV_HAS_OPENMP
+    {   OsdOmpComputeController controller(g_threadCounts.back());
+        benchRefineSamples(shape, controller, "omp", g_threadCounts.back(), context, batches,
+            positions, level, numVertices, numRefined, iterations);
+    }
+#endif
+
+    {   OsdCpuComputeController controller;
+        addResult(shape.name, "refine", "cpu", level, 1,
+            timeRefine(controller, context, batches, vbuffer, iterations),
+            numRefined, "vertices/s");
+    }
+
+    {   int first = (int)g_results.size();
+        for (int i=0; i<(int)g_threadCounts.size(); ++i) {
+#ifndef OPENSUBDIV_HAS_OPENMP
+            if (g_threadCounts[i]>1)
+                break;
+#endif
+            OsdDefaultScheduler scheduler(g_threadCounts[i]);
+            OsdCpuComputeController controller(&scheduler);
+            addResult(shape.name, "refine", "scheduler", level, g_threadCounts[i],
+                timeRefine(controller, context, batches, vbuffer, iterations),
+                numRefined, "vertices/s");
+        }
+        setSpeedups(first);
+    }
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    {   int first = (int)g_results.size();
+        for (int i=0; i<(int)g_threadCounts.size(); ++i) {
+            OsdOmpComputeController controller(g_threadCounts[i]);
+            addResult(shape.name, "refine", "omp", level, g_threadCounts[i],
+                timeRefine(controller, context, batches, vbuffer, iterations),
+                numRefined, "vertices/s");
+        }
+        setSpeedups(first);
+    }
+#endif
+
+#ifdef OPENSUBDIV_HAS_TBB
+    {   OsdTbbComputeController controller;
+        addResult(shape.name, "refine", "tbb", level, g_threadCounts.back(),
+            timeRefine(controller, context, batches, vbuffer, iterations),
+            numRefined, "vertices/s");
+    }
+#endif
+
+#ifdef OPENSUBDIV_HAS_GCD
+    {   OsdGcdComputeController controller;
+        addResult(shape.name, "refine", "gcd", level, g_threadCounts.back(),
+            timeRefine(controller, context, batches, vbuffer, iterations),
+            numRefined, "vertices/s");
+    }
+#endif
+
+    // smooth normals : the uniform patch tables hold the quads of the
+    // finest level
+    OsdCpuSmoothNormalContext * normalContext =
+        OsdCpuSmoothNormalContext::Create(fmesh->GetPatchTables(), /*resetMemory*/ true);
+
+    {   OsdCpuSmoothNormalController controller;
+        addResult(shape.name, "smooth_normals", "cpu", level, 1,
+            timeSmoothNormals(controller, normalContext, vbuffer, iterations),
+            numVertices, "vertices/s");
+    }
+
+    {   int first = (int)g_results.size();
+        for (int i=0; i<(int)g_threadCounts.size(); ++i) {
+#ifndef OPENSUBDIV_HAS_OPENMP
+            if (g_threadCounts[i]>1)
+                break;
+#endif
+            OsdDefaultScheduler scheduler(g_threadCounts[i]);
+            OsdCpuSmoothNormalController controller(&scheduler);
+            addResult(shape.name, "smooth_normals", "scheduler", level, g_threadCounts[i],
+                timeSmoothNormals(controller, normalContext, vbuffer, iterations),
+                numVertices, "vertices/s");
+        }
+        setSpeedups(first);
+    }
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    {   int first = (int)g_results.size();
+        int maxThreads = omp_get_max_threads();
+        for (int i=0; i<(int)g_threadCounts.size(); ++i) {
+            omp_set_num_threads(g_threadCounts[i]);
+            OsdOmpSmoothNormalController controller;
+            addResult(shape.name, "smooth_normals", "omp", level, g_threadCounts[i],
+                timeSmoothNormals(controller, normalContext, vbuffer, iterations),
+                numVertices, "vertices/s");
+        }
+        omp_set_num_threads(maxThreads);
+        setSpeedups(first);
+    }
+#endif
+
+#ifdef OPENSUBDIV_HAS_TBB
+    {   OsdTbbSmoothNormalController controller;
+        addResult(shape.name, "smooth_normals", "tbb", level, g_threadCounts.back(),
+            timeSmoothNormals(controller, normalContext, vbuffer, iterations),
+            numVertices, "vertices/s");
+    }
+#endif
+
+    delete normalContext;
+    delete vbuffer;
+    delete context;
+    delete fmesh;
+    delete hmesh;
+}
+
+//------------------------------------------------------------------------------
+// OsdUtilMeshBatch : the copies of the mesh are all dirtied before each update,
+// which refines them back to back (FinalizeUpdate) or as parallel tasks
+// (FinalizeUpdateParallel)
+static int const kNumBatchMeshes = 8;
+
+static double
+timeBatchRefine(CpuMeshBatch * batch, std::vector<float> const & positions,
+                int numThreads, int iterations) {
+
+    double elapsed = 0.0;
+    for (int i=0; i<=iterations; ++i) {
+        for (int j=0; j<batch->GetNumMeshes(); ++j) {
+            batch->UpdateCoarseVertices(j, &positions[0], (int)positions.size()/3);
+        }
+
+        double start = getTime();
+        if (numThreads) {
+            batch->FinalizeUpdateParallel(numThreads);
+        } else {
+            batch->FinalizeUpdate();
+        }
+        // the first update warms up
+        if (i>0) {
+            elapsed += getTime() - start;
+        }
+    }
+    return elapsed * 1000.0 / iterations;
+}
+
+static void
+benchBatchRefine(TestShape const & shape, int level, int iterations) {
+
+    std::vector<float> positions;
+    HbrMesh<OsdVertex> * hmesh =
+        simpleHbr<OsdVertex>(shape.data.c_str(), kCatmark, positions);
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level);
+    FarMesh<OsdVertex> * fmesh = factory.Create();
+
+    std::vector<FarMesh<OsdVertex> const *> meshes(kNumBatchMeshes, fmesh);
+
+    OsdCpuComputeController controller;
+    CpuMeshBatch * batch = CpuMeshBatch::Create(&controller, meshes, 3, 0, 0);
+
+    int numRefined = batch->GetNumVertices() -
+                     kNumBatchMeshes * (int)positions.size()/3;
+
+    addResult(shape.name, "batch_refine", "cpu", level, 1,
+        timeBatchRefine(batch, positions, 0, iterations), numRefined, "vertices/s");
+
+    int first = (int)g_results.size();
+    for (int i=0; i<(int)g_threadCounts.size(); ++i) {
+#ifndef OPENSUBDIV_HAS_OPENMP
+        if (g_threadCounts[i]>1)
+            break;
+#endif
+        addResult(shape.name, "batch_refine", "parallel", level, g_threadCounts[i],
+            timeBatchRefine(batch, positions, g_threadCounts[i], iterations),
+            numRefined, "vertices/s");
+    }
+    setSpeedups(first);
+
+    delete batch;
+    delete fmesh;
+    delete hmesh;
+}
+
+//------------------------------------------------------------------------------
+// Evaluates the limit surface (position and tangents) at random samples of
+// every ptex face of an adaptive mesh. With "cached", the Gregory patches are
+// computed once per iteration (pose) by the controller.
+static double
+timeLimitEval(OsdCpuEvalLimitController & controller, OsdCpuEvalLimitContext * context,
+              std::vector<OsdEvalCoords> const & coords, int numThreads, int iterations,
+              bool cached) {
+
+    int nsamples = (int)coords.size();
+
+    double start = getTime();
+    for (int it=0; it<iterations; ++it) {
+        if (cached) {
+            context->InvalidateGregoryCache();
+            controller.UpdateGregoryCache(context);
+        }
+#ifdef OPENSUBDIV_HAS_OPENMP
+        #pragma omp parallel for num_threads(numThreads)
+#endif
+        for (int i=0; i<nsamples; ++i) {
+            controller.EvalLimitSample(coords[i], context, i);
+        }
+    }
+    (void)numThreads;
+    return (getTime() - start) * 1000.0 / iterations;
+}
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+// Stateless evaluation : every thread evaluates all the samples into its own
+// output buffer through its own Bindings (as concurrent tasks evaluating
+// different primvars would), with a shared controller and context
+static double
+timeLimitEvalStateless(OsdCpuEvalLimitController const & controller, OsdCpuEvalLimitContext * context,
+                       std::vector<OsdEvalCoords> const & coords,
+                       OsdVertexBufferDescriptor const & idesc, OsdCpuVertexBuffer * vbuffer,
+                       OsdVertexBufferDescriptor const & odesc,
+                       std::vector<OsdCpuVertexBuffer *> const & outputs, int iterations) {
+
+    int nsamples = (int)coords.size(),
+        numThreads = (int)outputs.size();
+
+    double start = getTime();
+    for (int it=0; it<iterations; ++it) {
+        #pragma omp parallel num_threads(numThreads)
+        {
+            OsdCpuEvalLimitController::Bindings bindings;
+            bindings.BindVertexBuffers(idesc, vbuffer, odesc, outputs[omp_get_thread_num()]);
+
+            for (int i=0; i<nsamples; ++i) {
+                controller.EvalLimitSample(coords[i], context, bindings, i);
+            }
+        }
+    }
+    return (getTime() - start) * 1000.0 / iterations;
+}
+#endif
+
+static void
+benchLimitEval(TestShape const & shape, int level, int numSamples, int iterations) {
+
+    std::vector<float> positions;
+    HbrMesh<OsdVertex> * hmesh =
+        simpleHbr<OsdVertex>(shape.data.c_str(), kCatmark, positions);
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level, /*adaptive*/ true);
+    FarMesh<OsdVertex> * fmesh = factory.Create();
+
+    int numVertices = fmesh->GetNumVertices();
+
+    OsdCpuComputeContext * computeContext =
+        OsdCpuComputeContext::Create(fmesh->GetSubdivisionTables(),
+                                     fmesh->GetVertexEditTables());
+
+    OsdCpuVertexBuffer * vbuffer = OsdCpuVertexBuffer::Create(3, numVertices);
+    vbuffer->UpdateData(&positions[0], 0, (int)positions.size()/3);
+
+    OsdCpuComputeController computeController;
+    computeController.Refine(computeContext, fmesh->GetKernelBatches(), vbuffer);
+
+    // random samples
+    FarPatchTables const * patchTables = fmesh->GetPatchTables();
+
+    int nptexfaces = patchTables->GetNumPtexFaces();
+
+    std::vector<OsdEvalCoords> coords(nptexfaces * numSamples);
+
+    srand( static_cast<int>(2147483647) ); // use a large Pell prime number
+    for (int i=0; i<(int)coords.size(); ++i) {
+        coords[i].face = i / numSamples;
+        coords[i].u = (float)rand()/(float)RAND_MAX;
+        coords[i].v = (float)rand()/(float)RAND_MAX;
+    }
+
+    int nsamples = (int)coords.size();
+
+    OsdCpuVertexBuffer * Q = OsdCpuVertexBuffer::Create(3, nsamples),
+                       * dQu = OsdCpuVertexBuffer::Create(3, nsamples),
+                       * dQv = OsdCpuVertexBuffer::Create(3, nsamples);
+
+    OsdCpuEvalLimitContext * evalContext =
+        OsdCpuEvalLimitContext::Create(patchTables, /*requireFVarData*/ false);
+
+    OsdVertexBufferDescriptor idesc(0, 3, 3),
+                              odesc(0, 3, 3);
+
+    OsdCpuEvalLimitController controller;
+    controller.BindVertexBuffers(idesc, vbuffer, odesc, Q, dQu, dQv);
+
+    // warm up
+    timeLimitEval(controller, evalContext, coords, 1, 1, false);
+
+    for (int cached=0; cached<2; ++cached) {
+
+        char const * name = cached ? "limit_eval_cached" : "limit_eval";
+
+        int first = (int)g_results.size();
+#ifdef OPENSUBDIV_HAS_OPENMP
+        for (int i=0; i<(int)g_threadCounts.size(); ++i) {
+            addResult(shape.name, name, "omp", level, g_threadCounts[i],
+                timeLimitEval(controller, evalContext, coords, g_threadCounts[i], iterations, cached!=0),
+                nsamples, "samples/s");
+        }
+#else
+        addResult(shape.name, name, "cpu", level, 1,
+            timeLimitEval(controller, evalContext, coords, 1, iterations, cached!=0),
+            nsamples, "samples/s");
+#endif
+        setSpeedups(first);
+    }
+
+    controller.Unbind();
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    {   int first = (int)g_results.size();
+        for (int i=0; i<(int)g_threadCounts.size(); ++i) {
+
+            int numThreads = g_threadCounts[i];
+
+            std::vector<OsdCpuVertexBuffer *> outputs(numThreads);
+            for (int j=0; j<numThreads; ++j) {
+                outputs[j] = OsdCpuVertexBuffer::Create(3, nsamples);
+            }
+
+            Result & r = addResult(shape.name, "limit_eval_stateless", "omp", level, numThreads,
+                timeLimitEvalStateless(controller, evalContext, coords, idesc, vbuffer, odesc,
+                                       outputs, iterations),
+                nsamples*numThreads, "samples/s");
+
+            // every thread evaluates all the samples : the speedup is the
+            // throughput relative to the single thread run
+            r.speedup = r.throughput / g_results[first].throughput;
+
+            for (int j=0; j<numThreads; ++j) {
+                delete outputs[j];
+            }
+        }
+    }
+#endif
+
+    delete evalContext;
+    delete Q;
+    delete dQu;
+    delete dQv;
+    delete vbuffer;
+    delete computeContext;
+    delete fmesh;
+    delete hmesh;
+}
+
+//------------------------------------------------------------------------------
+// Limit evaluation through the C API of osdutil : the random samples of every
+// ptex face are evaluated with one call per sample, then with the array entry
+// point.
+static void
+benchCapiLimitEval(TestShape const & shape, int level, int numSamples, int iterations) {
+
+    ::shape * sh = ::shape::parseShape(shape.data.c_str());
+
+    int numVertices = (int)sh->verts.size()/3;
+
+    OpenSubdiv_EvaluatorDescr * descr = openSubdiv_createEvaluatorDescr(numVertices);
+
+    int nptexfaces = 0;
+    for (int i=0, idx=0; i<sh->getNfaces(); ++i) {
+        int nv = sh->nvertsPerFace[i];
+        openSubdiv_createEvaluatorDescrFace(descr, nv, &sh->faceverts[idx]);
+        nptexfaces += nv==4 ? 1 : nv;
+        idx += nv;
+    }
+
+    if (not openSubdiv_finishEvaluatorDescr(descr, level, OSD_SCHEME_CATMARK) or
+        not openSubdiv_setEvaluatorCoarsePositions(descr, &sh->verts[0], numVertices)) {
+        abortBenchmark(shape.name, "capi_limit_eval", "evaluator setup failed");
+    }
+
+    int nsamples = nptexfaces * numSamples;
+
+    std::vector<int> faces(nsamples);
+    std::vector<float> u(nsamples), v(nsamples);
+
+    srand( static_cast<int>(2147483647) ); // use a large Pell prime number
+    for (int i=0; i<nsamples; ++i) {
+        faces[i] = i / numSamples;
+        u[i] = (float)rand()/(float)RAND_MAX;
+        v[i] = (float)rand()/(float)RAND_MAX;
+    }
+
+    std::vector<float> P(nsamples*3), dPdu(nsamples*3), dPdv(nsamples*3);
+
+    double start = getTime();
+    for (int it=0; it<iterations; ++it) {
+        for (int i=0; i<nsamples; ++i) {
+            openSubdiv_evaluateLimit(descr, faces[i], u[i], v[i],
+                &P[i*3], &dPdu[i*3], &dPdv[i*3]);
+        }
+    }
+    double perSample = (getTime() - start) * 1000.0 / iterations;
+
+    addResult(shape.name, "capi_limit_eval", "capi", level, 1,
+        perSample, nsamples, "samples/s");
+
+    for (int i=0; i<(int)g_threadCounts.size(); ++i) {
+
+        int numThreads = g_threadCounts[i];
+
+        start = getTime();
+        for (int it=0; it<iterations; ++it) {
+            openSubdiv_evaluateLimitArray(descr, nsamples, &faces[0], &u[0], &v[0],
+                &P[0], &dPdu[0], &dPdv[0], numThreads);
+        }
+        double elapsed = (getTime() - start) * 1000.0 / iterations;
+
+        // speedup relative to the calls per sample
+        addResult(shape.name, "capi_limit_eval_array", "capi", level, numThreads,
+            elapsed, nsamples, "samples/s").speedup = perSample / elapsed;
+    }
+
+    openSubdiv_deleteEvaluatorDescr(descr);
+    delete sh;
+}
+
+//------------------------------------------------------------------------------
+// Limit surface tessellation (OsdUtilTessellator) of every coarse face at
+// kTessRate segments per edge : Initialize locates the samples and computes
+// their basis weights once, Evaluate is run for each pose. The evaluation is
+// compared to the per-sample limit evaluation of the same grids, the edge
+// vertices of each face included ("speedup" is relative to it).
+static int const kTessRate = 8;
+
+static void
+benchTessellate(TestShape const & shape, int level, int iterations) {
+
+    OsdUtilSubdivTopology topology;
+    std::vector<float> positions;
+    std::string errorMessage;
+    if (not topology.ParseFromObjString(shape.data.c_str(), 1, &positions, &errorMessage)) {
+        abortBenchmark(shape.name, "tessellate", errorMessage);
+    }
+    topology.refinementLevel = level;
+
+    OsdUtilRefiner refiner;
+    if (not refiner.Initialize(topology, /*adaptive*/ true, &errorMessage)) {
+        abortBenchmark(shape.name, "tessellate", errorMessage);
+    }
+
+    FarMesh<OsdVertex> const * fmesh = refiner.GetFarMesh();
+
+    int numVertices = fmesh->GetNumVertices();
+
+    OsdCpuComputeContext * computeContext =
+        OsdCpuComputeContext::Create(fmesh->GetSubdivisionTables(),
+                                     fmesh->GetVertexEditTables());
+
+    OsdCpuVertexBuffer * vbuffer = OsdCpuVertexBuffer::Create(3, numVertices);
+    vbuffer->UpdateData(&positions[0], 0, (int)positions.size()/3);
+
+    OsdCpuComputeController computeController;
+    computeController.Refine(computeContext, fmesh->GetKernelBatches(), vbuffer);
+
+    OsdUtilTessellator tessellator;
+
+    double start = getTime();
+    for (int it=0; it<iterations; ++it) {
+        if (not tessellator.Initialize(topology, fmesh->GetPatchTables(), kTessRate, NULL, &errorMessage)) {
+            abortBenchmark(shape.name, "tessellate", errorMessage);
+        }
+    }
+    double elapsed = (getTime() - start) * 1000.0 / iterations;
+
+    int ntess = tessellator.GetNumVertices();
+
+    addResult(shape.name, "tessellate_init", "osdutil", level, 1,
+        elapsed, ntess, "vertices/s");
+
+    // per-sample limit evaluation of the grids of the ptex faces
+    FarPatchTables const * patchTables = fmesh->GetPatchTables();
+
+    std::vector<OsdEvalCoords> coords;
+    for (int face=0; face<patchTables->GetNumPtexFaces(); ++face) {
+        for (int y=0; y<=kTessRate; ++y) {
+            for (int x=0; x<=kTessRate; ++x) {
+                coords.push_back(OsdEvalCoords(face, float(x)/kTessRate, float(y)/kTessRate));
+            }
+        }
+    }
+
+    OsdCpuVertexBuffer * Q = OsdCpuVertexBuffer::Create(3, (int)coords.size());
+
+    OsdCpuEvalLimitContext * evalContext =
+        OsdCpuEvalLimitContext::Create(patchTables, /*requireFVarData*/ false);
+
+    OsdVertexBufferDescriptor desc(0, 3, 3);
+
+    OsdCpuEvalLimitController controller;
+    controller.BindVertexBuffers<OsdCpuVertexBuffer,OsdCpuVertexBuffer>(desc, vbuffer, desc, Q);
+
+    double perSample = timeLimitEval(controller, evalContext, coords, 1, iterations, false);
+
+    addResult(shape.name, "tessellate_limit_eval", "cpu", level, 1,
+        perSample, (int)coords.size(), "samples/s");
+
+    std::vector<float> tessPositions(ntess*3);
+
+    for (int i=0; i<(int)g_threadCounts.size(); ++i) {
+
+        int numThreads = g_threadCounts[i];
+
+        start = getTime();
+        for (int it=0; it<iterations; ++it) {
+            tessellator.Evaluate(desc, vbuffer->BindCpuBuffer(),
+                                 desc, &tessPositions[0], numThreads);
+        }
+        elapsed = (getTime() - start) * 1000.0 / iterations;
+
+        addResult(shape.name, "tessellate_eval", "osdutil", level, numThreads,
+            elapsed, ntess, "vertices/s").speedup = perSample / elapsed;
+    }
+
+    controller.Unbind();
+
+    delete evalContext;
+    delete Q;
+    delete vbuffer;
+    delete computeContext;
+}
+
+//------------------------------------------------------------------------------
+// Ray intersections with the limit surface : the rays are shot from a sphere
+// around the mesh towards the random samples of every ptex face.
+static double
+timeLimitBVHIntersect(OsdCpuEvalLimitBVH const & bvh, std::vector<float> const & rays,
+                      int numThreads, int iterations, int * numHits) {
+
+    int nrays = (int)rays.size()/6,
+        nhits = 0;
+
+    double start = getTime();
+    for (int it=0; it<iterations; ++it) {
+        nhits = 0;
+#ifdef OPENSUBDIV_HAS_OPENMP
+        #pragma omp parallel for reduction(+:nhits) num_threads(numThreads)
+#endif
+        for (int i=0; i<nrays; ++i) {
+            OsdCpuEvalLimitBVH::Hit hit;
+            if (bvh.Intersect(&rays[i*6], &rays[i*6+3], &hit))
+                ++nhits;
+        }
+    }
+    (void)numThreads;
+    *numHits = nhits;
+    return (getTime() - start) * 1000.0 / iterations;
+}
+
+static double
+timeLimitBVHClosest(OsdCpuEvalLimitBVH const & bvh, std::vector<float> const & points,
+                    int numThreads, int iterations) {
+
+    int npoints = (int)points.size()/3;
+
+    double start = getTime();
+    for (int it=0; it<iterations; ++it) {
+#ifdef OPENSUBDIV_HAS_OPENMP
+        #pragma omp parallel for num_threads(numThreads)
+#endif
+        for (int i=0; i<npoints; ++i) {
+            OsdEvalCoords coords;
+            bvh.FindClosestPoint(&points[i*3], &coords);
+        }
+    }
+    (void)numThreads;
+    return (getTime() - start) * 1000.0 / iterations;
+}
+
+static void
+benchLimitBVH(TestShape const & shape, int level, int numSamples, int iterations) {
+
+    std::vector<float> positions;
+    HbrMesh<OsdVertex> * hmesh =
+        simpleHbr<OsdVertex>(shape.data.c_str(), kCatmark, positions);
+
+    FarMeshFactory<OsdVertex> factory(hmesh, level, /*adaptive*/ true);
+    FarMesh<OsdVertex> * fmesh = factory.Create();
+
+    OsdCpuComputeContext * computeContext =
+        OsdCpuComputeContext::Create(fmesh->GetSubdivisionTables(),
+                                     fmesh->GetVertexEditTables());
+
+    OsdCpuVertexBuffer * vbuffer = OsdCpuVertexBuffer::Create(3, fmesh->GetNumVertices());
+    vbuffer->UpdateData(&positions[0], 0, (int)positions.size()/3);
+
+    OsdCpuComputeController computeController;
+    computeController.Refine(computeContext, fmesh->GetKernelBatches(), vbuffer);
+
+    FarPatchTables const * patchTables = fmesh->GetPatchTables();
+
+    OsdCpuEvalLimitBVH * bvh = OsdCpuEvalLimitBVH::Create(patchTables);
+
+    OsdVertexBufferDescriptor desc(0, 3, 3);
+
+    float const * data = vbuffer->BindCpuBuffer();
+
+    double start = getTime();
+    for (int it=0; it<iterations; ++it) {
+        bvh->Build(desc, data);
+    }
+    addResult(shape.name, "limit_bvh_build", "cpu", level, 1,
+        (getTime() - start) * 1000.0 / iterations, bvh->GetNumPatches(), "patches/s");
+
+    start = getTime();
+    for (int it=0; it<iterations; ++it) {
+        bvh->Refit(desc, data);
+    }
+    addResult(shape.name, "limit_bvh_refit", "cpu", level, 1,
+        (getTime() - start) * 1000.0 / iterations, bvh->GetNumPatches(), "patches/s");
+
+    // rays towards random limit samples, and points near them
+    float bounds[6];
+    bvh->GetBounds(bounds);
+
+    float center[3], radius = 0.0f;
+    for (int k=0; k<3; ++k) {
+        center[k] = (bounds[k] + bounds[k+3]) * 0.5f;
+        radius += (bounds[k+3] - bounds[k]) * (bounds[k+3] - bounds[k]);
+    }
+    radius = sqrtf(radius);
+
+    OsdCpuEvalLimitContext * evalContext =
+        OsdCpuEvalLimitContext::Create(patchTables, /*requireFVarData*/ false);
+
+    OsdCpuEvalLimitController controller;
+    controller.BindVertexBuffers<OsdCpuVertexBuffer,OsdCpuVertexBuffer>(
+        desc, vbuffer, OsdVertexBufferDescriptor(0, 0, 0), NULL);
+
+    int nptexfaces = patchTables->GetNumPtexFaces();
+
+    std::vector<float> rays, points;
+    rays.reserve(nptexfaces * numSamples * 6);
+    points.reserve(nptexfaces * numSamples * 3);
+
+    srand( static_cast<int>(2147483647) ); // use a large Pell prime number
+    for (int i=0; i<nptexfaces * numSamples; ++i) {
+
+        OsdEvalCoords coords(i / numSamples,
+                             (float)rand()/(float)RAND_MAX,
+                             (float)rand()/(float)RAND_MAX);
+
+        float P[3];
+        if (not controller.EvalLimitSample(coords, evalContext, desc, P, 0, 0))
+            continue;
+
+        float dir[3], len = 0.0f;
+        for (int k=0; k<3; ++k) {
+            dir[k] = (float)rand()/(float)RAND_MAX - 0.5f;
+            len += dir[k]*dir[k];
+        }
+        len = sqrtf(len);
+        if (len==0.0f)
+            continue;
+
+        for (int k=0; k<3; ++k) {
+            float org = center[k] + dir[k] * radius / len;
+            rays.push_back(org);
+        }
+        for (int k=0; k<3; ++k) {
+            rays.push_back(P[k] - rays[rays.size()-3]);
+        }
+        for (int k=0; k<3; ++k) {
+            points.push_back(P[k] + dir[k] * radius * 0.01f / len);
+        }
+    }
+
+    int nrays = (int)rays.size()/6,
+        nhits = 0,
+        first = (int)g_results.size();
+#ifdef OPENSUBDIV_HAS_OPENMP
+    for (int i=0; i<(int)g_threadCounts.size(); ++i) {
+        addResult(shape.name, "limit_bvh_intersect", "omp", level, g_threadCounts[i],
+            timeLimitBVHIntersect(*bvh, rays, g_threadCounts[i], iterations, &nhits),
+            nrays, "rays/s");
+    }
+#else
+    addResult(shape.name, "limit_bvh_intersect", "cpu", level, 1,
+        timeLimitBVHIntersect(*bvh, rays, 1, iterations, &nhits), nrays, "rays/s");
+#endif
+    setSpeedups(first);
+
+    int npoints = (int)points.size()/3;
+
+    first = (int)g_results.size();
+#ifdef OPENSUBDIV_HAS_OPENMP
+    for (int i=0; i<(int)g_threadCounts.size(); ++i) {
+        addResult(shape.name, "limit_bvh_closest", "omp", level, g_threadCounts[i],
+            timeLimitBVHClosest(*bvh, points, g_threadCounts[i], iterations),
+            npoints, "points/s");
+    }
+#else
+    addResult(shape.name, "limit_bvh_closest", "cpu", level, 1,
+        timeLimitBVHClosest(*bvh, points, 1, iterations), npoints, "points/s");
+#endif
+    setSpeedups(first);
+
+    // every ray is shot at a point of the surface : only the rays grazing the
+    // surface can miss it
+    if (nhits!=nrays) {
+        fprintf(stderr, "  Warning : %d of %d rays missed the limit surface\n",
+            nrays-nhits, nrays);
+    }
+
+    delete evalContext;
+    delete bvh;
+    delete vbuffer;
+    delete computeContext;
+    delete fmesh;
+    delete hmesh;
+}
+
+//------------------------------------------------------------------------------
+static void
+writeJSON(FILE * f, int level, int iterations, int numSamples) {
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"config\" : { \"level\" : %d, \"iterations\" : %d, "
+               "\"samples\" : %d, \"max_threads\" : %d },\n",
+               level, iterations, numSamples, g_threadCounts.back());
+    fprintf(f, "  \"per_case_rss\" : %s,\n", g_perCaseRSS ? "true" : "false");
+    fprintf(f, "  \"results\" : [\n");
+
+    for (int i=0; i<(int)g_results.size(); ++i) {
+        Result const & r = g_results[i];
+        fprintf(f, "    { \"shape\" : \"%s\", \"benchmark\" : \"%s\", "
+                   "\"controller\" : \"%s\", \"level\" : %d, \"threads\" : %d, "
+                   "\"time_ms\" : %.4f, \"throughput\" : %.1f, \"unit\" : \"%s\", "
+                   "\"speedup\" : %.3f, \"peak_rss_kb\" : %ld, \"rss_growth_kb\" : %ld }%s\n",
+            r.shape.c_str(), r.benchmark.c_str(), r.controller.c_str(),
+            r.level, r.threads, r.timeMs, r.throughput, r.unit, r.speedup,
+            r.peakRSS, r.growthRSS, (i+1)<(int)g_results.size() ? "," : "");
+    }
+
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+}
+
+//------------------------------------------------------------------------------
+static void
+usage(char const * name) {
+    printf("Usage : %s [-l level] [-n iterations] [-s samples] [-t maxThreads] [-o file.json]\n", name);
+}
+
+//------------------------------------------------------------------------------
+int
+main(int argc, char ** argv) {
+
+    int level = 3,
+        iterations = 10,
+        numSamples = 16,
+        maxThreads = 1;
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    maxThreads = omp_get_max_threads();
+#endif
+
+    char const * filename = 0;
+
+    for (int i=1; i<argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg=="-l" and i+1<argc) {
+            level = std::max(1, atoi(argv[++i]));
+        } else if (arg=="-n" and i+1<argc) {
+            iterations = std::max(1, atoi(argv[++i]));
+        } else if (arg=="-s" and i+1<argc) {
+            numSamples = std::max(1, atoi(argv[++i]));
+        } else if (arg=="-t" and i+1<argc) {
+            maxThreads = std::max(1, atoi(argv[++i]));
+        } else if (arg=="-o" and i+1<argc) {
+            filename = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    initShapes();
+    initThreadCounts(maxThreads);
+
+    g_perCaseRSS = resetPeakRSS();
+
+    for (int i=0; i<(int)g_shapes.size(); ++i) {
+
+        TestShape const & shape = g_shapes[i];
+
+        fprintf(stderr, "%s\n", shape.name.c_str());
+
+        benchFarCreate(shape, level, iterations);
+        benchStencils(shape, level, numSamples);
+        benchLimitStencils(shape, level, numSamples);
+        benchEvalStencils(shape, level, numSamples, iterations);
+        benchStencilFrames(shape, level, numSamples, iterations);
+        benchRefine(shape, level, iterations);
+        benchBatchRefine(shape, level, iterations);
+        benchLimitEval(shape, level, numSamples, iterations);
+        benchCapiLimitEval(shape, level, numSamples, iterations);
+        benchTessellate(shape, level, iterations);
+        benchLimitBVH(shape, level, numSamples, iterations);
+    }
+
+    FILE * f = stdout;
+    if (filename) {
+        f = fopen(filename, "w");
+        if (not f) {
+            fprintf(stderr, "Error : cannot open %s\n", filename);
+            return 1;
+        }
+    }
+
+    writeJSON(f, level, iterations, numSamples);
+
+    if (f!=stdout) {
+        fclose(f);
+    }
+    return 0;
+}
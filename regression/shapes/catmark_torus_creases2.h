@@ -0,0 +1,112 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+static const std::string catmark_torus_creases2 =
+"# This file uses centimeters as units for non-parametric coordinates.\n"
+"\n"
+"v 1.25052 0.517982 0.353553\n"
+"v 0.597239 0.247384 0.353553\n"
+"v 0.597239 0.247384 -0.353553\n"
+"v 1.25052 0.517982 -0.353553\n"
+"v 0.517982 1.25052 0.353553\n"
+"v 0.247384 0.597239 0.353553\n"
+"v 0.247384 0.597239 -0.353553\n"
+"v 0.517982 1.25052 -0.353553\n"
+"v -0.517982 1.25052 0.353553\n"
+"v -0.247384 0.597239 0.353553\n"
+"v -0.247384 0.597239 -0.353553\n"
+"v -0.517982 1.25052 -0.353553\n"
+"v -1.25052 0.517982 0.353553\n"
+"v -0.597239 0.247384 0.353553\n"
+"v -0.597239 0.247384 -0.353553\n"
+"v -1.25052 0.517982 -0.353553\n"
+"v -1.25052 -0.517982 0.353553\n"
+"v -0.597239 -0.247384 0.353553\n"
+"v -0.597239 -0.247384 -0.353553\n"
+"v -1.25052 -0.517982 -0.353553\n"
+"v -0.517982 -1.25052 0.353553\n"
+"v -0.247384 -0.597239 0.353553\n"
+"v -0.247384 -0.597239 -0.353553\n"
+"v -0.517982 -1.25052 -0.353553\n"
+"v 0.517982 -1.25052 0.353553\n"
+"v 0.247384 -0.597239 0.353553\n"
+"v 0.247384 -0.597239 -0.353553\n"
+"v 0.517982 -1.25052 -0.353553\n"
+"v 1.25052 -0.517982 0.353553\n"
+"v 0.597239 -0.247384 0.353553\n"
+"v 0.597239 -0.247384 -0.353553\n"
+"v 1.25052 -0.517982 -0.353553\n"
+"vt 0 0\n"
+"vt 1 0\n"
+"vt 1 1\n"
+"vt 0 1\n"
+"f 5/1/1 6/2/2 2/3/3 1/4/4\n"
+"f 6/1/5 7/2/6 3/3/7 2/4/8\n"
+"f 7/1/9 8/2/10 4/3/11 3/4/12\n"
+"f 8/1/13 5/2/14 1/3/15 4/4/16\n"
+"f 9/1/17 10/2/18 6/3/19 5/4/20\n"
+"f 10/1/21 11/2/22 7/3/23 6/4/24\n"
+"f 11/1/25 12/2/26 8/3/27 7/4/28\n"
+"f 12/1/29 9/2/30 5/3/31 8/4/32\n"
+"f 13/1/33 14/2/34 10/3/35 9/4/36\n"
+"f 14/1/37 15/2/38 11/3/39 10/4/40\n"
+"f 15/1/41 16/2/42 12/3/43 11/4/44\n"
+"f 16/1/45 13/2/46 9/3/47 12/4/48\n"
+"f 17/1/49 18/2/50 14/3/51 13/4/52\n"
+"f 18/1/53 19/2/54 15/3/55 14/4/56\n"
+"f 19/1/57 20/2/58 16/3/59 15/4/60\n"
+"f 20/1/61 17/2/62 13/3/63 16/4/64\n"
+"f 21/1/65 22/2/66 18/3/67 17/4/68\n"
+"f 22/1/69 23/2/70 19/3/71 18/4/72\n"
+"f 23/1/73 24/2/74 20/3/75 19/4/76\n"
+"f 24/1/77 21/2/78 17/3/79 20/4/80\n"
+"f 25/1/81 26/2/82 22/3/83 21/4/84\n"
+"f 26/1/85 27/2/86 23/3/87 22/4/88\n"
+"f 27/1/89 28/2/90 24/3/91 23/4/92\n"
+"f 28/1/93 25/2/94 21/3/95 24/4/96\n"
+"f 29/1/97 30/2/98 26/3/99 25/4/100\n"
+"f 30/1/101 31/2/102 27/3/103 26/4/104\n"
+"f 31/1/105 32/2/106 28/3/107 27/4/108\n"
+"f 32/1/109 29/2/110 25/3/111 28/4/112\n"
+"f 1/1/113 2/2/114 30/3/115 29/4/116\n"
+"f 2/1/117 3/2/118 31/3/119 30/4/120\n"
+"f 3/1/121 4/2/122 32/3/123 31/4/124\n"
+"f 4/1/125 1/2/126 29/3/127 32/4/128\n"
+"t crease 2/1/0 1 5 10\n"
+"t crease 2/1/0 5 9 10\n"
+"t crease 2/1/0 9 13 10\n"
+"t crease 2/1/0 13 17 10\n"
+"t crease 2/1/0 17 21 10\n"
+"t crease 2/1/0 21 25 10\n"
+"t crease 2/1/0 25 29 10\n"
+"t crease 2/1/0 29 1 10\n"
+"t crease 2/1/0 2 6 10\n"
+"t crease 2/1/0 6 10 10\n"
+"t crease 2/1/0 10 14 10\n"
+"t crease 2/1/0 14 18 10\n"
+"t crease 2/1/0 18 22 10\n"
+"t crease 2/1/0 22 26 10\n"
+"t crease 2/1/0 26 30 10\n"
+"t crease 2/1/0 30 2 10\n"
+;
@@ -0,0 +1,224 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include <osdutil/uniformEvaluator.h>
+#include <far/subdivisionStencilTablesFactory.h>
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../common/timing_utils.h"
+
+//
+// Uniform refinement benchmark : compares the level by level refinement of
+// OsdUtilUniformEvaluator with the stencil refinement (which maps the coarse
+// vertices directly to the finest level).
+//
+// For each level, reports the time of a single Refine call, the size of the
+// tables read by the kernels and an estimate of the vertex data traffic :
+//
+// - level by level : every vertex of every level is written once, and read
+//   back from the previous level (or the coarse vertices).
+//
+// - stencils : every control vertex index of a stencil reads one coarse
+//   vertex, and only the finest level is written.
+//
+// Usage : uniform_perf [-t numThreads] [-n iterations]
+//
+
+using namespace OpenSubdiv;
+
+struct TestShape {
+    TestShape(char const * n, std::string const & d) : name(n), data(d) { }
+
+    char const * name;
+    std::string  data;
+};
+
+#include "../shapes/catmark_car.h"
+#include "../shapes/catmark_pawn.h"
+#include "../shapes/catmark_torus_creases0.h"
+
+static std::vector<TestShape> g_shapes;
+
+static void
+initShapes() {
+    g_shapes.push_back(TestShape("catmark_car",            catmark_car));
+    g_shapes.push_back(TestShape("catmark_pawn",           catmark_pawn));
+    g_shapes.push_back(TestShape("catmark_torus_creases0", catmark_torus_creases0));
+}
+
+//------------------------------------------------------------------------------
+// returns the average time (in ms) of a Refine call
+static double
+timeRefine(OsdUtilUniformEvaluator & evaluator, int numThreads, int iterations) {
+
+    // warm up
+    evaluator.Refine(numThreads);
+
+    double start = getTime();
+    for (int i=0; i<iterations; ++i) {
+        evaluator.Refine(numThreads);
+    }
+    return (getTime() - start) * 1000.0 / iterations;
+}
+
+//------------------------------------------------------------------------------
+static float
+compareRefined(OsdUtilUniformEvaluator & a, OsdUtilUniformEvaluator & b) {
+
+    float const * pa=0, * pb=0;
+    int na=0, nb=0;
+
+    if (not (a.GetRefinedPositions(&pa, &na) and
+             b.GetRefinedPositions(&pb, &nb)) or na!=nb) {
+        return -1.0f;
+    }
+
+    float maxdiff = 0.0f;
+    for (int i=0; i<na; ++i) {
+        maxdiff = std::max(maxdiff, std::abs(pa[i]-pb[i]));
+    }
+    return maxdiff;
+}
+
+//------------------------------------------------------------------------------
+static bool
+runShape(TestShape const & shape, int level, int numThreads, int iterations) {
+
+    std::string errorMessage;
+
+    OsdUtilSubdivTopology topology;
+    std::vector<float> positions;
+    if (not topology.ParseFromObjString(shape.data.c_str(), 1, &positions, &errorMessage)) {
+        printf("%s : %s\n", shape.name, errorMessage.c_str());
+        return false;
+    }
+    topology.name = shape.name;
+    topology.refinementLevel = level;
+
+    OsdUtilUniformEvaluator levels, stencils;
+    stencils.SetUseStencils(true);
+
+    if (not levels.Initialize(topology, &errorMessage) or
+        not stencils.Initialize(topology, &errorMessage)) {
+        printf("%s : %s\n", shape.name, errorMessage.c_str());
+        return false;
+    }
+
+    if (not levels.SetCoarsePositions(positions, &errorMessage) or
+        not stencils.SetCoarsePositions(positions, &errorMessage)) {
+        printf("%s : %s\n", shape.name, errorMessage.c_str());
+        return false;
+    }
+
+    double levelsTime = timeRefine(levels, numThreads, iterations),
+           stencilsTime = timeRefine(stencils, numThreads, iterations);
+
+    float maxdiff = compareRefined(levels, stencils);
+
+    // memory estimates
+    FarMesh<OsdVertex> const * fmesh = levels.GetFarMesh();
+    FarSubdivisionTables const * tables = fmesh->GetSubdivisionTables();
+
+    FarStencilTables const * stables =
+        FarSubdivisionStencilTablesFactory::Create(fmesh, level);
+
+    int const vertSize = 3 * sizeof(float);
+
+    int numCoarse = tables->GetNumVertices(0),
+        numTotal = tables->GetNumVerticesTotal(level),
+        numFinest = tables->GetNumVertices(level);
+
+    size_t levelsTables = tables->GetMemoryUsed(),
+           levelsTraffic = (size_t)(numTotal - numCoarse) * vertSize * 2;
+
+    size_t numIndices = stables->GetControlIndices().size(),
+           stencilsTables = (stables->GetSizes().size() +
+                             stables->GetOffsets().size() +
+                             numIndices) * sizeof(int) +
+                            stables->GetWeights().size() * sizeof(float),
+           stencilsTraffic = (numIndices + numFinest) * vertSize;
+
+    printf("%-24s %2d %8d %9.3f %9.3f %9.1f %9.1f %9.1f %9.1f %8.1e\n",
+        shape.name, level, numFinest,
+        levelsTime, stencilsTime,
+        levelsTables/1024.0, levelsTraffic/1024.0,
+        stencilsTables/1024.0, stencilsTraffic/1024.0,
+        maxdiff);
+
+    delete stables;
+
+    return maxdiff >= 0.0f and maxdiff < 1e-3f;
+}
+
+//------------------------------------------------------------------------------
+static void
+usage(char const * name) {
+    printf("Usage : %s [-t numThreads] [-n iterations]\n", name);
+}
+
+//------------------------------------------------------------------------------
+int
+main(int argc, char ** argv) {
+
+    int numThreads = 1,
+        iterations = 20;
+
+    for (int i=1; i<argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg=="-t" and i+1<argc) {
+            numThreads = atoi(argv[++i]);
+        } else if (arg=="-n" and i+1<argc) {
+            iterations = std::max(1, atoi(argv[++i]));
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    initShapes();
+
+    printf("%-24s %2s %8s %9s %9s %9s %9s %9s %9s %8s\n",
+        "shape", "lv", "verts", "levels", "stencils",
+        "tables", "traffic", "stencils", "traffic", "maxdiff");
+    printf("%-24s %2s %8s %9s %9s %9s %9s %9s %9s %8s\n",
+        "", "", "", "(ms)", "(ms)", "(KB)", "(KB)", "(KB)", "(KB)", "");
+
+    int failures = 0;
+    for (int i=0; i<(int)g_shapes.size(); ++i) {
+        for (int level=2; level<=5; ++level) {
+            if (not runShape(g_shapes[i], level, numThreads, iterations)) {
+                ++failures;
+            }
+        }
+    }
+
+    if (failures) {
+        printf("%d test(s) failed\n", failures);
+    }
+    return failures ? 1 : 0;
+}